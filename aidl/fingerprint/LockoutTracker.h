@@ -13,7 +13,9 @@ namespace biometrics {
 namespace fingerprint {
 
 #define LOCKOUT_TIMED_THRESHOLD 5
+#ifndef LOCKOUT_TIMED_DURATION
 #define LOCKOUT_TIMED_DURATION 30 * 1000
+#endif
 #define LOCKOUT_PERMANENT_THRESHOLD 20
 
 enum class LockoutMode {
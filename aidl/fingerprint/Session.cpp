@@ -20,6 +20,9 @@
 using namespace ::android::fingerprint::samsung;
 using namespace ::std::chrono_literals;
 
+// How long enroll waits for the sensor to report capture ready after a forced calibration
+static constexpr auto kCaptureReadyTimeout = 5s;
+
 namespace aidl {
 namespace android {
 namespace hardware {
@@ -38,6 +41,7 @@ Session::Session(LegacyHAL hal, int userId, std::shared_ptr<ISessionCallback> cb
                  LockoutTracker lockoutTracker)
     : mHal(hal),
       mLockoutTracker(lockoutTracker),
+      mForceCalibrate(FingerprintHalProperties::force_calibrate().value_or(false)),
       mUserId(userId),
       mCb(cb) {
     mDeathRecipient = AIBinder_DeathRecipient_new(onClientDeath);
@@ -45,6 +49,17 @@ Session::Session(LegacyHAL hal, int userId, std::shared_ptr<ISessionCallback> cb
     char filename[64];
     snprintf(filename, sizeof(filename), FINGERPRINT_DATA_DIR, userId);
     mHal.ss_fingerprint_set_active_group(userId, filename);
+
+    mTimerThread = std::thread(&Session::timerLoop, this);
+}
+
+Session::~Session() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTimerThreadExit = true;
+    }
+    mCond.notify_all();
+    mTimerThread.join();
 }
 
 ndk::ScopedAStatus Session::generateChallenge() {
@@ -69,8 +84,11 @@ ndk::ScopedAStatus Session::enroll(const HardwareAuthToken& hat,
                                    std::shared_ptr<ICancellationSignal>* out) {
     LOG(INFO) << "enroll";
 
-    if (FingerprintHalProperties::force_calibrate().value_or(false)) {
-        mCaptureReady = false;
+    if (mForceCalibrate) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mCaptureReady = false;
+        }
         mHal.request(SEM_REQUEST_FORCE_CBGE, 1);
     }
 
@@ -83,10 +101,10 @@ ndk::ScopedAStatus Session::enroll(const HardwareAuthToken& hat,
         mCb->onError(Error::UNABLE_TO_PROCESS, error);
     }
 
-    if (FingerprintHalProperties::force_calibrate().value_or(false)) {
-        while (!mCaptureReady) {
-            std::this_thread::sleep_for(100ms);
-        }
+    if (mForceCalibrate) {
+        std::unique_lock<std::mutex> lock(mLock);
+        if (!mCond.wait_for(lock, kCaptureReadyTimeout, [this] { return mCaptureReady; }))
+            LOG(WARNING) << "Timed out waiting for capture ready";
     }
 
     *out = SharedRefBase::make<CancellationSignal>(this);
@@ -182,7 +200,7 @@ ndk::ScopedAStatus Session::resetLockout(const HardwareAuthToken& /*hat*/) {
     LOG(INFO) << "resetLockout";
 
     clearLockout(true);
-    mIsLockoutTimerAborted = true;
+    abortLockoutTimer();
 
     return ndk::ScopedAStatus::ok();
 }
@@ -349,13 +367,13 @@ bool Session::checkSensorLockout() {
     if (lockoutMode == LockoutMode::PERMANENT) {
         LOG(ERROR) << "Fail: lockout permanent";
         mCb->onLockoutPermanent();
-        mIsLockoutTimerAborted = true;
+        abortLockoutTimer();
         return true;
     } else if (lockoutMode == LockoutMode::TIMED) {
         int64_t timeLeft = mLockoutTracker.getLockoutTimeLeft();
         LOG(ERROR) << "Fail: lockout timed " << timeLeft;
         mCb->onLockoutTimed(timeLeft);
-        if (!mIsLockoutTimerStarted) startLockoutTimer(timeLeft);
+        startLockoutTimer(timeLeft);
         return true;
     }
     return false;
@@ -367,23 +385,50 @@ void Session::clearLockout(bool clearAttemptCounter) {
 }
 
 void Session::startLockoutTimer(int64_t timeout) {
-    mIsLockoutTimerAborted = false;
-    std::function<void()> action =
-            std::bind(&Session::lockoutTimerExpired, this);
-    std::thread([timeout, action]() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
-        action();
-    }).detach();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mIsLockoutTimerArmed)
+            return;
+
+        mLockoutDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        mIsLockoutTimerArmed = true;
+    }
+    mCond.notify_all();
+}
 
-    mIsLockoutTimerStarted = true;
+void Session::abortLockoutTimer() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mIsLockoutTimerArmed = false;
+    }
+    mCond.notify_all();
 }
 
 void Session::lockoutTimerExpired() {
-    if (!mIsLockoutTimerAborted)
-        clearLockout(false);
+    clearLockout(false);
+}
+
+void Session::timerLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+
+    while (!mTimerThreadExit) {
+        if (!mIsLockoutTimerArmed) {
+            mCond.wait(lock);
+            continue;
+        }
 
-    mIsLockoutTimerStarted = false;
-    mIsLockoutTimerAborted = false;
+        if (std::chrono::steady_clock::now() < mLockoutDeadline) {
+            // Woken early by an abort, a re-arm or teardown; re-evaluate
+            mCond.wait_until(lock, mLockoutDeadline);
+            continue;
+        }
+
+        mIsLockoutTimerArmed = false;
+
+        lock.unlock();
+        lockoutTimerExpired();
+        lock.lock();
+    }
 }
 
 void Session::notify(const fingerprint_msg_t* msg) {
@@ -455,7 +500,11 @@ void Session::notify(const fingerprint_msg_t* msg) {
 }
 
 void Session::onCaptureReady() {
-    mCaptureReady = true;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mCaptureReady = true;
+    }
+    mCond.notify_all();
 }
 
 } // namespace fingerprint
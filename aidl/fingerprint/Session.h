@@ -11,6 +11,11 @@
 
 #include <hardware/fingerprint.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "LegacyHAL.h"
 #include "LockoutTracker.h"
 
@@ -33,6 +38,7 @@ class Session : public BnSession {
 public:
     Session(LegacyHAL hal, int userId, std::shared_ptr<ISessionCallback> cb,
             LockoutTracker lockoutTracker);
+    ~Session();
     ndk::ScopedAStatus generateChallenge() override;
     ndk::ScopedAStatus revokeChallenge(int64_t challenge) override;
     ndk::ScopedAStatus enroll(const HardwareAuthToken& hat,
@@ -74,21 +80,33 @@ public:
     void onCaptureReady();
 
 private:
+    friend class SessionTest;
+
     LegacyHAL mHal;
     LockoutTracker mLockoutTracker;
     bool mClosed = false;
-    bool mCaptureReady = false;
+    bool mForceCalibrate;
 
     Error VendorErrorFilter(int32_t error, int32_t* vendorCode);
     AcquiredInfo VendorAcquiredFilter(int32_t info, int32_t* vendorCode);
     bool checkSensorLockout();
     void clearLockout(bool clearAttemptCounter);
     void startLockoutTimer(int64_t timeout);
+    void abortLockoutTimer();
     void lockoutTimerExpired();
+    void timerLoop();
+
+    // Guards the capture ready flag and the lockout timer. mCond is signalled
+    // on capture ready, on timer (re)arm or abort, and on session teardown.
+    std::mutex mLock;
+    std::condition_variable mCond;
+    bool mCaptureReady = false;
 
-    // lockout timer
-    bool mIsLockoutTimerStarted = false;
-    bool mIsLockoutTimerAborted = false;
+    // lockout timer, fired by mTimerThread
+    bool mIsLockoutTimerArmed = false;
+    std::chrono::steady_clock::time_point mLockoutDeadline;
+    bool mTimerThreadExit = false;
+    std::thread mTimerThread;
 
     // The user ID for which this session was created.
     int32_t mUserId;
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "Session.h"
+#include "VendorConstants.h"
+
+#include <aidl/android/hardware/biometrics/fingerprint/BnSessionCallback.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+
+// Records the lockout callbacks; the rest are accepted and dropped
+class FakeSessionCallback : public BnSessionCallback {
+public:
+    ndk::ScopedAStatus onChallengeGenerated(int64_t) override { return ok(); }
+    ndk::ScopedAStatus onChallengeRevoked(int64_t) override { return ok(); }
+    ndk::ScopedAStatus onAcquired(AcquiredInfo, int32_t) override { return ok(); }
+    ndk::ScopedAStatus onError(Error, int32_t) override { return ok(); }
+    ndk::ScopedAStatus onEnrollmentProgress(int32_t, int32_t) override { return ok(); }
+    ndk::ScopedAStatus onAuthenticationSucceeded(int32_t, const HardwareAuthToken&) override {
+        return ok();
+    }
+    ndk::ScopedAStatus onAuthenticationFailed() override { return ok(); }
+    ndk::ScopedAStatus onLockoutTimed(int64_t) override { return count(&mTimed); }
+    ndk::ScopedAStatus onLockoutPermanent() override { return count(&mPermanent); }
+    ndk::ScopedAStatus onLockoutCleared() override { return count(&mCleared); }
+    ndk::ScopedAStatus onInteractionDetected() override { return ok(); }
+    ndk::ScopedAStatus onEnrollmentsEnumerated(const std::vector<int32_t>&) override {
+        return ok();
+    }
+    ndk::ScopedAStatus onEnrollmentsRemoved(const std::vector<int32_t>&) override { return ok(); }
+    ndk::ScopedAStatus onAuthenticatorIdRetrieved(int64_t) override { return ok(); }
+    ndk::ScopedAStatus onAuthenticatorIdInvalidated(int64_t) override { return ok(); }
+    ndk::ScopedAStatus onSessionClosed() override { return ok(); }
+
+    int cleared() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mCleared;
+    }
+
+    int timed() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mTimed;
+    }
+
+    int permanent() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mPermanent;
+    }
+
+    bool waitForCleared(int n, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCond.wait_for(lock, timeout, [&] { return mCleared >= n; });
+    }
+
+private:
+    static ndk::ScopedAStatus ok() { return ndk::ScopedAStatus::ok(); }
+
+    ndk::ScopedAStatus count(int* counter) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            (*counter)++;
+        }
+        mCond.notify_all();
+        return ok();
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    int mTimed = 0;
+    int mPermanent = 0;
+    int mCleared = 0;
+};
+
+// Stub vendor library: requests are recorded, and a forced calibration can
+// report capture ready from within the request like a fast sensor would
+static int sLastRequest;
+static Session* sReadyOnRequest;
+
+static int stubSetActiveGroup(uint32_t, const char*) {
+    return 0;
+}
+
+static int stubEnroll(const hw_auth_token_t*, uint32_t, uint32_t) {
+    return 0;
+}
+
+static int stubAuthenticate(uint64_t, uint32_t) {
+    return 0;
+}
+
+static int stubCancel() {
+    return 0;
+}
+
+static int stubRequest(uint32_t cmd, char*, uint32_t, char*, uint32_t, uint32_t) {
+    sLastRequest = cmd;
+    if (sReadyOnRequest)
+        sReadyOnRequest->onCaptureReady();
+    return 0;
+}
+
+class SessionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        LegacyHAL hal = {};
+        LockoutTracker lockoutTracker;
+
+        hal.ss_fingerprint_set_active_group = stubSetActiveGroup;
+        hal.ss_fingerprint_enroll = stubEnroll;
+        hal.ss_fingerprint_authenticate = stubAuthenticate;
+        hal.ss_fingerprint_cancel = stubCancel;
+        hal.ss_fingerprint_request = stubRequest;
+
+        sLastRequest = 0;
+        sReadyOnRequest = nullptr;
+        lockoutTracker.reset(true);
+
+        mCb = SharedRefBase::make<FakeSessionCallback>();
+        mSession = SharedRefBase::make<Session>(hal, 0, mCb, lockoutTracker);
+    }
+
+    void TearDown() override {
+        if (mHelper.joinable())
+            mHelper.join();
+        sReadyOnRequest = nullptr;
+    }
+
+    void setForceCalibrate(bool forceCalibrate) { mSession->mForceCalibrate = forceCalibrate; }
+
+    // Milliseconds spent in enroll()
+    long long enroll() {
+        std::shared_ptr<ICancellationSignal> cancel;
+        auto start = std::chrono::steady_clock::now();
+
+        EXPECT_TRUE(mSession->enroll(HardwareAuthToken(), &cancel).isOk());
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    }
+
+    void failAuthentication(int times) {
+        fingerprint_msg_t msg = {};
+
+        msg.type = FINGERPRINT_AUTHENTICATED;
+        msg.data.authenticated.finger.fid = 0;
+        for (int i = 0; i < times; i++)
+            mSession->notify(&msg);
+    }
+
+    std::shared_ptr<FakeSessionCallback> mCb;
+    std::shared_ptr<Session> mSession;
+    std::thread mHelper;
+};
+
+TEST_F(SessionTest, EnrollWithoutCalibrationDoesNotWait) {
+    setForceCalibrate(false);
+
+    EXPECT_LT(enroll(), 50);
+    EXPECT_EQ(0, sLastRequest);
+}
+
+TEST_F(SessionTest, EnrollWakesOnCaptureReady) {
+    setForceCalibrate(true);
+
+    mHelper = std::thread([this] {
+        std::this_thread::sleep_for(50ms);
+        mSession->onCaptureReady();
+    });
+
+    long long waited = enroll();
+    EXPECT_GE(waited, 50);
+    EXPECT_LT(waited, 150);
+    EXPECT_EQ(SEM_REQUEST_FORCE_CBGE, sLastRequest);
+}
+
+TEST_F(SessionTest, EnrollCaptureReadyBeforeWait) {
+    setForceCalibrate(true);
+    sReadyOnRequest = mSession.get();
+
+    EXPECT_LT(enroll(), 50);
+}
+
+TEST_F(SessionTest, EnrollCaptureReadyIsPerEnroll) {
+    setForceCalibrate(true);
+    sReadyOnRequest = mSession.get();
+    enroll();
+
+    // A stale capture ready from the previous enroll does not end this wait
+    sReadyOnRequest = nullptr;
+    mHelper = std::thread([this] {
+        std::this_thread::sleep_for(50ms);
+        mSession->onCaptureReady();
+    });
+    EXPECT_GE(enroll(), 50);
+}
+
+TEST_F(SessionTest, TimedLockoutExpires) {
+    failAuthentication(LOCKOUT_TIMED_THRESHOLD);
+    EXPECT_EQ(1, mCb->timed());
+    EXPECT_EQ(0, mCb->cleared());
+
+    EXPECT_TRUE(mCb->waitForCleared(1, 10 * LOCKOUT_TIMED_DURATION * 1ms));
+}
+
+TEST_F(SessionTest, ResetLockoutAbortsTimer) {
+    failAuthentication(LOCKOUT_TIMED_THRESHOLD);
+    ASSERT_TRUE(mSession->resetLockout(HardwareAuthToken()).isOk());
+    EXPECT_EQ(1, mCb->cleared());
+
+    EXPECT_FALSE(mCb->waitForCleared(2, 2 * LOCKOUT_TIMED_DURATION * 1ms));
+}
+
+TEST_F(SessionTest, PermanentLockoutAbortsTimer) {
+    failAuthentication(LOCKOUT_PERMANENT_THRESHOLD);
+    EXPECT_EQ(1, mCb->permanent());
+
+    EXPECT_FALSE(mCb->waitForCleared(1, 2 * LOCKOUT_TIMED_DURATION * 1ms));
+}
+
+TEST_F(SessionTest, DestroyWithArmedTimer) {
+    failAuthentication(LOCKOUT_TIMED_THRESHOLD);
+
+    // The timer thread is woken and joined rather than left sleeping
+    auto start = std::chrono::steady_clock::now();
+    mSession.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, LOCKOUT_TIMED_DURATION * 1ms / 2);
+    EXPECT_EQ(0, mCb->cleared());
+}
+
+} // namespace fingerprint
+} // namespace biometrics
+} // namespace hardware
+} // namespace android
+} // namespace aidl
@@ -6,7 +6,11 @@
 
 #define LOG_TAG "android.hardware.lights-service.samsung"
 
+#include <android-base/logging.h>
 #include <android-base/stringprintf.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <fstream>
 
 #include "Lights.h"
@@ -19,13 +23,35 @@ namespace android {
 namespace hardware {
 namespace light {
 
-/*
- * Write value to path and close file.
- */
-template <typename T>
-static void set(const std::string& path, const T& value) {
-    std::ofstream file(path);
-    file << value << std::endl;
+SysfsNode::SysfsNode(const std::string& path) : mPath(path) {
+    mFd.reset(TEMP_FAILURE_RETRY(open(mPath.c_str(), O_WRONLY | O_CLOEXEC)));
+}
+
+void SysfsNode::set(const std::string& value) {
+    if (mHasLastValue && value == mLastValue) {
+        return;
+    }
+
+    /*
+     * Retry the open in case the node was not there yet at start.
+     */
+    if (!mFd.ok()) {
+        mFd.reset(TEMP_FAILURE_RETRY(open(mPath.c_str(), O_WRONLY | O_CLOEXEC)));
+        if (!mFd.ok()) {
+            LOG(ERROR) << "Failed to open " << mPath;
+            return;
+        }
+    }
+
+    std::string line = value + "\n";
+    if (TEMP_FAILURE_RETRY(pwrite(mFd.get(), line.c_str(), line.size(), 0)) < 0) {
+        PLOG(ERROR) << "Failed to write " << value << " to " << mPath;
+        mHasLastValue = false;
+        return;
+    }
+
+    mLastValue = value;
+    mHasLastValue = true;
 }
 
 template <typename T>
@@ -37,7 +63,18 @@ static T get(const std::string& path, const T& def) {
     return file.fail() ? def : result;
 }
 
-Lights::Lights() {
+Lights::Lights()
+    : mBacklightNode(PANEL_BRIGHTNESS_NODE),
+#ifdef BUTTON_BRIGHTNESS_NODE
+      mButtonNode(BUTTON_BRIGHTNESS_NODE),
+#endif /* BUTTON_BRIGHTNESS_NODE */
+#ifdef LED_BLINK_NODE
+      mLedBlinkNode(LED_BLINK_NODE),
+#ifdef LED_BLN_NODE
+      mLedBlnNode(LED_BLN_NODE),
+#endif /* LED_BLN_NODE */
+#endif /* LED_BLINK_NODE */
+      mMaxBrightness(get(PANEL_MAX_BRIGHTNESS_NODE, MAX_INPUT_BRIGHTNESS)) {
     mLights.emplace(LightType::BACKLIGHT,
                     std::bind(&Lights::handleBacklight, this, std::placeholders::_1));
 #ifdef BUTTON_BRIGHTNESS_NODE
@@ -50,6 +87,17 @@ Lights::Lights() {
     mLights.emplace(LightType::ATTENTION,
                     std::bind(&Lights::handleAttention, this, std::placeholders::_1));
 #endif /* LED_BLINK_NODE */
+
+    mBacklightThread = std::thread(&Lights::backlightWriter, this);
+}
+
+Lights::~Lights() {
+    {
+        std::lock_guard<std::mutex> lock(mBacklightLock);
+        mExit = true;
+    }
+    mBacklightCond.notify_one();
+    mBacklightThread.join();
 }
 
 ndk::ScopedAStatus Lights::setLightState(int32_t id, const HwLightState& state) {
@@ -71,14 +119,39 @@ ndk::ScopedAStatus Lights::setLightState(int32_t id, const HwLightState& state)
 }
 
 void Lights::handleBacklight(const HwLightState& state) {
-    uint32_t max_brightness = get(PANEL_MAX_BRIGHTNESS_NODE, MAX_INPUT_BRIGHTNESS);
     uint32_t brightness = rgbToBrightness(state);
 
-    if (max_brightness != MAX_INPUT_BRIGHTNESS) {
-        brightness = brightness * max_brightness / MAX_INPUT_BRIGHTNESS;
+    if (mMaxBrightness != MAX_INPUT_BRIGHTNESS) {
+        brightness = brightness * mMaxBrightness / MAX_INPUT_BRIGHTNESS;
     }
 
-    set(PANEL_BRIGHTNESS_NODE, brightness);
+    {
+        std::lock_guard<std::mutex> lock(mBacklightLock);
+        mPendingBrightness = brightness;
+        mBacklightPending = true;
+    }
+    mBacklightCond.notify_one();
+}
+
+void Lights::backlightWriter() {
+    std::unique_lock<std::mutex> lock(mBacklightLock);
+
+    while (true) {
+        mBacklightCond.wait(lock, [this] { return mBacklightPending || mExit; });
+        if (mExit) {
+            break;
+        }
+
+        uint32_t brightness = mPendingBrightness;
+        mBacklightPending = false;
+
+        /*
+         * Write without the lock so new updates can queue up meanwhile.
+         */
+        lock.unlock();
+        mBacklightNode.set(brightness);
+        lock.lock();
+    }
 }
 
 #ifdef BUTTON_BRIGHTNESS_NODE
@@ -89,7 +162,7 @@ void Lights::handleButtons(const HwLightState& state) {
     uint32_t brightness = (state.color & COLOR_MASK) ? 1 : 0;
 #endif
 
-    set(BUTTON_BRIGHTNESS_NODE, brightness);
+    mButtonNode.set(brightness);
 }
 #endif
 
@@ -136,7 +209,7 @@ void Lights::setNotificationLED() {
         adjusted_brightness = LED_BRIGHTNESS_BATTERY;
         state = mBatteryState;
     } else {
-        set(LED_BLINK_NODE, "0x00000000 0 0");
+        mLedBlinkNode.set("0x00000000 0 0");
         return;
     }
 
@@ -146,12 +219,12 @@ void Lights::setNotificationLED() {
     }
 
     state.color = calibrateColor(state.color & COLOR_MASK, adjusted_brightness);
-    set(LED_BLINK_NODE, ::android::base::StringPrintf("0x%08x %d %d", state.color, state.flashOnMs,
-                                                    state.flashOffMs));
+    mLedBlinkNode.set(::android::base::StringPrintf("0x%08x %d %d", state.color, state.flashOnMs,
+                                                  state.flashOffMs));
 
 #ifdef LED_BLN_NODE
     if (bln) {
-        set(LED_BLN_NODE, (state.color & COLOR_MASK) ? 1 : 0);
+        mLedBlnNode.set((state.color & COLOR_MASK) ? 1 : 0);
     }
 #endif /* LED_BLN_NODE */
 }
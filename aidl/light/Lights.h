@@ -7,9 +7,14 @@
 #pragma once
 
 #include <aidl/android/hardware/light/BnLights.h>
+#include <android-base/unique_fd.h>
 #include <samsung_lights.h>
 
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
 
 using ::aidl::android::hardware::light::HwLightState;
@@ -20,15 +25,35 @@ namespace android {
 namespace hardware {
 namespace light {
 
+/*
+ * Sysfs node opened once and kept open. A write of the value the node was
+ * last set to is skipped.
+ */
+class SysfsNode {
+public:
+    explicit SysfsNode(const std::string& path);
+
+    void set(const std::string& value);
+    void set(uint32_t value) { set(std::to_string(value)); }
+
+private:
+    std::string mPath;
+    ::android::base::unique_fd mFd;
+    std::string mLastValue;
+    bool mHasLastValue = false;
+};
+
 class Lights : public BnLights {
 public:
     Lights();
+    ~Lights();
 
     ndk::ScopedAStatus setLightState(int32_t id, const HwLightState& state) override;
     ndk::ScopedAStatus getLights(std::vector<HwLight> *_aidl_return) override;
 
 private:
     void handleBacklight(const HwLightState& state);
+    void backlightWriter();
 #ifdef BUTTON_BRIGHTNESS_NODE
     void handleButtons(const HwLightState& state);
 #endif /* BUTTON_BRIGHTNESS_NODE */
@@ -48,6 +73,30 @@ private:
 
     std::mutex mLock;
     std::unordered_map<LightType, std::function<void(const HwLightState&)>> mLights;
+
+    SysfsNode mBacklightNode;
+#ifdef BUTTON_BRIGHTNESS_NODE
+    SysfsNode mButtonNode;
+#endif /* BUTTON_BRIGHTNESS_NODE */
+#ifdef LED_BLINK_NODE
+    SysfsNode mLedBlinkNode;
+#ifdef LED_BLN_NODE
+    SysfsNode mLedBlnNode;
+#endif /* LED_BLN_NODE */
+#endif /* LED_BLINK_NODE */
+
+    uint32_t mMaxBrightness;
+
+    /*
+     * Backlight updates are handed to a writer thread, which only ever
+     * writes the latest one; intermediate values of a ramp are dropped.
+     */
+    std::mutex mBacklightLock;
+    std::condition_variable mBacklightCond;
+    uint32_t mPendingBrightness = 0;
+    bool mBacklightPending = false;
+    bool mExit = false;
+    std::thread mBacklightThread;
 };
 
 } // namespace light
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "Lights.h"
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using ::aidl::android::hardware::light::FlashMode;
+using ::aidl::android::hardware::light::LightType;
+using ::aidl::android::hardware::light::Lights;
+using ::aidl::android::hardware::light::SysfsNode;
+using ::android::base::ReadFileToString;
+using ::android::base::Trim;
+using ::android::base::WriteStringToFile;
+
+static std::string sNodeDir;
+
+std::string lightsTestNode(const char* name) {
+    return sNodeDir + "/" + name;
+}
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class LightsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sNodeDir = mDir.path;
+        for (const char* node : {"brightness", "touchkey_brightness", "led_blink",
+                                 "notification_led"}) {
+            ASSERT_TRUE(WriteStringToFile("", lightsTestNode(node)));
+        }
+        ASSERT_TRUE(WriteStringToFile("1023\n", lightsTestNode("max_brightness")));
+    }
+
+    void TearDown() override { mLights.reset(); }
+
+    void start() { mLights = ndk::SharedRefBase::make<Lights>(); }
+
+    // pwrite() does not truncate a plain file, so only the first line is current
+    static std::string read(const char* node) {
+        std::string value;
+        EXPECT_TRUE(ReadFileToString(lightsTestNode(node), &value));
+        return Trim(value.substr(0, value.find('\n')));
+    }
+
+    // The backlight is written asynchronously
+    static bool waitFor(const char* node, const std::string& value) {
+        auto deadline = std::chrono::steady_clock::now() + 1s;
+        while (read(node) != value) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    void set(LightType type, uint32_t color, FlashMode mode = FlashMode::NONE, int32_t onMs = 0,
+             int32_t offMs = 0) {
+        HwLightState state;
+
+        state.color = color;
+        state.flashMode = mode;
+        state.flashOnMs = onMs;
+        state.flashOffMs = offMs;
+        ASSERT_TRUE(mLights->setLightState(static_cast<int32_t>(type), state).isOk());
+    }
+
+    TemporaryDir mDir;
+    std::shared_ptr<Lights> mLights;
+};
+
+TEST_F(LightsTest, SysfsNodeSkipsRepeatedValue) {
+    SysfsNode node(lightsTestNode("brightness"));
+
+    node.set(42);
+    EXPECT_EQ("42", read("brightness"));
+
+    // Clobber the node behind its back: a repeat of the last value is not written
+    ASSERT_TRUE(WriteStringToFile("7\n", lightsTestNode("brightness")));
+    node.set(42);
+    EXPECT_EQ("7", read("brightness"));
+
+    node.set(43);
+    EXPECT_EQ("43", read("brightness"));
+}
+
+TEST_F(LightsTest, SysfsNodeOpensLate) {
+    SysfsNode node(lightsTestNode("late"));
+
+    node.set(1);
+    ASSERT_TRUE(WriteStringToFile("", lightsTestNode("late")));
+    node.set(1);
+    EXPECT_EQ("1", read("late"));
+}
+
+TEST_F(LightsTest, BacklightScaledToPanelMax) {
+    start();
+
+    set(LightType::BACKLIGHT, 0xffffffff);
+    EXPECT_TRUE(waitFor("brightness", "1023"));
+
+    set(LightType::BACKLIGHT, 0xff808080);
+    EXPECT_TRUE(waitFor("brightness", std::to_string(128 * 1023 / 255)));
+}
+
+TEST_F(LightsTest, BacklightRampEndsOnLastValue) {
+    start();
+
+    for (uint32_t i = 0; i < 256; i++)
+        set(LightType::BACKLIGHT, 0xff000000 | (i * 0x010101));
+
+    EXPECT_TRUE(waitFor("brightness", "1023"));
+}
+
+TEST_F(LightsTest, Buttons) {
+    start();
+
+    set(LightType::BUTTONS, 0xff202020);
+    EXPECT_EQ("1", read("touchkey_brightness"));
+    set(LightType::BUTTONS, 0xff000000);
+    EXPECT_EQ("0", read("touchkey_brightness"));
+}
+
+TEST_F(LightsTest, NotificationLed) {
+    start();
+
+    // Battery only
+    set(LightType::BATTERY, 0xffff0000);
+    EXPECT_EQ("0x00ff0000 0 0", read("led_blink"));
+
+    // Notifications win over the battery, blue is calibrated down
+    set(LightType::NOTIFICATIONS, 0xffff00ff, FlashMode::TIMED, 500, 1000);
+    EXPECT_EQ("0x00ff007f 500 1000", read("led_blink"));
+    EXPECT_EQ("1", read("notification_led"));
+
+    set(LightType::NOTIFICATIONS, 0);
+    EXPECT_EQ("0x00ff0000 0 0", read("led_blink"));
+
+    set(LightType::BATTERY, 0);
+    EXPECT_EQ("0x00000000 0 0", read("led_blink"));
+}
+
+TEST_F(LightsTest, AttentionLed) {
+    start();
+
+    // Hardware blinking is shown as dimmed blue
+    set(LightType::ATTENTION, 0xffffffff, FlashMode::HARDWARE, 100, 200);
+    EXPECT_EQ("0x0000003f 100 200", read("led_blink"));
+
+    // Solid attention turns the LED off
+    set(LightType::ATTENTION, 0xffffffff, FlashMode::HARDWARE, 100, 0);
+    EXPECT_EQ("0x00000000 0 0", read("led_blink"));
+}
+
+TEST_F(LightsTest, Lights) {
+    std::vector<HwLight> lights;
+
+    start();
+
+    ASSERT_TRUE(mLights->getLights(&lights).isOk());
+    EXPECT_EQ(5u, lights.size());
+
+    HwLightState state;
+    EXPECT_EQ(EX_UNSUPPORTED_OPERATION,
+              mLights->setLightState(static_cast<int32_t>(LightType::KEYBOARD), state)
+                      .getExceptionCode());
+}
+
+} // namespace
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+/*
+ * Test build: every node lives in a directory the test picks at run time.
+ */
+std::string lightsTestNode(const char* name);
+
+#define PANEL_BRIGHTNESS_NODE lightsTestNode("brightness")
+#define PANEL_MAX_BRIGHTNESS_NODE lightsTestNode("max_brightness")
+#define BUTTON_BRIGHTNESS_NODE lightsTestNode("touchkey_brightness")
+#define LED_BLINK_NODE lightsTestNode("led_blink")
+#define LED_BLN_NODE lightsTestNode("notification_led")
+
+#define LED_ADJUSTMENT_R 1.0
+#define LED_ADJUSTMENT_G 1.0
+#define LED_ADJUSTMENT_B 0.5
+
+#define LED_BRIGHTNESS_BATTERY 255
+#define LED_BRIGHTNESS_NOTIFICATION 255
+#define LED_BRIGHTNESS_ATTENTION 128
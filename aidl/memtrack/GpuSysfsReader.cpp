@@ -1,11 +1,12 @@
 #include "GpuSysfsReader.h"
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <log/log.h>
+#include <stdlib.h>
+#include <unistd.h>
 
-#include <fstream>
-#include <sstream>
-
-#include "filesystem.h"
+#include <memory>
 
 #undef LOG_TAG
 #define LOG_TAG "memtrack-gpusysfsreader"
@@ -13,47 +14,157 @@
 using namespace GpuSysfsReader;
 
 namespace {
-uint64_t readNode(const std::string node, pid_t pid) {
-    std::stringstream ss;
-    if (pid)
-        ss << kSysfsDevicePath << "/" << kProcessDir << "/" << pid << "/" << node;
-    else
-        ss << kSysfsDevicePath << "/" << node;
-    const std::string path = ss.str();
-
-    if (!filesystem::exists(filesystem::path(path))) {
-        ALOGV("File not found: %s", path.c_str());
-        return 0;
+Snapshot& defaultSnapshot() {
+    static Snapshot snapshot;
+    return snapshot;
+}
+
+bool parsePid(const char* name, pid_t* pid) {
+    char* end;
+    long val = strtol(name, &end, 10);
+    if (end == name || *end != '\0' || val <= 0)
+        return false;
+
+    *pid = static_cast<pid_t>(val);
+    return true;
+}
+
+bool readValue(int fd, uint64_t* out) {
+    char buf[32];
+    ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf, sizeof(buf) - 1, 0));
+    if (len <= 0)
+        return false;
+
+    buf[len] = '\0';
+    *out = strtoull(buf, nullptr, 10);
+    return true;
+}
+} // namespace
+
+Snapshot::Snapshot(const std::string& devicePath, std::chrono::milliseconds epoch)
+    : mDevicePath(devicePath), mEpoch(epoch) {}
+
+bool Snapshot::get(pid_t pid, GpuMem* out) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    auto now = std::chrono::steady_clock::now();
+    if (!mValid || now - mLastRefresh >= mEpoch) {
+        refreshLocked();
+        mLastRefresh = now;
+        mValid = true;
     }
 
-    std::ifstream file(path.c_str());
-    if (!file.is_open()) {
-        ALOGW("Failed to open %s path", path.c_str());
-        return 0;
+    auto it = mTable.find(pid);
+    if (it == mTable.end())
+        return false;
+
+    *out = it->second;
+    return true;
+}
+
+bool Snapshot::openNodes(const std::string& dir, Nodes* nodes) {
+    nodes->total.reset(open((dir + "/" + kTotalGpuMemNode).c_str(), O_RDONLY | O_CLOEXEC));
+    nodes->dmaBuf.reset(open((dir + "/" + kDmaBufGpuMemNode).c_str(), O_RDONLY | O_CLOEXEC));
+
+    return nodes->total.ok() || nodes->dmaBuf.ok();
+}
+
+bool Snapshot::readNodes(const Nodes& nodes, GpuMem* out) {
+    bool found = false;
+
+    out->total = 0;
+    out->dmaBuf = 0;
+
+    if (nodes.total.ok())
+        found |= readValue(nodes.total.get(), &out->total);
+    if (nodes.dmaBuf.ok())
+        found |= readValue(nodes.dmaBuf.get(), &out->dmaBuf);
+
+    return found;
+}
+
+void Snapshot::refreshLocked() {
+    std::unordered_map<pid_t, Nodes> nodes;
+    GpuMem mem;
+
+    mTable.clear();
+
+    // Device-wide counters, kept under pid 0
+    auto dev = mNodes.find(0);
+    if (dev != mNodes.end()) {
+        nodes.emplace(0, std::move(dev->second));
+    } else {
+        Nodes devNodes;
+        if (openNodes(mDevicePath, &devNodes))
+            nodes.emplace(0, std::move(devNodes));
+    }
+
+    const std::string processDir = mDevicePath + "/" + kProcessDir;
+    std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(processDir.c_str()), &closedir);
+    if (!dir) {
+        ALOGV("Failed to open %s directory", processDir.c_str());
+    } else {
+        struct dirent* dent;
+        while ((dent = readdir(dir.get()))) {
+            pid_t pid;
+            if (!parsePid(dent->d_name, &pid))
+                continue;
+
+            // Reuse the descriptors of processes still alive since the last walk
+            auto it = mNodes.find(pid);
+            if (it != mNodes.end()) {
+                nodes.emplace(pid, std::move(it->second));
+                continue;
+            }
+
+            Nodes procNodes;
+            if (openNodes(processDir + "/" + dent->d_name, &procNodes))
+                nodes.emplace(pid, std::move(procNodes));
+        }
     }
 
-    uint64_t out;
-    file >> out;
-    file.close();
+    // Descriptors of exited processes are closed here
+    mNodes.swap(nodes);
 
-    return out;
+    for (auto it = mNodes.begin(); it != mNodes.end();) {
+        if (!readNodes(it->second, &mem)) {
+            // The process went away between the walk and the read
+            it = mNodes.erase(it);
+            continue;
+        }
+
+        mTable.emplace(it->first, mem);
+        ++it;
+    }
 }
-} // namespace
 
-uint64_t GpuSysfsReader::getDmaBufGpuMem(pid_t pid) { return readNode(kDmaBufGpuMemNode, pid); }
+uint64_t GpuSysfsReader::getDmaBufGpuMem(pid_t pid) {
+    GpuMem mem;
+    if (!defaultSnapshot().get(pid, &mem))
+        return 0;
+
+    return mem.dmaBuf;
+}
 
-uint64_t GpuSysfsReader::getGpuMemTotal(pid_t pid) { return readNode(kTotalGpuMemNode, pid); }
+uint64_t GpuSysfsReader::getGpuMemTotal(pid_t pid) {
+    GpuMem mem;
+    if (!defaultSnapshot().get(pid, &mem))
+        return 0;
+
+    return mem.total;
+}
 
 uint64_t GpuSysfsReader::getPrivateGpuMem(pid_t pid) {
-    auto dma_buf_size = getDmaBufGpuMem(pid);
-    auto gpu_total_size = getGpuMemTotal(pid);
+    GpuMem mem;
+    if (!defaultSnapshot().get(pid, &mem))
+        return 0;
 
-    if (dma_buf_size > gpu_total_size) {
+    if (mem.dmaBuf > mem.total) {
         ALOGE("Bug in reader, dma-buf size (%" PRIu64 ") is higher than total gpu size (%" PRIu64
               ")",
-              dma_buf_size, gpu_total_size);
+              mem.dmaBuf, mem.total);
         return 0;
     }
 
-    return gpu_total_size - dma_buf_size;
+    return mem.total - mem.dmaBuf;
 }
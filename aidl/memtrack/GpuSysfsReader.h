@@ -1,9 +1,15 @@
 
 #pragma once
 
+#include <android-base/unique_fd.h>
 #include <inttypes.h>
 #include <sys/types.h>
 
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 namespace GpuSysfsReader {
 uint64_t getDmaBufGpuMem(pid_t pid = 0);
 uint64_t getGpuMemTotal(pid_t pid = 0);
@@ -14,4 +20,44 @@ constexpr char kProcessDir[] = "kprcs";
 constexpr char kMappedDmaBufsDir[] = "dma_bufs";
 constexpr char kTotalGpuMemNode[] = "total_gpu_mem";
 constexpr char kDmaBufGpuMemNode[] = "dma_buf_gpu_mem";
+
+// How long a snapshot is served before the process directory is walked again.
+constexpr std::chrono::milliseconds kSnapshotEpoch(200);
+
+struct GpuMem {
+    uint64_t total;
+    uint64_t dmaBuf;
+};
+
+// Per-process GPU memory table. The process directory is walked at most once
+// per epoch; the nodes of every process are kept open across epochs and
+// re-read with pread(), so a sweep over all pids costs one walk instead of
+// two path lookups and opens per pid. pid 0 holds the device-wide counters.
+class Snapshot {
+public:
+    explicit Snapshot(const std::string& devicePath = kSysfsDevicePath,
+                      std::chrono::milliseconds epoch = kSnapshotEpoch);
+
+    // Returns false if the pid has no GPU memory node in the current epoch.
+    bool get(pid_t pid, GpuMem* out);
+
+private:
+    struct Nodes {
+        android::base::unique_fd total;
+        android::base::unique_fd dmaBuf;
+    };
+
+    void refreshLocked();
+    bool openNodes(const std::string& dir, Nodes* nodes);
+    bool readNodes(const Nodes& nodes, GpuMem* out);
+
+    const std::string mDevicePath;
+    const std::chrono::milliseconds mEpoch;
+
+    std::mutex mLock;
+    std::chrono::steady_clock::time_point mLastRefresh;
+    bool mValid = false;
+    std::unordered_map<pid_t, Nodes> mNodes;
+    std::unordered_map<pid_t, GpuMem> mTable;
+};
 } // namespace GpuSysfsReader
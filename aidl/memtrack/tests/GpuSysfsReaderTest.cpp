@@ -0,0 +1,151 @@
+#include "GpuSysfsReader.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace GpuSysfsReader;
+using android::base::WriteStringToFile;
+
+namespace {
+// Fake mali device tree: <root>/{total_gpu_mem,dma_buf_gpu_mem,kprcs/<pid>/...}
+class GpuSysfsReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mRoot = mDir.path;
+        ASSERT_EQ(0, mkdir((mRoot + "/" + kProcessDir).c_str(), 0755));
+        writeNodes(mRoot, 1000, 300);
+    }
+
+    static void writeNodes(const std::string& dir, uint64_t total, uint64_t dmaBuf) {
+        ASSERT_TRUE(WriteStringToFile(std::to_string(total) + "\n",
+                                      dir + "/" + kTotalGpuMemNode));
+        ASSERT_TRUE(WriteStringToFile(std::to_string(dmaBuf) + "\n",
+                                      dir + "/" + kDmaBufGpuMemNode));
+    }
+
+    std::string processDir(pid_t pid) {
+        return mRoot + "/" + kProcessDir + "/" + std::to_string(pid);
+    }
+
+    void addProcess(pid_t pid, uint64_t total, uint64_t dmaBuf) {
+        ASSERT_EQ(0, mkdir(processDir(pid).c_str(), 0755));
+        writeNodes(processDir(pid), total, dmaBuf);
+    }
+
+    void removeProcess(pid_t pid) {
+        ASSERT_EQ(0, unlink((processDir(pid) + "/" + kTotalGpuMemNode).c_str()));
+        ASSERT_EQ(0, unlink((processDir(pid) + "/" + kDmaBufGpuMemNode).c_str()));
+        ASSERT_EQ(0, rmdir(processDir(pid).c_str()));
+    }
+
+    TemporaryDir mDir;
+    std::string mRoot;
+};
+
+TEST_F(GpuSysfsReaderTest, DeviceCountersUnderPidZero) {
+    Snapshot snapshot(mRoot);
+    GpuMem mem;
+
+    ASSERT_TRUE(snapshot.get(0, &mem));
+    EXPECT_EQ(1000u, mem.total);
+    EXPECT_EQ(300u, mem.dmaBuf);
+}
+
+TEST_F(GpuSysfsReaderTest, EveryProcessInOneWalk) {
+    Snapshot snapshot(mRoot);
+    GpuMem mem;
+
+    for (pid_t pid = 100; pid < 400; pid++)
+        addProcess(pid, pid * 10, pid);
+
+    for (pid_t pid = 100; pid < 400; pid++) {
+        ASSERT_TRUE(snapshot.get(pid, &mem)) << pid;
+        EXPECT_EQ(static_cast<uint64_t>(pid) * 10, mem.total);
+        EXPECT_EQ(static_cast<uint64_t>(pid), mem.dmaBuf);
+    }
+
+    EXPECT_FALSE(snapshot.get(99, &mem));
+}
+
+TEST_F(GpuSysfsReaderTest, ServedFromSnapshotWithinEpoch) {
+    Snapshot snapshot(mRoot, std::chrono::hours(1));
+    GpuMem mem;
+
+    addProcess(100, 50, 10);
+    ASSERT_TRUE(snapshot.get(100, &mem));
+
+    // Neither new values nor new processes are seen until the epoch ends
+    writeNodes(processDir(100), 60, 20);
+    addProcess(200, 70, 30);
+
+    ASSERT_TRUE(snapshot.get(100, &mem));
+    EXPECT_EQ(50u, mem.total);
+    EXPECT_FALSE(snapshot.get(200, &mem));
+}
+
+TEST_F(GpuSysfsReaderTest, RefreshedAfterEpoch) {
+    const std::chrono::milliseconds epoch(20);
+    Snapshot snapshot(mRoot, epoch);
+    GpuMem mem;
+
+    addProcess(100, 50, 10);
+    addProcess(101, 40, 10);
+    ASSERT_TRUE(snapshot.get(100, &mem));
+
+    writeNodes(processDir(100), 60, 20);
+    addProcess(200, 70, 30);
+    removeProcess(101);
+    std::this_thread::sleep_for(epoch * 2);
+
+    // Surviving descriptors are re-read, new processes are opened,
+    // exited ones are gone
+    ASSERT_TRUE(snapshot.get(100, &mem));
+    EXPECT_EQ(60u, mem.total);
+    EXPECT_EQ(20u, mem.dmaBuf);
+    ASSERT_TRUE(snapshot.get(200, &mem));
+    EXPECT_EQ(70u, mem.total);
+    EXPECT_FALSE(snapshot.get(101, &mem));
+}
+
+TEST_F(GpuSysfsReaderTest, PartialNodes) {
+    Snapshot snapshot(mRoot);
+    GpuMem mem;
+
+    // Only the total node is present
+    ASSERT_EQ(0, mkdir(processDir(100).c_str(), 0755));
+    ASSERT_TRUE(WriteStringToFile("42", processDir(100) + "/" + kTotalGpuMemNode));
+    // Neither node is present
+    ASSERT_EQ(0, mkdir(processDir(101).c_str(), 0755));
+    // Not a pid
+    ASSERT_EQ(0, mkdir((mRoot + "/" + kProcessDir + "/self").c_str(), 0755));
+
+    ASSERT_TRUE(snapshot.get(100, &mem));
+    EXPECT_EQ(42u, mem.total);
+    EXPECT_EQ(0u, mem.dmaBuf);
+    EXPECT_FALSE(snapshot.get(101, &mem));
+}
+
+TEST_F(GpuSysfsReaderTest, NoProcessDirectory) {
+    GpuMem mem;
+
+    ASSERT_EQ(0, rmdir((mRoot + "/" + kProcessDir).c_str()));
+    Snapshot snapshot(mRoot);
+
+    ASSERT_TRUE(snapshot.get(0, &mem));
+    EXPECT_EQ(1000u, mem.total);
+    EXPECT_FALSE(snapshot.get(100, &mem));
+}
+
+TEST_F(GpuSysfsReaderTest, NoDevice) {
+    Snapshot snapshot(mRoot + "/missing");
+    GpuMem mem;
+
+    EXPECT_FALSE(snapshot.get(0, &mem));
+}
+} // namespace
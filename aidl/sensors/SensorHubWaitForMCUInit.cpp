@@ -14,29 +14,105 @@
  * limitations under the License.
  */
 
+#define LOG_TAG "sensors.sensorhub_wait_for_mcu"
+
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <string>
 #include <thread>
 
-extern "C" void* sensorsHalGetSubHal(uint32_t* version) {
-    static auto sensorsHalGetSubHalOrig = reinterpret_cast<typeof(sensorsHalGetSubHal)*>(
-            dlsym(dlopen("sensors.sensorhub.so", RTLD_NOW), "sensorsHalGetSubHal"));
+#include "SensorHubWaitForMCUInit.h"
+
+using namespace std::chrono_literals;
+
+static constexpr char kMcuTestPath[] = "/sys/devices/virtual/sensors/ssp_sensor/mcu_test";
+
+// Give up waiting after this long and let the sensor hub HAL try anyway.
+static constexpr auto kMcuInitTimeout = 60s;
+// Re-check interval when the driver does not notify changes; doubles up to the max.
+static constexpr auto kMcuPollMinDelay = 5ms;
+static constexpr auto kMcuPollMaxDelay = 200ms;
+
+static bool isMcuReady(int fd) {
+    char buf[64];
+    ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf, sizeof(buf) - 1, 0));
+
+    if (len <= 0) {
+        return false;
+    }
+
+    std::string value(buf, len);
+    value.erase(value.find_last_not_of(" \n") + 1);
+
+    return value.ends_with(",OK");
+}
+
+/*
+ * Wait until the MCU reports ready. The node is kept open and re-read on
+ * sysfs change notification (POLLPRI); since the driver may not notify,
+ * each wait is also bounded by an exponentially growing re-check delay.
+ */
+bool waitForMcuInit(const char* path, std::chrono::milliseconds timeout) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + timeout;
+    std::chrono::milliseconds delay = kMcuPollMinDelay;
+    bool ready = false;
+    int fd = -1;
 
     while (true) {
-        std::ifstream mcu_test("/sys/devices/virtual/sensors/ssp_sensor/mcu_test");
+        if (fd < 0) {
+            fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+        }
+
+        if (fd >= 0 && isMcuReady(fd)) {
+            ready = true;
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
 
-        if (mcu_test) {
-            std::string value;
-            mcu_test >> value;
+        auto timeout = std::min<std::chrono::milliseconds>(
+                delay, std::chrono::ceil<std::chrono::milliseconds>(deadline - now));
 
-            if (value.ends_with(",OK")) {
-                break;
-            }
+        if (fd >= 0) {
+            struct pollfd pfd = {.fd = fd, .events = POLLPRI | POLLERR, .revents = 0};
+            TEMP_FAILURE_RETRY(poll(&pfd, 1, timeout.count()));
+        } else {
+            std::this_thread::sleep_for(timeout);
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        delay = std::min<std::chrono::milliseconds>(delay * 2, kMcuPollMaxDelay);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    auto waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    if (ready) {
+        ALOGI("MCU ready after %lld ms", static_cast<long long>(waitedMs));
+    } else {
+        ALOGE("MCU not ready after %lld ms, continuing anyway", static_cast<long long>(waitedMs));
     }
 
+    return ready;
+}
+
+extern "C" void* sensorsHalGetSubHal(uint32_t* version) {
+    static auto sensorsHalGetSubHalOrig = reinterpret_cast<typeof(sensorsHalGetSubHal)*>(
+            dlsym(dlopen("sensors.sensorhub.so", RTLD_NOW), "sensorsHalGetSubHal"));
+
+    waitForMcuInit(kMcuTestPath, kMcuInitTimeout);
+
     return sensorsHalGetSubHalOrig(version);
 }
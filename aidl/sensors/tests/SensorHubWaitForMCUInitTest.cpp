@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SensorHubWaitForMCUInit.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using ::android::base::WriteStringToFile;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class SensorHubWaitForMCUInitTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        if (mHelper.joinable())
+            mHelper.join();
+    }
+
+    std::string node() const { return std::string(mDir.path) + "/mcu_test"; }
+
+    // Toggle the fake node from another thread, like the driver finishing init
+    void writeLater(std::chrono::milliseconds after, const std::string& value) {
+        mHelper = std::thread([this, after, value] {
+            std::this_thread::sleep_for(after);
+            WriteStringToFile(value, node());
+        });
+    }
+
+    // Milliseconds spent in waitForMcuInit(), or -1 if it timed out
+    long long wait(std::chrono::milliseconds timeout) {
+        auto start = std::chrono::steady_clock::now();
+        bool ready = waitForMcuInit(node().c_str(), timeout);
+        auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+
+        return ready ? waited.count() : -1;
+    }
+
+    TemporaryDir mDir;
+    std::thread mHelper;
+};
+
+TEST_F(SensorHubWaitForMCUInitTest, AlreadyReady) {
+    ASSERT_TRUE(WriteStringToFile("NG,NG,OK\n", node()));
+
+    long long waited = wait(1s);
+    EXPECT_GE(waited, 0);
+    EXPECT_LT(waited, 5);
+}
+
+TEST_F(SensorHubWaitForMCUInitTest, BecomesReady) {
+    ASSERT_TRUE(WriteStringToFile("NG,NG,NG\n", node()));
+    writeLater(100ms, "NG,NG,OK\n");
+
+    // Plain files never raise POLLPRI, so this relies on the re-check backoff
+    long long waited = wait(5s);
+    EXPECT_GE(waited, 100);
+    EXPECT_LT(waited, 100 + 200 + 100);
+}
+
+TEST_F(SensorHubWaitForMCUInitTest, NodeAppearsLate) {
+    writeLater(50ms, "OK,OK,OK\n");
+
+    long long waited = wait(5s);
+    EXPECT_GE(waited, 50);
+    EXPECT_LT(waited, 50 + 200 + 100);
+}
+
+TEST_F(SensorHubWaitForMCUInitTest, TimesOut) {
+    ASSERT_TRUE(WriteStringToFile("OK,OK,NG\n", node()));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(-1, wait(150ms));
+    auto waited = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(waited, 150ms);
+    EXPECT_LT(waited, 250ms);
+}
+
+TEST_F(SensorHubWaitForMCUInitTest, MissingNodeTimesOut) {
+    EXPECT_EQ(-1, wait(100ms));
+}
+
+} // namespace
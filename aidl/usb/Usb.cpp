@@ -47,7 +47,7 @@ namespace android {
 namespace hardware {
 namespace usb {
 
-constexpr char kTypecPath[] = "/sys/class/typec/";
+constexpr char kTypecPath[] = TYPEC_PATH;
 constexpr char kDataRoleNode[] = "/data_role";
 constexpr char kPowerRoleNode[] = "/power_role";
 
@@ -520,91 +520,189 @@ bool canSwitchRoleHelper(const string &portName) {
     return false;
 }
 
-Status getPortStatusHelper(std::vector<PortStatus> *currentPortStatus) {
+Status getPortStatusHelper(const string &portName, bool connected, PortStatus *portStatus) {
+    PortRole currentRole;
+
+    ALOGI("%s", portName.c_str());
+    *portStatus = PortStatus();
+    portStatus->portName = portName;
+
+    currentRole.set<PortRole::powerRole>(PortPowerRole::NONE);
+    if (getCurrentRoleHelper(portName, connected, &currentRole) == Status::SUCCESS){
+        portStatus->currentPowerRole = currentRole.get<PortRole::powerRole>();
+    } else {
+        ALOGE("Error while retrieving portNames");
+        return Status::ERROR;
+    }
+
+    currentRole.set<PortRole::dataRole>(PortDataRole::NONE);
+    if (getCurrentRoleHelper(portName, connected, &currentRole) == Status::SUCCESS) {
+        portStatus->currentDataRole = currentRole.get<PortRole::dataRole>();
+    } else {
+        ALOGE("Error while retrieving current port role");
+        return Status::ERROR;
+    }
+
+    currentRole.set<PortRole::mode>(PortMode::NONE);
+    if (getCurrentRoleHelper(portName, connected, &currentRole) == Status::SUCCESS) {
+        portStatus->currentMode = currentRole.get<PortRole::mode>();
+    } else {
+        ALOGE("Error while retrieving current data role");
+        return Status::ERROR;
+    }
+
+    bool canSwitchRole = connected ? canSwitchRoleHelper(portName) : false;
+    portStatus->canChangeMode = true;
+    portStatus->canChangeDataRole = canSwitchRole;
+    portStatus->canChangePowerRole = canSwitchRole;
+
+    portStatus->supportedModes.push_back(PortMode::DRP);
+
+    bool dataEnabled = true;
+    string usbDataEnabled = "0";
+    if (ReadFileToString(USB_DATA_PATH, &usbDataEnabled) &&
+        stoi(Trim(usbDataEnabled)) == 0) {
+        portStatus->usbDataStatus.push_back(UsbDataStatus::DISABLED_FORCE);
+        dataEnabled = false;
+    }
+    if (dataEnabled) {
+        portStatus->usbDataStatus.push_back(UsbDataStatus::ENABLED);
+    }
+
+    ALOGI("%s connected:%d canChangeMode:%d canChagedata:%d canChangePower:%d "
+          "usbDataEnabled:%d plugOrientation:%d",
+          portName.c_str(), connected, portStatus->canChangeMode,
+          portStatus->canChangeDataRole, portStatus->canChangePowerRole,
+          dataEnabled ? 1 : 0, portStatus->plugOrientation);
+
+    return Status::SUCCESS;
+}
+
+/*
+ * Rescan /sys/class/typec, drop the ports that went away and mark every
+ * port dirty. Called with usb->mLock held.
+ */
+Status markAllPortsDirtyLocked(android::hardware::usb::Usb *usb) {
     std::unordered_map<string, bool> names;
     Status result = getTypeCPortNamesHelper(&names);
-    int i = -1;
-
-    if (result == Status::SUCCESS) {
-        currentPortStatus->resize(names.size());
-        for (std::pair<string, bool> port : names) {
-            i++;
-            ALOGI("%s", port.first.c_str());
-            (*currentPortStatus)[i].portName = port.first;
-
-            PortRole currentRole;
-            currentRole.set<PortRole::powerRole>(PortPowerRole::NONE);
-            if (getCurrentRoleHelper(port.first, port.second, &currentRole) == Status::SUCCESS){
-                (*currentPortStatus)[i].currentPowerRole = currentRole.get<PortRole::powerRole>();
-            } else {
-                ALOGE("Error while retrieving portNames");
-                goto done;
-            }
 
-            currentRole.set<PortRole::dataRole>(PortDataRole::NONE);
-            if (getCurrentRoleHelper(port.first, port.second, &currentRole) == Status::SUCCESS) {
-                (*currentPortStatus)[i].currentDataRole = currentRole.get<PortRole::dataRole>();
-            } else {
-                ALOGE("Error while retrieving current port role");
-                goto done;
-            }
+    if (result != Status::SUCCESS)
+        return result;
 
-            currentRole.set<PortRole::mode>(PortMode::NONE);
-            if (getCurrentRoleHelper(port.first, port.second, &currentRole) == Status::SUCCESS) {
-                (*currentPortStatus)[i].currentMode = currentRole.get<PortRole::mode>();
-            } else {
-                ALOGE("Error while retrieving current data role");
-                goto done;
-            }
+    for (auto it = usb->mPorts.begin(); it != usb->mPorts.end();) {
+        if (names.find(it->first) == names.end())
+            it = usb->mPorts.erase(it);
+        else
+            ++it;
+    }
 
-            (*currentPortStatus)[i].canChangeMode = true;
-            (*currentPortStatus)[i].canChangeDataRole =
-                port.second ? canSwitchRoleHelper(port.first) : false;
-            (*currentPortStatus)[i].canChangePowerRole =
-                port.second ? canSwitchRoleHelper(port.first) : false;
+    for (std::pair<string, bool> port : names) {
+        Usb::PortState &state = usb->mPorts[port.first];
+        state.connected = port.second;
+        state.dirty = true;
+    }
 
-            (*currentPortStatus)[i].supportedModes.push_back(PortMode::DRP);
+    return Status::SUCCESS;
+}
 
-            bool dataEnabled = true;
-            string usbDataEnabled = "0";
-            if (ReadFileToString(USB_DATA_PATH, &usbDataEnabled) &&
-                stoi(Trim(usbDataEnabled)) == 0) {
-                (*currentPortStatus)[i].usbDataStatus.push_back(UsbDataStatus::DISABLED_FORCE);
-                dataEnabled = false;
-            }
-            if (dataEnabled) {
-                (*currentPortStatus)[i].usbDataStatus.push_back(UsbDataStatus::ENABLED);
-            }
+/*
+ * Mark only the port a typec uevent was about dirty. Called with
+ * usb->mLock held.
+ */
+void markPortDirtyLocked(android::hardware::usb::Usb *usb, const string &portName) {
+    if (access((kTypecPath + portName).c_str(), F_OK)) {
+        usb->mPorts.erase(portName);
+        return;
+    }
 
-            ALOGI("%d:%s connected:%d canChangeMode:%d canChagedata:%d canChangePower:%d "
-                  "usbDataEnabled:%d plugOrientation:%d",
-                  i, port.first.c_str(), port.second, (*currentPortStatus)[i].canChangeMode,
-                  (*currentPortStatus)[i].canChangeDataRole,
-                  (*currentPortStatus)[i].canChangePowerRole, dataEnabled ? 1 : 0,
-                  (*currentPortStatus)[i].plugOrientation);
-        }
+    Usb::PortState &state = usb->mPorts[portName];
+    state.connected = !access((kTypecPath + portName + "-partner").c_str(), F_OK);
+    state.dirty = true;
+}
 
-        return Status::SUCCESS;
+/*
+ * Read the dirty ports again and build the status list from the cache.
+ * A port that fails to read stays dirty so the next event retries it.
+ * Called with usb->mLock held.
+ */
+Status updatePortCacheLocked(android::hardware::usb::Usb *usb,
+                             std::vector<PortStatus> *currentPortStatus) {
+    Status result = Status::SUCCESS;
+
+    for (auto &port : usb->mPorts) {
+        if (!port.second.dirty)
+            continue;
+
+        if (getPortStatusHelper(port.first, port.second.connected, &port.second.status) !=
+            Status::SUCCESS) {
+            result = Status::ERROR;
+            continue;
+        }
+        port.second.dirty = false;
     }
-done:
-    return Status::ERROR;
+
+    currentPortStatus->clear();
+    for (auto &port : usb->mPorts)
+        currentPortStatus->push_back(port.second.status);
+
+    return result;
 }
 
-void queryVersionHelper(android::hardware::usb::Usb *usb,
-                        std::vector<PortStatus> *currentPortStatus) {
-    Status status;
-    pthread_mutex_lock(&usb->mLock);
-    status = getPortStatusHelper(currentPortStatus);
-    queryMoistureDetectionStatus(currentPortStatus);
-    queryNonCompliantChargerStatus(currentPortStatus);
+/*
+ * Send the status to the framework. With onlyIfChanged, a status equal to
+ * the last one sent is not sent again. Called with usb->mLock held.
+ */
+void notifyPortStatusLocked(android::hardware::usb::Usb *usb,
+                            const std::vector<PortStatus> &currentPortStatus, Status status,
+                            bool onlyIfChanged) {
+    if (onlyIfChanged && status == Status::SUCCESS && currentPortStatus == usb->mLastPortStatus) {
+        ALOGI("Port status unchanged, not notifying");
+        return;
+    }
+
     if (usb->mCallback != NULL) {
-        ScopedAStatus ret = usb->mCallback->notifyPortStatusChange(*currentPortStatus,
+        ScopedAStatus ret = usb->mCallback->notifyPortStatusChange(currentPortStatus,
             status);
         if (!ret.isOk())
             ALOGE("queryPortStatus error %s", ret.getDescription().c_str());
+        else if (status == Status::SUCCESS)
+            usb->mLastPortStatus = currentPortStatus;
     } else {
         ALOGI("Notifying userspace skipped. Callback is NULL");
     }
+}
+
+void queryVersionHelper(android::hardware::usb::Usb *usb,
+                        std::vector<PortStatus> *currentPortStatus) {
+    Status status;
+    pthread_mutex_lock(&usb->mLock);
+    status = markAllPortsDirtyLocked(usb);
+    if (status == Status::SUCCESS)
+        status = updatePortCacheLocked(usb, currentPortStatus);
+    queryMoistureDetectionStatus(currentPortStatus);
+    queryNonCompliantChargerStatus(currentPortStatus);
+    notifyPortStatusLocked(usb, *currentPortStatus, status, false);
+    pthread_mutex_unlock(&usb->mLock);
+}
+
+/*
+ * Like queryVersionHelper(), but for a uevent: only the named port is read
+ * again (none for port-less events), and the framework is only notified if
+ * the resulting status differs from the last one sent.
+ */
+void queryPortChangeHelper(android::hardware::usb::Usb *usb, const string &portName,
+                           std::vector<PortStatus> *currentPortStatus) {
+    Status status = Status::SUCCESS;
+    pthread_mutex_lock(&usb->mLock);
+    if (usb->mPorts.empty())
+        status = markAllPortsDirtyLocked(usb);
+    else if (!portName.empty())
+        markPortDirtyLocked(usb, portName);
+    if (status == Status::SUCCESS)
+        status = updatePortCacheLocked(usb, currentPortStatus);
+    queryMoistureDetectionStatus(currentPortStatus);
+    queryNonCompliantChargerStatus(currentPortStatus);
+    notifyPortStatusLocked(usb, *currentPortStatus, status, true);
     pthread_mutex_unlock(&usb->mLock);
 }
 
@@ -652,36 +750,53 @@ struct data {
     ::aidl::android::hardware::usb::Usb *usb;
 };
 
-static void uevent_event(uint32_t /*epevents*/, struct data *payload) {
-    char msg[UEVENT_MSG_LEN + 2];
-    char *cp;
-    int n;
+/*
+ * Port a typec uevent is about, from the devpath in its header, e.g.
+ * "change@/devices/.../typec/port0-partner" -> "port0". Empty if none.
+ */
+static string typecPortName(const char *header) {
+    const char *devpath = strchr(header, '@');
+    const char *base;
 
-    n = uevent_kernel_multicast_recv(payload->uevent_fd, msg, UEVENT_MSG_LEN);
-    if (n <= 0)
-        return;
-    if (n >= UEVENT_MSG_LEN) /* overflow -- discard */
-        return;
+    if (devpath == NULL)
+        return "";
+
+    base = strrchr(devpath, '/');
+    string name(base != NULL ? base + 1 : devpath + 1);
+    name = name.substr(0, name.find_first_of("-."));
+
+    return name.compare(0, strlen("port"), "port") ? "" : name;
+}
+
+void handleUevent(android::hardware::usb::Usb *usb, char *msg) {
+    char *cp;
 
-    msg[n] = '\0';
-    msg[n + 1] = '\0';
     cp = msg;
 
     while (*cp) {
         if (std::regex_match(cp, std::regex("(add)(.*)(-partner)"))) {
             ALOGI("partner added");
-            pthread_mutex_lock(&payload->usb->mPartnerLock);
-            payload->usb->mPartnerUp = true;
-            pthread_cond_signal(&payload->usb->mPartnerCV);
-            pthread_mutex_unlock(&payload->usb->mPartnerLock);
+            pthread_mutex_lock(&usb->mPartnerLock);
+            usb->mPartnerUp = true;
+            pthread_cond_signal(&usb->mPartnerCV);
+            pthread_mutex_unlock(&usb->mPartnerLock);
         } else if (!strncmp(cp, "DEVTYPE=typec_", strlen("DEVTYPE=typec_")) ||
                    !strncmp(cp, "CCIC=WATER", strlen("CCIC=WATER")) ||
                    !strncmp(cp, "CCIC=DRY", strlen("CCIC=DRY"))) {
             std::vector<PortStatus> currentPortStatus;
-            queryVersionHelper(payload->usb, &currentPortStatus);
+            if (!strncmp(cp, "DEVTYPE=typec_", strlen("DEVTYPE=typec_"))) {
+                string portName = typecPortName(msg);
+                if (portName.empty())
+                    queryVersionHelper(usb, &currentPortStatus);
+                else
+                    queryPortChangeHelper(usb, portName, &currentPortStatus);
+            } else {
+                // Moisture is not tied to a port, the role nodes did not change
+                queryPortChangeHelper(usb, "", &currentPortStatus);
+            }
 
             // Role switch is not in progress and port is in disconnected state
-            if (!pthread_mutex_trylock(&payload->usb->mRoleSwitchLock)) {
+            if (!pthread_mutex_trylock(&usb->mRoleSwitchLock)) {
                 for (unsigned long i = 0; i < currentPortStatus.size(); i++) {
                     DIR *dp =
                         opendir(string(kTypecPath +
@@ -693,7 +808,7 @@ static void uevent_event(uint32_t /*epevents*/, struct data *payload) {
                         closedir(dp);
                     }
                 }
-                pthread_mutex_unlock(&payload->usb->mRoleSwitchLock);
+                pthread_mutex_unlock(&usb->mRoleSwitchLock);
             }
             break;
         } /* advance to after the next \0 */
@@ -702,6 +817,22 @@ static void uevent_event(uint32_t /*epevents*/, struct data *payload) {
     }
 }
 
+static void uevent_event(uint32_t /*epevents*/, struct data *payload) {
+    char msg[UEVENT_MSG_LEN + 2];
+    int n;
+
+    n = uevent_kernel_multicast_recv(payload->uevent_fd, msg, UEVENT_MSG_LEN);
+    if (n <= 0)
+        return;
+    if (n >= UEVENT_MSG_LEN) /* overflow -- discard */
+        return;
+
+    msg[n] = '\0';
+    msg[n + 1] = '\0';
+
+    handleUevent(payload->usb, msg);
+}
+
 void *work(void *param) {
     int epoll_fd, uevent_fd;
     struct epoll_event ev;
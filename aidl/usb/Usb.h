@@ -20,8 +20,12 @@
 #include <android-base/file.h>
 #include <aidl/android/hardware/usb/BnUsb.h>
 #include <aidl/android/hardware/usb/BnUsbCallback.h>
+#include <aidl/android/hardware/usb/PortStatus.h>
 #include <utils/Log.h>
 
+#include <map>
+#include <vector>
+
 #define UEVENT_MSG_LEN     2048
 #define UEVENT_MAX_EVENTS  64
 // The type-c stack waits for 4.5 - 5.5 secs before declaring a port non-pd.
@@ -29,8 +33,16 @@
 // Having a margin of ~3 secs for the directory and other related bookeeping
 // structures created and uvent fired.
 #define PORT_TYPE_TIMEOUT 8
+// The sysfs paths can be pointed at a fake tree by the test build
+#ifndef TYPEC_PATH
+#define TYPEC_PATH "/sys/class/typec/"
+#endif
+#ifndef USB_DATA_PATH
 #define USB_DATA_PATH "/sys/devices/virtual/usb_notify/usb_control/usb_data_enabled"
+#endif
+#ifndef CONTAMINANT_DETECTION_PATH
 #define CONTAMINANT_DETECTION_PATH "/sys/devices/virtual/sec/ccic/water"
+#endif
 #define DISABLE_CONTAMINANT_DETECTION "vendor.usb.contaminantdisable"
 
 namespace aidl {
@@ -40,6 +52,7 @@ namespace usb {
 
 using ::aidl::android::hardware::usb::IUsbCallback;
 using ::aidl::android::hardware::usb::PortRole;
+using ::aidl::android::hardware::usb::PortStatus;
 using ::android::base::ReadFileToString;
 using ::android::base::WriteStringToFile;
 using ::android::sp;
@@ -76,10 +89,24 @@ struct Usb : public BnUsb {
     pthread_mutex_t mPartnerLock;
     // Variable to signal partner coming back online after type switch
     bool mPartnerUp;
+
+    struct PortState {
+        PortStatus status;
+        bool connected;
+        // Set when the sysfs nodes of the port have to be read again
+        bool dirty;
+    };
+    // Last read status of every typec port, keyed by port name. Protected by mLock.
+    std::map<string, PortState> mPorts;
+    // Status last sent through notifyPortStatusChange. Protected by mLock.
+    std::vector<PortStatus> mLastPortStatus;
   private:
     pthread_t mPoll;
 };
 
+// Handles one uevent message, as read from the uevent socket
+void handleUevent(Usb *usb, char *msg);
+
 } // namespace usb
 } // namespace hardware
 } // namespace android
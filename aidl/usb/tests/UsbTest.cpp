@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ftw.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "Usb.h"
+
+using ::aidl::android::hardware::usb::BnUsbCallback;
+using ::aidl::android::hardware::usb::ContaminantDetectionStatus;
+using ::aidl::android::hardware::usb::PortDataRole;
+using ::aidl::android::hardware::usb::PortMode;
+using ::aidl::android::hardware::usb::PortPowerRole;
+using ::aidl::android::hardware::usb::PortRole;
+using ::aidl::android::hardware::usb::PortStatus;
+using ::aidl::android::hardware::usb::Status;
+using ::aidl::android::hardware::usb::Usb;
+using ::android::base::ReadFileToString;
+using ::android::base::WriteStringToFile;
+using ::ndk::ScopedAStatus;
+using ::std::string;
+
+namespace {
+
+// Records every port status sent to the framework
+class FakeUsbCallback : public BnUsbCallback {
+public:
+    ScopedAStatus notifyPortStatusChange(const std::vector<PortStatus>& in_currentPortStatus,
+                                         Status in_retval) override {
+        mPortStatus.push_back(in_currentPortStatus);
+        mRetval.push_back(in_retval);
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyRoleSwitchStatus(const string&, const PortRole&, Status,
+                                         int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyEnableUsbDataStatus(const string&, bool, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyEnableUsbDataWhileDockedStatus(const string&, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyContaminantEnabledStatus(const string&, bool, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyQueryPortStatus(const string&, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyLimitPowerTransferStatus(const string&, bool, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+    ScopedAStatus notifyResetUsbPortStatus(const string&, Status, int64_t) override {
+        return ScopedAStatus::ok();
+    }
+
+    std::vector<std::vector<PortStatus>> mPortStatus;
+    std::vector<Status> mRetval;
+};
+
+int removeNode(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+/*
+ * Fake /sys/class/typec: every port and partner is a link into a devices
+ * directory, like on a real device. Uevents are replayed through
+ * handleUevent(), so no uevent socket is involved.
+ */
+class UsbTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        nftw(root().c_str(), removeNode, 16, FTW_DEPTH | FTW_PHYS);
+        ASSERT_EQ(0, mkdir(root().c_str(), 0755));
+        ASSERT_EQ(0, mkdir(TYPEC_PATH, 0755));
+        ASSERT_EQ(0, mkdir(devices().c_str(), 0755));
+        ASSERT_TRUE(WriteStringToFile("0\n", CONTAMINANT_DETECTION_PATH));
+        ASSERT_TRUE(WriteStringToFile("1\n", USB_DATA_PATH));
+
+        mUsb = ndk::SharedRefBase::make<Usb>();
+        mCallback = ndk::SharedRefBase::make<FakeUsbCallback>();
+        // Not through setCallback(), which would start the uevent thread
+        mUsb->mCallback = mCallback;
+    }
+
+    void TearDown() override { nftw(root().c_str(), removeNode, 16, FTW_DEPTH | FTW_PHYS); }
+
+    // Parent of the fake class directory, which also holds the linked devices
+    static string root() {
+        string typec(TYPEC_PATH);
+        return typec.substr(0, typec.rfind('/', typec.size() - 2) + 1);
+    }
+    static string devices() { return root() + "devices/"; }
+
+    static void link(const string& name) {
+        ASSERT_EQ(0, mkdir((devices() + name).c_str(), 0755));
+        ASSERT_EQ(0, symlink((devices() + name).c_str(), (string(TYPEC_PATH) + name).c_str()));
+    }
+
+    static void unlink(const string& name) {
+        ASSERT_EQ(0, ::unlink((string(TYPEC_PATH) + name).c_str()));
+    }
+
+    static void write(const string& name, const string& node, const string& value) {
+        ASSERT_TRUE(WriteStringToFile(value, devices() + name + "/" + node));
+    }
+
+    static void addPort(const string& port) {
+        link(port);
+        write(port, "power_role", "source [sink]\n");
+        write(port, "data_role", "host [device]\n");
+        write(port, "port_type", "[dual] source sink\n");
+    }
+
+    static void addPartner(const string& port, bool pd) {
+        link(port + "-partner");
+        write(port + "-partner", "accessory_mode", "none\n");
+        write(port + "-partner", "supports_usb_power_delivery", pd ? "yes\n" : "no\n");
+    }
+
+    // Replays a uevent made of a header and its KEY=value lines
+    void uevent(const string& header, std::initializer_list<string> lines) {
+        std::vector<char> msg(header.begin(), header.end());
+
+        msg.push_back('\0');
+        for (const string& line : lines) {
+            msg.insert(msg.end(), line.begin(), line.end());
+            msg.push_back('\0');
+        }
+        msg.push_back('\0');
+
+        handleUevent(mUsb.get(), msg.data());
+    }
+
+    void typecEvent(const string& action, const string& dev, const string& devtype) {
+        string devpath = "/devices/platform/usbpd/typec/" + dev;
+        uevent(action + "@" + devpath,
+               {"ACTION=" + action, "DEVPATH=" + devpath, "SUBSYSTEM=typec",
+                "DEVTYPE=" + devtype});
+    }
+
+    size_t notified() { return mCallback->mPortStatus.size(); }
+    const std::vector<PortStatus>& last() { return mCallback->mPortStatus.back(); }
+
+    const PortStatus* port(const string& name) {
+        for (const auto& status : last()) {
+            if (status.portName == name)
+                return &status;
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Usb> mUsb;
+    std::shared_ptr<FakeUsbCallback> mCallback;
+};
+
+TEST_F(UsbTest, QueryDisconnectedPort) {
+    addPort("port0");
+
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    ASSERT_EQ(1u, notified());
+    EXPECT_EQ(Status::SUCCESS, mCallback->mRetval.back());
+    ASSERT_EQ(1u, last().size());
+    EXPECT_EQ("port0", last()[0].portName);
+    EXPECT_EQ(PortPowerRole::NONE, last()[0].currentPowerRole);
+    EXPECT_EQ(PortDataRole::NONE, last()[0].currentDataRole);
+    EXPECT_FALSE(last()[0].canChangeDataRole);
+    EXPECT_EQ(ContaminantDetectionStatus::NOT_DETECTED, last()[0].contaminantDetectionStatus);
+}
+
+TEST_F(UsbTest, PartnerAttach) {
+    addPort("port0");
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    addPartner("port0", true);
+    typecEvent("add", "port0/port0-partner", "typec_partner");
+
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(PortPowerRole::SINK, last()[0].currentPowerRole);
+    EXPECT_EQ(PortDataRole::DEVICE, last()[0].currentDataRole);
+    EXPECT_EQ(PortMode::UFP, last()[0].currentMode);
+    EXPECT_TRUE(last()[0].canChangeDataRole);
+    EXPECT_TRUE(mUsb->mPartnerUp);
+}
+
+TEST_F(UsbTest, RepeatedEventNotNotifiedAgain) {
+    addPort("port0");
+    addPartner("port0", false);
+
+    typecEvent("change", "port0", "typec_port");
+    ASSERT_EQ(1u, notified());
+
+    // Nothing changed in sysfs
+    typecEvent("change", "port0", "typec_port");
+    typecEvent("change", "port0/port0-partner", "typec_partner");
+    EXPECT_EQ(1u, notified());
+
+    write("port0", "data_role", "[host] device\n");
+    typecEvent("change", "port0", "typec_port");
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(PortDataRole::HOST, last()[0].currentDataRole);
+}
+
+TEST_F(UsbTest, OnlyChangedPortIsRead) {
+    addPort("port0");
+    addPort("port1");
+    addPartner("port0", false);
+    addPartner("port1", false);
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    // Both ports change in sysfs, but only port1 raises an event
+    write("port0", "data_role", "[host] device\n");
+    write("port1", "data_role", "[host] device\n");
+    typecEvent("change", "port1", "typec_port");
+
+    ASSERT_EQ(2u, notified());
+    ASSERT_EQ(2u, last().size());
+    EXPECT_EQ(PortDataRole::DEVICE, port("port0")->currentDataRole);
+    EXPECT_EQ(PortDataRole::HOST, port("port1")->currentDataRole);
+
+    // An explicit query reads every port again
+    ASSERT_TRUE(mUsb->queryPortStatus(2).isOk());
+    EXPECT_EQ(PortDataRole::HOST, port("port0")->currentDataRole);
+}
+
+TEST_F(UsbTest, AltModeEventReadsItsPort) {
+    addPort("port0");
+    addPartner("port0", false);
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    write("port0", "power_role", "[source] sink\n");
+    typecEvent("add", "port0/port0.1", "typec_alternate_mode");
+
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(PortPowerRole::SOURCE, last()[0].currentPowerRole);
+}
+
+TEST_F(UsbTest, PartnerDetach) {
+    addPort("port0");
+    addPartner("port0", true);
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+    ASSERT_TRUE(last()[0].canChangeDataRole);
+
+    unlink("port0-partner");
+    typecEvent("remove", "port0/port0-partner", "typec_partner");
+
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(PortPowerRole::NONE, last()[0].currentPowerRole);
+    EXPECT_FALSE(last()[0].canChangeDataRole);
+
+    // A disconnected port is switched back to dual role
+    string portType;
+    ASSERT_TRUE(ReadFileToString(devices() + "port0/port_type", &portType));
+    EXPECT_EQ("dual", portType.substr(0, 4));
+}
+
+TEST_F(UsbTest, PortRemoved) {
+    addPort("port0");
+    addPort("port1");
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+    ASSERT_EQ(2u, last().size());
+
+    unlink("port1");
+    typecEvent("remove", "port1", "typec_port");
+
+    ASSERT_EQ(2u, notified());
+    ASSERT_EQ(1u, last().size());
+    EXPECT_EQ("port0", last()[0].portName);
+}
+
+TEST_F(UsbTest, WaterEventReadsNoPort) {
+    addPort("port0");
+    addPartner("port0", false);
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    write("port0", "data_role", "[host] device\n");
+    ASSERT_TRUE(WriteStringToFile("1\n", CONTAMINANT_DETECTION_PATH));
+    uevent("change@/devices/virtual/sec/ccic", {"ACTION=change", "CCIC=WATER"});
+
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(ContaminantDetectionStatus::DETECTED, last()[0].contaminantDetectionStatus);
+    EXPECT_EQ(PortDataRole::DEVICE, last()[0].currentDataRole);
+
+    ASSERT_TRUE(WriteStringToFile("0\n", CONTAMINANT_DETECTION_PATH));
+    uevent("change@/devices/virtual/sec/ccic", {"ACTION=change", "CCIC=DRY"});
+
+    ASSERT_EQ(3u, notified());
+    EXPECT_EQ(ContaminantDetectionStatus::NOT_DETECTED, last()[0].contaminantDetectionStatus);
+}
+
+TEST_F(UsbTest, EventWithoutPortRescans) {
+    addPort("port0");
+    ASSERT_TRUE(mUsb->queryPortStatus(1).isOk());
+
+    addPort("port1");
+    typecEvent("change", "typec", "typec_port");
+
+    ASSERT_EQ(2u, notified());
+    EXPECT_EQ(2u, last().size());
+}
+
+TEST_F(UsbTest, UnrelatedEventIgnored) {
+    addPort("port0");
+
+    uevent("change@/devices/virtual/power_supply/battery",
+           {"ACTION=change", "SUBSYSTEM=power_supply"});
+
+    EXPECT_EQ(0u, notified());
+}
+
+} // namespace
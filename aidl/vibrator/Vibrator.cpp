@@ -9,11 +9,13 @@
 #include <android-base/logging.h>
 #include <android-base/properties.h>
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <thread>
+
+#include <unistd.h>
 
 namespace aidl {
 namespace android {
@@ -31,6 +33,29 @@ static std::map<Effect, int> CP_TRIGGER_EFFECTS {
     { Effect::TICK, 50 }
 };
 
+/*
+ * Default duration (overridable by ro.vendor.vibrator_hal.<name>_duration) and
+ * relative amplitude of each primitive. A timed output motor cannot ramp, so
+ * rises and falls are rendered as a constant level.
+ */
+struct PrimitiveDefault {
+    const char* name;
+    int32_t durationMs;
+    float amplitude;
+};
+
+static std::map<CompositePrimitive, PrimitiveDefault> PRIMITIVE_DEFAULTS {
+    { CompositePrimitive::NOOP, { "noop", 0, 0 } },
+    { CompositePrimitive::CLICK, { "primitive_click", 12, AMPLITUDE_STRONG } },
+    { CompositePrimitive::THUD, { "primitive_thud", 30, AMPLITUDE_STRONG } },
+    { CompositePrimitive::SPIN, { "primitive_spin", 60, 0.75 } },
+    { CompositePrimitive::QUICK_RISE, { "primitive_quick_rise", 40, 0.75 } },
+    { CompositePrimitive::SLOW_RISE, { "primitive_slow_rise", 80, AMPLITUDE_MEDIUM } },
+    { CompositePrimitive::QUICK_FALL, { "primitive_quick_fall", 40, 0.75 } },
+    { CompositePrimitive::LIGHT_TICK, { "primitive_light_tick", 5, AMPLITUDE_MEDIUM } },
+    { CompositePrimitive::LOW_TICK, { "primitive_low_tick", 8, 0.75 } }
+};
+
 #ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
 static std::map<EffectStrength, float> DURATION_AMPLITUDE = {
     { EffectStrength::LIGHT, DURATION_AMPLITUDE_LIGHT },
@@ -62,24 +87,51 @@ static ndk::ScopedAStatus writeNode(const std::string& path, const T& value) {
 }
 
 static bool nodeExists(const std::string& path) {
-    std::ofstream f(path.c_str());
-    return f.good();
+    return access(path.c_str(), W_OK) == 0;
 }
 
 static int getIntProperty(const std::string& key, int def) {
     return ::android::base::GetIntProperty(kVibratorPropPrefix + key, def);
 }
 
-Vibrator::Vibrator() {
-    mIsTimedOutVibrator = nodeExists(VIBRATOR_TIMEOUT_PATH);
-    mHasTimedOutIntensity = nodeExists(VIBRATOR_INTENSITY_PATH);
-    mHasTimedOutEffect = nodeExists(VIBRATOR_CP_TRIGGER_PATH);
+Vibrator::Vibrator(const std::string& sysfsPath)
+    : mTimeoutPath(sysfsPath + VIBRATOR_TIMEOUT_NODE),
+      mIntensityPath(sysfsPath + VIBRATOR_INTENSITY_NODE),
+      mCpTriggerPath(sysfsPath + VIBRATOR_CP_TRIGGER_NODE) {
+    mIsTimedOutVibrator = nodeExists(mTimeoutPath);
+    mHasTimedOutIntensity = nodeExists(mIntensityPath);
+    mHasTimedOutEffect = nodeExists(mCpTriggerPath);
+
+    for (const auto& primitive : PRIMITIVE_DEFAULTS) {
+        size_t index = static_cast<size_t>(primitive.first);
+        if (mPrimitives.size() <= index)
+            mPrimitives.resize(index + 1, { -1, 0 });
+
+        mPrimitives[index] = {
+            getIntProperty(std::string(primitive.second.name) + kVibratorPropDuration,
+                           primitive.second.durationMs),
+            primitive.second.amplitude
+        };
+    }
+
+    mSchedulerThread = std::thread(&Vibrator::schedulerLoop, this);
+}
+
+Vibrator::~Vibrator() {
+    {
+        std::lock_guard<std::mutex> lock{mSchedulerMutex};
+        mSchedulerExit = true;
+    }
+    mSchedulerCv.notify_one();
+    mSchedulerThread.join();
 }
 
 ndk::ScopedAStatus Vibrator::getCapabilities(int32_t* _aidl_return) {
     *_aidl_return = IVibrator::CAP_ON_CALLBACK | IVibrator::CAP_PERFORM_CALLBACK |
-                    IVibrator::CAP_EXTERNAL_CONTROL /*| IVibrator::CAP_COMPOSE_EFFECTS |
-                    IVibrator::CAP_ALWAYS_ON_CONTROL*/;
+                    IVibrator::CAP_EXTERNAL_CONTROL /*| IVibrator::CAP_ALWAYS_ON_CONTROL*/;
+
+    if (mIsTimedOutVibrator)
+        *_aidl_return |= IVibrator::CAP_COMPOSE_EFFECTS;
 
 #ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
     *_aidl_return |= IVibrator::CAP_AMPLITUDE_CONTROL | IVibrator::CAP_EXTERNAL_AMPLITUDE_CONTROL;
@@ -92,14 +144,16 @@ ndk::ScopedAStatus Vibrator::getCapabilities(int32_t* _aidl_return) {
 }
 
 ndk::ScopedAStatus Vibrator::off() {
+    startEffect();
     return activate(0);
 }
 
 ndk::ScopedAStatus Vibrator::on(int32_t timeoutMs, const std::shared_ptr<IVibratorCallback>& callback) {
     ndk::ScopedAStatus status;
+    uint64_t generation = startEffect();
 
     if (mHasTimedOutEffect)
-        writeNode(VIBRATOR_CP_TRIGGER_PATH, 0); // Clear all effects
+        writeNode(mCpTriggerPath, 0); // Clear all effects
 
 #ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
     timeoutMs *= mDurationAmplitude;
@@ -107,16 +161,8 @@ ndk::ScopedAStatus Vibrator::on(int32_t timeoutMs, const std::shared_ptr<IVibrat
 
     status = activate(timeoutMs);
 
-    if (callback != nullptr) {
-        std::thread([=] {
-            LOG(DEBUG) << "Starting on on another thread";
-            usleep(timeoutMs * 1000);
-            LOG(DEBUG) << "Notifying on complete";
-            if (!callback->onComplete().isOk()) {
-                LOG(ERROR) << "Failed to call onComplete";
-            }
-        }).detach();
-    }
+    if (callback != nullptr)
+        scheduleCompletion(generation, timeoutMs, callback);
 
     return status;
 }
@@ -129,14 +175,16 @@ ndk::ScopedAStatus Vibrator::perform(Effect effect, EffectStrength strength, con
     if (!status.isOk())
         return status;
 
+    uint64_t generation = startEffect();
+
     activate(0);
     setAmplitude(amplitude);
 
     if (mHasTimedOutEffect && CP_TRIGGER_EFFECTS.find(effect) != CP_TRIGGER_EFFECTS.end()) {
-        writeNode(VIBRATOR_CP_TRIGGER_PATH, CP_TRIGGER_EFFECTS[effect]);
+        writeNode(mCpTriggerPath, CP_TRIGGER_EFFECTS[effect]);
     } else {
         if (mHasTimedOutEffect)
-            writeNode(VIBRATOR_CP_TRIGGER_PATH, 0); // Clear previous effect
+            writeNode(mCpTriggerPath, 0); // Clear previous effect
 
         ms = effectToMs(effect, &status);
 
@@ -150,14 +198,8 @@ ndk::ScopedAStatus Vibrator::perform(Effect effect, EffectStrength strength, con
 
     status = activate(ms);
 
-    if (callback != nullptr) {
-        std::thread([=] {
-            LOG(DEBUG) << "Starting perform on another thread";
-            usleep(ms * 1000);
-            LOG(DEBUG) << "Notifying perform complete";
-            callback->onComplete();
-        }).detach();
-    }
+    if (callback != nullptr)
+        scheduleCompletion(generation, ms, callback);
 
     *_aidl_return = ms;
     return status;
@@ -193,7 +235,7 @@ ndk::ScopedAStatus Vibrator::setAmplitude(float amplitude) {
     LOG(DEBUG) << "Setting intensity: " << intensity;
 
     if (mHasTimedOutIntensity) {
-        return writeNode(VIBRATOR_INTENSITY_PATH, intensity);
+        return writeNode(mIntensityPath, intensity);
     }
 #endif
 
@@ -212,24 +254,81 @@ ndk::ScopedAStatus Vibrator::setExternalControl(bool enabled) {
     return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::getCompositionDelayMax(int32_t* /*_aidl_return*/) {
-    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+ndk::ScopedAStatus Vibrator::getCompositionDelayMax(int32_t* _aidl_return) {
+    *_aidl_return = COMPOSE_DELAY_MAX_MS;
+    return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::getCompositionSizeMax(int32_t* /*_aidl_return*/) {
-    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+ndk::ScopedAStatus Vibrator::getCompositionSizeMax(int32_t* _aidl_return) {
+    *_aidl_return = COMPOSE_SIZE_MAX;
+    return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::getSupportedPrimitives(std::vector<CompositePrimitive>* /*_aidl_return*/) {
-    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+ndk::ScopedAStatus Vibrator::getSupportedPrimitives(std::vector<CompositePrimitive>* _aidl_return) {
+    _aidl_return->clear();
+
+    for (size_t i = 0; i < mPrimitives.size(); i++) {
+        if (mPrimitives[i].durationMs >= 0)
+            _aidl_return->push_back(static_cast<CompositePrimitive>(i));
+    }
+
+    return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::getPrimitiveDuration(CompositePrimitive /*primitive*/, int32_t* /*_aidl_return*/) {
-    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+ndk::ScopedAStatus Vibrator::getPrimitiveDuration(CompositePrimitive primitive, int32_t* _aidl_return) {
+    size_t index = static_cast<size_t>(primitive);
+
+    if (index >= mPrimitives.size() || mPrimitives[index].durationMs < 0)
+        return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+
+    *_aidl_return = mPrimitives[index].durationMs;
+    return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::compose(const std::vector<CompositeEffect>& /*composite*/, const std::shared_ptr<IVibratorCallback>& /*callback*/) {
-    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+ndk::ScopedAStatus Vibrator::compose(const std::vector<CompositeEffect>& composite, const std::shared_ptr<IVibratorCallback>& callback) {
+    std::vector<WriteStep> plan;
+    uint32_t totalMs;
+
+    if (!mIsTimedOutVibrator)
+        return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+
+    if (composite.size() > COMPOSE_SIZE_MAX)
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+
+    for (const auto& effect : composite) {
+        size_t index = static_cast<size_t>(effect.primitive);
+
+        if (effect.delayMs < 0 || effect.delayMs > COMPOSE_DELAY_MAX_MS)
+            return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+
+        if (effect.scale < 0.0f || effect.scale > 1.0f)
+            return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+
+        if (index >= mPrimitives.size() || mPrimitives[index].durationMs < 0)
+            return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+    }
+
+    plan = renderComposition(composite, &totalMs);
+
+    LOG(DEBUG) << "Composing " << composite.size() << " primitives into " << plan.size()
+               << " writes over " << totalMs << "ms";
+
+    uint64_t generation = startEffect();
+
+    if (mHasTimedOutEffect)
+        writeNode(mCpTriggerPath, 0); // Clear all effects
+
+    // The whole plan runs on the scheduler thread, relative to one start time
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& step : plan) {
+        schedule(generation, start + std::chrono::milliseconds(step.offsetMs),
+                 [this, step] { runWriteStep(step); });
+    }
+
+    if (callback != nullptr)
+        scheduleCompletion(generation, totalMs, callback);
+
+    return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Vibrator::getSupportedAlwaysOnEffects(std::vector<Effect>* /*_aidl_return*/) {
@@ -280,13 +379,77 @@ ndk::ScopedAStatus Vibrator::composePwle(const std::vector<PrimitivePwle>& /*com
     return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
 }
 
+/*
+ * Supersede whatever effect is in flight: its queued tasks are dropped.
+ */
+uint64_t Vibrator::startEffect() {
+    std::lock_guard<std::mutex> lock{mSchedulerMutex};
+
+    mTasks = {};
+    return ++mGeneration;
+}
+
+void Vibrator::schedule(uint64_t generation, std::chrono::steady_clock::time_point deadline,
+                        std::function<void()> action) {
+    {
+        std::lock_guard<std::mutex> lock{mSchedulerMutex};
+        if (generation != mGeneration) {
+            LOG(DEBUG) << "Dropping task of superseded effect " << generation;
+            return;
+        }
+
+        mTasks.push({deadline, mSequence++, generation, std::move(action)});
+    }
+    mSchedulerCv.notify_one();
+}
+
+void Vibrator::scheduleCompletion(uint64_t generation, uint32_t delayMs,
+                                  const std::shared_ptr<IVibratorCallback>& callback) {
+    schedule(generation, std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs),
+             [callback] {
+        LOG(DEBUG) << "Notifying on complete";
+        if (!callback->onComplete().isOk()) {
+            LOG(ERROR) << "Failed to call onComplete";
+        }
+    });
+}
+
+void Vibrator::schedulerLoop() {
+    std::unique_lock<std::mutex> lock{mSchedulerMutex};
+
+    while (!mSchedulerExit) {
+        if (mTasks.empty()) {
+            mSchedulerCv.wait(lock);
+            continue;
+        }
+
+        auto deadline = mTasks.top().deadline;
+        if (std::chrono::steady_clock::now() < deadline) {
+            // Woken early by a new task, a new effect or exit; re-evaluate
+            mSchedulerCv.wait_until(lock, deadline);
+            continue;
+        }
+
+        ScheduledTask task = std::move(const_cast<ScheduledTask&>(mTasks.top()));
+        mTasks.pop();
+
+        if (task.generation != mGeneration)
+            continue;
+
+        // Run without the lock so the action may start a new effect
+        lock.unlock();
+        task.action();
+        lock.lock();
+    }
+}
+
 ndk::ScopedAStatus Vibrator::activate(uint32_t timeoutMs) {
     std::lock_guard<std::mutex> lock{mMutex};
     if (!mIsTimedOutVibrator) {
         return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
     }
 
-    return writeNode(VIBRATOR_TIMEOUT_PATH, timeoutMs);
+    return writeNode(mTimeoutPath, timeoutMs);
 }
 
 float Vibrator::strengthToAmplitude(EffectStrength strength, ndk::ScopedAStatus* status) {
@@ -321,6 +484,57 @@ uint32_t Vibrator::effectToMs(Effect effect, ndk::ScopedAStatus* status) {
     return 0;
 }
 
+/*
+ * Render a composition into timed writes. Back-to-back primitives at the same
+ * level are merged into a single enable write.
+ */
+std::vector<Vibrator::WriteStep> Vibrator::renderComposition(const std::vector<CompositeEffect>& composite,
+                                                             uint32_t* totalMs) {
+    std::vector<WriteStep> plan;
+    uint32_t offsetMs = 0;
+
+    for (const auto& effect : composite) {
+        const Primitive& primitive = mPrimitives[static_cast<size_t>(effect.primitive)];
+        float amplitude = effect.scale * primitive.amplitude;
+        uint32_t durationMs = primitive.durationMs;
+        uint32_t intensity;
+
+        offsetMs += effect.delayMs;
+
+        if (durationMs == 0 || amplitude <= 0.0f) {
+            offsetMs += durationMs;
+            continue;
+        }
+
+#ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
+        durationMs *= durationAmplitude(amplitude);
+#endif
+
+        intensity = std::max<uint32_t>(amplitude * INTENSITY_MAX, INTENSITY_MIN);
+
+        if (!plan.empty() && plan.back().intensity == intensity &&
+            plan.back().offsetMs + plan.back().durationMs == offsetMs) {
+            plan.back().durationMs += durationMs;
+        } else {
+            plan.push_back({ offsetMs, intensity, durationMs });
+        }
+
+        offsetMs += primitive.durationMs;
+    }
+
+    *totalMs = offsetMs;
+    return plan;
+}
+
+void Vibrator::runWriteStep(const WriteStep& step) {
+#ifndef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
+    if (mHasTimedOutIntensity)
+        writeNode(mIntensityPath, step.intensity);
+#endif
+
+    activate(step.durationMs);
+}
+
 #ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
 float Vibrator::durationAmplitude(float amplitude) {
     if (amplitude == 1) {
@@ -8,6 +8,15 @@
 
 #include <aidl/android/hardware/vibrator/BnVibrator.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
 #define INTENSITY_MIN 1000
 #define INTENSITY_MAX 10000
 #define INTENSITY_DEFAULT INTENSITY_MAX
@@ -22,9 +31,13 @@
 #define DURATION_AMPLITUDE_STRONG 1
 #endif
 
-#define VIBRATOR_TIMEOUT_PATH "/sys/class/timed_output/vibrator/enable"
-#define VIBRATOR_INTENSITY_PATH "/sys/class/timed_output/vibrator/intensity"
-#define VIBRATOR_CP_TRIGGER_PATH "/sys/class/timed_output/vibrator/cp_trigger_index"
+#define COMPOSE_DELAY_MAX_MS 1000
+#define COMPOSE_SIZE_MAX 256
+
+#define VIBRATOR_SYSFS_PATH "/sys/class/timed_output/vibrator"
+#define VIBRATOR_TIMEOUT_NODE "/enable"
+#define VIBRATOR_INTENSITY_NODE "/intensity"
+#define VIBRATOR_CP_TRIGGER_NODE "/cp_trigger_index"
 
 using ::aidl::android::hardware::vibrator::IVibratorCallback;
 using ::aidl::android::hardware::vibrator::Braking;
@@ -41,7 +54,8 @@ namespace vibrator {
 
 class Vibrator : public BnVibrator {
 public:
-    Vibrator();
+    explicit Vibrator(const std::string& sysfsPath = VIBRATOR_SYSFS_PATH);
+    ~Vibrator();
     ndk::ScopedAStatus getCapabilities(int32_t* _aidl_return) override;
     ndk::ScopedAStatus off() override;
     ndk::ScopedAStatus on(int32_t timeoutMs, const std::shared_ptr<IVibratorCallback>& callback) override;
@@ -68,8 +82,40 @@ public:
     ndk::ScopedAStatus composePwle(const std::vector<PrimitivePwle>& composite, const std::shared_ptr<IVibratorCallback>& callback) override;
 
 private:
+    struct ScheduledTask {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t sequence;
+        uint64_t generation;
+        std::function<void()> action;
+    };
+
+    // One write of the rendered composition, relative to its start
+    struct WriteStep {
+        uint32_t offsetMs;
+        uint32_t intensity;
+        uint32_t durationMs;
+    };
+
+    struct LaterDeadline {
+        bool operator()(const ScheduledTask& a, const ScheduledTask& b) const {
+            if (a.deadline != b.deadline)
+                return a.deadline > b.deadline;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    uint64_t startEffect();
+    void schedule(uint64_t generation, std::chrono::steady_clock::time_point deadline,
+                  std::function<void()> action);
+    void scheduleCompletion(uint64_t generation, uint32_t delayMs,
+                            const std::shared_ptr<IVibratorCallback>& callback);
+    void schedulerLoop();
+
     ndk::ScopedAStatus activate(uint32_t ms);
     uint32_t effectToMs(Effect effect, ndk::ScopedAStatus* status);
+    std::vector<WriteStep> renderComposition(const std::vector<CompositeEffect>& composite,
+                                             uint32_t* totalMs);
+    void runWriteStep(const WriteStep& step);
     static float strengthToAmplitude(EffectStrength strength, ndk::ScopedAStatus* status);
 
 #ifdef VIBRATOR_SUPPORTS_DURATION_AMPLITUDE_CONTROL
@@ -81,9 +127,31 @@ private:
     bool mExternalControl{false};
     std::mutex mMutex;
 
+    const std::string mTimeoutPath;
+    const std::string mIntensityPath;
+    const std::string mCpTriggerPath;
+
     bool mIsTimedOutVibrator;
     bool mHasTimedOutIntensity;
     bool mHasTimedOutEffect;
+
+    // Indexed by CompositePrimitive, filled once at start; durationMs < 0 if unsupported
+    struct Primitive {
+        int32_t durationMs;
+        float amplitude;
+    };
+    std::vector<Primitive> mPrimitives;
+
+    // Single scheduler thread for effect completions. Every new effect (or
+    // off()) bumps the generation, which drops whatever the previous effect
+    // still had queued, so only the latest effect's onComplete can fire.
+    std::mutex mSchedulerMutex;
+    std::condition_variable mSchedulerCv;
+    std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, LaterDeadline> mTasks;
+    uint64_t mGeneration{0};
+    uint64_t mSequence{0};
+    bool mSchedulerExit{false};
+    std::thread mSchedulerThread;
 };
 
 } // namespace vibrator
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "Vibrator.h"
+
+#include <aidl/android/hardware/vibrator/BnVibratorCallback.h>
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using ::aidl::android::hardware::vibrator::BnVibratorCallback;
+using ::aidl::android::hardware::vibrator::IVibrator;
+using ::aidl::android::hardware::vibrator::Vibrator;
+using ::android::base::ReadFileToString;
+using ::android::base::Trim;
+using ::android::base::WriteStringToFile;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class FakeCallback : public BnVibratorCallback {
+public:
+    ndk::ScopedAStatus onComplete() override {
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            mCompleted++;
+            mCompletedAt = std::chrono::steady_clock::now();
+        }
+        mCv.notify_all();
+        return ndk::ScopedAStatus::ok();
+    }
+
+    bool waitCompleted(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock{mMutex};
+        return mCv.wait_for(lock, timeout, [this] { return mCompleted > 0; });
+    }
+
+    int completed() {
+        std::lock_guard<std::mutex> lock{mMutex};
+        return mCompleted;
+    }
+
+    std::chrono::steady_clock::time_point completedAt() {
+        std::lock_guard<std::mutex> lock{mMutex};
+        return mCompletedAt;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    int mCompleted = 0;
+    std::chrono::steady_clock::time_point mCompletedAt;
+};
+
+// Fake timed output motor with enable and intensity nodes
+class VibratorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(WriteStringToFile("0\n", node(VIBRATOR_TIMEOUT_NODE)));
+        ASSERT_TRUE(WriteStringToFile("0\n", node(VIBRATOR_INTENSITY_NODE)));
+        mVibrator = ndk::SharedRefBase::make<Vibrator>(mDir.path);
+    }
+
+    void TearDown() override { mVibrator.reset(); }
+
+    std::string node(const char* name) { return std::string(mDir.path) + name; }
+
+    std::string read(const char* name) {
+        std::string value;
+        EXPECT_TRUE(ReadFileToString(node(name), &value));
+        return Trim(value);
+    }
+
+    TemporaryDir mDir;
+    std::shared_ptr<Vibrator> mVibrator;
+};
+
+TEST_F(VibratorTest, OnCompletesAfterTimeout) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+    auto start = std::chrono::steady_clock::now();
+
+    ASSERT_TRUE(mVibrator->on(30, callback).isOk());
+    EXPECT_EQ("30", read(VIBRATOR_TIMEOUT_NODE));
+
+    ASSERT_TRUE(callback->waitCompleted(1s));
+    EXPECT_GE(callback->completedAt() - start, 30ms);
+    EXPECT_EQ(1, callback->completed());
+}
+
+TEST_F(VibratorTest, OffCancelsCompletion) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+
+    ASSERT_TRUE(mVibrator->on(30, callback).isOk());
+    ASSERT_TRUE(mVibrator->off().isOk());
+    EXPECT_EQ("0", read(VIBRATOR_TIMEOUT_NODE));
+
+    EXPECT_FALSE(callback->waitCompleted(100ms));
+}
+
+TEST_F(VibratorTest, OnlyLatestEffectCompletes) {
+    std::vector<std::shared_ptr<FakeCallback>> callbacks;
+    int32_t ms;
+
+    // A burst of overlapping effects, each superseding the previous one
+    for (int i = 0; i < 20; i++) {
+        callbacks.push_back(ndk::SharedRefBase::make<FakeCallback>());
+        ASSERT_TRUE(mVibrator->perform(Effect::CLICK, EffectStrength::MEDIUM, callbacks.back(),
+                                       &ms).isOk());
+        std::this_thread::sleep_for(2ms);
+    }
+
+    ASSERT_TRUE(callbacks.back()->waitCompleted(1s));
+    std::this_thread::sleep_for(50ms);
+
+    for (int i = 0; i < 19; i++)
+        EXPECT_EQ(0, callbacks[i]->completed()) << i;
+    EXPECT_EQ(1, callbacks.back()->completed());
+}
+
+TEST_F(VibratorTest, CompletionsRunInDeadlineOrder) {
+    auto slow = ndk::SharedRefBase::make<FakeCallback>();
+    auto fast = ndk::SharedRefBase::make<FakeCallback>();
+    int32_t ms;
+
+    // A shorter effect started after a longer one replaces it
+    ASSERT_TRUE(mVibrator->on(200, slow).isOk());
+    ASSERT_TRUE(mVibrator->perform(Effect::TICK, EffectStrength::STRONG, fast, &ms).isOk());
+
+    ASSERT_TRUE(fast->waitCompleted(1s));
+    EXPECT_FALSE(slow->waitCompleted(300ms));
+}
+
+TEST_F(VibratorTest, DestroyWithPendingCompletion) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+
+    ASSERT_TRUE(mVibrator->on(1000, callback).isOk());
+    mVibrator.reset();
+
+    EXPECT_EQ(0, callback->completed());
+}
+
+TEST_F(VibratorTest, ComposeCapabilities) {
+    std::vector<CompositePrimitive> primitives;
+    int32_t caps, durationMs;
+
+    ASSERT_TRUE(mVibrator->getCapabilities(&caps).isOk());
+    EXPECT_NE(0, caps & IVibrator::CAP_COMPOSE_EFFECTS);
+
+    ASSERT_TRUE(mVibrator->getSupportedPrimitives(&primitives).isOk());
+    EXPECT_EQ(9u, primitives.size());
+    ASSERT_TRUE(mVibrator->getPrimitiveDuration(CompositePrimitive::CLICK, &durationMs).isOk());
+    EXPECT_EQ(12, durationMs);
+    ASSERT_TRUE(mVibrator->getPrimitiveDuration(CompositePrimitive::NOOP, &durationMs).isOk());
+    EXPECT_EQ(0, durationMs);
+
+    // Without a timed output node there is nothing to compose on
+    TemporaryDir empty;
+    auto vibrator = ndk::SharedRefBase::make<Vibrator>(empty.path);
+    ASSERT_TRUE(vibrator->getCapabilities(&caps).isOk());
+    EXPECT_EQ(0, caps & IVibrator::CAP_COMPOSE_EFFECTS);
+    EXPECT_EQ(EX_UNSUPPORTED_OPERATION,
+              vibrator->compose({{0, CompositePrimitive::CLICK, 1}}, nullptr).getExceptionCode());
+}
+
+TEST_F(VibratorTest, ComposeMergesBackToBackPrimitives) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+    auto start = std::chrono::steady_clock::now();
+
+    // Both at full strength, so a single 12 + 30ms write
+    ASSERT_TRUE(mVibrator->compose({{0, CompositePrimitive::CLICK, 1},
+                                    {0, CompositePrimitive::THUD, 1}}, callback).isOk());
+
+    ASSERT_TRUE(callback->waitCompleted(1s));
+    EXPECT_GE(callback->completedAt() - start, 42ms);
+    EXPECT_EQ("42", read(VIBRATOR_TIMEOUT_NODE));
+    EXPECT_EQ("10000", read(VIBRATOR_INTENSITY_NODE));
+}
+
+TEST_F(VibratorTest, ComposeRunsDelayedSteps) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+    auto start = std::chrono::steady_clock::now();
+
+    ASSERT_TRUE(mVibrator->compose({{0, CompositePrimitive::CLICK, 1},
+                                    {20, CompositePrimitive::LIGHT_TICK, 0.5}}, callback).isOk());
+
+    // The click is written at once, the tick once its delay has passed
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ("12", read(VIBRATOR_TIMEOUT_NODE));
+
+    ASSERT_TRUE(callback->waitCompleted(1s));
+    EXPECT_GE(callback->completedAt() - start, 37ms);
+    EXPECT_EQ("5", read(VIBRATOR_TIMEOUT_NODE));
+    EXPECT_EQ("2500", read(VIBRATOR_INTENSITY_NODE));
+}
+
+TEST_F(VibratorTest, ComposeSilentPrimitives) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+
+    ASSERT_TRUE(mVibrator->compose({{10, CompositePrimitive::NOOP, 1},
+                                    {0, CompositePrimitive::CLICK, 0}}, callback).isOk());
+
+    ASSERT_TRUE(callback->waitCompleted(1s));
+    EXPECT_EQ("0", read(VIBRATOR_TIMEOUT_NODE));
+}
+
+TEST_F(VibratorTest, OffCancelsRestOfComposition) {
+    auto callback = ndk::SharedRefBase::make<FakeCallback>();
+
+    ASSERT_TRUE(mVibrator->compose({{0, CompositePrimitive::CLICK, 1},
+                                    {100, CompositePrimitive::THUD, 0.5}}, callback).isOk());
+    std::this_thread::sleep_for(20ms);
+    ASSERT_TRUE(mVibrator->off().isOk());
+
+    EXPECT_FALSE(callback->waitCompleted(300ms));
+    EXPECT_EQ("0", read(VIBRATOR_TIMEOUT_NODE));
+}
+
+TEST_F(VibratorTest, ComposeRejectsBadRequests) {
+    std::vector<CompositeEffect> tooLong(COMPOSE_SIZE_MAX + 1, {0, CompositePrimitive::CLICK, 1});
+
+    EXPECT_EQ(EX_ILLEGAL_ARGUMENT, mVibrator->compose(tooLong, nullptr).getExceptionCode());
+    EXPECT_EQ(EX_ILLEGAL_ARGUMENT,
+              mVibrator->compose({{-1, CompositePrimitive::CLICK, 1}}, nullptr).getExceptionCode());
+    EXPECT_EQ(EX_ILLEGAL_ARGUMENT,
+              mVibrator->compose({{COMPOSE_DELAY_MAX_MS + 1, CompositePrimitive::CLICK, 1}},
+                                 nullptr).getExceptionCode());
+    EXPECT_EQ(EX_ILLEGAL_ARGUMENT,
+              mVibrator->compose({{0, CompositePrimitive::CLICK, 1.5}}, nullptr).getExceptionCode());
+
+    // Nothing was started
+    EXPECT_EQ("0", read(VIBRATOR_TIMEOUT_NODE));
+}
+
+} // namespace
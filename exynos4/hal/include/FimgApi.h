@@ -90,6 +90,46 @@ struct Fimg {
     float           matrixSy;
 };
 
+/*
+ * Command list for batched blits.
+ *
+ * Each entry keeps its own copy of the blit and of the images it refers to,
+ * so the caller's fimg2d_image structs need not outlive addFimgCmdList().
+ * A submitted list keeps its entries and can be submitted again as is
+ * (e.g. per-frame HDMI rotation with only the buffer addresses patched),
+ * or cleared with resetFimgCmdList() and refilled.
+ *
+ * submitFimgCmdList() queues the whole list under one device lock and
+ * stores a fence in list->fence; waitFimgFence(list->fence) returns once
+ * every blit of that submit (and of all earlier ones) has completed.
+ *
+ * A fence carries the generation of the instance that issued it and is
+ * only known to that instance. Once the instance is destroyed (e.g. by the
+ * auto free thread), waiting on its fences fails instead of guessing.
+ */
+#define FIMG_CMD_LIST_MAX   (16)
+
+#define FIMG_FENCE_SEQ_BITS (24)
+#define FIMG_FENCE_SEQ_MASK ((1U << FIMG_FENCE_SEQ_BITS) - 1)
+#define FIMG_FENCE_GEN_MASK (0xff)
+#define FIMG_FENCE(gen, seq) (((gen) << FIMG_FENCE_SEQ_BITS) | ((seq) & FIMG_FENCE_SEQ_MASK))
+#define FIMG_FENCE_GEN(fence) ((fence) >> FIMG_FENCE_SEQ_BITS)
+#define FIMG_FENCE_SEQ(fence) ((fence) & FIMG_FENCE_SEQ_MASK)
+
+struct fimg2d_cmd {
+    struct fimg2d_blit  blit;
+    struct fimg2d_image src;
+    struct fimg2d_image msk;
+    struct fimg2d_image tmp;
+    struct fimg2d_image dst;
+};
+
+struct FimgCmdList {
+    unsigned int        count;
+    unsigned int        fence;  // fence of the last submit, 0 if never submitted
+    struct fimg2d_cmd   cmd[FIMG_CMD_LIST_MAX];
+};
+
 #ifdef __cplusplus
 
 struct blit_op_table {
@@ -108,6 +148,17 @@ class FimgApi
     private :
         bool    m_flagCreate;
 
+        // fences are sequence numbers of submitted command lists,
+        // tagged with the generation of this instance (0 if not created)
+        unsigned int m_fenceGeneration;
+        unsigned int m_fenceSubmitted;
+        unsigned int m_fenceSignaled;
+
+        static volatile int m_lastFenceGeneration;
+
+        bool    m_IsKnownFence(unsigned int fence);
+        bool    m_IsSignaled(unsigned int fence);
+
     protected :
         FimgApi();
         FimgApi(const FimgApi& rhs) {}
@@ -120,10 +171,15 @@ class FimgApi
         bool        Stretch(struct fimg2d_blit *cmd);
         bool        Sync(void);
 
+        unsigned int Submit(struct FimgCmdList *list);
+        bool        WaitFence(unsigned int fence);
+        bool        IsSignaled(unsigned int fence);
+
     protected:
         virtual bool t_Create(void);
         virtual bool t_Destroy(void);
         virtual bool t_Stretch(struct fimg2d_blit *cmd);
+        virtual bool t_StretchList(struct fimg2d_cmd *cmd, unsigned int count);
         virtual bool t_Sync(void);
         virtual bool t_Lock(void);
         virtual bool t_UnLock(void);
@@ -150,6 +206,23 @@ extern "C"
 #endif
 int SyncFimgApi(void);
 
+#ifdef __cplusplus
+extern "C"
+#endif
+void resetFimgCmdList(struct FimgCmdList *list);
+#ifdef __cplusplus
+extern "C"
+#endif
+int addFimgCmdList(struct FimgCmdList *list, struct fimg2d_blit *cmd);
+#ifdef __cplusplus
+extern "C"
+#endif
+int submitFimgCmdList(struct FimgCmdList *list);
+#ifdef __cplusplus
+extern "C"
+#endif
+int waitFimgFence(unsigned int fence);
+
 void printDataBlit(char *title, struct fimg2d_blit *cmd);
 void printDataBlitRotate(int rotate);
 void printDataBlitImage(char *title, struct fimg2d_image *image);
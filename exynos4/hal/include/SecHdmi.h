@@ -60,6 +60,7 @@
 #include <hardware/hardware.h>
 
 #include <utils/threads.h>
+#include <utils/Timers.h>
 
 
 namespace android {
@@ -75,6 +76,16 @@ public :
         HDMI_LAYER_MAX,
     };
 
+    /* smallest reconfiguration a flush() needs, in increasing cost */
+    enum HDMI_RECONFIG {
+        HDMI_RECONFIG_NONE = 0, /* buffer address only: queue the buffer */
+        HDMI_RECONFIG_SCALE,    /* destination position: crop of the running layer */
+        HDMI_RECONFIG_SOURCE,   /* layer input size: restart the layer on its node */
+        HDMI_RECONFIG_FORMAT,   /* source color format: reopen the layer */
+        HDMI_RECONFIG_OUTPUT,   /* output mode, resolution or hdcp: reopen and output reset */
+        HDMI_RECONFIG_MAX,
+    };
+
 private :
     class CECThread: public Thread
     {
@@ -83,13 +94,16 @@ private :
 
         private:
             sp<SecHdmi>         mSecHdmi;
-            Mutex               mThreadLoopLock;
             Mutex               mThreadControlLock;
             virtual bool        threadLoop();
             enum CECDeviceType  mDevtype;
             int                 mLaddr;
             int                 mPaddr;
 
+            static void         onGivePhysicalAddress(unsigned char *buffer, int size, void *data);
+            static void         onRequestActiveSource(unsigned char *buffer, int size, void *data);
+            static void         onFeatureAbort(unsigned char *buffer, int size, void *data);
+
         public:
             CECThread(sp<SecHdmi> secHdmi)
                 :Thread(false),
@@ -144,6 +158,10 @@ private :
     bool         mCurrentHdcpMode;
     int          mCurrentAudioMode;
     bool         mHdmiInfoChange;
+    bool         mHdmiLayerChange[HDMI_LAYER_MAX];
+
+    unsigned int mReconfigCount[HDMI_RECONFIG_MAX];
+    nsecs_t      mReconfigTraceTime;
 
     int          mFimcDstColorFormat;
 
@@ -202,7 +220,15 @@ public :
 
 private:
 
+    int         m_checkReconfig(int w, int h, int colorFormat, int hdmiLayer);
+    void        m_traceReconfig(int reconfig);
     bool        m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer);
+    bool        m_resetLayer(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer);
+    bool        m_setLayerCrop(int w, int h, int hdmiLayer, int hwcLayer);
+    bool        m_setLayerParams(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer);
+#if defined(BOARD_USE_V4L2)
+    void        m_getGraphicRect(int w, int h, int hwcLayer, struct v4l2_rect *rect);
+#endif
     bool        m_startHdmi(int hdmiLayer, unsigned int num_of_plane);
     bool        m_startHdmi(int hdmiLayer);
     bool        m_stopHdmi(int hdmiLayer);
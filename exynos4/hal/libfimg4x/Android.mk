@@ -11,7 +11,7 @@ LOCAL_SRC_FILES:= \
 LOCAL_C_INCLUDES += \
 	$(LOCAL_PATH)/../include
 
-LOCAL_SHARED_LIBRARIES:= liblog libutils libbinder
+LOCAL_SHARED_LIBRARIES:= liblog libcutils libutils libbinder
 
 LOCAL_MODULE:= libfimg
 
@@ -19,4 +19,26 @@ LOCAL_PRELINK_MODULE := false
 
 include $(BUILD_SHARED_LIBRARY)
 
+# software reference backend, for exercising command lists on a host
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SRC_FILES:= \
+	FimgApi.cpp   \
+	FimgSw.cpp
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH)/../include
+
+LOCAL_CFLAGS += -DFIMG_SW_BACKEND
+
+LOCAL_STATIC_LIBRARIES:= liblog libcutils libutils
+
+LOCAL_MODULE:= libfimg_sw
+
+include $(BUILD_HOST_STATIC_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif
@@ -20,6 +20,7 @@
 #define LOG_NDEBUG 0
 #define LOG_TAG "SKIA"
 #include <utils/Log.h>
+#include <cutils/atomic.h>
 
 #include "FimgApi.h"
 
@@ -69,9 +70,14 @@ struct blit_op_table optbl[] = {
     {}
 #endif
 
+volatile int FimgApi::m_lastFenceGeneration = 0;
+
 FimgApi::FimgApi()
 {
     m_flagCreate = false;
+    m_fenceGeneration = 0;
+    m_fenceSubmitted = 0;
+    m_fenceSignaled = 0;
 }
 
 FimgApi::~FimgApi()
@@ -99,6 +105,13 @@ bool FimgApi::Create(void)
         goto CREATE_DONE;
     }
 
+    // generation 0 is never used, so fences of a destroyed instance stay unknown
+    do {
+        m_fenceGeneration = (android_atomic_inc(&m_lastFenceGeneration) + 1) & FIMG_FENCE_GEN_MASK;
+    } while (m_fenceGeneration == 0);
+    m_fenceSubmitted = 0;
+    m_fenceSignaled = 0;
+
     m_flagCreate = true;
 
     ret = true;
@@ -130,6 +143,7 @@ bool FimgApi::Destroy(void)
     }
 
     m_flagCreate = false;
+    m_fenceGeneration = 0;
 
     ret = true;
 
@@ -186,6 +200,138 @@ SYNC_DONE :
     return ret;
 }
 
+unsigned int FimgApi::Submit(struct FimgCmdList *list)
+{
+    unsigned int fence = 0;
+
+    if (list == NULL || list->count == 0 || FIMG_CMD_LIST_MAX < list->count) {
+        PRINT("%s::invalid command list fail\n", __func__);
+        return 0;
+    }
+
+    if (t_Lock() == false) {
+        PRINT("%s::t_Lock() fail\n", __func__);
+        goto SUBMIT_DONE;
+    }
+
+    if (m_flagCreate == false) {
+        PRINT("%s::This is not Created fail\n", __func__);
+        goto SUBMIT_DONE;
+    }
+
+    // the list may have been copied since it was filled
+    for (unsigned int i = 0; i < list->count; i++) {
+        struct fimg2d_cmd *cmd = &list->cmd[i];
+
+        if (cmd->blit.src != NULL)
+            cmd->blit.src = &cmd->src;
+        if (cmd->blit.msk != NULL)
+            cmd->blit.msk = &cmd->msk;
+        if (cmd->blit.tmp != NULL)
+            cmd->blit.tmp = &cmd->tmp;
+        cmd->blit.dst = &cmd->dst;
+    }
+
+    if (t_StretchList(list->cmd, list->count) == false) {
+        PRINT("%s::t_StretchList(%d) fail\n", __func__, list->count);
+        goto SUBMIT_DONE;
+    }
+
+    m_fenceSubmitted = (m_fenceSubmitted + 1) & FIMG_FENCE_SEQ_MASK;
+
+    fence = FIMG_FENCE(m_fenceGeneration, m_fenceSubmitted);
+    list->fence = fence;
+
+SUBMIT_DONE :
+
+    t_UnLock();
+
+    return fence;
+}
+
+bool FimgApi::WaitFence(unsigned int fence)
+{
+    bool ret = false;
+
+    if (t_Lock() == false) {
+        PRINT("%s::t_Lock() fail\n", __func__);
+        goto WAIT_FENCE_DONE;
+    }
+
+    if (m_flagCreate == false) {
+        PRINT("%s::This is not Created fail\n", __func__);
+        goto WAIT_FENCE_DONE;
+    }
+
+    if (fence != 0 && m_IsKnownFence(fence) == false) {
+        PRINT("%s::unknown fence(%x) fail\n", __func__, fence);
+        goto WAIT_FENCE_DONE;
+    }
+
+    if (m_IsSignaled(fence) == false) {
+        // the engine runs lists in submit order, so once it is idle
+        // every fence handed out so far has been reached
+        if (t_Sync() == false) {
+            PRINT("%s::t_Sync() fail\n", __func__);
+            goto WAIT_FENCE_DONE;
+        }
+
+        m_fenceSignaled = m_fenceSubmitted;
+    }
+
+    ret = true;
+
+WAIT_FENCE_DONE :
+
+    t_UnLock();
+
+    return ret;
+}
+
+bool FimgApi::IsSignaled(unsigned int fence)
+{
+    bool ret = false;
+
+    if (t_Lock() == false) {
+        PRINT("%s::t_Lock() fail\n", __func__);
+        return false;
+    }
+
+    if (fence == 0 || m_IsKnownFence(fence) == true)
+        ret = m_IsSignaled(fence);
+
+    t_UnLock();
+
+    return ret;
+}
+
+bool FimgApi::m_IsKnownFence(unsigned int fence)
+{
+    unsigned int age;
+
+    if (m_flagCreate == false || FIMG_FENCE_GEN(fence) != m_fenceGeneration)
+        return false;
+
+    // not submitted yet, or so old that the sequence has wrapped past it
+    age = (m_fenceSubmitted - FIMG_FENCE_SEQ(fence)) & FIMG_FENCE_SEQ_MASK;
+    if ((FIMG_FENCE_SEQ_MASK >> 1) < age)
+        return false;
+
+    return true;
+}
+
+bool FimgApi::m_IsSignaled(unsigned int fence)
+{
+    unsigned int pending;
+
+    if (fence == 0)
+        return true;
+
+    pending = (FIMG_FENCE_SEQ(fence) - m_fenceSignaled) & FIMG_FENCE_SEQ_MASK;
+
+    return (pending == 0 || (FIMG_FENCE_SEQ_MASK >> 1) < pending);
+}
+
 bool FimgApi::t_Create(void)
 {
     PRINT("%s::This is empty virtual function fail\n", __func__);
@@ -204,6 +350,16 @@ bool FimgApi::t_Stretch(struct fimg2d_blit *cmd)
     return false;
 }
 
+bool FimgApi::t_StretchList(struct fimg2d_cmd *cmd, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        if (t_Stretch(&cmd[i].blit) == false)
+            return false;
+    }
+
+    return true;
+}
+
 bool FimgApi::t_Sync(void)
 {
     PRINT("%s::This is empty virtual function fail\n", __func__);
@@ -268,6 +424,87 @@ extern "C" int SyncFimgApi(void)
     return 0;
 }
 
+extern "C" void resetFimgCmdList(struct FimgCmdList *list)
+{
+    list->count = 0;
+}
+
+extern "C" int addFimgCmdList(struct FimgCmdList *list, struct fimg2d_blit *cmd)
+{
+    struct fimg2d_cmd *entry;
+    int index;
+
+    if (cmd == NULL || cmd->dst == NULL) {
+        PRINT("%s::invalid blit fail\n", __func__);
+        return -1;
+    }
+
+    if (FIMG_CMD_LIST_MAX <= list->count) {
+        PRINT("%s::command list is full(%d) fail\n", __func__, list->count);
+        return -1;
+    }
+
+    index = list->count;
+    entry = &list->cmd[index];
+
+    entry->blit = *cmd;
+
+    if (cmd->src != NULL) {
+        entry->src = *cmd->src;
+        entry->blit.src = &entry->src;
+    }
+    if (cmd->msk != NULL) {
+        entry->msk = *cmd->msk;
+        entry->blit.msk = &entry->msk;
+    }
+    if (cmd->tmp != NULL) {
+        entry->tmp = *cmd->tmp;
+        entry->blit.tmp = &entry->tmp;
+    }
+    entry->dst = *cmd->dst;
+    entry->blit.dst = &entry->dst;
+
+    list->count++;
+
+    return index;
+}
+
+extern "C" int submitFimgCmdList(struct FimgCmdList *list)
+{
+    FimgApi * fimgApi = createFimgApi();
+    if (fimgApi == NULL) {
+        PRINT("%s::createFimgApi() fail\n", __func__);
+        return -1;
+    }
+
+    if (fimgApi->Submit(list) == 0) {
+        destroyFimgApi(fimgApi);
+        return -1;
+    }
+
+    destroyFimgApi(fimgApi);
+
+    return 0;
+}
+
+extern "C" int waitFimgFence(unsigned int fence)
+{
+    FimgApi * fimgApi = createFimgApi();
+    if (fimgApi == NULL) {
+        PRINT("%s::createFimgApi() fail\n", __func__);
+        return -1;
+    }
+
+    if (fimgApi->WaitFence(fence) == false) {
+        destroyFimgApi(fimgApi);
+        return -1;
+    }
+
+    destroyFimgApi(fimgApi);
+
+    return 0;
+}
+
 void printDataBlit(char *title, struct fimg2d_blit *cmd)
 {
     SLOGI("%s\n", title);
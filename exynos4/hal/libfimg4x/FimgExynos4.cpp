@@ -183,6 +183,32 @@ STRETCH_FAIL:
 
 }
 
+bool FimgV4x::t_StretchList(struct fimg2d_cmd *cmd, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+#ifdef G2D_NONE_BLOCKING_MODE
+        // queue the whole list, completion is collected by t_Sync()
+        cmd[i].blit.sync = BLIT_ASYNC;
+#endif
+        if (m_DoG2D(&cmd[i].blit) == false) {
+            PRINT("%s::m_DoG2D(%d/%d) fail\n", __func__, i, count);
+            goto STRETCH_LIST_FAIL;
+        }
+    }
+
+    return true;
+
+STRETCH_LIST_FAIL:
+#ifdef G2D_NONE_BLOCKING_MODE
+    // do not leave the part of the list already queued in flight
+    if (0 < i && m_PollG2D(&m_g2dPoll) == false)
+        PRINT("%s::m_PollG2D() fail\n", __func__);
+#endif
+    return false;
+}
+
 bool FimgV4x::t_Sync(void)
 {
     if (m_PollG2D(&m_g2dPoll) == false)
@@ -88,6 +88,7 @@ protected:
     virtual bool    t_Create(void);
     virtual bool    t_Destroy(void);
     virtual bool    t_Stretch(struct fimg2d_blit *cmd);
+    virtual bool    t_StretchList(struct fimg2d_cmd *cmd, unsigned int count);
     virtual bool    t_Sync(void);
     virtual bool    t_Lock(void);
     virtual bool    t_UnLock(void);
@@ -0,0 +1,412 @@
+/*
+**
+** Copyright 2009 Samsung Electronics Co, Ltd.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+**
+*/
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "FimgSw"
+#include <utils/Log.h>
+
+#include "FimgSw.h"
+
+namespace android
+{
+Mutex      FimgSw::m_instanceLock;
+FimgApi *  FimgSw::m_ptrFimgApi = NULL;
+
+static inline unsigned int MUL_255(unsigned int a, unsigned int b)
+{
+    return (a * b + 127) / 255;
+}
+
+//---------------------------------------------------------------------------//
+
+FimgSw::FimgSw()
+         : m_numOfBlit(0),
+           m_numOfQueued(0)
+{
+}
+
+FimgSw::~FimgSw()
+{
+}
+
+FimgApi *FimgSw::CreateInstance()
+{
+    Mutex::Autolock autolock(m_instanceLock);
+
+    if (m_ptrFimgApi == NULL)
+        m_ptrFimgApi = new FimgSw;
+
+    if (m_ptrFimgApi->FlagCreate() == false
+        && m_ptrFimgApi->Create() == false) {
+        PRINT("%s::Create() fail\n", __func__);
+        return NULL;
+    }
+
+    return m_ptrFimgApi;
+}
+
+void FimgSw::DestroyInstance(FimgApi *ptrFimgApi)
+{
+    Mutex::Autolock autolock(m_instanceLock);
+
+    if (m_ptrFimgApi == NULL || m_ptrFimgApi != ptrFimgApi)
+        return;
+
+    if (m_ptrFimgApi->FlagCreate() == true && m_ptrFimgApi->Destroy() == false) {
+        PRINT("%s::Destroy() fail\n", __func__);
+        return;
+    }
+
+    delete (FimgSw *)m_ptrFimgApi;
+    m_ptrFimgApi = NULL;
+}
+
+bool FimgSw::t_Create(void)
+{
+    m_numOfBlit = 0;
+    m_numOfQueued = 0;
+    return true;
+}
+
+bool FimgSw::t_Destroy(void)
+{
+    // the engine drops what is still queued when the device is closed
+    m_numOfQueued = 0;
+    return true;
+}
+
+bool FimgSw::t_Stretch(struct fimg2d_blit *cmd)
+{
+    if (m_RunQueue() == false)
+        return false;
+
+    return m_DoBlit(cmd);
+}
+
+bool FimgSw::t_StretchList(struct fimg2d_cmd *cmd, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        struct fimg2d_cmd *entry;
+
+        if (m_numOfQueued == FIMG_SW_QUEUE_MAX && m_RunQueue() == false)
+            return false;
+
+        entry = &m_queue[m_numOfQueued++];
+        *entry = cmd[i];
+
+        if (entry->blit.src != NULL)
+            entry->blit.src = &entry->src;
+        if (entry->blit.msk != NULL)
+            entry->blit.msk = &entry->msk;
+        if (entry->blit.tmp != NULL)
+            entry->blit.tmp = &entry->tmp;
+        entry->blit.dst = &entry->dst;
+    }
+
+    return true;
+}
+
+bool FimgSw::t_Sync(void)
+{
+    return m_RunQueue();
+}
+
+bool FimgSw::m_RunQueue(void)
+{
+    bool ret = true;
+
+    // a failed blit is dropped like on the engine, the rest still run
+    for (unsigned int i = 0; i < m_numOfQueued; i++) {
+        if (m_DoBlit(&m_queue[i].blit) == false)
+            ret = false;
+    }
+
+    m_numOfQueued = 0;
+
+    return ret;
+}
+
+bool FimgSw::m_DoBlit(struct fimg2d_blit *cmd)
+{
+    struct fimg2d_image *src = cmd->src;
+    struct fimg2d_image *dst = cmd->dst;
+    bool needSrc;
+    int  x1, y1, x2, y2;
+    int  dstW, dstH, srcW, srcH, unrotW, unrotH;
+
+    switch (cmd->op) {
+    case BLIT_OP_SOLID_FILL:
+    case BLIT_OP_CLR:
+        needSrc = false;
+        break;
+    case BLIT_OP_SRC:
+    case BLIT_OP_SRC_OVER:
+        needSrc = true;
+        break;
+    default:
+        PRINT("%s::unsupported op(%d) fail\n", __func__, cmd->op);
+        return false;
+    }
+
+    if (dst == NULL || m_CheckImage(dst) == false) {
+        PRINT("%s::invalid dst fail\n", __func__);
+        return false;
+    }
+
+    if (needSrc == true && (src == NULL || m_CheckImage(src) == false)) {
+        PRINT("%s::invalid src fail\n", __func__);
+        return false;
+    }
+
+    x1 = dst->rect.x1;
+    y1 = dst->rect.y1;
+    x2 = dst->rect.x2;
+    y2 = dst->rect.y2;
+
+    if (cmd->param.clipping.enable == true) {
+        if (x1 < cmd->param.clipping.x1) x1 = cmd->param.clipping.x1;
+        if (y1 < cmd->param.clipping.y1) y1 = cmd->param.clipping.y1;
+        if (cmd->param.clipping.x2 < x2) x2 = cmd->param.clipping.x2;
+        if (cmd->param.clipping.y2 < y2) y2 = cmd->param.clipping.y2;
+    }
+
+    dstW = dst->rect.x2 - dst->rect.x1;
+    dstH = dst->rect.y2 - dst->rect.y1;
+
+    // size of the dst rect before the rotation is applied
+    if (cmd->param.rotate == ROT_90 || cmd->param.rotate == ROT_270) {
+        unrotW = dstH;
+        unrotH = dstW;
+    } else {
+        unrotW = dstW;
+        unrotH = dstH;
+    }
+
+    srcW = (needSrc == true) ? src->rect.x2 - src->rect.x1 : unrotW;
+    srcH = (needSrc == true) ? src->rect.y2 - src->rect.y1 : unrotH;
+
+    for (int y = y1; y < y2; y++) {
+        for (int x = x1; x < x2; x++) {
+            int rx = x - dst->rect.x1;
+            int ry = y - dst->rect.y1;
+            int ux, uy;
+            unsigned int srcPixel;
+            unsigned int dstPixel = 0;
+
+            switch (cmd->param.rotate) {
+            case ROT_90:
+                ux = ry;
+                uy = dstW - 1 - rx;
+                break;
+            case ROT_180:
+                ux = dstW - 1 - rx;
+                uy = dstH - 1 - ry;
+                break;
+            case ROT_270:
+                ux = dstH - 1 - ry;
+                uy = rx;
+                break;
+            case XFLIP:
+                ux = dstW - 1 - rx;
+                uy = ry;
+                break;
+            case YFLIP:
+                ux = rx;
+                uy = dstH - 1 - ry;
+                break;
+            case ORIGIN:
+            default:
+                ux = rx;
+                uy = ry;
+                break;
+            }
+
+            if (needSrc == true)
+                srcPixel = m_ReadPixel(src,
+                                       src->rect.x1 + (ux * srcW) / unrotW,
+                                       src->rect.y1 + (uy * srcH) / unrotH);
+            else if (cmd->op == BLIT_OP_SOLID_FILL)
+                srcPixel = (unsigned int)cmd->param.solid_color;
+            else
+                srcPixel = 0;
+
+            if (cmd->op == BLIT_OP_SRC_OVER)
+                dstPixel = m_ReadPixel(dst, x, y);
+
+            m_WritePixel(dst, x, y, m_BlendPixel(cmd, srcPixel, dstPixel));
+        }
+    }
+
+    m_numOfBlit++;
+
+    return true;
+}
+
+bool FimgSw::t_Lock(void)
+{
+    m_lock.lock();
+    return true;
+}
+
+bool FimgSw::t_UnLock(void)
+{
+    m_lock.unlock();
+    return true;
+}
+
+bool FimgSw::m_CheckImage(struct fimg2d_image *image)
+{
+    int bpp;
+
+    if (image->addr.type != ADDR_USER && image->addr.type != ADDR_USER_RSVD) {
+        PRINT("%s::unsupported addr type(%d) fail\n", __func__, image->addr.type);
+        return false;
+    }
+
+    if (image->addr.start == 0 || image->order != AX_RGB) {
+        PRINT("%s::invalid addr(%lx)/order(%d) fail\n", __func__,
+              image->addr.start, image->order);
+        return false;
+    }
+
+    switch (image->fmt) {
+    case CF_XRGB_8888:
+    case CF_ARGB_8888:
+        bpp = 4;
+        break;
+    case CF_RGB_565:
+        bpp = 2;
+        break;
+    default:
+        PRINT("%s::unsupported format(%d) fail\n", __func__, image->fmt);
+        return false;
+    }
+
+    if (image->stride < image->width * bpp
+        || image->rect.x1 < 0 || image->rect.y1 < 0
+        || image->rect.x2 <= image->rect.x1 || image->rect.y2 <= image->rect.y1
+        || image->width < image->rect.x2 || image->height < image->rect.y2) {
+        PRINT("%s::invalid geometry fail\n", __func__);
+        return false;
+    }
+
+    return true;
+}
+
+unsigned int FimgSw::m_ReadPixel(struct fimg2d_image *image, int x, int y)
+{
+    unsigned char *line = (unsigned char *)image->addr.start + y * image->stride;
+    unsigned int r, g, b;
+    unsigned short rgb565;
+
+    switch (image->fmt) {
+    case CF_XRGB_8888:
+        return ((unsigned int *)line)[x] | 0xff000000;
+    case CF_ARGB_8888:
+        return ((unsigned int *)line)[x];
+    case CF_RGB_565:
+    default:
+        rgb565 = ((unsigned short *)line)[x];
+        r = (rgb565 >> 11) & 0x1f;
+        g = (rgb565 >> 5) & 0x3f;
+        b = rgb565 & 0x1f;
+        return 0xff000000
+               | (((r << 3) | (r >> 2)) << 16)
+               | (((g << 2) | (g >> 4)) << 8)
+               | ((b << 3) | (b >> 2));
+    }
+}
+
+void FimgSw::m_WritePixel(struct fimg2d_image *image, int x, int y, unsigned int argb)
+{
+    unsigned char *line = (unsigned char *)image->addr.start + y * image->stride;
+
+    switch (image->fmt) {
+    case CF_XRGB_8888:
+    case CF_ARGB_8888:
+        ((unsigned int *)line)[x] = argb;
+        break;
+    case CF_RGB_565:
+    default:
+        ((unsigned short *)line)[x] = (unsigned short)(((argb >> 8) & 0xf800)
+                                                     | ((argb >> 5) & 0x07e0)
+                                                     | ((argb >> 3) & 0x001f));
+        break;
+    }
+}
+
+unsigned int FimgSw::m_BlendPixel(struct fimg2d_blit *cmd, unsigned int src, unsigned int dst)
+{
+    unsigned int ga = cmd->param.g_alpha;
+    bool premult = (cmd->param.premult == PREMULTIPLIED);
+    unsigned int s[4], d[4], out[4];
+
+    if (cmd->op == BLIT_OP_CLR)
+        return 0;
+
+    for (int i = 0; i < 4; i++) {
+        s[i] = (src >> (i * 8)) & 0xff;
+        d[i] = (dst >> (i * 8)) & 0xff;
+    }
+
+    // s[3] and d[3] are alpha
+    if (ga < G2D_ALPHA_VALUE_MAX) {
+        if (premult == true) {
+            for (int i = 0; i < 4; i++)
+                s[i] = MUL_255(s[i], ga);
+        } else {
+            s[3] = MUL_255(s[3], ga);
+        }
+    }
+
+    if (cmd->op != BLIT_OP_SRC_OVER)
+        return (s[3] << 24) | (s[2] << 16) | (s[1] << 8) | s[0];
+
+    if (premult == true) {
+        for (int i = 0; i < 4; i++)
+            out[i] = s[i] + MUL_255(d[i], 255 - s[3]);
+    } else {
+        for (int i = 0; i < 3; i++)
+            out[i] = MUL_255(s[i], s[3]) + MUL_255(d[i], 255 - s[3]);
+        out[3] = s[3] + MUL_255(d[3], 255 - s[3]);
+    }
+
+    for (int i = 0; i < 4; i++)
+        if (255 < out[i])
+            out[i] = 255;
+
+    return (out[3] << 24) | (out[2] << 16) | (out[1] << 8) | out[0];
+}
+
+#ifdef FIMG_SW_BACKEND
+//---------------------------------------------------------------------------//
+// extern function
+//---------------------------------------------------------------------------//
+extern "C" struct FimgApi * createFimgApi()
+{
+    return FimgSw::CreateInstance();
+}
+
+extern "C" void destroyFimgApi(FimgApi * ptrFimgApi)
+{
+    // Dont' call DestroyInstance.
+}
+#endif // FIMG_SW_BACKEND
+
+}; // namespace android
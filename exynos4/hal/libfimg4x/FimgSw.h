@@ -0,0 +1,94 @@
+/*
+**
+** Copyright 2009 Samsung Electronics Co, Ltd.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+**
+*/
+
+#ifndef FIMG_SW_H
+#define FIMG_SW_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <utils/threads.h>
+
+#include "FimgApi.h"
+
+#include "sec_g2d_4x.h"
+
+namespace android
+{
+
+//---------------------------------------------------------------------------//
+// class FimgSw : public FimgApi
+//
+// Software reference for the G2D block, on user virtual addresses only,
+// with nearest sampling. Supported: SOLID_FILL, CLR, SRC and SRC_OVER on
+// ARGB/XRGB 8888 and RGB 565 (AX_RGB order), rotation, flip, scaling and
+// clipping.
+//
+// Like the engine, blits of a command list are only queued: they run in
+// queue order on t_Sync(), when the queue is full, or before a single
+// t_Stretch(), so fences stay pending until they are waited on.
+//---------------------------------------------------------------------------//
+#define FIMG_SW_QUEUE_MAX   (FIMG_CMD_LIST_MAX * 4)
+
+class FimgSw : public FimgApi
+{
+private :
+    Mutex           m_lock;
+
+    unsigned int    m_numOfBlit;
+
+    struct fimg2d_cmd m_queue[FIMG_SW_QUEUE_MAX];
+    unsigned int    m_numOfQueued;
+
+    static Mutex    m_instanceLock;
+    static FimgApi *m_ptrFimgApi;
+
+protected :
+    FimgSw();
+    virtual ~FimgSw();
+
+public:
+    static FimgApi *CreateInstance();
+    static void     DestroyInstance(FimgApi *ptrFimgApi);
+
+    inline unsigned int NumOfBlit(void) { return m_numOfBlit; }
+    inline unsigned int NumOfQueued(void) { return m_numOfQueued; }
+
+protected:
+    virtual bool    t_Create(void);
+    virtual bool    t_Destroy(void);
+    virtual bool    t_Stretch(struct fimg2d_blit *cmd);
+    virtual bool    t_StretchList(struct fimg2d_cmd *cmd, unsigned int count);
+    virtual bool    t_Sync(void);
+    virtual bool    t_Lock(void);
+    virtual bool    t_UnLock(void);
+
+private:
+    bool            m_DoBlit(struct fimg2d_blit *cmd);
+    bool            m_RunQueue(void);
+    bool            m_CheckImage(struct fimg2d_image *image);
+    unsigned int    m_ReadPixel(struct fimg2d_image *image, int x, int y);
+    void            m_WritePixel(struct fimg2d_image *image, int x, int y, unsigned int argb);
+    unsigned int    m_BlendPixel(struct fimg2d_blit *cmd, unsigned int src, unsigned int dst);
+};
+
+}; // namespace android
+
+#endif // FIMG_SW_H
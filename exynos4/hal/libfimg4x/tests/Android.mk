@@ -0,0 +1,19 @@
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SRC_FILES:= \
+	FimgCmdListTest.cpp
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH)/.. \
+	$(LOCAL_PATH)/../../include
+
+LOCAL_CFLAGS += -DFIMG_SW_BACKEND
+
+LOCAL_STATIC_LIBRARIES:= libfimg_sw liblog libcutils libutils
+
+LOCAL_MODULE:= libfimg_cmdlist_test
+
+include $(BUILD_HOST_NATIVE_TEST)
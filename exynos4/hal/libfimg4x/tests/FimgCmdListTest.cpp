@@ -0,0 +1,283 @@
+/*
+**
+** Copyright 2009 Samsung Electronics Co, Ltd.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+**
+*/
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "FimgSw.h"
+
+using namespace android;
+
+#define WIDTH   (8)
+#define HEIGHT  (4)
+
+#define RED     (0xffff0000)
+#define GREEN   (0xff00ff00)
+#define BLUE    (0x800000ff)    // half transparent, not premultiplied
+
+class FimgCmdListTest : public ::testing::Test {
+protected:
+    unsigned int    m_dst[WIDTH * HEIGHT];
+    unsigned int    m_dst2[WIDTH * HEIGHT];
+    unsigned int    m_src[WIDTH * HEIGHT];
+
+    struct FimgCmdList m_list;
+
+    virtual void SetUp()
+    {
+        memset(m_dst, 0, sizeof(m_dst));
+        memset(m_dst2, 0, sizeof(m_dst2));
+        for (int i = 0; i < WIDTH * HEIGHT; i++)
+            m_src[i] = BLUE;
+
+        memset(&m_list, 0, sizeof(m_list));
+    }
+
+    virtual void TearDown()
+    {
+        FimgSw::DestroyInstance(createFimgApi());
+    }
+
+    static FimgSw *sw(void)
+    {
+        return (FimgSw *)createFimgApi();
+    }
+
+    static void image(struct fimg2d_image *img, unsigned int *buf,
+                      int x1, int y1, int x2, int y2)
+    {
+        memset(img, 0, sizeof(*img));
+        img->width = WIDTH;
+        img->height = HEIGHT;
+        img->stride = WIDTH * 4;
+        img->order = AX_RGB;
+        img->fmt = CF_ARGB_8888;
+        img->addr.type = ADDR_USER;
+        img->addr.start = (unsigned long)buf;
+        img->rect.x1 = x1;
+        img->rect.y1 = y1;
+        img->rect.x2 = x2;
+        img->rect.y2 = y2;
+    }
+
+    // the images are copied by addFimgCmdList(), so they may live on the stack
+    int addFill(unsigned int *dst, unsigned int color, int x1, int y1, int x2, int y2)
+    {
+        struct fimg2d_blit blit;
+        struct fimg2d_image dstImage;
+
+        memset(&blit, 0, sizeof(blit));
+        image(&dstImage, dst, x1, y1, x2, y2);
+        blit.op = BLIT_OP_SOLID_FILL;
+        blit.param.solid_color = color;
+        blit.param.g_alpha = G2D_ALPHA_VALUE_MAX;
+        blit.dst = &dstImage;
+
+        return addFimgCmdList(&m_list, &blit);
+    }
+
+    int addOver(unsigned int *dst, int x1, int y1, int x2, int y2)
+    {
+        struct fimg2d_blit blit;
+        struct fimg2d_image srcImage, dstImage;
+
+        memset(&blit, 0, sizeof(blit));
+        image(&srcImage, m_src, 0, 0, x2 - x1, y2 - y1);
+        image(&dstImage, dst, x1, y1, x2, y2);
+        blit.op = BLIT_OP_SRC_OVER;
+        blit.param.g_alpha = G2D_ALPHA_VALUE_MAX;
+        blit.param.premult = NON_PREMULTIPLIED;
+        blit.src = &srcImage;
+        blit.dst = &dstImage;
+
+        return addFimgCmdList(&m_list, &blit);
+    }
+
+    static unsigned int pixel(unsigned int *buf, int x, int y)
+    {
+        return buf[y * WIDTH + x];
+    }
+};
+
+TEST_F(FimgCmdListTest, EntriesRunInListOrder)
+{
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, WIDTH, HEIGHT));
+    ASSERT_EQ(1, addFill(m_dst, GREEN, 0, 0, WIDTH / 2, HEIGHT));
+    ASSERT_EQ(2, addOver(m_dst, 0, 0, WIDTH / 2, 1));
+
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    ASSERT_EQ(0, waitFimgFence(m_list.fence));
+
+    // blue at half alpha over green
+    EXPECT_EQ(0xff007f80u, pixel(m_dst, 0, 0));
+    EXPECT_EQ(GREEN, pixel(m_dst, 0, 1));
+    EXPECT_EQ(RED, pixel(m_dst, WIDTH - 1, HEIGHT - 1));
+    EXPECT_EQ(3u, sw()->NumOfBlit());
+}
+
+TEST_F(FimgCmdListTest, FencePendingUntilWaited)
+{
+    struct FimgCmdList first;
+    FimgApi *api = createFimgApi();
+
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, WIDTH, HEIGHT));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    first = m_list;
+
+    resetFimgCmdList(&m_list);
+    ASSERT_EQ(0, addFill(m_dst, GREEN, 0, 0, 1, 1));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+
+    // both lists are only queued
+    EXPECT_NE(first.fence, m_list.fence);
+    EXPECT_FALSE(api->IsSignaled(first.fence));
+    EXPECT_FALSE(api->IsSignaled(m_list.fence));
+    EXPECT_EQ(2u, sw()->NumOfQueued());
+    EXPECT_EQ(0u, pixel(m_dst, 0, 0));
+
+    // the later fence retires the earlier list too, in submit order
+    ASSERT_EQ(0, waitFimgFence(m_list.fence));
+    EXPECT_TRUE(api->IsSignaled(first.fence));
+    EXPECT_TRUE(api->IsSignaled(m_list.fence));
+    EXPECT_EQ(GREEN, pixel(m_dst, 0, 0));
+    EXPECT_EQ(RED, pixel(m_dst, 1, 0));
+}
+
+TEST_F(FimgCmdListTest, SingleBlitRunsAfterQueuedList)
+{
+    struct fimg2d_blit blit;
+    struct fimg2d_image dstImage;
+
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, WIDTH, HEIGHT));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+
+    memset(&blit, 0, sizeof(blit));
+    image(&dstImage, m_dst, 0, 0, 1, 1);
+    blit.op = BLIT_OP_SOLID_FILL;
+    blit.param.solid_color = GREEN;
+    blit.param.g_alpha = G2D_ALPHA_VALUE_MAX;
+    blit.dst = &dstImage;
+    ASSERT_EQ(0, stretchFimgApi(&blit));
+
+    EXPECT_EQ(GREEN, pixel(m_dst, 0, 0));
+    EXPECT_EQ(RED, pixel(m_dst, 1, 0));
+    EXPECT_EQ(0u, sw()->NumOfQueued());
+    EXPECT_EQ(0, waitFimgFence(m_list.fence));
+}
+
+TEST_F(FimgCmdListTest, ReuseListWithPatchedAddress)
+{
+    unsigned int fence;
+
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, WIDTH, HEIGHT));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    fence = m_list.fence;
+    ASSERT_EQ(0, waitFimgFence(fence));
+
+    // submit the same list again, with only the buffer address patched
+    m_list.cmd[0].dst.addr.start = (unsigned long)m_dst2;
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    EXPECT_NE(fence, m_list.fence);
+    ASSERT_EQ(0, waitFimgFence(m_list.fence));
+
+    EXPECT_EQ(RED, pixel(m_dst2, WIDTH - 1, HEIGHT - 1));
+    EXPECT_EQ(2u, sw()->NumOfBlit());
+}
+
+TEST_F(FimgCmdListTest, CopiedListKeepsOwnImages)
+{
+    struct FimgCmdList copy;
+
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, WIDTH, HEIGHT));
+    copy = m_list;
+    memset(&m_list, 0xff, sizeof(m_list));
+
+    ASSERT_EQ(0, submitFimgCmdList(&copy));
+    ASSERT_EQ(0, waitFimgFence(copy.fence));
+    EXPECT_EQ(RED, pixel(m_dst, 0, 0));
+}
+
+TEST_F(FimgCmdListTest, QueueFullRunsInOrder)
+{
+    unsigned int i;
+
+    // more blits than the queue holds, each overwriting the same pixel
+    for (i = 0; i < FIMG_SW_QUEUE_MAX + FIMG_CMD_LIST_MAX; i++) {
+        if (m_list.count == FIMG_CMD_LIST_MAX) {
+            ASSERT_EQ(0, submitFimgCmdList(&m_list));
+            resetFimgCmdList(&m_list);
+        }
+        ASSERT_LE(0, addFill(m_dst, 0xff000000 | i, 0, 0, 1, 1));
+    }
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    ASSERT_EQ(0, waitFimgFence(m_list.fence));
+
+    EXPECT_EQ(0xff000000 | (i - 1), pixel(m_dst, 0, 0));
+    EXPECT_EQ(i, sw()->NumOfBlit());
+}
+
+TEST_F(FimgCmdListTest, InvalidLists)
+{
+    for (int i = 0; i < FIMG_CMD_LIST_MAX; i++)
+        ASSERT_EQ(i, addFill(m_dst, RED, 0, 0, 1, 1));
+    EXPECT_EQ(-1, addFill(m_dst, RED, 0, 0, 1, 1));
+
+    resetFimgCmdList(&m_list);
+    EXPECT_EQ(-1, submitFimgCmdList(&m_list));
+    EXPECT_EQ(0u, m_list.fence);
+
+    // a list that was never submitted has nothing to wait for
+    EXPECT_EQ(0, waitFimgFence(m_list.fence));
+}
+
+TEST_F(FimgCmdListTest, UnknownFences)
+{
+    unsigned int fence;
+    FimgApi *api = createFimgApi();
+
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, 1, 1));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+    fence = m_list.fence;
+
+    // not submitted yet
+    EXPECT_EQ(-1, waitFimgFence(FIMG_FENCE(FIMG_FENCE_GEN(fence), FIMG_FENCE_SEQ(fence) + 1)));
+    EXPECT_FALSE(api->IsSignaled(fence + 1));
+
+    // from another generation
+    EXPECT_EQ(-1, waitFimgFence(FIMG_FENCE(FIMG_FENCE_GEN(fence) + 1, FIMG_FENCE_SEQ(fence))));
+
+    ASSERT_EQ(0, waitFimgFence(fence));
+
+    // fences die with the instance that handed them out
+    FimgSw::DestroyInstance(api);
+    EXPECT_EQ(-1, waitFimgFence(fence));
+    EXPECT_FALSE(createFimgApi()->IsSignaled(fence));
+}
+
+TEST_F(FimgCmdListTest, DestroyDropsQueuedBlits)
+{
+    ASSERT_EQ(0, addFill(m_dst, RED, 0, 0, 1, 1));
+    ASSERT_EQ(0, submitFimgCmdList(&m_list));
+
+    FimgSw::DestroyInstance(createFimgApi());
+
+    EXPECT_EQ(-1, waitFimgFence(m_list.fence));
+    EXPECT_EQ(0u, sw()->NumOfQueued());
+}
@@ -62,90 +62,61 @@ SecHdmi::CECThread::~CECThread()
 
 bool SecHdmi::CECThread::threadLoop()
 {
-    unsigned char buffer[CEC_MAX_FRAME_SIZE];
-    int size;
-    unsigned char lsrc, ldst, opcode;
+    mFlagRunning = true;
 
-    {
-        Mutex::Autolock lock(mThreadLoopLock);
-        mFlagRunning = true;
-
-        size = CECReceiveMessage(buffer, CEC_MAX_FRAME_SIZE, 100000);
-
-        if (!size) // no data available or ctrl-c
-            return true;
-
-        if (size == 1)
-            return true; // "Polling Message"
-
-        lsrc = buffer[0] >> 4;
-
-        /* ignore messages with src address == mLaddr*/
-        if (lsrc == mLaddr)
-            return true;
-
-        opcode = buffer[1];
-
-        if (CECIgnoreMessage(opcode, lsrc)) {
-            ALOGE("### ignore message coming from address 15 (unregistered)\n");
-            return true;
-        }
-
-        if (!CECCheckMessageSize(opcode, size)) {
-            ALOGE("### invalid message size: %d(opcode: 0x%x) ###\n", size, opcode);
-            return true;
-        }
+    /* returns early when stop() wakes us up */
+    CECProcess(100000);
 
-        /* check if message broadcasted/directly addressed */
-        if (!CECCheckMessageMode(opcode, (buffer[0] & 0x0F) == CEC_MSG_BROADCAST ? 1 : 0)) {
-            ALOGE("### invalid message mode (directly addressed/broadcast) ###\n");
-            return true;
-        }
-
-        ldst = lsrc;
-
-        //TODO: macroses to extract src and dst logical addresses
-        //TODO: macros to extract opcode
+    return true;
+}
 
-        switch (opcode) {
-        case CEC_OPCODE_GIVE_PHYSICAL_ADDRESS:
-            /* responce with "Report Physical Address" */
-            buffer[0] = (mLaddr << 4) | CEC_MSG_BROADCAST;
-            buffer[1] = CEC_OPCODE_REPORT_PHYSICAL_ADDRESS;
-            buffer[2] = (mPaddr >> 8) & 0xFF;
-            buffer[3] = mPaddr & 0xFF;
-            buffer[4] = mDevtype;
-            size = 5;
-            break;
+void SecHdmi::CECThread::onGivePhysicalAddress(unsigned char *buffer, int size, void *data)
+{
+    CECThread *thread = static_cast<CECThread *>(data);
+    unsigned char reply[5];
+
+    /* responce with "Report Physical Address" */
+    reply[0] = (thread->mLaddr << 4) | CEC_MSG_BROADCAST;
+    reply[1] = CEC_OPCODE_REPORT_PHYSICAL_ADDRESS;
+    reply[2] = (thread->mPaddr >> 8) & 0xFF;
+    reply[3] = thread->mPaddr & 0xFF;
+    reply[4] = thread->mDevtype;
+
+    if (!CECQueueMessage(reply, sizeof(reply)))
+        ALOGE("CECQueueMessage() failed!!!\n");
+}
 
-        case CEC_OPCODE_REQUEST_ACTIVE_SOURCE:
-            ALOGD("[CEC_OPCODE_REQUEST_ACTIVE_SOURCE]\n");
-            /* responce with "Active Source" */
-            buffer[0] = (mLaddr << 4) | CEC_MSG_BROADCAST;
-            buffer[1] = CEC_OPCODE_ACTIVE_SOURCE;
-            buffer[2] = (mPaddr >> 8) & 0xFF;
-            buffer[3] = mPaddr & 0xFF;
-            size = 4;
-            ALOGD("Tx : [CEC_OPCODE_ACTIVE_SOURCE]\n");
-            break;
+void SecHdmi::CECThread::onRequestActiveSource(unsigned char *buffer, int size, void *data)
+{
+    CECThread *thread = static_cast<CECThread *>(data);
+    unsigned char reply[4];
+
+    ALOGD("[CEC_OPCODE_REQUEST_ACTIVE_SOURCE]\n");
+    /* responce with "Active Source" */
+    reply[0] = (thread->mLaddr << 4) | CEC_MSG_BROADCAST;
+    reply[1] = CEC_OPCODE_ACTIVE_SOURCE;
+    reply[2] = (thread->mPaddr >> 8) & 0xFF;
+    reply[3] = thread->mPaddr & 0xFF;
+
+    if (!CECQueueMessage(reply, sizeof(reply)))
+        ALOGE("CECQueueMessage() failed!!!\n");
+    else
+        ALOGD("Tx : [CEC_OPCODE_ACTIVE_SOURCE]\n");
+}
 
-        case CEC_OPCODE_ABORT:
-        case CEC_OPCODE_FEATURE_ABORT:
-        default:
-            /* send "Feature Abort" */
-            buffer[0] = (mLaddr << 4) | ldst;
-            buffer[1] = CEC_OPCODE_FEATURE_ABORT;
-            buffer[2] = CEC_OPCODE_ABORT;
-            buffer[3] = 0x04; // "refused"
-            size = 4;
-            break;
-        }
+void SecHdmi::CECThread::onFeatureAbort(unsigned char *buffer, int size, void *data)
+{
+    CECThread *thread = static_cast<CECThread *>(data);
+    unsigned char reply[4];
 
-        if (CECSendMessage(buffer, size) != size)
-            ALOGE("CECSendMessage() failed!!!\n");
+    /* send "Feature Abort" */
+    reply[0] = (thread->mLaddr << 4) | (buffer[0] >> 4);
+    reply[1] = CEC_OPCODE_FEATURE_ABORT;
+    reply[2] = CEC_OPCODE_ABORT;
+    reply[3] = 0x04; // "refused"
 
-    }
-    return true;
+    if (!CECQueueMessage(reply, sizeof(reply)))
+        ALOGE("CECQueueMessage() failed!!!\n");
 }
 
 bool SecHdmi::CECThread::start()
@@ -202,6 +173,10 @@ bool SecHdmi::CECThread::start()
         return false;
     }
 
+    CECSetHandler(CEC_OPCODE_GIVE_PHYSICAL_ADDRESS, onGivePhysicalAddress, this);
+    CECSetHandler(CEC_OPCODE_REQUEST_ACTIVE_SOURCE, onRequestActiveSource, this);
+    CECSetDefaultHandler(onFeatureAbort, this);
+
 #ifdef DEBUG_HDMI_HW_LEVEL
     ALOGD("request to run CECThread");
 #endif
@@ -220,11 +195,21 @@ bool SecHdmi::CECThread::stop()
     ALOGD("%s request Exit", __func__);
 #endif
     Mutex::Autolock lock(mThreadControlLock);
+    requestExit();
+    CECWakeup();
     if (requestExitAndWait() == WOULD_BLOCK) {
         ALOGE("mCECThread.requestExitAndWait() == WOULD_BLOCK");
         return false;
     }
 
+#ifdef DEBUG_HDMI_HW_LEVEL
+    struct CECStats stats;
+    CECGetStats(&stats);
+    ALOGD("CEC rx %u (avg %lld us, max %lld us), tx %u, retries %u, dropped %u",
+          stats.rxCount, stats.rxCount ? stats.latencyTotal / stats.rxCount : 0,
+          stats.latencyMax, stats.txCount, stats.txRetries, stats.txDropped);
+#endif
+
     if (!CECClose())
         ALOGE("CECClose() failed!\n");
 
@@ -255,6 +240,7 @@ SecHdmi::SecHdmi():
     mCurrentHdcpMode(false),
     mCurrentAudioMode(-1),
     mHdmiInfoChange(true),
+    mReconfigTraceTime(0),
     mFimcDstColorFormat(0),
     mFimcCurrentOutBufIndex(0),
     mFBaddr(NULL),
@@ -282,8 +268,12 @@ SecHdmi::SecHdmi():
         mDstHeight [i] = 0;
         mPrevDstWidth  [i] = 0;
         mPrevDstHeight [i] = 0;
+        mHdmiLayerChange[i] = false;
     }
 
+    for (int i = 0; i < HDMI_RECONFIG_MAX; i++)
+        mReconfigCount[i] = 0;
+
     mHdmiPresetId = DEFAULT_HDMI_PRESET_ID;
     mHdmiStdId = DEFAULT_HDMI_STD_ID;
 
@@ -750,28 +740,39 @@ bool SecHdmi::flush(int srcW, int srcH, int srcColorFormat,
 #endif
 #endif
 
-    if (srcW != mSrcWidth[hdmiLayer] ||
-        srcH != mSrcHeight[hdmiLayer] ||
-        srcColorFormat != mSrcColorFormat[hdmiLayer] ||
-        mHdmiDstWidth != mHdmiResolutionWidth[hdmiLayer] ||
-        mHdmiDstHeight != mHdmiResolutionHeight[hdmiLayer] ||
-#if defined(BOARD_USE_V4L2)
-        mDstWidth[hdmiLayer] != mPrevDstWidth[hdmiLayer] ||
-        mDstHeight[hdmiLayer] != mPrevDstHeight[hdmiLayer] ||
-#endif
-        mHdmiInfoChange == true) {
+    int reconfig = m_checkReconfig(srcW, srcH, srcColorFormat, hdmiLayer);
+    m_traceReconfig(reconfig);
+
 #ifdef DEBUG_MSG_ENABLE
-        ALOGD("m_reset param(%d, %d, %d, %d, %d, %d, %d)",
+    if (reconfig != HDMI_RECONFIG_NONE)
+        ALOGD("m_reset param(%d, %d, %d, %d, %d, %d, %d, reconfig %d)",
             srcW, mSrcWidth[hdmiLayer], \
             srcH, mSrcHeight[hdmiLayer], \
             srcColorFormat,mSrcColorFormat[hdmiLayer], \
-            hdmiLayer);
+            hdmiLayer, reconfig);
 #endif
 
+    switch (reconfig) {
+    case HDMI_RECONFIG_NONE:
+        break;
+    case HDMI_RECONFIG_SCALE:
+        if (m_setLayerCrop(srcW, srcH, hdmiLayer, num_of_hwc_layer) == false) {
+            ALOGE("%s::m_setLayerCrop(%d, %d, %d, %d) fail", __func__, srcW, srcH, hdmiLayer, num_of_hwc_layer);
+            return false;
+        }
+        break;
+    case HDMI_RECONFIG_SOURCE:
+        if (m_resetLayer(srcW, srcH, srcColorFormat, hdmiLayer, num_of_hwc_layer) == false) {
+            ALOGE("%s::m_resetLayer(%d, %d, %d, %d, %d) fail", __func__, srcW, srcH, srcColorFormat, hdmiLayer, num_of_hwc_layer);
+            return false;
+        }
+        break;
+    default:
         if (m_reset(srcW, srcH, srcColorFormat, hdmiLayer, num_of_hwc_layer) == false) {
             ALOGE("%s::m_reset(%d, %d, %d, %d, %d) fail", __func__, srcW, srcH, srcColorFormat, hdmiLayer, num_of_hwc_layer);
             return false;
         }
+        break;
     }
 
     if (srcYAddr == 0) {
@@ -1240,26 +1241,27 @@ bool SecHdmi::setUIRotation(unsigned int rotVal, unsigned int hwcLayer)
         return false;
     }
 
+    /*
+     * rotation only changes layer geometry, and the output sequence in
+     * m_reset() takes no rotation input. The next flush() of each marked
+     * layer reprograms it (see m_checkReconfig()).
+     */
+
     /* G2D rotation */
     if (rotVal != mG2DUIRotVal) {
         mG2DUIRotVal = rotVal;
-        mHdmiInfoChange = true;
+        mHdmiLayerChange[HDMI_LAYER_GRAPHIC_0] = true;
+        mHdmiLayerChange[HDMI_LAYER_GRAPHIC_1] = true;
     }
 
     /* FIMC rotation */
-    if (hwcLayer == 0) { /* Rotate in UI only mode */
-        if (rotVal != mUIRotVal) {
-            mSecFimc.setRotVal(rotVal);
-            mUIRotVal = rotVal;
-            mHdmiInfoChange = true;
-        }
-    } else { /* Don't rotate video layer when video is played. */
+    if (hwcLayer != 0) /* Don't rotate video layer when video is played. */
         rotVal = 0;
-        if (rotVal != mUIRotVal) {
-            mSecFimc.setRotVal(rotVal);
-            mUIRotVal = rotVal;
-            mHdmiInfoChange = true;
-        }
+
+    if (rotVal != mUIRotVal) {
+        mSecFimc.setRotVal(rotVal);
+        mUIRotVal = rotVal;
+        mHdmiLayerChange[HDMI_LAYER_VIDEO] = true;
     }
 
     return true;
@@ -1273,6 +1275,169 @@ bool SecHdmi::setDisplaySize(int width, int height)
     return true;
 }
 
+int SecHdmi::m_checkReconfig(int w, int h, int colorFormat, int hdmiLayer)
+{
+    /* each layer node carries the output preset, so it is reopened */
+    if (mHdmiInfoChange == true ||
+        mHdmiDstWidth != mHdmiResolutionWidth[hdmiLayer] ||
+        mHdmiDstHeight != mHdmiResolutionHeight[hdmiLayer])
+        return HDMI_RECONFIG_OUTPUT;
+
+    if (colorFormat != mSrcColorFormat[hdmiLayer])
+        return HDMI_RECONFIG_FORMAT;
+
+    if (w != mSrcWidth[hdmiLayer] ||
+        h != mSrcHeight[hdmiLayer])
+        return HDMI_RECONFIG_SOURCE;
+
+    /* FIMC rotation swaps the size of the VP input */
+    if (hdmiLayer == HDMI_LAYER_VIDEO) {
+        if (mHdmiLayerChange[hdmiLayer] == true)
+            return HDMI_RECONFIG_SOURCE;
+#if defined(BOARD_USE_V4L2)
+        /* cleared while the graphic layer ran alone */
+        if (mDstWidth[hdmiLayer] != mPrevDstWidth[hdmiLayer] ||
+            mDstHeight[hdmiLayer] != mPrevDstHeight[hdmiLayer])
+            return HDMI_RECONFIG_SOURCE;
+#endif
+        return HDMI_RECONFIG_NONE;
+    }
+
+#if defined(BOARD_USE_V4L2)
+    if (mDstWidth[hdmiLayer] != mPrevDstWidth[hdmiLayer] ||
+        mDstHeight[hdmiLayer] != mPrevDstHeight[hdmiLayer]) {
+#if defined(BOARD_USES_FIMGAPI)
+        /* the G2D output sized to the destination is the layer input */
+        return HDMI_RECONFIG_SOURCE;
+#else
+        return HDMI_RECONFIG_SCALE;
+#endif
+    }
+#endif
+
+    if (mHdmiLayerChange[hdmiLayer] == true)
+        return HDMI_RECONFIG_SCALE;
+
+    return HDMI_RECONFIG_NONE;
+}
+
+void SecHdmi::m_traceReconfig(int reconfig)
+{
+    nsecs_t now = systemTime();
+
+    mReconfigCount[reconfig]++;
+
+    if (mReconfigTraceTime == 0) {
+        mReconfigTraceTime = now;
+    } else if (now - mReconfigTraceTime >= seconds(60)) {
+        if (mReconfigCount[HDMI_RECONFIG_SCALE] || mReconfigCount[HDMI_RECONFIG_SOURCE] ||
+            mReconfigCount[HDMI_RECONFIG_FORMAT] || mReconfigCount[HDMI_RECONFIG_OUTPUT])
+            ALOGD("%s::last minute: %u flushes, %u crop updates, %u layer restarts, %u layer reopens (%u with output reset)",
+                  __func__,
+                  mReconfigCount[HDMI_RECONFIG_NONE] + mReconfigCount[HDMI_RECONFIG_SCALE] +
+                  mReconfigCount[HDMI_RECONFIG_SOURCE] + mReconfigCount[HDMI_RECONFIG_FORMAT] +
+                  mReconfigCount[HDMI_RECONFIG_OUTPUT],
+                  mReconfigCount[HDMI_RECONFIG_SCALE], mReconfigCount[HDMI_RECONFIG_SOURCE],
+                  mReconfigCount[HDMI_RECONFIG_FORMAT] + mReconfigCount[HDMI_RECONFIG_OUTPUT],
+                  mReconfigCount[HDMI_RECONFIG_OUTPUT]);
+
+        for (int i = 0; i < HDMI_RECONFIG_MAX; i++)
+            mReconfigCount[i] = 0;
+        mReconfigTraceTime = now;
+    }
+}
+
+#if defined(BOARD_USE_V4L2)
+void SecHdmi::m_getGraphicRect(int w, int h, int hwcLayer, struct v4l2_rect *rect)
+{
+    if (hwcLayer == 0) { /* UI only mode */
+        if (mG2DUIRotVal == 0 || mG2DUIRotVal == 180)
+            hdmi_cal_rect(w, h, mHdmiDstWidth, mHdmiDstHeight, rect);
+        else
+            hdmi_cal_rect(h, w, mHdmiDstWidth, mHdmiDstHeight, rect);
+
+        rect->left = ALIGN(rect->left, 16);
+    } else { /* Video Playback + UI Mode */
+        rect->left = 0;
+        rect->top = 0;
+        rect->width = mHdmiDstWidth;
+        rect->height = mHdmiDstHeight;
+    }
+}
+#endif
+
+bool SecHdmi::m_setLayerCrop(int w, int h, int hdmiLayer, int hwcLayer)
+{
+#ifdef DEBUG_HDMI_HW_LEVEL
+    ALOGD("### %s: hdmiLayer(%d) called", __func__, hdmiLayer);
+#endif
+
+#if defined(BOARD_USE_V4L2)
+    struct v4l2_rect rect;
+
+    m_getGraphicRect(w, h, hwcLayer, &rect);
+
+    /* the mixer picks the new crop up with the next queued buffer */
+    if (hdmi_set_g_crop(mHdmiFd[hdmiLayer], hdmiLayer, w, h,
+                        rect.left, rect.top, rect.width, rect.height) < 0) {
+        ALOGE("%s::hdmi_set_g_crop(%d) fail", __func__, hdmiLayer);
+        return false;
+    }
+
+    mPrevDstWidth[hdmiLayer] = rect.width;
+    mPrevDstHeight[hdmiLayer] = rect.height;
+    if (hwcLayer == 0) {
+        mPrevDstWidth[HDMI_LAYER_VIDEO] = 0;
+        mPrevDstHeight[HDMI_LAYER_VIDEO] = 0;
+    }
+#endif
+    /* without V4L2 flush() sets the window position on every frame */
+
+#if defined(BOARD_USES_FIMGAPI)
+    /* blit again even if the source buffer did not change */
+    cur_g2d_address = 0;
+#endif
+
+    mHdmiLayerChange[hdmiLayer] = false;
+
+    return true;
+}
+
+bool SecHdmi::m_resetLayer(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer)
+{
+#ifdef DEBUG_HDMI_HW_LEVEL
+    ALOGD("### %s: hdmiLayer(%d) called", __func__, hdmiLayer);
+#endif
+
+    mFimcCurrentOutBufIndex = 0;
+
+    if (mFlagHdmiStart[hdmiLayer] == true && m_stopHdmi(hdmiLayer) == false) {
+        ALOGE("%s::m_stopHdmi: layer[%d] fail", __func__, hdmiLayer);
+        return false;
+    }
+
+#if defined(BOARD_USE_V4L2)
+    /* the format can not change while the node still holds buffers */
+    if (tvout_std_v4l2_reqbuf(mHdmiFd[hdmiLayer], V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, V4L2_MEMORY_USERPTR, 0) < 0)
+        ALOGE("%s::tvout_std_v4l2_reqbuf(buf_num=0) layer(%d) fail", __func__, hdmiLayer);
+#endif
+
+#if defined(BOARD_USES_FIMGAPI)
+    if (hdmiLayer != HDMI_LAYER_VIDEO)
+        cur_g2d_address = 0;
+#endif
+
+    if (m_setLayerParams(w, h, colorFormat, hdmiLayer, hwcLayer) == false)
+        return false;
+
+#ifdef BOARD_USE_V4L2
+    for (int i = 0; i < HDMI_FIMC_OUTPUT_BUF_NUM; i++)
+        mFimcReservedMem[i] = *(mSecFimc.getMemAddr(i));
+#endif
+
+    return true;
+}
+
 bool SecHdmi::m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer)
 {
 #ifdef DEBUG_MSG_ENABLE
@@ -1285,9 +1450,6 @@ bool SecHdmi::m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer
     v4l2_std_id std_id = 0;
     mFimcCurrentOutBufIndex = 0;
 
-    int srcW = w;
-    int srcH = h;
-
 #if defined(BOARD_USE_V4L2)
     if (mFlagHdmiStart[hdmiLayer] == true && m_stopHdmi(hdmiLayer) == false) {
         ALOGE("%s::m_stopHdmi: layer[%d] fail", __func__, hdmiLayer);
@@ -1323,6 +1485,7 @@ bool SecHdmi::m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer
         mDstWidth[hdmiLayer] != mPrevDstWidth[hdmiLayer] ||
         mDstHeight[hdmiLayer] != mPrevDstHeight[hdmiLayer] ||
 #endif
+        mHdmiLayerChange[hdmiLayer] == true ||
         colorFormat != mSrcColorFormat[hdmiLayer]) {
         int preVideoSrcColorFormat = mSrcColorFormat[hdmiLayer];
         int videoSrcColorFormat = colorFormat;
@@ -1336,121 +1499,12 @@ bool SecHdmi::m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer
                 preVideoSrcColorFormat = HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP_TILED;
         }
 
-        if (hdmiLayer == HDMI_LAYER_VIDEO) {
-            if (colorFormat != HAL_PIXEL_FORMAT_YCbCr_420_SP &&
-                colorFormat != HAL_PIXEL_FORMAT_YCrCb_420_SP &&
-                colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP &&
-                colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCrCb_420_SP &&
-                colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP_TILED) {
-#ifdef DEBUG_HDMI_HW_LEVEL
-                ALOGD("### %s  call mSecFimc.setSrcParams\n", __func__);
-#endif
-                unsigned int full_wdith = ALIGN(w, 16);
-                unsigned int full_height = ALIGN(h, 2);
-
-                if (mSecFimc.setSrcParams(full_wdith, full_height, 0, 0,
-                            (unsigned int*)&w, (unsigned int*)&h, colorFormat, true) == false) {
-                    ALOGE("%s::mSecFimc.setSrcParams(%d, %d, %d) fail \n",
-                            __func__, w, h, colorFormat);
-                    return false;
-                }
-
-                mFimcDstColorFormat = HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP_TILED;
-
-#ifdef DEBUG_HDMI_HW_LEVEL
-                ALOGD("### %s  call mSecFimc.setDstParams\n", __func__);
-#endif
-                if (mUIRotVal == 0 || mUIRotVal == 180) {
-                    if (mSecFimc.setDstParams((unsigned int)w, (unsigned int)h, 0, 0,
-                                (unsigned int*)&w, (unsigned int*)&h, mFimcDstColorFormat, true) == false) {
-                        ALOGE("%s::mSecFimc.setDstParams(%d, %d, %d) fail \n",
-                                __func__, w, h, mFimcDstColorFormat);
-                        return false;
-                    }
-#if defined(BOARD_USE_V4L2)
-                    hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
-                                    mFimcDstColorFormat, srcW, srcH,
-                                    &mMixerBuffer[hdmiLayer][0],
-                                    0, 0, mHdmiDstWidth, mHdmiDstHeight);
-#endif
-                } else {
-                    if (mSecFimc.setDstParams((unsigned int)h, (unsigned int)w, 0, 0,
-                                (unsigned int*)&h, (unsigned int*)&w, mFimcDstColorFormat, true) == false) {
-                        ALOGE("%s::mSecFimc.setDstParams(%d, %d, %d) fail \n",
-                                __func__, w, h, mFimcDstColorFormat);
-                        return false;
-                    }
-#if defined(BOARD_USE_V4L2)
-                    hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
-                                    mFimcDstColorFormat, srcH, srcW,
-                                    &mMixerBuffer[hdmiLayer][0],
-                                    0, 0, mHdmiDstWidth, mHdmiDstHeight);
-#endif
-                }
-            }
-#if defined(BOARD_USE_V4L2)
-            else {
-                hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
-                                colorFormat, srcW, srcH,
-                                &mMixerBuffer[hdmiLayer][0],
-                                0, 0, mHdmiDstWidth, mHdmiDstHeight);
-            }
-#endif
-            mPrevDstWidth[hdmiLayer] = mHdmiDstWidth;
-            mPrevDstHeight[hdmiLayer] = mHdmiDstHeight;
-        } else {
-#if defined(BOARD_USE_V4L2)
-            struct v4l2_rect rect;
-            int tempSrcW, tempSrcH;
-
-            if (mG2DUIRotVal == 0 || mG2DUIRotVal == 180) {
-                tempSrcW = srcW;
-                tempSrcH = srcH;
-            } else {
-                tempSrcW = srcH;
-                tempSrcH = srcW;
-            }
-
-            hdmi_cal_rect(tempSrcW, tempSrcH, mHdmiDstWidth, mHdmiDstHeight, &rect);
-            rect.left = ALIGN(rect.left, 16);
-
-            if (hwcLayer == 0) { /* UI only mode */
-                hdmi_set_g_param(mHdmiFd[hdmiLayer], hdmiLayer,
-                                colorFormat, srcW, srcH,
-                                &mMixerBuffer[hdmiLayer][0],
-                                rect.left, rect.top, rect.width, rect.height);
-                mPrevDstWidth[hdmiLayer] = rect.width;
-                mPrevDstHeight[hdmiLayer] = rect.height;
-                mPrevDstWidth[HDMI_LAYER_VIDEO] = 0;
-                mPrevDstHeight[HDMI_LAYER_VIDEO] = 0;
-            } else { /* Video Playback + UI Mode */
-                hdmi_set_g_param(mHdmiFd[hdmiLayer], hdmiLayer,
-                                colorFormat, srcW, srcH,
-                                &mMixerBuffer[hdmiLayer][0],
-                                0, 0, mHdmiDstWidth, mHdmiDstHeight);
-                mPrevDstWidth[hdmiLayer] = mHdmiDstWidth;
-                mPrevDstHeight[hdmiLayer] = mHdmiDstHeight;
-            }
-#endif
-        }
+        if (m_setLayerParams(w, h, colorFormat, hdmiLayer, hwcLayer) == false)
+            return false;
 
         if (preVideoSrcColorFormat != videoSrcColorFormat)
             mHdmiInfoChange = true;
 
-        mSrcWidth[hdmiLayer] = srcW;
-        mSrcHeight[hdmiLayer] = srcH;
-        mSrcColorFormat[hdmiLayer] = colorFormat;
-
-        mHdmiResolutionWidth[hdmiLayer] = mHdmiDstWidth;
-        mHdmiResolutionHeight[hdmiLayer] = mHdmiDstHeight;
-
-#ifdef DEBUG_MSG_ENABLE
-        ALOGD("m_reset saved param(%d, %d, %d, %d, %d, %d, %d) \n",
-            srcW, mSrcWidth[hdmiLayer], \
-            srcH, mSrcHeight[hdmiLayer], \
-            colorFormat,mSrcColorFormat[hdmiLayer], \
-            hdmiLayer);
-#endif
     }
 
     if (mHdmiInfoChange == true) {
@@ -1522,12 +1576,118 @@ bool SecHdmi::m_reset(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer
         }
 
         mHdmiInfoChange = false;
+    }
+
 #ifdef BOARD_USE_V4L2
-        for (int i = 0; i < HDMI_FIMC_OUTPUT_BUF_NUM; i++)
-            mFimcReservedMem[i] = *(mSecFimc.getMemAddr(i));
+    /* a layer reset may have reconfigured FIMC */
+    for (int i = 0; i < HDMI_FIMC_OUTPUT_BUF_NUM; i++)
+        mFimcReservedMem[i] = *(mSecFimc.getMemAddr(i));
+#endif
+
+    return true;
+}
+
+bool SecHdmi::m_setLayerParams(int w, int h, int colorFormat, int hdmiLayer, int hwcLayer)
+{
+    int srcW = w;
+    int srcH = h;
+
+    if (hdmiLayer == HDMI_LAYER_VIDEO) {
+        if (colorFormat != HAL_PIXEL_FORMAT_YCbCr_420_SP &&
+            colorFormat != HAL_PIXEL_FORMAT_YCrCb_420_SP &&
+            colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP &&
+            colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCrCb_420_SP &&
+            colorFormat != HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP_TILED) {
+#ifdef DEBUG_HDMI_HW_LEVEL
+            ALOGD("### %s  call mSecFimc.setSrcParams\n", __func__);
+#endif
+            unsigned int full_wdith = ALIGN(w, 16);
+            unsigned int full_height = ALIGN(h, 2);
+
+            if (mSecFimc.setSrcParams(full_wdith, full_height, 0, 0,
+                        (unsigned int*)&w, (unsigned int*)&h, colorFormat, true) == false) {
+                ALOGE("%s::mSecFimc.setSrcParams(%d, %d, %d) fail \n",
+                        __func__, w, h, colorFormat);
+                return false;
+            }
+
+            mFimcDstColorFormat = HAL_PIXEL_FORMAT_CUSTOM_YCbCr_420_SP_TILED;
+
+#ifdef DEBUG_HDMI_HW_LEVEL
+            ALOGD("### %s  call mSecFimc.setDstParams\n", __func__);
+#endif
+            if (mUIRotVal == 0 || mUIRotVal == 180) {
+                if (mSecFimc.setDstParams((unsigned int)w, (unsigned int)h, 0, 0,
+                            (unsigned int*)&w, (unsigned int*)&h, mFimcDstColorFormat, true) == false) {
+                    ALOGE("%s::mSecFimc.setDstParams(%d, %d, %d) fail \n",
+                            __func__, w, h, mFimcDstColorFormat);
+                    return false;
+                }
+#if defined(BOARD_USE_V4L2)
+                hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
+                                mFimcDstColorFormat, srcW, srcH,
+                                &mMixerBuffer[hdmiLayer][0],
+                                0, 0, mHdmiDstWidth, mHdmiDstHeight);
+#endif
+            } else {
+                if (mSecFimc.setDstParams((unsigned int)h, (unsigned int)w, 0, 0,
+                            (unsigned int*)&h, (unsigned int*)&w, mFimcDstColorFormat, true) == false) {
+                    ALOGE("%s::mSecFimc.setDstParams(%d, %d, %d) fail \n",
+                            __func__, w, h, mFimcDstColorFormat);
+                    return false;
+                }
+#if defined(BOARD_USE_V4L2)
+                hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
+                                mFimcDstColorFormat, srcH, srcW,
+                                &mMixerBuffer[hdmiLayer][0],
+                                0, 0, mHdmiDstWidth, mHdmiDstHeight);
+#endif
+            }
+        }
+#if defined(BOARD_USE_V4L2)
+        else {
+            hdmi_set_v_param(mHdmiFd[hdmiLayer], hdmiLayer,
+                            colorFormat, srcW, srcH,
+                            &mMixerBuffer[hdmiLayer][0],
+                            0, 0, mHdmiDstWidth, mHdmiDstHeight);
+        }
+#endif
+        mPrevDstWidth[hdmiLayer] = mHdmiDstWidth;
+        mPrevDstHeight[hdmiLayer] = mHdmiDstHeight;
+    } else {
+#if defined(BOARD_USE_V4L2)
+        struct v4l2_rect rect;
+
+        m_getGraphicRect(srcW, srcH, hwcLayer, &rect);
+        hdmi_set_g_param(mHdmiFd[hdmiLayer], hdmiLayer,
+                        colorFormat, srcW, srcH,
+                        &mMixerBuffer[hdmiLayer][0],
+                        rect.left, rect.top, rect.width, rect.height);
+        mPrevDstWidth[hdmiLayer] = rect.width;
+        mPrevDstHeight[hdmiLayer] = rect.height;
+        if (hwcLayer == 0) { /* UI only mode */
+            mPrevDstWidth[HDMI_LAYER_VIDEO] = 0;
+            mPrevDstHeight[HDMI_LAYER_VIDEO] = 0;
+        }
 #endif
     }
 
+    mSrcWidth[hdmiLayer] = srcW;
+    mSrcHeight[hdmiLayer] = srcH;
+    mSrcColorFormat[hdmiLayer] = colorFormat;
+
+    mHdmiResolutionWidth[hdmiLayer] = mHdmiDstWidth;
+    mHdmiResolutionHeight[hdmiLayer] = mHdmiDstHeight;
+    mHdmiLayerChange[hdmiLayer] = false;
+
+#ifdef DEBUG_MSG_ENABLE
+    ALOGD("m_reset saved param(%d, %d, %d, %d, %d, %d, %d) \n",
+        srcW, mSrcWidth[hdmiLayer], \
+        srcH, mSrcHeight[hdmiLayer], \
+        colorFormat,mSrcColorFormat[hdmiLayer], \
+        hdmiLayer);
+#endif
+
     return true;
 }
 
@@ -1436,6 +1436,36 @@ int hdmi_set_g_param(int fd, int layer,
     return 0;
 }
 
+/* moves a running graphic layer; the size must match hdmi_set_g_param() */
+int hdmi_set_g_crop(int fd, int layer,
+                      int src_w, int src_h,
+                      int dst_x, int dst_y, int dst_w, int dst_h)
+{
+#ifdef DEBUG_HDMI_HW_LEVEL
+    ALOGD("%s", __func__);
+#endif
+
+    struct v4l2_rect rect;
+
+    rect.left   = dst_x;
+    rect.top    = dst_y;
+
+#if defined(BOARD_USES_FIMGAPI)
+    rect.width  = dst_w;
+    rect.height = dst_h;
+#else
+    rect.width  = src_w;
+    rect.height = src_h;
+#endif
+
+    if (tvout_std_v4l2_s_crop(fd, V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE, V4L2_FIELD_ANY, rect.left, rect.top, rect.width, rect.height) < 0) {
+        ALOGE("%s::tvout_std_v4l2_s_crop() [layer=%d] failed", __func__, layer);
+        return -1;
+    }
+
+    return 0;
+}
+
 int hdmi_set_g_scaling(int layer,
         int srcColorFormat,
         int src_w, int src_h,
@@ -51,14 +51,63 @@ namespace android {
 
     int SecTVOutService::HdmiFlushThread()
     {
+        SecHdmiFrameMailbox::Frame frame;
+
         while (!mExitHdmiFlushThread) {
             nsecs_t timeout = -1;
             sp<MessageBase> msg = mHdmiEventQueue.waitMessage(timeout);
+
+            /* postFrame() invalidates the queue to wake us up */
+            for (uint32_t mode = HDMI_MODE_UI; mode <= HDMI_MODE_VIDEO; mode++) {
+                if (mHdmiFrameMailbox.take(mode, &frame))
+                    flushFrame(mode, frame);
+            }
         }
 
         return 0;
     }
 
+    void SecTVOutService::flushFrame(uint32_t hdmiMode, const SecHdmiFrameMailbox::Frame &frame)
+    {
+#if defined(CHECK_UI_TIME) || defined(CHECK_VIDEO_TIME)
+        nsecs_t start, end;
+        start = systemTime();
+#endif
+        if (mSecHdmi.flush(frame.srcWidth, frame.srcHeight, frame.srcColorFormat,
+                           frame.srcYAddr, frame.srcCbAddr, frame.srcCrAddr,
+                           frame.dstX, frame.dstY, frame.hdmiLayer, frame.hwcLayer) == false)
+            ALOGE("%s::mSecHdmi.flush() fail on %s", __func__,
+                  hdmiMode == HDMI_MODE_UI ? "HDMI_MODE_UI" : "HDMI_MODE_VIDEO");
+#if defined(CHECK_UI_TIME) || defined(CHECK_VIDEO_TIME)
+        end = systemTime();
+        ALOGD("[%s] mSecHdmi.flush[end-start] = %ld ms, dropped %u",
+              hdmiMode == HDMI_MODE_UI ? "UI" : "VIDEO",
+              long(ns2ms(end)) - long(ns2ms(start)), mHdmiFrameMailbox.droppedCount(hdmiMode));
+#endif
+    }
+
+    void SecTVOutService::postFrame(uint32_t hdmiMode, uint32_t w, uint32_t h, uint32_t colorFormat,
+                                    uint32_t pPhyYAddr, uint32_t pPhyCbAddr, uint32_t pPhyCrAddr,
+                                    uint32_t dstX, uint32_t dstY, uint32_t hdmiLayer)
+    {
+        SecHdmiFrameMailbox::Frame frame;
+
+        frame.srcWidth = w;
+        frame.srcHeight = h;
+        frame.srcColorFormat = colorFormat;
+        frame.srcYAddr = pPhyYAddr;
+        frame.srcCbAddr = pPhyCbAddr;
+        frame.srcCrAddr = pPhyCrAddr;
+        frame.dstX = dstX;
+        frame.dstY = dstY;
+        frame.hdmiLayer = hdmiLayer;
+        frame.hwcLayer = mHwcLayer;
+
+        /* a stale frame still in the mailbox is simply replaced */
+        mHdmiFrameMailbox.post(hdmiMode, frame);
+        mHdmiEventQueue.invalidate();
+    }
+
     int SecTVOutService::instantiate()
     {
         ALOGD("SecTVOutService instantiate");
@@ -123,6 +172,7 @@ namespace android {
         if (mHdmiFlushThread != NULL) {
             mHdmiFlushThread->requestExit();
             mExitHdmiFlushThread = true;
+            mHdmiEventQueue.invalidate();
             mHdmiFlushThread->requestExitAndWait();
             mHdmiFlushThread.clear();
         }
@@ -283,8 +333,6 @@ namespace android {
         nsecs_t start, end;
 #endif
 
-        sp<MessageBase> msg;
-
         switch (hdmiMode) {
         case HDMI_MODE_UI :
             if (mHwcLayer >= 2)
@@ -331,13 +379,8 @@ namespace android {
 #endif
             }
 #else
-            {
-                msg = new SecHdmiEventMsg(&mSecHdmi, w, h, colorFormat, pPhyYAddr, pPhyCbAddr, pPhyCrAddr,
-                                            dstX, dstY, mUILayerMode, mHwcLayer, HDMI_MODE_UI);
-
-                /* post to HdmiEventQueue */
-                mHdmiEventQueue.postMessage(msg, 0, 0);
-            }
+            postFrame(HDMI_MODE_UI, w, h, colorFormat, pPhyYAddr, pPhyCbAddr, pPhyCrAddr,
+                        dstX, dstY, mUILayerMode);
 #endif
             break;
 
@@ -363,11 +406,8 @@ namespace android {
             ALOGD("[Video] mSecHdmi.flush[end-start] = %ld ms", long(ns2ms(end)) - long(ns2ms(start)));
 #endif
 #else
-            msg = new SecHdmiEventMsg(&mSecHdmi, w, h, colorFormat, pPhyYAddr, pPhyCbAddr, pPhyCrAddr,
-                                        dstX, dstY, SecHdmi::HDMI_LAYER_VIDEO, mHwcLayer, HDMI_MODE_VIDEO);
-
-            /* post to HdmiEventQueue */
-            mHdmiEventQueue.postMessage(msg, 0, 0);
+            postFrame(HDMI_MODE_VIDEO, w, h, colorFormat, pPhyYAddr, pPhyCbAddr, pPhyCrAddr,
+                        dstX, dstY, SecHdmi::HDMI_LAYER_VIDEO);
 #endif
             break;
 
@@ -40,6 +40,69 @@ namespace android {
 //#define CHECK_VIDEO_TIME
 //#define CHECK_UI_TIME
 
+    /*
+     * Latest-frame mailbox per HDMI mode. A newer frame overwrites a frame
+     * that has not been flushed yet, so a slow flush drops stale frames
+     * instead of queueing them.
+     */
+    class SecHdmiFrameMailbox {
+        public:
+            enum {
+                HDMI_MODE_NONE = 0,
+                HDMI_MODE_UI,
+                HDMI_MODE_VIDEO,
+                HDMI_MODE_MAX,
+            };
+
+            struct Frame {
+                uint32_t    srcWidth, srcHeight;
+                uint32_t    srcColorFormat;
+                uint32_t    srcYAddr, srcCbAddr, srcCrAddr;
+                uint32_t    dstX, dstY;
+                uint32_t    hdmiLayer, hwcLayer;
+            };
+
+            SecHdmiFrameMailbox() {
+                for (int i = 0; i < HDMI_MODE_MAX; i++) {
+                    mPending[i] = false;
+                    mDropped[i] = 0;
+                }
+            }
+
+            /* returns true if an unflushed frame was overwritten */
+            bool post(uint32_t hdmiMode, const Frame &frame) {
+                Mutex::Autolock _l(mLock);
+                bool dropped = mPending[hdmiMode];
+
+                if (dropped)
+                    mDropped[hdmiMode]++;
+                mFrame[hdmiMode] = frame;
+                mPending[hdmiMode] = true;
+                return dropped;
+            }
+
+            bool take(uint32_t hdmiMode, Frame *frame) {
+                Mutex::Autolock _l(mLock);
+
+                if (mPending[hdmiMode] == false)
+                    return false;
+                *frame = mFrame[hdmiMode];
+                mPending[hdmiMode] = false;
+                return true;
+            }
+
+            uint32_t droppedCount(uint32_t hdmiMode) const {
+                Mutex::Autolock _l(mLock);
+                return mDropped[hdmiMode];
+            }
+
+        private:
+            mutable Mutex   mLock;
+            Frame           mFrame[HDMI_MODE_MAX];
+            bool            mPending[HDMI_MODE_MAX];
+            uint32_t        mDropped[HDMI_MODE_MAX];
+    };
+
     class SecTVOutService : public BBinder
     {
         public :
@@ -68,8 +131,14 @@ namespace android {
 
             sp<HDMIFlushThread>     mHdmiFlushThread;
             int                     HdmiFlushThread();
+            void                    flushFrame(uint32_t hdmiMode, const SecHdmiFrameMailbox::Frame &frame);
+            void                    postFrame(uint32_t hdmiMode, uint32_t w, uint32_t h, uint32_t colorFormat,
+                                                uint32_t pPhyYAddr, uint32_t pPhyCbAddr, uint32_t pPhyCrAddr,
+                                                uint32_t dstX, uint32_t dstY, uint32_t hdmiLayer);
 
+            /* control events only, frames go through mHdmiFrameMailbox */
             mutable MessageQueue    mHdmiEventQueue;
+            SecHdmiFrameMailbox     mHdmiFrameMailbox;
             bool                    mExitHdmiFlushThread;
 
             SecTVOutService();
@@ -99,76 +168,5 @@ namespace android {
             uint32_t                    mHwcLayer;
     };
 
-    class SecHdmiEventMsg : public MessageBase {
-        public:
-            enum {
-                HDMI_MODE_NONE = 0,
-                HDMI_MODE_UI,
-                HDMI_MODE_VIDEO,
-            };
-
-            mutable     Mutex mBlitLock;
-
-            SecHdmi     *pSecHdmi;
-            uint32_t    mSrcWidth, mSrcHeight;
-            uint32_t    mSrcColorFormat;
-            uint32_t    mSrcYAddr, mSrcCbAddr, mSrcCrAddr;
-            uint32_t    mDstX, mDstY;
-            uint32_t    mHdmiMode;
-            uint32_t    mHdmiLayer, mHwcLayer;
-
-            SecHdmiEventMsg(SecHdmi *SecHdmi, uint32_t srcWidth, uint32_t srcHeight, uint32_t srcColorFormat,
-                    uint32_t srcYAddr, uint32_t srcCbAddr, uint32_t srcCrAddr,
-                    uint32_t dstX, uint32_t dstY, uint32_t hdmiLayer, uint32_t hwcLayer, uint32_t hdmiMode)
-                : pSecHdmi(SecHdmi), mSrcWidth(srcWidth), mSrcHeight(srcHeight), mSrcColorFormat(srcColorFormat),
-                mSrcYAddr(srcYAddr), mSrcCbAddr(srcCbAddr), mSrcCrAddr(srcCrAddr),
-                mDstX(dstX), mDstY(dstY), mHdmiLayer(hdmiLayer), mHwcLayer(hwcLayer), mHdmiMode(hdmiMode) {
-            }
-
-            virtual bool handler() {
-                Mutex::Autolock _l(mBlitLock);
-                bool ret = true;
-#if defined(CHECK_UI_TIME) || defined(CHECK_VIDEO_TIME)
-                nsecs_t start, end;
-#endif
-
-                switch (mHdmiMode) {
-                case HDMI_MODE_UI:
-#ifdef CHECK_UI_TIME
-                    start = systemTime();
-#endif
-                    if (pSecHdmi->flush(mSrcWidth, mSrcHeight, mSrcColorFormat, mSrcYAddr, mSrcCbAddr, mSrcCrAddr,
-                                mDstX, mDstY, mHdmiLayer, mHwcLayer) == false) {
-                        ALOGE("%s::pSecHdmi->flush() fail on HDMI_MODE_UI", __func__);
-                        ret = false;
-                    }
-#ifdef CHECK_UI_TIME
-                    end = systemTime();
-                    ALOGD("[UI] pSecHdmi->flush[end-start] = %ld ms", long(ns2ms(end)) - long(ns2ms(start)));
-#endif
-                    break;
-                case HDMI_MODE_VIDEO:
-#ifdef CHECK_VIDEO_TIME
-                    start = systemTime();
-#endif
-                    if (pSecHdmi->flush(mSrcWidth, mSrcHeight, mSrcColorFormat, mSrcYAddr, mSrcCbAddr, mSrcCrAddr,
-                                mDstX, mDstY, mHdmiLayer, mHwcLayer) == false) {
-                        ALOGE("%s::pSecHdmi->flush() fail on HDMI_MODE_VIDEO", __func__);
-                        ret = false;
-                    }
-#ifdef CHECK_VIDEO_TIME
-                    end = systemTime();
-                    ALOGD("[VIDEO] pSecHdmi->flush[end-start] = %ld ms", long(ns2ms(end)) - long(ns2ms(start)));
-#endif
-                    break;
-                default:
-                    ALOGE("Undefined HDMI_MODE");
-                    ret = false;
-                    break;
-                }
-                return ret;
-            }
-    };
-
 };
 #endif
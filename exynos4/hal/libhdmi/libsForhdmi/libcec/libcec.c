@@ -21,6 +21,10 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 #include <cutils/log.h>
 
 /* drv. header */
@@ -53,7 +57,15 @@ static struct {
     { CEC_DEVICE_PLAYER,  11 },
 };
 
+/** Number of frames the outbound queue can hold */
+#define CEC_TX_QUEUE_SIZE       8
+/** Number of retries before an outbound frame is dropped */
+#define CEC_TX_MAX_RETRY        4
+/** First retry delay in microseconds, doubled on every retry */
+#define CEC_TX_RETRY_DELAY      20000
+
 static int CECSetLogicalAddr(unsigned int laddr);
+static void CECFlushQueue(void);
 
 #ifdef CEC_DEBUG
 inline static void CECPrintFrame(unsigned char *buffer, unsigned int size);
@@ -61,6 +73,56 @@ inline static void CECPrintFrame(unsigned char *buffer, unsigned int size);
 
 static int fd = -1;
 
+/** Pipe used to wake up CECProcess(), [0] is polled, [1] is written */
+static int wakefd[2] = { -1, -1 };
+
+/** Current logical address, messages from it are ignored */
+static unsigned char curLaddr = CEC_LADDR_UNREGISTERED;
+
+static struct {
+    CECMessageHandler handler;
+    void *data;
+} handlers[256], defaultHandler;
+
+static struct {
+    unsigned char buffer[CEC_MAX_FRAME_SIZE];
+    int size;
+} txQueue[CEC_TX_QUEUE_SIZE];
+
+static unsigned int txHead;
+static unsigned int txCount;
+static unsigned int txRetry;
+/** Monotonic time in microseconds before which the queue head is not resent */
+static long long txDeadline;
+
+static struct CECStats stats;
+
+/**
+ * Get monotonic time.
+ *
+ * @return monotonic time in microseconds.
+ */
+static long long CECGetTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/**
+ * Reset outbound queue, handlers and statistics.
+ */
+static void CECResetState(void)
+{
+    txHead = txCount = txRetry = 0;
+    txDeadline = 0;
+    curLaddr = CEC_LADDR_UNREGISTERED;
+    memset(handlers, 0, sizeof(handlers));
+    memset(&defaultHandler, 0, sizeof(defaultHandler));
+    memset(&stats, 0, sizeof(stats));
+}
+
 /**
  * Open device driver and assign CEC file descriptor.
  *
@@ -73,8 +135,17 @@ int CECOpen()
     if (fd != -1)
         CECClose();
 
+    CECResetState();
+
     if ((fd = open(CEC_DEVICE_NAME, O_RDWR)) < 0) {
         ALOGE("Can't open %s!\n", CEC_DEVICE_NAME);
+        return 0;
+    }
+
+    if (pipe2(wakefd, O_NONBLOCK | O_CLOEXEC) < 0) {
+        ALOGE("pipe2() failed!\n");
+        wakefd[0] = wakefd[1] = -1;
+        CECClose();
         res = 0;
     }
 
@@ -98,6 +169,14 @@ int CECClose()
         fd = -1;
     }
 
+    if (wakefd[0] != -1) {
+        close(wakefd[0]);
+        close(wakefd[1]);
+        wakefd[0] = wakefd[1] = -1;
+    }
+
+    CECResetState();
+
     return res;
 }
 
@@ -249,9 +328,260 @@ int CECSetLogicalAddr(unsigned int laddr)
         return 0;
     }
 
+    curLaddr = laddr;
+
+    return 1;
+}
+
+/**
+ * Set handler for a CEC opcode.
+ *
+ * @param opcode  [in] CEC opcode.
+ * @param handler [in] handler to call from CECProcess(), or NULL to use the default handler.
+ * @param data    [in] user data passed to handler.
+ *
+ * @return 1 if success, otherwise, return 0.
+ */
+int CECSetHandler(unsigned char opcode, CECMessageHandler handler, void *data)
+{
+    handlers[opcode].handler = handler;
+    handlers[opcode].data = data;
+
+    return 1;
+}
+
+/**
+ * Set handler for CEC opcodes without a registered handler.
+ *
+ * @param handler [in] handler to call from CECProcess().
+ * @param data    [in] user data passed to handler.
+ *
+ * @return 1 if success, otherwise, return 0.
+ */
+int CECSetDefaultHandler(CECMessageHandler handler, void *data)
+{
+    defaultHandler.handler = handler;
+    defaultHandler.data = data;
+
+    return 1;
+}
+
+/**
+ * Queue CEC message. The message is sent right away if the queue is empty,
+ * otherwise from CECProcess(). A failed send is retried with exponential
+ * backoff up to CEC_TX_MAX_RETRY times.
+ * Must be called from the thread that runs CECProcess().
+ *
+ * @param *buffer   [in] pointer to buffer address where message located.
+ * @param size      [in] message size.
+ *
+ * @return 1 if message is queued, or 0 if an arror occured.
+ */
+int CECQueueMessage(const unsigned char *buffer, int size)
+{
+    unsigned int tail;
+
+    if (fd == -1) {
+        ALOGE("open device first!\n");
+        return 0;
+    }
+
+    if (size <= 0 || size > CEC_MAX_FRAME_SIZE) {
+        ALOGE("size should not exceed %d\n", CEC_MAX_FRAME_SIZE);
+        return 0;
+    }
+
+    if (txCount == CEC_TX_QUEUE_SIZE) {
+        ALOGE("CEC tx queue is full!\n");
+        return 0;
+    }
+
+    tail = (txHead + txCount) % CEC_TX_QUEUE_SIZE;
+    memcpy(txQueue[tail].buffer, buffer, size);
+    txQueue[tail].size = size;
+    txCount++;
+
+    CECFlushQueue();
+
+    return 1;
+}
+
+/**
+ * Send queued messages until the queue is empty or a send fails.
+ */
+static void CECFlushQueue(void)
+{
+    while (txCount) {
+        if (txDeadline && CECGetTime() < txDeadline)
+            return;
+
+        if (write(fd, txQueue[txHead].buffer, txQueue[txHead].size) == txQueue[txHead].size) {
+            stats.txCount++;
+        } else if (txRetry < CEC_TX_MAX_RETRY) {
+            txDeadline = CECGetTime() + ((long long)CEC_TX_RETRY_DELAY << txRetry);
+            txRetry++;
+            stats.txRetries++;
+            return;
+        } else {
+            ALOGE("CEC message(opcode: 0x%x) dropped after %d retries\n",
+                  txQueue[txHead].size > 1 ? txQueue[txHead].buffer[1] : 0, txRetry);
+            stats.txDropped++;
+        }
+
+        txHead = (txHead + 1) % CEC_TX_QUEUE_SIZE;
+        txCount--;
+        txRetry = 0;
+        txDeadline = 0;
+    }
+}
+
+/**
+ * Validate a received CEC message and call its handler.
+ *
+ * @param *buffer   [in] received frame.
+ * @param size      [in] frame size.
+ */
+static void CECDispatchMessage(unsigned char *buffer, int size)
+{
+    unsigned char lsrc, opcode;
+
+    if (size == 1)
+        return; // "Polling Message"
+
+    lsrc = buffer[0] >> 4;
+
+    /* ignore messages with src address == own address */
+    if (lsrc == curLaddr)
+        return;
+
+    opcode = buffer[1];
+
+    if (CECIgnoreMessage(opcode, lsrc)) {
+        ALOGE("### ignore message coming from address 15 (unregistered)\n");
+        return;
+    }
+
+    if (!CECCheckMessageSize(opcode, size)) {
+        ALOGE("### invalid message size: %d(opcode: 0x%x) ###\n", size, opcode);
+        return;
+    }
+
+    /* check if message broadcasted/directly addressed */
+    if (!CECCheckMessageMode(opcode, (buffer[0] & 0x0F) == CEC_MSG_BROADCAST ? 1 : 0)) {
+        ALOGE("### invalid message mode (directly addressed/broadcast) ###\n");
+        return;
+    }
+
+    if (handlers[opcode].handler)
+        handlers[opcode].handler(buffer, size, handlers[opcode].data);
+    else if (defaultHandler.handler)
+        defaultHandler.handler(buffer, size, defaultHandler.data);
+}
+
+/**
+ * Wait for a CEC message, dispatch it to its handler and send queued messages.
+ *
+ * @param timeout   [in] timeout in microseconds.
+ *
+ * @return 1 if a message was received, 0 on timeout, or -1 if woken up by CECWakeup() or an error occured.
+ */
+int CECProcess(long timeout)
+{
+    unsigned char buffer[CEC_MAX_FRAME_SIZE];
+    struct pollfd fds[2];
+    long long now;
+    int size, retval;
+
+    if (fd == -1) {
+        ALOGE("open device first!\n");
+        return -1;
+    }
+
+    /* wake up in time for the next retry */
+    if (txCount) {
+        now = CECGetTime();
+        if (txDeadline <= now)
+            timeout = 0;
+        else if (txDeadline - now < timeout)
+            timeout = txDeadline - now;
+    }
+
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wakefd[0];
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    retval = poll(fds, 2, (timeout + 999) / 1000);
+    if (retval < 0) {
+        if (errno != EINTR)
+            ALOGE("poll() failed!\n");
+        return errno == EINTR ? 0 : -1;
+    }
+
+    if (fds[1].revents & POLLIN) {
+        char drain[8];
+        while (read(wakefd[0], drain, sizeof(drain)) > 0);
+        return -1;
+    }
+
+    retval = 0;
+    if (fds[0].revents & POLLIN) {
+        now = CECGetTime();
+        size = read(fd, buffer, CEC_MAX_FRAME_SIZE);
+        if (size > 0) {
+            long long latency;
+#if CEC_DEBUG
+            ALOGI("CECProcess() : size(%d)", size);
+            CECPrintFrame(buffer, size);
+#endif
+            CECDispatchMessage(buffer, size);
+
+            latency = CECGetTime() - now;
+            stats.rxCount++;
+            stats.latencyTotal += latency;
+            if (latency > stats.latencyMax)
+                stats.latencyMax = latency;
+            retval = 1;
+        }
+    }
+
+    CECFlushQueue();
+
+    return retval;
+}
+
+/**
+ * Wake up CECProcess() waiting in another thread.
+ *
+ * @return 1 if success, otherwise, return 0.
+ */
+int CECWakeup()
+{
+    char c = 0;
+
+    if (wakefd[1] == -1)
+        return 0;
+
+    if (write(wakefd[1], &c, 1) != 1 && errno != EAGAIN) {
+        ALOGE("write() to wakeup pipe failed!\n");
+        return 0;
+    }
+
     return 1;
 }
 
+/**
+ * Get CEC message handling statistics.
+ *
+ * @param *out      [out] statistics.
+ */
+void CECGetStats(struct CECStats *out)
+{
+    *out = stats;
+}
+
 #if CEC_DEBUG
 /**
  * Print CEC frame.
@@ -192,12 +192,46 @@ enum CECDeviceType {
     CEC_DEVICE_AUDIO,
 };
 
+/**
+ * Handler for a received CEC message.
+ * @param buffer [in] whole frame, header block first.
+ * @param size   [in] frame size.
+ * @param data   [in] user data given at registration.
+ */
+typedef void (*CECMessageHandler)(unsigned char *buffer, int size, void *data);
+
+/**
+ * @struct CECStats
+ * CEC message handling statistics
+ */
+struct CECStats {
+    /** Number of dispatched messages */
+    unsigned int rxCount;
+    /** Number of sent queued messages */
+    unsigned int txCount;
+    /** Number of send retries */
+    unsigned int txRetries;
+    /** Number of queued messages dropped after last retry */
+    unsigned int txDropped;
+    /** Sum of receive to handler return time in microseconds */
+    long long    latencyTotal;
+    /** Max receive to handler return time in microseconds */
+    long long    latencyMax;
+};
+
 int CECOpen();
 int CECClose();
 int CECAllocLogicalAddress(int paddr, enum CECDeviceType devtype);
 int CECSendMessage(unsigned char *buffer, int size);
 int CECReceiveMessage(unsigned char *buffer, int size, long timeout);
 
+int CECSetHandler(unsigned char opcode, CECMessageHandler handler, void *data);
+int CECSetDefaultHandler(CECMessageHandler handler, void *data);
+int CECQueueMessage(const unsigned char *buffer, int size);
+int CECProcess(long timeout);
+int CECWakeup();
+void CECGetStats(struct CECStats *stats);
+
 int CECIgnoreMessage(unsigned char opcode, unsigned char lsrc);
 int CECCheckMessageSize(unsigned char opcode, int size);
 int CECCheckMessageMode(unsigned char opcode, int broadcast);
@@ -29,4 +29,6 @@ LOCAL_C_INCLUDES := \
 LOCAL_MODULE := libedid
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif
@@ -58,6 +58,17 @@
 
 #define EDID_VSDB_MIN_LENGTH_VAL                        (5)
 
+// for HDMI Forum VSDB (OUI C4-5D-D8)
+#define EDID_HF_VSDB_MIN_LENGTH_VAL                     (7)
+#define EDID_HF_VSDB_MAX_TMDS_RATE_POS                  (5)
+#define EDID_HF_VSDB_SCDC_POS                           (6)
+#define EDID_HF_VSDB_SCDC_PRESENT                       (1<<7)
+#define EDID_HF_VSDB_RR_CAPABLE                         (1<<6)
+#define EDID_HF_VSDB_LTE_340MCSC_SCRAMBLE               (1<<3)
+#define EDID_HF_VSDB_SCDC_MASK                          (EDID_HF_VSDB_SCDC_PRESENT | \
+                                                         EDID_HF_VSDB_RR_CAPABLE | \
+                                                         EDID_HF_VSDB_LTE_340MCSC_SCRAMBLE)
+
 // for Established Timings
 #define EDID_ET_POS                                     (0x23)
 #define EDID_ET_640x480p_VAL                            (0x20)
@@ -145,6 +156,8 @@
 // latency
 #define EDID_HDMI_LATENCY_MASK                          (1<<7|1<<6)
 #define EDID_HDMI_LATENCY_POS                           (6)
+#define EDID_HDMI_LATENCY_PRESENT                       (1<<7)
+#define EDID_HDMI_I_LATENCY_PRESENT                     (1<<6)
 
 #define EDID_HDMI_3D_PRESENT_POS                        (13)
 #define EDID_HDMI_3D_PRESENT_MASK                       (1<<7)
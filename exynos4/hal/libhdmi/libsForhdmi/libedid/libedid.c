@@ -47,12 +47,6 @@ static unsigned char* gEdidData;
 static int gExtensions;
 
 
-/**
- * @var aVIC
- * This contains first 16 VIC in EDID
- */
-static unsigned char aVIC[NUM_OF_VIC_FOR_3D];
-
 //! Structure for parsing video timing parameter in EDID
 static const struct edid_params {
     /** H Total */
@@ -152,6 +146,114 @@ static const struct edid_3d_mandatory {
     { v1280x720p_50Hz, HDMI_3D_TB_FORMAT },     // 1280x720p @ 50Hz
 };
 
+#define NUM_OF_VIDEO_PARAMS         (sizeof(aVideoParams)/sizeof(aVideoParams[0]))
+#define EDID_MAX_DTD                32
+#define EDID_MAX_SAD                32
+#define EDID_NUM_OF_VIC             128
+#define EDID_MAX_HDMI_VIC           7
+
+#define EDID_RES_VIC_4_3            (1<<0)
+#define EDID_RES_VIC_16_9           (1<<1)
+
+//! Structure for Detailed Timing Descriptor parsed from EDID
+struct edid_dtd {
+    /** Pixel clock in 10kHz */
+    unsigned int pixelclock;
+
+    /** H Blank */
+    unsigned int hblank;
+
+    /** H Active */
+    unsigned int hactive;
+
+    /** V Blank */
+    unsigned int vblank;
+
+    /** V Active */
+    unsigned int vactive;
+
+    /** 0 if progressive, 1 if interlaced */
+    unsigned int interlaced;
+};
+
+//! Structure for Short Audio Descriptor parsed from EDID
+struct edid_sad {
+    /** Audio format code (unshifted) */
+    int audioFormat;
+
+    /** Max number of channels - 1 */
+    unsigned int channelNum;
+
+    /** Supported sample frequencies */
+    int sampleFreq;
+
+    /** Supported word lengths (LPCM only) */
+    int wordLen;
+};
+
+//! Structure for sink capabilities, parsed once from gEdidData by EDIDRead()
+static struct edid_caps {
+    /** 1 if the table below describes the current gEdidData */
+    int valid;
+
+    /** 1 if any extension block contains an HDMI VSDB */
+    int hdmiMode;
+
+    /** Offset of the first HDMI VSDB in a timing extension, 0 if none */
+    unsigned int vsdbOffset;
+
+    /** Max TMDS clock in 5MHz units, 0 if not available */
+    unsigned int maxTMDS;
+
+    /** Offset of the first HDMI Forum VSDB in a timing extension, 0 if none */
+    unsigned int hfVsdbOffset;
+
+    /** Max TMDS character rate of HF-VSDB in 5MHz units, 0 if not above 340MHz */
+    unsigned int maxTMDSCharRate;
+
+    /** EDID_HF_VSDB_SCDC_MASK flags of HF-VSDB, 0 if none */
+    int scdc;
+
+    /** 1 if the VSDB sets 3D_present, i.e. the mandatory 3D formats are supported */
+    int present3D;
+
+    /** HDMI_VIC codes of the VSDB */
+    unsigned char hdmiVIC[EDID_MAX_HDMI_VIC];
+    int numHdmiVIC;
+
+    /** First 16 VICs of the SVDs, in EDID order */
+    unsigned char vic3D[NUM_OF_VIC_FOR_3D];
+
+    /** HDMI3DVideoStructure bits supported by each entry of vic3D */
+    unsigned int structure3D[NUM_OF_VIC_FOR_3D];
+
+    /** Deep color flags of VSDB, -1 if not available */
+    int deepColor;
+
+    /** OR of color space flags of all timing extensions */
+    int colorSpace;
+
+    /** Extended colorimetry flags, -1 if no colorimetry block */
+    int colorimetry;
+
+    /** Gamut metadata profile of the colorimetry block */
+    int metadata;
+
+    /** Supported CEA VICs */
+    unsigned char vicMap[EDID_NUM_OF_VIC / SIZEOFBYTE];
+
+    /** Detailed timings of EDID block and timing extensions */
+    struct edid_dtd dtd[EDID_MAX_DTD];
+    int numDTD;
+
+    /** Short audio descriptors of timing extensions */
+    struct edid_sad sad[EDID_MAX_SAD];
+    int numSAD;
+
+    /** EDID_RES_VIC_* flags of supported resolutions, indexed by VideoFormat */
+    unsigned char resolution[NUM_OF_VIDEO_PARAMS];
+} gEdidCaps;
+
 /**
  * Calculate a checksum.
  *
@@ -285,28 +387,9 @@ static int GetVSDBOffset(const int extension)
     return 0;
 }
 
-/**
- * Check if Sink supports the HDMI mode.
- * @return  If Sink supports HDMI mode, return 1; Otherwise, return 0.
- */
-static int CheckHDMIMode(void)
-{
-    int i;
-
-    // read EDID
-    if (!EDIDRead())
-        return 0;
-
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++)
-        if (GetVSDBOffset(i) > 0) // if there is a VSDB, it means RX support HDMI mode
-            return 1;
-
-    return 0;
-}
-
 /**
  * Check if EDID extension block is timing extension block or not.
+ * gEdidCaps.hdmiMode must be parsed before calling this.
  * @param   extension   [in] The number of EDID extension block to check
  * @return  If the block is timing extension, return 1; Otherwise, return 0.
  */
@@ -324,7 +407,7 @@ static int IsTimingExtension(const int extension)
         if (gEdidData[extension*SIZEOFEDIDBLOCK + EDID_TIMING_EXT_REV_NUMBER_POS] == 3)
             ret = 1;
         // revison num != 3 && DVI mode
-        else if (!CheckHDMIMode() &&
+        else if (!gEdidCaps.hdmiMode &&
                 gEdidData[extension*SIZEOFEDIDBLOCK + EDID_TIMING_EXT_REV_NUMBER_POS] != 2)
             ret = 1;
     }
@@ -332,123 +415,66 @@ static int IsTimingExtension(const int extension)
 }
 
 /**
- * Check if the video format is contained in - @n
- * Detailed Timing Descriptor(DTD) of EDID extension block.
- * @param   extension   [in]    Number of EDID extension block to check
- * @param   videoFormat [in]    Video format to check
- * @return  If the video format is contained in DTD of EDID extension block, -@n
- *        return 1; Otherwise, return 0.
+ * Parse Detailed Timing Descriptors(DTD) into gEdidCaps.
+ * @param   StartOffset [in]    Offset of first DTD in gEdidData
+ * @param   EndOffset   [in]    Offset where DTD area ends in gEdidData
  */
-static int IsContainVideoDTD(const int extension,const enum VideoFormat videoFormat)
+static void ParseDTD(const unsigned int StartOffset, const unsigned int EndOffset)
 {
-    int i, StartOffset, EndOffset;
+    unsigned int i;
 
-    if (!EDIDValid() || (extension > gExtensions)) {
-        DPRINTF("EDID Data is not available\n");
-        return 0;
-    }
-
-    // if edid block( 0th block )
-    if (extension == 0) {
-        StartOffset = EDID_DTD_START_ADDR;
-        EndOffset = StartOffset + EDID_DTD_TOTAL_LENGTH;
-    } else { // if edid extension block
-        StartOffset = extension*SIZEOFEDIDBLOCK + gEdidData[extension*SIZEOFEDIDBLOCK + EDID_DETAILED_TIMING_OFFSET_POS];
-        EndOffset = (extension+1)*SIZEOFEDIDBLOCK;
-    }
-
-    // check DTD(Detailed Timing Description)
-    for (i = StartOffset; i < EndOffset; i+= EDID_DTD_BYTE_LENGTH) {
-        unsigned int hblank = 0, hactive = 0, vblank = 0, vactive = 0, interlaced = 0, pixelclock = 0;
-        unsigned int vHActive = 0, vVActive = 0, vVBlank = 0;
+    for (i = StartOffset; i + EDID_DTD_BYTE_LENGTH <= EndOffset &&
+                gEdidCaps.numDTD < EDID_MAX_DTD; i += EDID_DTD_BYTE_LENGTH) {
+        struct edid_dtd *dtd = &gEdidCaps.dtd[gEdidCaps.numDTD];
 
         // get pixel clock
-        pixelclock = (gEdidData[i+EDID_DTD_PIXELCLOCK_POS2] << SIZEOFBYTE);
-        pixelclock |= gEdidData[i+EDID_DTD_PIXELCLOCK_POS1];
+        dtd->pixelclock = (gEdidData[i+EDID_DTD_PIXELCLOCK_POS2] << SIZEOFBYTE);
+        dtd->pixelclock |= gEdidData[i+EDID_DTD_PIXELCLOCK_POS1];
 
-        if (!pixelclock)
+        if (!dtd->pixelclock)
             continue;
 
         // get HBLANK value in pixels
-        hblank = gEdidData[i+EDID_DTD_HBLANK_POS2] & EDID_DTD_HBLANK_POS2_MASK;
-        hblank <<= SIZEOFBYTE; // lower 4 bits
-        hblank |= gEdidData[i+EDID_DTD_HBLANK_POS1];
+        dtd->hblank = gEdidData[i+EDID_DTD_HBLANK_POS2] & EDID_DTD_HBLANK_POS2_MASK;
+        dtd->hblank <<= SIZEOFBYTE; // lower 4 bits
+        dtd->hblank |= gEdidData[i+EDID_DTD_HBLANK_POS1];
 
         // get HACTIVE value in pixels
-        hactive = gEdidData[i+EDID_DTD_HACTIVE_POS2] & EDID_DTD_HACTIVE_POS2_MASK;
-        hactive <<= (SIZEOFBYTE/2); // upper 4 bits
-        hactive |= gEdidData[i+EDID_DTD_HACTIVE_POS1];
+        dtd->hactive = gEdidData[i+EDID_DTD_HACTIVE_POS2] & EDID_DTD_HACTIVE_POS2_MASK;
+        dtd->hactive <<= (SIZEOFBYTE/2); // upper 4 bits
+        dtd->hactive |= gEdidData[i+EDID_DTD_HACTIVE_POS1];
 
         // get VBLANK value in pixels
-        vblank = gEdidData[i+EDID_DTD_VBLANK_POS2] & EDID_DTD_VBLANK_POS2_MASK;
-        vblank <<= SIZEOFBYTE; // lower 4 bits
-        vblank |= gEdidData[i+EDID_DTD_VBLANK_POS1];
+        dtd->vblank = gEdidData[i+EDID_DTD_VBLANK_POS2] & EDID_DTD_VBLANK_POS2_MASK;
+        dtd->vblank <<= SIZEOFBYTE; // lower 4 bits
+        dtd->vblank |= gEdidData[i+EDID_DTD_VBLANK_POS1];
 
         // get VACTIVE value in pixels
-        vactive = gEdidData[i+EDID_DTD_VACTIVE_POS2] & EDID_DTD_VACTIVE_POS2_MASK;
-        vactive <<= (SIZEOFBYTE/2); // upper 4 bits
-        vactive |= gEdidData[i+EDID_DTD_VACTIVE_POS1];
-
-        vHActive = aVideoParams[videoFormat].HTotal - aVideoParams[videoFormat].HBlank;
-        if (aVideoParams[videoFormat].interlaced == 1) {
-            if (aVideoParams[videoFormat].VIC == v1920x1080i_50Hz_1250) { // VTOP and VBOT are same
-                vVActive = (aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank*2)/2;
-                vVBlank = aVideoParams[videoFormat].VBlank;
-            } else {
-                vVActive = (aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank*2 - 1)/2;
-                vVBlank = aVideoParams[videoFormat].VBlank;
-            }
-        } else {
-            vVActive = aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank;
-            vVBlank = aVideoParams[videoFormat].VBlank;
-        }
+        dtd->vactive = gEdidData[i+EDID_DTD_VACTIVE_POS2] & EDID_DTD_VACTIVE_POS2_MASK;
+        dtd->vactive <<= (SIZEOFBYTE/2); // upper 4 bits
+        dtd->vactive |= gEdidData[i+EDID_DTD_VACTIVE_POS1];
 
         // get Interlaced Mode Value
-        interlaced = (int)(gEdidData[i+EDID_DTD_INTERLACE_POS] & EDID_DTD_INTERLACE_MASK);
-        if (interlaced)
-            interlaced = 1;
+        dtd->interlaced = (gEdidData[i+EDID_DTD_INTERLACE_POS] & EDID_DTD_INTERLACE_MASK) ? 1 : 0;
 
         DPRINTF("EDID: hblank = %d,vblank = %d, hactive = %d, vactive = %d\n"
-                            ,hblank,vblank,hactive,vactive);
-        DPRINTF("REQ: hblank = %d,vblank = %d, hactive = %d, vactive = %d\n"
-                            ,aVideoParams[videoFormat].HBlank
-                            ,vVBlank,vHActive,vVActive);
-
-        if (hblank == aVideoParams[videoFormat].HBlank && vblank == vVBlank // blank
-            && hactive == vHActive && vactive == vVActive) { //line
-            unsigned int EDIDpixelclock = aVideoParams[videoFormat].PixelClock;
-            EDIDpixelclock /= 100; pixelclock /= 100;
-
-            if (pixelclock == EDIDpixelclock) {
-                DPRINTF("Sink Support the Video mode\n");
-                return 1;
-            }
-        }
+                            ,dtd->hblank,dtd->vblank,dtd->hactive,dtd->vactive);
+
+        gEdidCaps.numDTD++;
     }
-    return 0;
 }
 
 /**
- * Check if a VIC(Video Identification Code) is contained in -@n
- * EDID extension block.
- * @param   extension   [in]    Number of EDID extension block to check
- * @param   VIC      [in]   VIC to check
- * @return  If the VIC is contained in contained in EDID extension block, -@n
- *        return 1; Otherwise, return 0.
+ * Parse CEA data blocks of a timing extension into gEdidCaps.
+ * @param   extension   [in]    Number of EDID extension block to parse
  */
-static int IsContainVIC(const int extension, const int VIC)
+static void ParseDataBlocks(const int extension)
 {
     unsigned int StartAddr = extension*SIZEOFEDIDBLOCK;
     unsigned int ExtAddr = StartAddr + EDID_DATA_BLOCK_START_POS;
-    unsigned int tag,blockLen;
     unsigned int DTDStartAddr = gEdidData[StartAddr + EDID_DETAILED_TIMING_OFFSET_POS];
+    unsigned int tag,blockLen,i;
 
-    if (!EDIDValid() || (extension > gExtensions)) {
-        DPRINTF("EDID Data is not available\n");
-        return 0;
-    }
-
-    // while
     while (ExtAddr < StartAddr + DTDStartAddr) {
         // find the block tag and length
         // tag
@@ -458,28 +484,284 @@ static int IsContainVIC(const int extension, const int VIC)
         DPRINTF("tag = %d\n",tag);
         DPRINTF("blockLen = %d\n",blockLen-1);
 
-        // check if it is short video description
-        if (tag == EDID_SHORT_VID_DEC_TAG_VAL) {
-            // if so, check SVD
-            unsigned int i;
+        switch (tag) {
+        case EDID_SHORT_VID_DEC_TAG_VAL:
             for (i = 1; i < blockLen; i++) {
-                DPRINTF("EDIDVIC = %d\n",gEdidData[ExtAddr+i] & EDID_SVD_VIC_MASK);
-                DPRINTF("VIC = %d\n",VIC);
+                unsigned int vic = gEdidData[ExtAddr+i] & EDID_SVD_VIC_MASK;
+                DPRINTF("EDIDVIC = %d\n",vic);
 
-                // check VIC with SVDB
-                if (VIC == (gEdidData[ExtAddr+i] & EDID_SVD_VIC_MASK)) {
-                    DPRINTF("Sink Device supports requested video mode\n");
-                    return 1;
-                }
+                gEdidCaps.vicMap[vic / SIZEOFBYTE] |= 1 << (vic % SIZEOFBYTE);
+            }
+            break;
+        case EDID_SHORT_AUD_DEC_TAG_VAL:
+            for (i = 1; i + 2 < blockLen && gEdidCaps.numSAD < EDID_MAX_SAD; i += 3) {
+                struct edid_sad *sad = &gEdidCaps.sad[gEdidCaps.numSAD++];
+
+                sad->audioFormat = gEdidData[ExtAddr+i] & EDID_SAD_CODE_MASK;
+                sad->channelNum = gEdidData[ExtAddr+i] & EDID_SAD_CHANNEL_MASK;
+                sad->sampleFreq = gEdidData[ExtAddr+i+1];
+                sad->wordLen = gEdidData[ExtAddr+i+2];
+            }
+            break;
+        case EDID_EXTENDED_TAG_VAL:
+            // only the first colorimetry block is used
+            if (gEdidCaps.colorimetry < 0 &&
+                gEdidData[ExtAddr+1] == EDID_EXTENDED_COLORIMETRY_VAL && // colorimetry block
+                (blockLen-1) == EDID_EXTENDED_COLORIMETRY_BLOCK_LEN) { // check length
+                gEdidCaps.colorimetry = gEdidData[ExtAddr + 2];
+                gEdidCaps.metadata = gEdidData[ExtAddr + 3];
+
+                DPRINTF("EDID extened colorimetry = %x\n",gEdidCaps.colorimetry);
+                DPRINTF("EDID gamut metadata profile = %x\n",gEdidCaps.metadata);
             }
+            break;
+        case EDID_VSDB_TAG_VAL:
+            // only the first HDMI Forum VSDB is used, the HDMI VSDB is found by GetVSDBOffset()
+            if (!gEdidCaps.hfVsdbOffset &&
+                gEdidData[ExtAddr+1] == 0xD8 &&
+                gEdidData[ExtAddr+2] == 0x5D &&
+                gEdidData[ExtAddr+3] == 0xC4 &&
+                (blockLen-1) >= EDID_HF_VSDB_MIN_LENGTH_VAL) {
+                gEdidCaps.hfVsdbOffset = ExtAddr;
+                gEdidCaps.maxTMDSCharRate = gEdidData[ExtAddr + EDID_HF_VSDB_MAX_TMDS_RATE_POS];
+                gEdidCaps.scdc = gEdidData[ExtAddr + EDID_HF_VSDB_SCDC_POS] & EDID_HF_VSDB_SCDC_MASK;
+
+                DPRINTF("EDID HF-VSDB max TMDS character rate = %d\n",gEdidCaps.maxTMDSCharRate);
+                DPRINTF("EDID HF-VSDB SCDC flags = %x\n",gEdidCaps.scdc);
+            }
+            break;
+        default:
+            break;
         }
-        // else find next block
+        // find next block
         ExtAddr += blockLen;
     }
+}
 
+/**
+ * Check if a parsed DTD matches the video format.
+ * @param   dtd         [in]    Parsed DTD
+ * @param   videoFormat [in]    Video format to check
+ * @return  If the DTD describes the video format, return 1; Otherwise, return 0.
+ */
+static int IsMatchVideoDTD(const struct edid_dtd * const dtd, const enum VideoFormat videoFormat)
+{
+    unsigned int vHActive = 0, vVActive = 0, vVBlank = 0;
+
+    vHActive = aVideoParams[videoFormat].HTotal - aVideoParams[videoFormat].HBlank;
+    if (aVideoParams[videoFormat].interlaced == 1) {
+        if (aVideoParams[videoFormat].VIC == v1920x1080i_50Hz_1250) { // VTOP and VBOT are same
+            vVActive = (aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank*2)/2;
+            vVBlank = aVideoParams[videoFormat].VBlank;
+        } else {
+            vVActive = (aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank*2 - 1)/2;
+            vVBlank = aVideoParams[videoFormat].VBlank;
+        }
+    } else {
+        vVActive = aVideoParams[videoFormat].VTotal - aVideoParams[videoFormat].VBlank;
+        vVBlank = aVideoParams[videoFormat].VBlank;
+    }
+
+    if (dtd->hblank == aVideoParams[videoFormat].HBlank && dtd->vblank == vVBlank // blank
+        && dtd->hactive == vHActive && dtd->vactive == vVActive) { //line
+        unsigned int EDIDpixelclock = aVideoParams[videoFormat].PixelClock / 100;
+
+        if (dtd->pixelclock / 100 == EDIDpixelclock)
+            return 1;
+    }
     return 0;
 }
 
+/**
+ * Check if a VIC(Video Identification Code) is in any timing extension.
+ * @param   VIC      [in]   VIC to check
+ * @return  If the VIC is supported, return 1; Otherwise, return 0.
+ */
+static inline int IsContainVIC(const unsigned int VIC)
+{
+    if (VIC >= EDID_NUM_OF_VIC)
+        return 0;
+
+    return (gEdidCaps.vicMap[VIC / SIZEOFBYTE] >> (VIC % SIZEOFBYTE)) & 1;
+}
+
+/**
+ * Build the resolution table of gEdidCaps from parsed VICs and DTDs.
+ */
+static void ParseResolutions(void)
+{
+    unsigned int format;
+    int i;
+
+    for (format = 0; format < NUM_OF_VIDEO_PARAMS; format++) {
+        unsigned char flags = 0;
+
+        // check ET(Established Timings) for 640x480p@60Hz
+        if (format == v640x480p_60Hz && (gEdidData[EDID_ET_POS] & EDID_ET_640x480p_VAL))
+            flags = EDID_RES_VIC_4_3 | EDID_RES_VIC_16_9;
+
+        // check DTD(Detailed Timing Description)
+        for (i = 0; i < gEdidCaps.numDTD && !flags; i++) {
+            if (IsMatchVideoDTD(&gEdidCaps.dtd[i], (enum VideoFormat)format))
+                flags = EDID_RES_VIC_4_3 | EDID_RES_VIC_16_9;
+        }
+
+        // check SVD(Short Video Descriptor)
+        if (IsContainVIC(aVideoParams[format].VIC))
+            flags |= EDID_RES_VIC_4_3;
+        if (IsContainVIC(aVideoParams[format].VIC16_9))
+            flags |= EDID_RES_VIC_16_9;
+
+        gEdidCaps.resolution[format] = flags;
+    }
+}
+
+/**
+ * Parse the HDMI video fields of a VSDB (HDMI_VIC and 3D) into gEdidCaps.
+ * Fields that run past the end of the block are ignored.
+ * @param   StartAddr   [in]    Offset of the VSDB in gEdidData
+ */
+static void ParseVSDB3D(const unsigned int StartAddr)
+{
+    unsigned int EndAddr = StartAddr + (gEdidData[StartAddr] & EDID_DATA_BLOCK_SIZE_MASK) + 1;
+    unsigned int offset = StartAddr + EDID_HDMI_EXT_POS;
+    unsigned int flags, multi, HDMIVICLen, HDMI3DLen, all = 0, mask = 0xFFFF;
+    unsigned int i;
+
+    if (offset >= EndAddr)
+        return;
+
+    // latency fields come before the HDMI video fields
+    flags = gEdidData[offset++];
+    if (flags & EDID_HDMI_LATENCY_PRESENT)
+        offset += 2;
+    if (flags & EDID_HDMI_I_LATENCY_PRESENT)
+        offset += 2;
+
+    if (!(flags & EDID_HDMI_VIDEO_PRESENT_MASK) || offset + 1 >= EndAddr)
+        return;
+
+    gEdidCaps.present3D = (gEdidData[offset] & EDID_HDMI_3D_PRESENT_MASK) ? 1 : 0;
+    multi = gEdidData[offset] & EDID_HDMI_3D_MULTI_PRESENT_MASK;
+    offset++;
+
+    HDMIVICLen = (gEdidData[offset] & EDID_HDMI_VSDB_VIC_LEN_MASK) >> EDID_HDMI_VSDB_VIC_LEN_BIT;
+    HDMI3DLen = gEdidData[offset] & EDID_HDMI_VSDB_3D_LEN_MASK;
+    offset++;
+
+    for (i = 0; i < HDMIVICLen && offset < EndAddr; i++, offset++)
+        gEdidCaps.hdmiVIC[gEdidCaps.numHdmiVIC++] = gEdidData[offset];
+
+    // HDMI_3D_LEN covers 3D_Structure_ALL, 3D_MASK and the 2D_VIC_order entries
+    EndAddr = (offset + HDMI3DLen < EndAddr) ? offset + HDMI3DLen : EndAddr;
+
+    if ((multi == EDID_3D_STRUCTURE_ONLY_EXIST || multi == EDID_3D_STRUCTURE_MASK_EXIST) &&
+            offset + 1 < EndAddr) {
+        all = (gEdidData[offset] << 8) | gEdidData[offset + 1];
+        offset += 2;
+    }
+    if (multi == EDID_3D_STRUCTURE_MASK_EXIST && offset + 1 < EndAddr) {
+        mask = (gEdidData[offset] << 8) | gEdidData[offset + 1];
+        offset += 2;
+    }
+
+    for (i = 0; i < NUM_OF_VIC_FOR_3D; i++)
+        if (mask & (1 << i))
+            gEdidCaps.structure3D[i] = all;
+
+    // 2D_VIC_order/3D_Structure, followed by 3D_Detail for side-by-side(half) and up
+    while (offset < EndAddr) {
+        unsigned int order = (gEdidData[offset] & EDID_HDMI_2D_VIC_ORDER_MASK) >> 4;
+        unsigned int structure = gEdidData[offset] & EDID_HDMI_3D_STRUCTURE_MASK;
+
+        gEdidCaps.structure3D[order] |= 1 << structure;
+        offset += (structure >= EDID_3D_STRUCTURE_SSH) ? 2 : 1;
+    }
+
+    DPRINTF("EDID 3D: present = %d, hdmi vic = %d, structure all = 0x%x, mask = 0x%x\n",
+            gEdidCaps.present3D, gEdidCaps.numHdmiVIC, all, mask);
+}
+
+/**
+ * Parse gEdidData into gEdidCaps. Every query below is answered from
+ * gEdidCaps, so the raw EDID is walked only once per EDIDRead().
+ */
+static void ParseEDID(void)
+{
+    int i, vic_count = 0;
+    unsigned int StartAddr;
+
+    memset(&gEdidCaps, 0, sizeof(gEdidCaps));
+    gEdidCaps.deepColor = -1;
+    gEdidCaps.colorimetry = -1;
+
+    // if there is a VSDB, it means RX support HDMI mode
+    for (i = 1; i <= gExtensions && !gEdidCaps.hdmiMode; i++)
+        if (GetVSDBOffset(i) > 0)
+            gEdidCaps.hdmiMode = 1;
+
+    // DTD of EDID block(0th)
+    ParseDTD(EDID_DTD_START_ADDR, EDID_DTD_START_ADDR + EDID_DTD_TOTAL_LENGTH);
+
+    for (i = 1; i <= gExtensions; i++) {
+        unsigned int BlockOffset = i*SIZEOFEDIDBLOCK;
+        unsigned int DTDOffset;
+
+        if (!IsTimingExtension(i))
+            continue;
+
+        gEdidCaps.colorSpace |= gEdidData[BlockOffset + EDID_COLOR_SPACE_POS];
+
+        ParseDataBlocks(i);
+
+        DTDOffset = gEdidData[BlockOffset + EDID_DETAILED_TIMING_OFFSET_POS];
+        if (DTDOffset >= EDID_DATA_BLOCK_START_POS)
+            ParseDTD(BlockOffset + DTDOffset, BlockOffset + SIZEOFEDIDBLOCK);
+
+        if ((StartAddr = GetVSDBOffset(i)) > 0) {
+            unsigned int blockLength = gEdidData[StartAddr] & EDID_DATA_BLOCK_SIZE_MASK;
+
+            if (!gEdidCaps.vsdbOffset)
+                gEdidCaps.vsdbOffset = StartAddr;
+
+            if (gEdidCaps.deepColor < 0 && blockLength >= EDID_DC_POS)
+                gEdidCaps.deepColor = gEdidData[StartAddr + EDID_DC_POS] & EDID_DC_MASK;
+
+            if (!gEdidCaps.maxTMDS && blockLength >= EDID_MAX_TMDS_POS)
+                gEdidCaps.maxTMDS = gEdidData[StartAddr + EDID_MAX_TMDS_POS];
+        }
+    }
+
+    // save first 16 VIC for 3D, in EDID order
+    for (i = 1; i <= gExtensions && vic_count < NUM_OF_VIC_FOR_3D; i++) {
+        unsigned int ExtAddr = i*SIZEOFEDIDBLOCK + EDID_DATA_BLOCK_START_POS;
+        unsigned int EndAddr = i*SIZEOFEDIDBLOCK + gEdidData[i*SIZEOFEDIDBLOCK + EDID_DETAILED_TIMING_OFFSET_POS];
+
+        while (ExtAddr < EndAddr) {
+            unsigned int tag = gEdidData[ExtAddr] & EDID_TAG_CODE_MASK;
+            unsigned int blockLen = (gEdidData[ExtAddr] & EDID_DATA_BLOCK_SIZE_MASK) + 1;
+
+            if (tag == EDID_SHORT_VID_DEC_TAG_VAL) {
+                unsigned int edid_index;
+                for (edid_index = 1; edid_index < blockLen && vic_count < NUM_OF_VIC_FOR_3D; edid_index++)
+                    gEdidCaps.vic3D[vic_count++] = (gEdidData[ExtAddr+edid_index] & EDID_SVD_VIC_MASK);
+            }
+            ExtAddr += blockLen;
+        }
+    }
+
+    if (gEdidCaps.vsdbOffset)
+        ParseVSDB3D(gEdidCaps.vsdbOffset);
+
+    ParseResolutions();
+
+    gEdidCaps.valid = 1;
+
+    DPRINTF("EDID parsed: hdmi = %d, vsdb = 0x%x, hf-vsdb = 0x%x, dtd = %d, sad = %d\n",
+            gEdidCaps.hdmiMode, gEdidCaps.vsdbOffset, gEdidCaps.hfVsdbOffset,
+            gEdidCaps.numDTD, gEdidCaps.numSAD);
+}
+
 /**
  * Check if EDID contains the video format.
  * @param   videoFormat [in]    Video format to check
@@ -489,36 +771,15 @@ static int IsContainVIC(const int extension, const int VIC)
 static int CheckResolution(const enum VideoFormat videoFormat,
                             const enum PixelAspectRatio pixelRatio)
 {
-    int i, vic;
-
     // read EDID
     if (!EDIDRead())
         return 0;
 
-    // check ET(Established Timings) for 640x480p@60Hz
-    if (videoFormat == v640x480p_60Hz // if it's 640x480p@60Hz
-        && (gEdidData[EDID_ET_POS] & EDID_ET_640x480p_VAL)) // it support
-         return 1;
-
-    // check STI(Standard Timing Identification)
-    // do not need
-
-    // check DTD(Detailed Timing Description) of EDID block(0th)
-    if (IsContainVideoDTD(0,videoFormat))
-        return 1;
-
-    // check EDID Extension
-    vic = (pixelRatio == HDMI_PIXEL_RATIO_16_9) ?
-            aVideoParams[videoFormat].VIC16_9 : aVideoParams[videoFormat].VIC;
-
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i)) // if it's timing block
-            if (IsContainVIC(i, vic) || IsContainVideoDTD(i, videoFormat))
-                return 1;
-    }
+    if ((unsigned int)videoFormat >= NUM_OF_VIDEO_PARAMS)
+        return 0;
 
-    return 0;
+    return (gEdidCaps.resolution[videoFormat] &
+            ((pixelRatio == HDMI_PIXEL_RATIO_16_9) ? EDID_RES_VIC_16_9 : EDID_RES_VIC_4_3)) ? 1 : 0;
 }
 
 /**
@@ -529,8 +790,7 @@ static int CheckResolution(const enum VideoFormat videoFormat,
  */
 static int CheckColorDepth(const enum ColorDepth depth,const enum ColorSpace space)
 {
-    int i;
-    unsigned int StartAddr;
+    int deepColor;
 
     // if color depth == 24 bit, no need to check
     if (depth == HDMI_CD_24)
@@ -541,42 +801,32 @@ static int CheckColorDepth(const enum ColorDepth depth,const enum ColorSpace spa
     if (!EDIDRead())
         return 0;
 
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i) // if it's timing block
-            && ((StartAddr = GetVSDBOffset(i)) > 0)) { // check block
-            int blockLength = gEdidData[StartAddr] & EDID_DATA_BLOCK_SIZE_MASK;
-            if (blockLength >= EDID_DC_POS) {
-                // get supported DC value
-                int deepColor = gEdidData[StartAddr + EDID_DC_POS] & EDID_DC_MASK;
-                DPRINTF("EDID deepColor = %x\n",deepColor);
-                // check supported DeepColor
-                // if YCBCR444
-                if (space == HDMI_CS_YCBCR444) {
-                    if ( !(deepColor & EDID_DC_YCBCR_VAL))
-                        return 0;
-                }
+    // get supported DC value
+    deepColor = gEdidCaps.deepColor;
+    DPRINTF("EDID deepColor = %x\n",deepColor);
+    if (deepColor < 0)
+        return 0;
 
-                // check colorDepth
-                switch (depth) {
-                case HDMI_CD_36:
-                    deepColor &= EDID_DC_36_VAL;
-                    break;
-                case HDMI_CD_30:
-                    deepColor &= EDID_DC_30_VAL;
-                    break;
-                default :
-                    deepColor = 0;
-                }
-                if (deepColor)
-                    return 1;
-                else
-                    return 0;
-            }
-        }
+    // check supported DeepColor
+    // if YCBCR444
+    if (space == HDMI_CS_YCBCR444) {
+        if ( !(deepColor & EDID_DC_YCBCR_VAL))
+            return 0;
     }
 
-    return 0;
+    // check colorDepth
+    switch (depth) {
+    case HDMI_CD_36:
+        deepColor &= EDID_DC_36_VAL;
+        break;
+    case HDMI_CD_30:
+        deepColor &= EDID_DC_30_VAL;
+        break;
+    default :
+        deepColor = 0;
+    }
+
+    return deepColor ? 1 : 0;
 }
 
 /**
@@ -586,8 +836,6 @@ static int CheckColorDepth(const enum ColorDepth depth,const enum ColorSpace spa
  */
 static int CheckColorSpace(const enum ColorSpace space)
 {
-    int i;
-
     // RGB is default
     if (space == HDMI_CS_RGB)
         return 1;
@@ -597,17 +845,10 @@ static int CheckColorSpace(const enum ColorSpace space)
     if (!EDIDRead())
         return 0;
 
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i)) { // if it's timing block
-            // read Color Space
-            int CS = gEdidData[i*SIZEOFEDIDBLOCK + EDID_COLOR_SPACE_POS];
+    if ((space == HDMI_CS_YCBCR444 && (gEdidCaps.colorSpace & EDID_YCBCR444_CS_MASK)) || // YCBCR444
+            (space == HDMI_CS_YCBCR422 && (gEdidCaps.colorSpace & EDID_YCBCR422_CS_MASK))) // YCBCR422
+        return 1;
 
-            if ((space == HDMI_CS_YCBCR444 && (CS & EDID_YCBCR444_CS_MASK)) || // YCBCR444
-                    (space == HDMI_CS_YCBCR422 && (CS & EDID_YCBCR422_CS_MASK))) // YCBCR422
-                return 1;
-        }
-    }
     return 0;
 }
 
@@ -618,8 +859,6 @@ static int CheckColorSpace(const enum ColorSpace space)
  */
 static int CheckColorimetry(const enum HDMIColorimetry color)
 {
-    int i;
-
     // do not need to parse if not extended colorimetry
     if (color == HDMI_COLORIMETRY_NO_DATA ||
             color == HDMI_COLORIMETRY_ITU601 ||
@@ -630,51 +869,20 @@ static int CheckColorimetry(const enum HDMIColorimetry color)
     if (!EDIDRead())
        return 0;
 
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i)) { // if it's timing block
-            // check address
-            unsigned int ExtAddr = i*SIZEOFEDIDBLOCK + EDID_DATA_BLOCK_START_POS;
-            unsigned int EndAddr = i*SIZEOFEDIDBLOCK + gEdidData[i*SIZEOFEDIDBLOCK + EDID_DETAILED_TIMING_OFFSET_POS];
-            unsigned int tag,blockLen;
-
-            while (ExtAddr < EndAddr) {
-                // find the block tag and length
-                // tag
-                tag = gEdidData[ExtAddr] & EDID_TAG_CODE_MASK;
-                // block len
-                blockLen = (gEdidData[ExtAddr] & EDID_DATA_BLOCK_SIZE_MASK) + 1;
-
-                // check if it is colorimetry block
-                if (tag == EDID_EXTENDED_TAG_VAL && // extended tag
-                    gEdidData[ExtAddr+1] == EDID_EXTENDED_COLORIMETRY_VAL && // colorimetry block
-                    (blockLen-1) == EDID_EXTENDED_COLORIMETRY_BLOCK_LEN) { // check length
-                    // get supported DC value
-                    int colorimetry = (gEdidData[ExtAddr + 2]);
-                    int metadata = (gEdidData[ExtAddr + 3]);
-
-                    DPRINTF("EDID extened colorimetry = %x\n",colorimetry);
-                    DPRINTF("EDID gamut metadata profile = %x\n",metadata);
-
-                    // check colorDepth
-                    switch (color) {
-                    case HDMI_COLORIMETRY_EXTENDED_xvYCC601:
-                        if (colorimetry & EDID_XVYCC601_MASK && metadata)
-                            return 1;
-                        break;
-                    case HDMI_COLORIMETRY_EXTENDED_xvYCC709:
-                        if (colorimetry & EDID_XVYCC709_MASK && metadata)
-                            return 1;
-                        break;
-                    default:
-                        break;
-                    }
-                    return 0;
-                }
-                // else find next block
-                ExtAddr += blockLen;
-            }
-        }
+    if (gEdidCaps.colorimetry < 0)
+        return 0;
+
+    switch (color) {
+    case HDMI_COLORIMETRY_EXTENDED_xvYCC601:
+        if (gEdidCaps.colorimetry & EDID_XVYCC601_MASK && gEdidCaps.metadata)
+            return 1;
+        break;
+    case HDMI_COLORIMETRY_EXTENDED_xvYCC709:
+        if (gEdidCaps.colorimetry & EDID_XVYCC709_MASK && gEdidCaps.metadata)
+            return 1;
+        break;
+    default:
+        break;
     }
 
     return 0;
@@ -682,63 +890,18 @@ static int CheckColorimetry(const enum HDMIColorimetry color)
 
 /**
  * Get Max TMDS clock that HDMI Rx can receive.
- * @return  If available, return MaxTMDS clock; Otherwise, return 0.
+ * The HF-VSDB rate, if present, supersedes the 340MHz-capped VSDB value.
+ * @return  If available, return MaxTMDS clock in 5MHz units; Otherwise, return 0.
  */
-static unsigned int GetMaxTMDS(void)
+static inline unsigned int GetMaxTMDS(void)
 {
-    int i;
-    unsigned int StartAddr;
+    if (!gEdidCaps.valid)
+        return 0;
 
-    // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i) // if it's timing block
-            && ((StartAddr = GetVSDBOffset(i)) > 0)) { // check block
-            int blockLength = gEdidData[StartAddr] & EDID_DATA_BLOCK_SIZE_MASK;
-            if (blockLength >= EDID_MAX_TMDS_POS) {
-                // get supported DC value
-                return gEdidData[StartAddr + EDID_MAX_TMDS_POS];
-            }
-        }
-    }
+    if (gEdidCaps.maxTMDSCharRate > gEdidCaps.maxTMDS)
+        return gEdidCaps.maxTMDSCharRate;
 
-    return 0;
-}
-
-/**
- * Save first 16 VIC of EDID
- */
-static void SaveVIC(void)
-{
-    int extension;
-    int vic_count = 0;
-    for (extension = 1; extension <= gExtensions && vic_count < NUM_OF_VIC_FOR_3D; extension++) {
-        unsigned int StartAddr = extension*SIZEOFEDIDBLOCK;
-        unsigned int ExtAddr = StartAddr + EDID_DATA_BLOCK_START_POS;
-        unsigned int tag,blockLen;
-        unsigned int DTDStartAddr = gEdidData[StartAddr + EDID_DETAILED_TIMING_OFFSET_POS];
-
-        while (ExtAddr < StartAddr + DTDStartAddr) {
-            // find the block tag and length
-            // tag
-            tag = gEdidData[ExtAddr] & EDID_TAG_CODE_MASK;
-            // block len
-            blockLen = (gEdidData[ExtAddr] & EDID_DATA_BLOCK_SIZE_MASK) + 1;
-
-            // check if it is short video description
-            if (tag == EDID_SHORT_VID_DEC_TAG_VAL) {
-                // if so, check SVD
-                unsigned int edid_index;
-                for (edid_index = 1; edid_index < blockLen && vic_count < NUM_OF_VIC_FOR_3D; edid_index++) {
-                    DPRINTF("EDIDVIC = %d\r\n", gEdidData[ExtAddr+edid_index] & EDID_SVD_VIC_MASK);
-
-                    // check VIC with SVDB
-                    aVIC[vic_count++] = (gEdidData[ExtAddr+edid_index] & EDID_SVD_VIC_MASK);
-                }
-            }
-            // else find next block
-            ExtAddr += blockLen;
-        }
-    }
+    return gEdidCaps.maxTMDS;
 }
 
 /**
@@ -748,9 +911,9 @@ static void SaveVIC(void)
  */
 static int EDID3DFormatSupport(const struct HDMIVideoParameter * const pVideo)
 {
-    int edid_index;
-    unsigned int StartAddr;
     unsigned int vic;
+    int i;
+
     vic = (pVideo->pixelAspectRatio == HDMI_PIXEL_RATIO_16_9) ?
             aVideoParams[pVideo->resolution].VIC16_9 : aVideoParams[pVideo->resolution].VIC;
 
@@ -759,162 +922,33 @@ static int EDID3DFormatSupport(const struct HDMIVideoParameter * const pVideo)
         return 1;
 
     // check EDID data is valid or not
-    if (!EDIDRead())
+    if (!EDIDRead() || !gEdidCaps.valid)
         return 0;
 
-    // save first 16 VIC to check
-    SaveVIC();
-
-    // find VSDB
-    for (edid_index = 1; edid_index <= gExtensions; edid_index++) {
-        if (IsTimingExtension(edid_index) // if it's timing block
-            && ((StartAddr = GetVSDBOffset(edid_index)) > 0)) { // check block
-            unsigned int blockLength = gEdidData[StartAddr] & EDID_DATA_BLOCK_SIZE_MASK;
-            unsigned int VSDBHdmiVideoPre = 0;
-            unsigned int VSDB3DPresent = 0;
-            unsigned int VSDB3DMultiPresent = 0;
-            unsigned int HDMIVICLen;
-            unsigned int HDMI3DLen;
-            int Hdmi3DStructure = 0;
-            unsigned int Hdmi3DMask = 0xFFFF;
-            unsigned int latency_offset = 0;
-
-            DPRINTF("VSDB Block length[0x%x] = 0x%x\r\n",StartAddr,blockLength);
-
-            // get HDMI Video Present  value
-            if (blockLength >= EDID_HDMI_EXT_POS) {
-                VSDBHdmiVideoPre = gEdidData[StartAddr + EDID_HDMI_EXT_POS]
-                            & EDID_HDMI_VIDEO_PRESENT_MASK;
-                DPRINTF("EDID HDMI Video Present = 0x%x\n",VSDBHdmiVideoPre);
-            } else { // data related to 3D format is not available
-                return 0;
-            }
-
-            // check if latency field is available
-            latency_offset = (gEdidData[StartAddr + EDID_HDMI_EXT_POS]
-                                                        & EDID_HDMI_LATENCY_MASK) >> EDID_HDMI_LATENCY_POS;
-            if (latency_offset == 0)
-                latency_offset = 4;
-            else if (latency_offset == 3)
-                latency_offset = 0;
-            else
-                latency_offset = 2;
-
-            StartAddr -= latency_offset;
-
-            // HDMI_VIC_LEN
-            HDMIVICLen = (gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS]
-                    & EDID_HDMI_VSDB_VIC_LEN_MASK) >> EDID_HDMI_VSDB_VIC_LEN_BIT;
-
-            if (pVideo->hdmi_3d_format == HDMI_VIC_FORMAT) {
-                if (HDMIVICLen) {
-                    for (edid_index = 0; edid_index < (int)HDMIVICLen; edid_index++) {
-                        if (vic == gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + edid_index])
-                            return 1;
-                    }
-                    return 0;
-                } else {
-                    return 0;
-                }
-            }
-
-            // HDMI_3D_LEN
-            HDMI3DLen = gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS]
-                        & EDID_HDMI_VSDB_3D_LEN_MASK;
-
-            DPRINTF("HDMI VIC LENGTH[%x] = %x\r\n",
-                                    StartAddr + EDID_HDMI_EXT_LENGTH_POS, HDMIVICLen);
-            DPRINTF("HDMI 3D LENGTH[%x] = %x\r\n",
-                                    StartAddr + EDID_HDMI_EXT_LENGTH_POS, HDMI3DLen);
-
-            // check 3D_Present bit
-            if (blockLength >= (EDID_HDMI_3D_PRESENT_POS - latency_offset)) {
-                VSDB3DPresent = gEdidData[StartAddr + EDID_HDMI_3D_PRESENT_POS]
-                                & EDID_HDMI_3D_PRESENT_MASK;
-                VSDB3DMultiPresent = gEdidData[StartAddr + EDID_HDMI_3D_PRESENT_POS]
-                                & EDID_HDMI_3D_MULTI_PRESENT_MASK;
-            }
-
-            if (VSDB3DPresent) {
-                DPRINTF("VSDB 3D Present!!!\r\n");
-                // check with 3D madatory format
-                if (CheckResolution(pVideo->resolution, pVideo->pixelAspectRatio)) {
-                    int size = sizeof(edid_3d)/sizeof(struct edid_3d_mandatory);
-                    for (edid_index = 0; edid_index < size; edid_index++) {
-                        if (edid_3d[edid_index].resolution == pVideo->resolution &&
-                            edid_3d[edid_index].hdmi_3d_format == pVideo->hdmi_3d_format )
-                            return 1;
-                    }
-                }
-            }
-
-            // check 3D_Multi_Present bit
-            if (VSDB3DMultiPresent) {
-                DPRINTF("VSDB 3D Multi Present!!! = 0x%02x\r\n",VSDB3DMultiPresent);
-                // 3D Structure only
-                if (VSDB3DMultiPresent == EDID_3D_STRUCTURE_ONLY_EXIST) {
-                    // 3D Structure All
-                    Hdmi3DStructure = (gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 1] << 8);
-                    Hdmi3DStructure |= gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 2];
-                    DPRINTF("VSDB 3D Structure!!! = [0x%02x]\r\n",Hdmi3DStructure);
-                }
-
-                // 3D Structure and Mask
-                if (VSDB3DMultiPresent == EDID_3D_STRUCTURE_MASK_EXIST) {
-                    // 3D Structure All
-                    Hdmi3DStructure = (gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 1] << 8);
-                    Hdmi3DStructure |= gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 2];
-                    // 3D Structure Mask
-                    Hdmi3DMask |= (gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 3] << 8);
-                    Hdmi3DMask |= gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen + 4];
-                    DPRINTF("VSDB 3D Structure!!! = [0x%02x]\r\n",Hdmi3DStructure);
-                    DPRINTF("VSDB 3D Mask!!! = [0x%02x]\r\n",Hdmi3DMask);
-                    DPRINTF("Current 3D Video format!!! = [%d]\r\n",pVideo->hdmi_3d_format);
-                    DPRINTF("Current 3D Video format!!! = [0x%02x]\r\n",1<<pVideo->hdmi_3d_format);
-                }
-
-                // check 3D Structure and Mask
-                if (Hdmi3DStructure & (1<<pVideo->hdmi_3d_format)) {
-                    DPRINTF("VSDB 3D Structure Contains Current Video Structure!!!\r\n");
-                    // check first 16 EDID
-                    for (edid_index = 0; edid_index < NUM_OF_VIC_FOR_3D; edid_index++) {
-                        DPRINTF("VIC = %d, EDID Vic = %d!!!\r\n",vic,aVIC[edid_index]);
-                        if (Hdmi3DMask & (1<<edid_index)) {
-                            if (vic == aVIC[edid_index]) {
-                                DPRINTF("VSDB 3D Mask Contains Current Video format!!!\r\n");
-                                return 1;
-                            }
-                        }
-                    }
-                }
-            }
+    if (pVideo->hdmi_3d_format == HDMI_VIC_FORMAT) {
+        for (i = 0; i < gEdidCaps.numHdmiVIC; i++)
+            if (vic == gEdidCaps.hdmiVIC[i])
+                return 1;
+        return 0;
+    }
 
-            // check block length if HDMI_VIC or HDMI Multi available
-            if (blockLength >= (EDID_HDMI_EXT_LENGTH_POS - latency_offset)) {
-                unsigned int HDMI3DExtLen = HDMI3DLen - (VSDB3DMultiPresent>>EDID_HDMI_3D_MULTI_PRESENT_BIT)*2;
-                unsigned int VICOrder;
-
-                // check if there is 3D extra data ?
-                //TODO: check 3D_Detail in case of SSH
-                if (HDMI3DExtLen) {
-                    // check HDMI 3D Extra Data
-                    for (edid_index = 0; edid_index < (int)(HDMI3DExtLen / 2); edid_index++) {
-                        VICOrder = gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen +
-                                          (VSDB3DMultiPresent>>EDID_HDMI_3D_MULTI_PRESENT_BIT) * 2 + edid_index * 2]
-                                                    & EDID_HDMI_2D_VIC_ORDER_MASK;
-                        VICOrder = (1<<VICOrder);
-                        Hdmi3DStructure = gEdidData[StartAddr + EDID_HDMI_EXT_LENGTH_POS + HDMIVICLen +
-                                                 (VSDB3DMultiPresent>>EDID_HDMI_3D_MULTI_PRESENT_BIT) * 2 + edid_index * 2]
-                                                 & EDID_HDMI_3D_STRUCTURE_MASK;
-                        Hdmi3DStructure = (1<<Hdmi3DStructure);
-                        if (Hdmi3DStructure == pVideo->hdmi_3d_format && vic == aVIC[VICOrder])
-                            return 1;
-                    }
-                }
-            }
+    // check with 3D mandatory format
+    if (gEdidCaps.present3D &&
+            CheckResolution(pVideo->resolution, pVideo->pixelAspectRatio)) {
+        for (i = 0; i < (int)(sizeof(edid_3d)/sizeof(edid_3d[0])); i++) {
+            if (edid_3d[i].resolution == pVideo->resolution &&
+                edid_3d[i].hdmi_3d_format == pVideo->hdmi_3d_format)
+                return 1;
         }
     }
 
+    // check 3D structures listed for the first 16 VICs
+    for (i = 0; i < NUM_OF_VIC_FOR_3D; i++) {
+        if (gEdidCaps.vic3D[i] == vic &&
+                (gEdidCaps.structure3D[i] & (1 << pVideo->hdmi_3d_format)))
+            return 1;
+    }
+
     return 0;
 }
 
@@ -951,9 +985,12 @@ int EDIDRead(void)
     unsigned char temp[SIZEOFEDIDBLOCK];
 
     // if already read??
-    if (EDIDValid())
+    if (EDIDValid() && gEdidCaps.valid)
         return 1;
 
+    // drop raw data left without a capability table
+    EDIDReset();
+
     // read EDID Extension Number
     // read EDID
     if (!ReadEDIDBlock(0,temp))
@@ -988,11 +1025,15 @@ int EDIDRead(void)
         return 0;
     }
 
-    return 1;
+    // build capability table
+    ParseEDID();
+
+    return gEdidCaps.valid;
 }
 
 /**
- * Reset stored EDID data.
+ * Reset stored EDID data and its capability table.
+ * Must be called on hotplug so the next query reads the new sink.
  */
 void EDIDReset(void)
 {
@@ -1001,6 +1042,7 @@ void EDIDReset(void)
         gEdidData = NULL;
         DPRINTF("\t\t\t\tEDID is reset!!!\n");
     }
+    memset(&gEdidCaps, 0, sizeof(gEdidCaps));
 }
 
 /**
@@ -1010,32 +1052,26 @@ void EDIDReset(void)
  */
 int EDIDGetCECPhysicalAddress(int* const outAddr)
 {
-    int i;
     unsigned int StartAddr;
+    int phyAddr;
 
     // check EDID data is valid or not
     // read EDID
-    if (!EDIDRead())
+    if (!EDIDRead() || !gEdidCaps.valid)
         return 0;
 
     // find VSDB
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i) // if it's timing block
-            && (StartAddr = GetVSDBOffset(i)) > 0) { // check block
-            // get supported DC value
-            // int tempDC1 = (int)(gEdidData[tempAddr+EDID_DC_POS]);
-            int phyAddr = gEdidData[StartAddr + EDID_CEC_PHYICAL_ADDR] << 8;
-            phyAddr |= gEdidData[StartAddr + EDID_CEC_PHYICAL_ADDR+1];
+    if ((StartAddr = gEdidCaps.vsdbOffset) == 0)
+        return 0;
 
-            DPRINTF("phyAddr = %x\n",phyAddr);
+    phyAddr = gEdidData[StartAddr + EDID_CEC_PHYICAL_ADDR] << 8;
+    phyAddr |= gEdidData[StartAddr + EDID_CEC_PHYICAL_ADDR+1];
 
-            *outAddr = phyAddr;
+    DPRINTF("phyAddr = %x\n",phyAddr);
 
-            return 1;
-        }
-    }
+    *outAddr = phyAddr;
 
-    return 0;
+    return 1;
 }
 
 /**
@@ -1046,14 +1082,14 @@ int EDIDGetCECPhysicalAddress(int* const outAddr)
 int EDIDHDMIModeSupport(struct HDMIVideoParameter * const video)
 {
     // check if read edid?
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
 
     // check hdmi mode
     if (video->mode == HDMI) {
-        if (!CheckHDMIMode()) {
+        if (!gEdidCaps.hdmiMode) {
             DPRINTF("HDMI mode Not Supported\n");
             return 0;
         }
@@ -1072,7 +1108,7 @@ int EDIDVideoResolutionSupport(struct HDMIVideoParameter * const video)
     unsigned int MaxTMDS = 0;
 
     // check if read edid?
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
@@ -1116,7 +1152,7 @@ int EDIDVideoResolutionSupport(struct HDMIVideoParameter * const video)
 int EDIDColorDepthSupport(struct HDMIVideoParameter * const video)
 {
     // check if read edid?
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
@@ -1138,7 +1174,7 @@ int EDIDColorDepthSupport(struct HDMIVideoParameter * const video)
 int EDIDColorSpaceSupport(struct HDMIVideoParameter * const video)
 {
     // check if read edid?
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
@@ -1159,7 +1195,7 @@ int EDIDColorSpaceSupport(struct HDMIVideoParameter * const video)
 int EDIDColorimetrySupport(struct HDMIVideoParameter * const video)
 {
     // check if read edid?
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
@@ -1183,78 +1219,45 @@ int EDIDAudioModeSupport(struct HDMIAudioParameter * const audio)
     int i;
 
     // read EDID
-    if (!EDIDRead()) {
+    if (!EDIDRead() || !gEdidCaps.valid) {
         DPRINTF("EDID Read Fail!!!\n");
         return 0;
     }
 
-    // check EDID Extension
-    // find timing block
-    for (i = 1; i <= gExtensions; i++) {
-        if (IsTimingExtension(i)) { // if it's timing block
-            // find Short Audio Description
-            unsigned int StartAddr = i*SIZEOFEDIDBLOCK;
-            unsigned int ExtAddr = StartAddr + EDID_DATA_BLOCK_START_POS;
-            unsigned int tag,blockLen;
-            unsigned int DTDStartAddr = gEdidData[StartAddr + EDID_DETAILED_TIMING_OFFSET_POS];
-
-            while (ExtAddr < StartAddr + DTDStartAddr) {
-                // find the block tag and length
-                // tag
-                tag = gEdidData[ExtAddr] & EDID_TAG_CODE_MASK;
-                // block len
-                blockLen = (gEdidData[ExtAddr] & EDID_DATA_BLOCK_SIZE_MASK) + 1;
-
-                DPRINTF("tag = %d\n",tag);
-                DPRINTF("blockLen = %d\n",blockLen-1);
-
-                // check if it is short video description
-                if (tag == EDID_SHORT_AUD_DEC_TAG_VAL) {
-                    // if so, check SAD
-                    unsigned int j, channelNum;
-                    int audioFormat,sampleFreq,wordLen;
-                    for (j = 1; j < blockLen; j += 3) {
-                        audioFormat = gEdidData[ExtAddr+j] & EDID_SAD_CODE_MASK;
-                        channelNum = gEdidData[ExtAddr+j] & EDID_SAD_CHANNEL_MASK;
-                        sampleFreq = gEdidData[ExtAddr+j+1];
-                        wordLen = gEdidData[ExtAddr+j+2];
-
-                        DPRINTF("request = %d, EDIDAudioFormatCode = %d\n",(audio->formatCode)<<3, audioFormat);
-                        DPRINTF("request = %d, EDIDChannelNumber= %d\n",(audio->channelNum)-1, channelNum);
-                        DPRINTF("request = %d, EDIDSampleFreq= %d\n",1<<(audio->sampleFreq), sampleFreq);
-                        DPRINTF("request = %d, EDIDWordLeng= %d\n",1<<(audio->wordLength), wordLen);
-
-                        // check parameter
-                        // check audioFormat
-                        if (audioFormat & ( (audio->formatCode) << 3) &&  // format code
-                                channelNum >= ( (audio->channelNum) -1) &&  // channel number
-                                (sampleFreq & (1<<(audio->sampleFreq)))) { // sample frequency
-                            if (audioFormat == LPCM_FORMAT) { // check wordLen
-                                int ret = 0;
-                                switch (audio->wordLength) {
-                                case WORD_16:
-                                case WORD_17:
-                                case WORD_18:
-                                case WORD_19:
-                                case WORD_20:
-                                    ret = wordLen & (1<<1);
-                                    break;
-                                case WORD_21:
-                                case WORD_22:
-                                case WORD_23:
-                                case WORD_24:
-                                    ret = wordLen & (1<<2);
-                                    break;
-                                }
-                                return ret;
-                            }
-                            return 1; // if not LPCM
-                        }
-                    }
+    // check SAD(Short Audio Description) of timing extensions
+    for (i = 0; i < gEdidCaps.numSAD; i++) {
+        const struct edid_sad * const sad = &gEdidCaps.sad[i];
+
+        DPRINTF("request = %d, EDIDAudioFormatCode = %d\n",(audio->formatCode)<<3, sad->audioFormat);
+        DPRINTF("request = %d, EDIDChannelNumber= %d\n",(audio->channelNum)-1, sad->channelNum);
+        DPRINTF("request = %d, EDIDSampleFreq= %d\n",1<<(audio->sampleFreq), sad->sampleFreq);
+        DPRINTF("request = %d, EDIDWordLeng= %d\n",1<<(audio->wordLength), sad->wordLen);
+
+        // check parameter
+        // check audioFormat
+        if (sad->audioFormat & ( (audio->formatCode) << 3) &&  // format code
+                sad->channelNum >= (unsigned int)( (audio->channelNum) -1) &&  // channel number
+                (sad->sampleFreq & (1<<(audio->sampleFreq)))) { // sample frequency
+            if (sad->audioFormat == LPCM_FORMAT) { // check wordLen
+                int ret = 0;
+                switch (audio->wordLength) {
+                case WORD_16:
+                case WORD_17:
+                case WORD_18:
+                case WORD_19:
+                case WORD_20:
+                    ret = sad->wordLen & (1<<1);
+                    break;
+                case WORD_21:
+                case WORD_22:
+                case WORD_23:
+                case WORD_24:
+                    ret = sad->wordLen & (1<<2);
+                    break;
                 }
-                // else find next block
-                ExtAddr += blockLen;
+                return ret;
             }
+            return 1; // if not LPCM
         }
     }
 
@@ -0,0 +1,96 @@
+/*
+* Copyright@ Samsung Electronics Co. LTD
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef EDID_CORPUS_H
+#define EDID_CORPUS_H
+
+/*
+ * EDID dumps in the layout of common sinks. Every block carries a valid
+ * checksum, so the dumps go through the same EDIDRead() path as a sink on DDC.
+ */
+
+/*
+ * DVI monitor, 1680x1050 native, base block only.
+ * Established timings include 640x480@60.
+ */
+static const unsigned char kDvi1680x1050[] = {
+    0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x10, 0xac, 0x30, 0xa0, 0x4c, 0x33, 0x32, 0x30,
+    0x0c, 0x13, 0x01, 0x03, 0x80, 0x2f, 0x1e, 0x78, 0xea, 0xee, 0x91, 0xa3, 0x54, 0x4c, 0x99, 0x26,
+    0x0f, 0x50, 0x54, 0x21, 0x08, 0x00, 0x81, 0x80, 0x71, 0x4f, 0xa9, 0x40, 0xb3, 0x00, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x21, 0x39, 0x90, 0x30, 0x62, 0x1a, 0x27, 0x40, 0x68, 0xb0,
+    0x36, 0x00, 0xda, 0x28, 0x11, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x38, 0x4c, 0x1e,
+    0x53, 0x11, 0x00, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0xfc, 0x00, 0x44,
+    0x45, 0x4c, 0x4c, 0x20, 0x32, 0x32, 0x30, 0x39, 0x57, 0x41, 0x0a, 0x20, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x43, 0x35, 0x39, 0x32, 0x4d, 0x39, 0x41, 0x52, 0x32, 0x30, 0x33, 0x33, 0x0a, 0x00, 0xa3,
+};
+
+/*
+ * HDMI 1.4 TV, one CEA extension.
+ * SVDs: 16(native) 4 31 5 20 32 34 3 18 2 17 19 1
+ * SADs: LPCM 2ch 32/44.1/48kHz 16/20/24bit, AC-3 6ch, DTS 6ch
+ * VSDB: 1.0.0.0, DC_36/DC_30/DC_Y444, max TMDS 225MHz, no latency,
+ *       3D_present, 3D_Multi_present = 01 with FP/TB/SSH,
+ *       2D_VIC_order 1 (720p60) L+depth
+ * Colorimetry: xvYCC601/xvYCC709 with MD0. YCbCr 4:4:4 and 4:2:2.
+ */
+static const unsigned char kHdmi14Tv3d[] = {
+    0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x4c, 0x2d, 0x43, 0x05, 0x00, 0x0e, 0x00, 0x01,
+    0x26, 0x15, 0x01, 0x03, 0x80, 0x66, 0x39, 0x78, 0x0a, 0xee, 0x91, 0xa3, 0x54, 0x4c, 0x99, 0x26,
+    0x0f, 0x50, 0x54, 0x21, 0x08, 0x00, 0x81, 0xc0, 0x81, 0x00, 0x81, 0x80, 0x95, 0x00, 0xa9, 0xc0,
+    0xb3, 0x00, 0x01, 0x01, 0x01, 0x01, 0x02, 0x3a, 0x80, 0x18, 0x71, 0x38, 0x2d, 0x40, 0x58, 0x2c,
+    0x45, 0x00, 0xfa, 0x3c, 0x32, 0x00, 0x00, 0x1e, 0x01, 0x1d, 0x00, 0x72, 0x51, 0xd0, 0x1e, 0x20,
+    0x6e, 0x28, 0x55, 0x00, 0xfa, 0x3c, 0x32, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x18,
+    0x4b, 0x0f, 0x51, 0x0f, 0x00, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0xfc,
+    0x00, 0x53, 0x41, 0x4d, 0x53, 0x55, 0x4e, 0x47, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x01, 0x8a,
+    0x02, 0x03, 0x32, 0xf2, 0x4d, 0x90, 0x04, 0x1f, 0x05, 0x14, 0x20, 0x22, 0x03, 0x12, 0x02, 0x11,
+    0x13, 0x01, 0x29, 0x09, 0x07, 0x07, 0x15, 0x07, 0x50, 0x3d, 0x07, 0xc0, 0x83, 0x01, 0x00, 0x00,
+    0x6d, 0x03, 0x0c, 0x00, 0x10, 0x00, 0xb8, 0x2d, 0x20, 0xa0, 0x03, 0x01, 0x41, 0x14, 0xe3, 0x05,
+    0x03, 0x01, 0x01, 0x1d, 0x80, 0x18, 0x71, 0x1c, 0x16, 0x20, 0x58, 0x2c, 0x25, 0x00, 0xfa, 0x3c,
+    0x32, 0x00, 0x00, 0x9e, 0x8c, 0x0a, 0xd0, 0x8a, 0x20, 0xe0, 0x2d, 0x10, 0x10, 0x3e, 0x96, 0x00,
+    0xfa, 0x3c, 0x32, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7,
+};
+
+/*
+ * HDMI 2.0 TV, one CEA extension.
+ * SVDs: 16(native) 4 19 31 32 34 5 20 3 2 1
+ * VSDB: 2.0.0.0, no deep color, max TMDS 300MHz, latency and interlaced
+ *       latency present, 3D_present, HDMI_VIC 1 2,
+ *       3D_Multi_present = 10 with TB masked to SVD 0 and 2,
+ *       2D_VIC_order 1 (720p60) side-by-side(half) with 3D_Detail
+ * HF-VSDB: max TMDS character rate 600MHz, SCDC_Present. RGB only.
+ */
+static const unsigned char kHdmi20TvHfvsdb[] = {
+    0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x1e, 0x6d, 0x09, 0x5b, 0xf5, 0xc3, 0x01, 0x00,
+    0x01, 0x1a, 0x01, 0x03, 0x80, 0x66, 0x39, 0x78, 0x0a, 0xee, 0x91, 0xa3, 0x54, 0x4c, 0x99, 0x26,
+    0x0f, 0x50, 0x54, 0x21, 0x08, 0x00, 0x81, 0xc0, 0x81, 0x00, 0x81, 0x80, 0x95, 0x00, 0xa9, 0xc0,
+    0xb3, 0x00, 0x71, 0x4f, 0x01, 0x01, 0x02, 0x3a, 0x80, 0x18, 0x71, 0x38, 0x2d, 0x40, 0x58, 0x2c,
+    0x45, 0x00, 0xfa, 0x3c, 0x32, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x18, 0x3d, 0x1e,
+    0x87, 0x3c, 0x00, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0xfc, 0x00, 0x4c,
+    0x47, 0x20, 0x54, 0x56, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x10,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x81,
+    0x02, 0x03, 0x33, 0xc1, 0x4b, 0x90, 0x04, 0x13, 0x1f, 0x20, 0x22, 0x05, 0x14, 0x03, 0x02, 0x01,
+    0x23, 0x09, 0x07, 0x07, 0x76, 0x03, 0x0c, 0x00, 0x20, 0x00, 0x80, 0x3c, 0xe0, 0x1e, 0x1e, 0x2e,
+    0x2e, 0xc0, 0x46, 0x01, 0x02, 0x00, 0x40, 0x00, 0x05, 0x18, 0x10, 0x67, 0xd8, 0x5d, 0xc4, 0x01,
+    0x78, 0x80, 0x00, 0x01, 0x1d, 0x00, 0x72, 0x51, 0xd0, 0x1e, 0x20, 0x6e, 0x28, 0x55, 0x00, 0xfa,
+    0x3c, 0x32, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53,
+};
+
+#endif // EDID_CORPUS_H
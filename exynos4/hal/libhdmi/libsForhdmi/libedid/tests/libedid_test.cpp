@@ -0,0 +1,311 @@
+/*
+* Copyright@ Samsung Electronics Co. LTD
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "libedid.h"
+#include "../libddc/libddc.h"
+#include "edid_corpus.h"
+
+/*
+ * Fake DDC bus: EDDCRead() serves the dump of the sink that is currently
+ * "plugged", and counts reads so tests can see when libedid goes to the bus.
+ */
+static const unsigned char *gSink;
+static unsigned int gSinkSize;
+static int gReads;
+
+extern "C" {
+
+int DDCOpen()
+{
+    return 1;
+}
+
+int DDCClose()
+{
+    return 1;
+}
+
+int DDCRead(unsigned char, unsigned char, unsigned int, unsigned char*)
+{
+    return 0;
+}
+
+int DDCWrite(unsigned char, unsigned char, unsigned int, unsigned char*)
+{
+    return 0;
+}
+
+int EDDCRead(unsigned char, unsigned char segment, unsigned char,
+        unsigned char offset, unsigned int size, unsigned char* buffer)
+{
+    unsigned int start = segment * 256 + offset;
+
+    gReads++;
+    if (!gSink || start + size > gSinkSize)
+        return 0;
+
+    memcpy(buffer, gSink + start, size);
+    return 1;
+}
+
+}
+
+class EdidTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(1, EDIDOpen());
+    }
+
+    virtual void TearDown()
+    {
+        EDIDClose();
+        plug(NULL, 0);
+    }
+
+    void plug(const unsigned char *dump, unsigned int size)
+    {
+        gSink = dump;
+        gSinkSize = size;
+        gReads = 0;
+    }
+
+    // hotplug: the new sink is read on the next query
+    void hotplug(const unsigned char *dump, unsigned int size)
+    {
+        EDIDReset();
+        plug(dump, size);
+    }
+
+    static struct HDMIVideoParameter video(enum VideoFormat resolution,
+            enum HDMI3DVideoStructure format = HDMI_2D_VIDEO_FORMAT)
+    {
+        struct HDMIVideoParameter v;
+
+        memset(&v, 0, sizeof(v));
+        v.mode = HDMI;
+        v.resolution = resolution;
+        v.colorSpace = HDMI_CS_RGB;
+        v.colorDepth = HDMI_CD_24;
+        v.colorimetry = HDMI_COLORIMETRY_NO_DATA;
+        v.pixelAspectRatio = HDMI_PIXEL_RATIO_16_9;
+        v.hdmi_3d_format = format;
+        return v;
+    }
+
+    static struct HDMIAudioParameter audio(enum AudioFormat format, enum ChannelNum ch,
+            enum SamplingFreq freq, enum LPCM_WordLen len)
+    {
+        struct HDMIAudioParameter a;
+
+        memset(&a, 0, sizeof(a));
+        a.formatCode = format;
+        a.channelNum = ch;
+        a.sampleFreq = freq;
+        a.wordLength = len;
+        return a;
+    }
+
+    static int resolution(enum VideoFormat res,
+            enum HDMI3DVideoStructure format = HDMI_2D_VIDEO_FORMAT)
+    {
+        struct HDMIVideoParameter v = video(res, format);
+        return EDIDVideoResolutionSupport(&v);
+    }
+};
+
+#define PLUG(dump)      plug(dump, sizeof(dump))
+#define HOTPLUG(dump)   hotplug(dump, sizeof(dump))
+
+TEST_F(EdidTest, DviMonitor)
+{
+    struct HDMIVideoParameter v = video(v640x480p_60Hz);
+    int addr;
+
+    PLUG(kDvi1680x1050);
+
+    EXPECT_EQ(0, EDIDHDMIModeSupport(&v));
+    v.mode = DVI;
+    EXPECT_EQ(1, EDIDHDMIModeSupport(&v));
+
+    // only the established 640x480 timing matches a CEA format
+    EXPECT_EQ(1, resolution(v640x480p_60Hz));
+    EXPECT_EQ(0, resolution(v1280x720p_60Hz));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz));
+
+    v.colorSpace = HDMI_CS_YCBCR444;
+    EXPECT_EQ(0, EDIDColorSpaceSupport(&v));
+    EXPECT_EQ(0, EDIDGetCECPhysicalAddress(&addr));
+}
+
+TEST_F(EdidTest, Hdmi14Video)
+{
+    struct HDMIVideoParameter v = video(v1920x1080p_60Hz);
+
+    PLUG(kHdmi14Tv3d);
+
+    EXPECT_EQ(1, EDIDHDMIModeSupport(&v));
+    EXPECT_EQ(1, resolution(v1920x1080p_60Hz));
+    EXPECT_EQ(1, resolution(v1280x720p_50Hz));
+    EXPECT_EQ(1, resolution(v1920x1080i_60Hz));
+
+    // 480p is listed with both aspect ratios
+    v = video(v720x480p_60Hz);
+    v.pixelAspectRatio = HDMI_PIXEL_RATIO_4_3;
+    EXPECT_EQ(1, EDIDVideoResolutionSupport(&v));
+
+    v.colorDepth = HDMI_CD_36;
+    EXPECT_EQ(1, EDIDColorDepthSupport(&v));
+    v.colorSpace = HDMI_CS_YCBCR444;
+    EXPECT_EQ(1, EDIDColorDepthSupport(&v));
+    EXPECT_EQ(1, EDIDColorSpaceSupport(&v));
+    v.colorSpace = HDMI_CS_YCBCR422;
+    EXPECT_EQ(1, EDIDColorSpaceSupport(&v));
+
+    v.colorimetry = HDMI_COLORIMETRY_EXTENDED_xvYCC709;
+    EXPECT_EQ(1, EDIDColorimetrySupport(&v));
+}
+
+TEST_F(EdidTest, Hdmi14Audio)
+{
+    struct HDMIAudioParameter a;
+    int addr;
+
+    PLUG(kHdmi14Tv3d);
+
+    a = audio(LPCM_FORMAT, CH_2, SF_48KHZ, WORD_16);
+    EXPECT_NE(0, EDIDAudioModeSupport(&a));
+    a = audio(LPCM_FORMAT, CH_2, SF_96KHZ, WORD_16);
+    EXPECT_EQ(0, EDIDAudioModeSupport(&a));
+    a = audio(AC3_FORMAT, CH_6, SF_48KHZ, WORD_16);
+    EXPECT_EQ(1, EDIDAudioModeSupport(&a));
+
+    ASSERT_EQ(1, EDIDGetCECPhysicalAddress(&addr));
+    EXPECT_EQ(0x1000, addr);
+}
+
+TEST_F(EdidTest, Hdmi14ThreeD)
+{
+    PLUG(kHdmi14Tv3d);
+
+    // 3D_Structure_ALL applies to every listed VIC
+    EXPECT_EQ(1, resolution(v1920x1080p_60Hz, HDMI_3D_FP_FORMAT));
+    EXPECT_EQ(1, resolution(v1920x1080p_24Hz, HDMI_3D_TB_FORMAT));
+    EXPECT_EQ(1, resolution(v1920x1080i_60Hz, HDMI_3D_SSH_FORMAT));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz, HDMI_3D_FA_FORMAT));
+
+    // 2D_VIC_order 1 adds L+depth to 720p60 only
+    EXPECT_EQ(1, resolution(v1280x720p_60Hz, HDMI_3D_LD_FORMAT));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz, HDMI_3D_LD_FORMAT));
+
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz, HDMI_VIC_FORMAT));
+}
+
+TEST_F(EdidTest, Hdmi20ThreeDMask)
+{
+    PLUG(kHdmi20TvHfvsdb);
+
+    // TB through 3D_MASK: SVD 0 (1080p60) and 2 (720p50), not SVD 3 (1080p50)
+    EXPECT_EQ(1, resolution(v1920x1080p_60Hz, HDMI_3D_TB_FORMAT));
+    EXPECT_EQ(1, resolution(v1280x720p_50Hz, HDMI_3D_TB_FORMAT));
+    EXPECT_EQ(0, resolution(v1920x1080p_50Hz, HDMI_3D_TB_FORMAT));
+
+    // side-by-side(half) from 2D_VIC_order 1, with its 3D_Detail byte skipped
+    EXPECT_EQ(1, resolution(v1280x720p_60Hz, HDMI_3D_SSH_FORMAT));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz, HDMI_3D_SSH_FORMAT));
+
+    // mandatory formats through 3D_present
+    EXPECT_EQ(1, resolution(v1920x1080p_24Hz, HDMI_3D_FP_FORMAT));
+    EXPECT_EQ(0, resolution(v1920x1080p_30Hz, HDMI_3D_FP_FORMAT));
+}
+
+TEST_F(EdidTest, Hdmi20Capabilities)
+{
+    struct HDMIVideoParameter v = video(v1920x1080p_60Hz);
+    int addr;
+
+    PLUG(kHdmi20TvHfvsdb);
+
+    EXPECT_EQ(1, EDIDHDMIModeSupport(&v));
+
+    // no deep color and RGB only
+    v.colorDepth = HDMI_CD_30;
+    EXPECT_EQ(0, EDIDColorDepthSupport(&v));
+    v.colorDepth = HDMI_CD_36;
+    EXPECT_EQ(0, EDIDColorDepthSupport(&v));
+    v.colorSpace = HDMI_CS_YCBCR444;
+    EXPECT_EQ(0, EDIDColorSpaceSupport(&v));
+    v.colorimetry = HDMI_COLORIMETRY_EXTENDED_xvYCC601;
+    EXPECT_EQ(0, EDIDColorimetrySupport(&v));
+
+    ASSERT_EQ(1, EDIDGetCECPhysicalAddress(&addr));
+    EXPECT_EQ(0x2000, addr);
+}
+
+TEST_F(EdidTest, ReadOncePerHotplug)
+{
+    int addr;
+
+    PLUG(kHdmi14Tv3d);
+
+    EXPECT_EQ(1, resolution(v1920x1080p_60Hz));
+    EXPECT_EQ(2, gReads);
+
+    EXPECT_EQ(1, resolution(v1280x720p_60Hz, HDMI_3D_LD_FORMAT));
+    EXPECT_EQ(1, EDIDGetCECPhysicalAddress(&addr));
+    EXPECT_EQ(2, gReads);
+
+    HOTPLUG(kHdmi20TvHfvsdb);
+    EXPECT_EQ(0, resolution(v1280x720p_60Hz, HDMI_3D_LD_FORMAT));
+    EXPECT_EQ(1, EDIDGetCECPhysicalAddress(&addr));
+    EXPECT_EQ(0x2000, addr);
+    EXPECT_EQ(2, gReads);
+}
+
+TEST_F(EdidTest, ResetWithoutSink)
+{
+    struct HDMIVideoParameter v = video(v1920x1080p_60Hz);
+    struct HDMIAudioParameter a = audio(LPCM_FORMAT, CH_2, SF_48KHZ, WORD_16);
+    int addr;
+
+    PLUG(kHdmi14Tv3d);
+    ASSERT_EQ(1, EDIDHDMIModeSupport(&v));
+
+    hotplug(NULL, 0);
+
+    EXPECT_EQ(0, EDIDHDMIModeSupport(&v));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz));
+    EXPECT_EQ(0, resolution(v1920x1080p_60Hz, HDMI_3D_FP_FORMAT));
+    EXPECT_EQ(0, EDIDAudioModeSupport(&a));
+    EXPECT_EQ(0, EDIDGetCECPhysicalAddress(&addr));
+}
+
+TEST_F(EdidTest, BadChecksum)
+{
+    unsigned char dump[sizeof(kHdmi14Tv3d)];
+    struct HDMIVideoParameter v = video(v1920x1080p_60Hz);
+
+    memcpy(dump, kHdmi14Tv3d, sizeof(dump));
+    dump[128 + 4] ^= 0xFF;
+    PLUG(dump);
+
+    EXPECT_EQ(0, EDIDRead());
+    EXPECT_EQ(0, EDIDHDMIModeSupport(&v));
+}
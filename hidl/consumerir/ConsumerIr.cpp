@@ -18,11 +18,12 @@
 
 #include <samsung_ir.h>
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
+#include <android-base/logging.h>
 
-using android::base::Join;
-using android::base::WriteStringToFile;
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 namespace android {
 namespace hardware {
@@ -30,10 +31,52 @@ namespace ir {
 namespace V1_0 {
 namespace implementation {
 
-// Methods from ::android::hardware::ir::V1_0::IConsumerIr follow.
-Return<bool> ConsumerIr::transmit(int32_t carrierFreq, const hidl_vec<int32_t>& pattern) {
+// Number of formatted patterns kept around for repeated transmits
+static constexpr size_t kPatternCacheSize = 8;
+
+// Appends the decimal form of value to out, which must have room for 11 chars
+static char* appendInt(char* out, int32_t value) {
+    char digits[10];
+    int len = 0;
+    uint32_t v = value;
+
+    if (value < 0) {
+        *out++ = '-';
+        v = 0u - v;
+    }
+
+    do {
+        digits[len++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    while (len)
+        *out++ = digits[--len];
+
+    return out;
+}
+
+const std::string& ConsumerIr::formatPattern(int32_t carrierFreq,
+                                             const hidl_vec<int32_t>& pattern) {
+    for (auto it = mCache.begin(); it != mCache.end(); ++it) {
+        if (it->carrierFreq == carrierFreq && it->pattern.size() == pattern.size() &&
+            std::equal(pattern.begin(), pattern.end(), it->pattern.begin())) {
+            mCache.splice(mCache.begin(), mCache, it);
+            return mCache.front().text;
+        }
+    }
+
+    // Reuse the storage of the least recently sent pattern
+    if (mCache.size() < kPatternCacheSize)
+        mCache.emplace_front();
+    else
+        mCache.splice(mCache.begin(), mCache, std::prev(mCache.end()));
+
+    CachedPattern& entry = mCache.front();
+    entry.carrierFreq = carrierFreq;
+    entry.pattern.assign(pattern.begin(), pattern.end());
+
     float factor;
-    std::vector<int32_t> buffer{carrierFreq};
 
 #ifndef MS_IR_SIGNAL
     // Calculate factor of conversion from microseconds to pulses
@@ -42,11 +85,43 @@ Return<bool> ConsumerIr::transmit(int32_t carrierFreq, const hidl_vec<int32_t>&
     factor = 1;
 #endif
 
+    // Every number takes at most 11 chars plus a separator
+    entry.text.resize((pattern.size() + 1) * 12);
+    char* out = appendInt(&entry.text[0], carrierFreq);
     for (const int32_t& number : pattern) {
-        buffer.emplace_back(number / factor);
+        *out++ = ',';
+        out = appendInt(out, static_cast<int32_t>(number / factor));
     }
+    entry.text.resize(out - entry.text.data());
+
+    return entry.text;
+}
+
+bool ConsumerIr::writePattern(const std::string& text) {
+    if (!mFd.ok()) {
+        mFd.reset(TEMP_FAILURE_RETRY(open(IR_PATH, O_WRONLY | O_CLOEXEC)));
+        if (!mFd.ok()) {
+            PLOG(ERROR) << "Failed to open " << IR_PATH;
+            return false;
+        }
+    }
+
+    ssize_t len = TEMP_FAILURE_RETRY(pwrite(mFd.get(), text.data(), text.size(), 0));
+    if (len != static_cast<ssize_t>(text.size())) {
+        PLOG(ERROR) << "Failed to write pattern to " << IR_PATH;
+        // Reopen on the next transmit in case the node went away
+        mFd.reset();
+        return false;
+    }
+
+    return true;
+}
+
+// Methods from ::android::hardware::ir::V1_0::IConsumerIr follow.
+Return<bool> ConsumerIr::transmit(int32_t carrierFreq, const hidl_vec<int32_t>& pattern) {
+    std::lock_guard<std::mutex> lock(mLock);
 
-    return WriteStringToFile(Join(buffer, ','), IR_PATH, true);
+    return writePattern(formatPattern(carrierFreq, pattern));
 }
 
 Return<void> ConsumerIr::getCarrierFreqs(getCarrierFreqs_cb _hidl_cb) {
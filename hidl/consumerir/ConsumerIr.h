@@ -20,6 +20,12 @@
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 
+#include <android-base/unique_fd.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+
 namespace android {
 namespace hardware {
 namespace ir {
@@ -34,6 +40,23 @@ class ConsumerIr : public IConsumerIr {
     // Methods from ::android::hardware::ir::V1_0::IConsumerIr follow.
     Return<bool> transmit(int32_t carrierFreq, const hidl_vec<int32_t>& pattern) override;
     Return<void> getCarrierFreqs(getCarrierFreqs_cb _hidl_cb) override;
+
+  private:
+    // A formatted pattern, as written to the IR node
+    struct CachedPattern {
+        int32_t carrierFreq;
+        std::vector<int32_t> pattern;
+        std::string text;
+    };
+
+    const std::string& formatPattern(int32_t carrierFreq, const hidl_vec<int32_t>& pattern);
+    bool writePattern(const std::string& text);
+
+    std::mutex mLock;
+    android::base::unique_fd mFd;
+    // Most recently sent patterns, newest first. Remotes repeat the same code
+    // on every press and while a key is held, so a hit skips the formatting.
+    std::list<CachedPattern> mCache;
 };
 
 }  // namespace implementation
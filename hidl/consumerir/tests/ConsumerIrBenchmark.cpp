@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConsumerIr.h"
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using ::android::sp;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::ir::V1_0::implementation::ConsumerIr;
+
+static std::string sNode;
+
+const char* consumerIrTestNode() {
+    return sNode.c_str();
+}
+
+// One NEC frame: leader, 32 bits and a stop bit
+static hidl_vec<int32_t> necFrame(uint32_t code) {
+    std::vector<int32_t> pattern = {9000, 4500};
+
+    for (int i = 0; i < 32; i++) {
+        pattern.push_back(560);
+        pattern.push_back((code >> i) & 1 ? 1690 : 560);
+    }
+    pattern.push_back(560);
+
+    return hidl_vec<int32_t>(pattern);
+}
+
+// A key held down: the same frame over and over
+static void BM_TransmitRepeat(benchmark::State& state) {
+    TemporaryDir dir;
+    sNode = std::string(dir.path) + "/ir_send";
+    android::base::WriteStringToFile("", sNode);
+
+    sp<ConsumerIr> ir = new ConsumerIr();
+    hidl_vec<int32_t> frame = necFrame(0x20df10ef);
+
+    for (auto _ : state)
+        ir->transmit(38000, frame);
+}
+BENCHMARK(BM_TransmitRepeat);
+
+// Every transmit a different key, so every pattern is formatted afresh
+static void BM_TransmitDistinct(benchmark::State& state) {
+    TemporaryDir dir;
+    sNode = std::string(dir.path) + "/ir_send";
+    android::base::WriteStringToFile("", sNode);
+
+    sp<ConsumerIr> ir = new ConsumerIr();
+    std::vector<hidl_vec<int32_t>> frames;
+    size_t i = 0;
+
+    for (uint32_t code = 0; code < 64; code++)
+        frames.push_back(necFrame(0x20df0000 | code));
+
+    for (auto _ : state)
+        ir->transmit(38000, frames[i++ % frames.size()]);
+}
+BENCHMARK(BM_TransmitDistinct);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConsumerIr.h"
+
+#include <samsung_ir.h>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using ::android::sp;
+using ::android::base::ReadFileToString;
+using ::android::base::WriteStringToFile;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::ir::V1_0::implementation::ConsumerIr;
+
+static std::string sNode;
+
+const char* consumerIrTestNode() {
+    return sNode.c_str();
+}
+
+namespace {
+
+class ConsumerIrTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        sNode = std::string(mDir.path) + "/ir_send";
+        ASSERT_TRUE(WriteStringToFile("", sNode));
+        mIr = new ConsumerIr();
+    }
+
+    // The node is a plain file, so empty it before each transmit
+    bool transmit(int32_t carrierFreq, const std::vector<int32_t>& pattern) {
+        EXPECT_TRUE(WriteStringToFile("", sNode));
+        return mIr->transmit(carrierFreq, hidl_vec<int32_t>(pattern));
+    }
+
+    static std::string sent() {
+        std::string text;
+        EXPECT_TRUE(ReadFileToString(sNode, &text));
+        return text;
+    }
+
+    // The formatting transmit() used before the pattern cache: ints joined by ','
+    static std::string expected(int32_t carrierFreq, const std::vector<int32_t>& pattern) {
+        float factor = 1000000 / carrierFreq;
+        std::string text = std::to_string(carrierFreq);
+
+        for (int32_t number : pattern)
+            text += "," + std::to_string(static_cast<int32_t>(number / factor));
+
+        return text;
+    }
+
+    static std::vector<int32_t> nec(uint8_t command) {
+        std::vector<int32_t> pattern = {9000, 4500};
+
+        for (int i = 0; i < 32; i++) {
+            pattern.push_back(560);
+            pattern.push_back((command >> (i % 8)) & 1 ? 1690 : 560);
+        }
+        pattern.push_back(560);
+
+        return pattern;
+    }
+
+    TemporaryDir mDir;
+    sp<ConsumerIr> mIr;
+};
+
+TEST_F(ConsumerIrTest, MatchesOldFormatting) {
+    std::mt19937 rng(1);
+
+    for (int i = 0; i < 200; i++) {
+        int32_t carrierFreq = consumerirFreqs[i % consumerirFreqs.size()].min;
+        std::vector<int32_t> pattern(1 + rng() % 150);
+
+        for (auto& number : pattern)
+            number = static_cast<int32_t>(rng() % 40000);
+        if (i % 7 == 0)
+            pattern[0] = -123456;
+
+        ASSERT_TRUE(transmit(carrierFreq, pattern));
+        ASSERT_EQ(expected(carrierFreq, pattern), sent()) << "pattern " << i;
+
+        // A repeat is served from the cache
+        if (i % 3 == 0) {
+            ASSERT_TRUE(transmit(carrierFreq, pattern));
+            ASSERT_EQ(expected(carrierFreq, pattern), sent()) << "repeat " << i;
+        }
+    }
+}
+
+TEST_F(ConsumerIrTest, CacheKeyedOnCarrierAndPattern) {
+    std::vector<int32_t> pattern = nec(0x10);
+
+    ASSERT_TRUE(transmit(38000, pattern));
+    ASSERT_TRUE(transmit(30000, pattern));
+    EXPECT_EQ(expected(30000, pattern), sent());
+
+    pattern.back()++;
+    ASSERT_TRUE(transmit(30000, pattern));
+    EXPECT_EQ(expected(30000, pattern), sent());
+
+    pattern.pop_back();
+    ASSERT_TRUE(transmit(30000, pattern));
+    EXPECT_EQ(expected(30000, pattern), sent());
+}
+
+TEST_F(ConsumerIrTest, EvictedPatternsAreReformatted) {
+    // Cycle through more keys than the cache holds, twice
+    for (int round = 0; round < 2; round++) {
+        for (uint8_t command = 0; command < 20; command++) {
+            ASSERT_TRUE(transmit(38000, nec(command)));
+            ASSERT_EQ(expected(38000, nec(command)), sent());
+        }
+    }
+}
+
+TEST_F(ConsumerIrTest, ReopensMissingNode) {
+    ASSERT_EQ(0, unlink(sNode.c_str()));
+    EXPECT_FALSE(mIr->transmit(38000, hidl_vec<int32_t>(nec(1))));
+
+    ASSERT_TRUE(transmit(38000, nec(1)));
+    EXPECT_EQ(expected(38000, nec(1)), sent());
+}
+
+TEST_F(ConsumerIrTest, CarrierFreqs) {
+    bool success = false;
+    std::vector<ConsumerIrFreqRange> freqs;
+
+    mIr->getCarrierFreqs([&](bool ok, const hidl_vec<ConsumerIrFreqRange>& ranges) {
+        success = ok;
+        freqs = ranges;
+    });
+
+    EXPECT_TRUE(success);
+    ASSERT_EQ(consumerirFreqs.size(), freqs.size());
+    EXPECT_EQ(38000, freqs[1].min);
+}
+
+}  // namespace
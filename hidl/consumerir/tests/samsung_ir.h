@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/hardware/ir/1.0/IConsumerIr.h>
+
+using android::hardware::ir::V1_0::ConsumerIrFreqRange;
+
+/*
+ * Test build: the IR node is a plain file the test picks at run time.
+ */
+const char* consumerIrTestNode();
+
+#define IR_PATH consumerIrTestNode()
+
+static const std::vector<ConsumerIrFreqRange> consumerirFreqs = {
+    {.min = 30000, .max = 30000},
+    {.min = 38000, .max = 38000},
+};
@@ -14,16 +14,10 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
-
 #include <fstream>
 
 #include "AdaptiveBacklight.h"
-
-using android::base::ReadFileToString;
-using android::base::Trim;
-using android::base::WriteStringToFile;
+#include "DisplayState.h"
 
 namespace vendor {
 namespace lineage {
@@ -40,18 +34,15 @@ bool AdaptiveBacklight::isSupported() {
 
 // Methods from ::vendor::lineage::livedisplay::V2_0::IAdaptiveBacklight follow.
 Return<bool> AdaptiveBacklight::isEnabled() {
-    std::string tmp;
     int32_t contents = 0;
 
-    if (ReadFileToString(kBacklightPath, &tmp)) {
-        contents = std::stoi(Trim(tmp));
-    }
+    DisplayState::getInstance().readInt(kBacklightPath, &contents);
 
     return contents > 0;
 }
 
 Return<bool> AdaptiveBacklight::setEnabled(bool enabled) {
-    return WriteStringToFile(enabled ? "1" : "0", kBacklightPath, true);
+    return DisplayState::getInstance().write(kBacklightPath, enabled ? "1" : "0");
 }
 
 }  // namespace samsung
@@ -14,17 +14,15 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
 #include <android-base/strings.h>
 
 #include <fstream>
 
 #include "DisplayColorCalibration.h"
+#include "DisplayState.h"
 
-using android::base::ReadFileToString;
 using android::base::Split;
 using android::base::Trim;
-using android::base::WriteStringToFile;
 
 namespace vendor {
 namespace lineage {
@@ -51,8 +49,8 @@ Return<void> DisplayColorCalibration::getCalibration(getCalibration_cb _hidl_cb)
     std::vector<int32_t> rgb;
     std::string tmp;
 
-    if (ReadFileToString(FILE_RGB, &tmp)) {
-        std::vector<std::string> colors = Split(Trim(tmp), " ");
+    if (DisplayState::getInstance().read(FILE_RGB, &tmp)) {
+        std::vector<std::string> colors = Split(tmp, " ");
         for (const std::string& color : colors) {
             rgb.push_back(std::stoi(color));
         }
@@ -69,7 +67,7 @@ Return<bool> DisplayColorCalibration::setCalibration(const hidl_vec<int32_t>& rg
         contents += std::to_string(color) + " ";
     }
 
-    return WriteStringToFile(Trim(contents), FILE_RGB, true);
+    return DisplayState::getInstance().write(FILE_RGB, Trim(contents));
 }
 
 }  // namespace samsung
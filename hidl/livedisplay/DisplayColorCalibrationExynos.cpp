@@ -14,17 +14,15 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
 #include <android-base/strings.h>
 
 #include <fstream>
 
 #include "DisplayColorCalibrationExynos.h"
+#include "DisplayState.h"
 
-using android::base::ReadFileToString;
 using android::base::Split;
 using android::base::Trim;
-using android::base::WriteStringToFile;
 
 namespace vendor {
 namespace lineage {
@@ -51,8 +49,8 @@ Return<void> DisplayColorCalibrationExynos::getCalibration(getCalibration_cb res
     std::vector<int32_t> rgb;
     std::string tmp;
 
-    if (ReadFileToString(kColorPath, &tmp)) {
-        std::vector<std::string> colors = Split(Trim(tmp), " ");
+    if (DisplayState::getInstance().read(kColorPath, &tmp)) {
+        std::vector<std::string> colors = Split(tmp, " ");
         for (const std::string& color : colors) {
             rgb.push_back(std::stoi(color));
         }
@@ -67,7 +65,7 @@ Return<bool> DisplayColorCalibrationExynos::setCalibration(const hidl_vec<int32_
     for (const int32_t& color : rgb) {
         contents += std::to_string(color) + " ";
     }
-    return WriteStringToFile(Trim(contents), kColorPath, true);
+    return DisplayState::getInstance().write(kColorPath, Trim(contents));
 }
 
 }  // namespace samsung
@@ -20,6 +20,8 @@
 #include <android-base/logging.h>
 #include <fstream>
 
+#include "DisplayState.h"
+
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -55,11 +57,8 @@ DisplayModes::DisplayModes() : mDefaultModeId(0) {
         return;
     }
 
-    for (const auto& entry : kModeMap) {
-        if (value == entry.first) {
-            mDefaultModeId = entry.first;
-            break;
-        }
+    if (kModeMap.count(value)) {
+        mDefaultModeId = value;
     }
 
     setDisplayMode(mDefaultModeId, false);
@@ -72,16 +71,14 @@ bool DisplayModes::isSupported() {
 
 // Methods from ::vendor::lineage::livedisplay::V2_0::IDisplayModes follow.
 Return<void> DisplayModes::getDisplayModes(getDisplayModes_cb resultCb) {
-    std::ifstream maxModeFile(kModeMaxPath);
-    int value;
+    int32_t value;
     std::vector<DisplayMode> modes;
-    if (!maxModeFile.fail()) {
-        maxModeFile >> value;
-    } else {
+    if (!DisplayState::getInstance().readInt(kModeMaxPath, &value)) {
         value = kModeMap.size();
     }
-    for (const auto& entry : kModeMap) {
-        if (entry.first < value) modes.push_back({entry.first, entry.second});
+    // kModeMap is ordered by id
+    for (auto it = kModeMap.begin(); it != kModeMap.end() && it->first < value; ++it) {
+        modes.push_back({it->first, it->second});
     }
     resultCb(modes);
     return Void();
@@ -89,16 +86,9 @@ Return<void> DisplayModes::getDisplayModes(getDisplayModes_cb resultCb) {
 
 Return<void> DisplayModes::getCurrentDisplayMode(getCurrentDisplayMode_cb resultCb) {
     int32_t currentModeId = mDefaultModeId;
-    std::ifstream modeFile(kModePath);
-    int value;
-    modeFile >> value;
-    if (!modeFile.fail()) {
-        for (const auto& entry : kModeMap) {
-            if (value == entry.first) {
-                currentModeId = entry.first;
-                break;
-            }
-        }
+    int32_t value;
+    if (DisplayState::getInstance().readInt(kModePath, &value) && kModeMap.count(value)) {
+        currentModeId = value;
     }
     resultCb({currentModeId, kModeMap.at(currentModeId)});
     return Void();
@@ -114,9 +104,7 @@ Return<bool> DisplayModes::setDisplayMode(int32_t modeID, bool makeDefault) {
     if (iter == kModeMap.end()) {
         return false;
     }
-    std::ofstream modeFile(kModePath);
-    modeFile << iter->first;
-    if (modeFile.fail()) {
+    if (!DisplayState::getInstance().write(kModePath, std::to_string(iter->first))) {
         return false;
     }
 
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2019-2022 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DisplayState"
+
+#include "DisplayState.h"
+
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+#include <cutils/uevent.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <thread>
+
+using android::base::ParseInt;
+using android::base::Trim;
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_0 {
+namespace samsung {
+
+static constexpr int kUeventBufSize = 64 * 1024;
+static constexpr int kUeventMsgLen = 2048;
+
+// Subsystems whose uevents may mean the panel state changed behind our back
+static constexpr const char* kUeventDevpaths[] = {"/mdnie", "/lcd/", "/graphics/"};
+
+DisplayState& DisplayState::getInstance() {
+    static DisplayState instance;
+    return instance;
+}
+
+DisplayState::DisplayState() {
+    // The instance lives as long as the service
+    std::thread(&DisplayState::ueventLoop, this).detach();
+}
+
+DisplayState::Node* DisplayState::openLocked(const char* path) {
+    Node& node = mNodes[path];
+
+    if (!node.fd.ok()) {
+        node.fd.reset(TEMP_FAILURE_RETRY(open(path, O_RDWR | O_CLOEXEC)));
+        if (!node.fd.ok())
+            node.fd.reset(TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)));
+        if (!node.fd.ok())
+            node.fd.reset(TEMP_FAILURE_RETRY(open(path, O_WRONLY | O_CLOEXEC)));
+        if (!node.fd.ok()) {
+            PLOG(ERROR) << "Failed to open " << path;
+            return nullptr;
+        }
+        node.valid = false;
+    }
+
+    return &node;
+}
+
+bool DisplayState::read(const char* path, std::string* out) {
+    std::lock_guard<std::mutex> lock(mLock);
+    char buf[4096];
+
+    Node* node = openLocked(path);
+    if (node == nullptr)
+        return false;
+
+    if (!node->valid) {
+        ssize_t len = TEMP_FAILURE_RETRY(pread(node->fd.get(), buf, sizeof(buf), 0));
+        if (len < 0) {
+            PLOG(ERROR) << "Failed to read " << path;
+            return false;
+        }
+        node->value = Trim(std::string(buf, len));
+        node->valid = true;
+    }
+
+    *out = node->value;
+    return true;
+}
+
+bool DisplayState::readInt(const char* path, int32_t* out) {
+    std::string value;
+
+    return read(path, &value) && ParseInt(value, out);
+}
+
+bool DisplayState::writeLocked(const char* path, const std::string& value) {
+    Node* node = openLocked(path);
+    if (node == nullptr)
+        return false;
+
+    if (node->valid && node->value == value)
+        return true;
+
+    ssize_t len = TEMP_FAILURE_RETRY(pwrite(node->fd.get(), value.data(), value.size(), 0));
+    if (len != static_cast<ssize_t>(value.size())) {
+        PLOG(ERROR) << "Failed to write " << value << " to " << path;
+        node->valid = false;
+        return false;
+    }
+
+    node->value = value;
+    node->valid = true;
+    return true;
+}
+
+bool DisplayState::write(const char* path, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return writeLocked(path, value);
+}
+
+bool DisplayState::apply(const std::vector<Write>& writes) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool ret = true;
+
+    for (size_t i = 0; i < writes.size(); i++) {
+        bool superseded = false;
+        for (size_t j = i + 1; j < writes.size() && !superseded; j++)
+            superseded = !strcmp(writes[i].path, writes[j].path);
+
+        if (!superseded && !writeLocked(writes[i].path, writes[i].value))
+            ret = false;
+    }
+
+    return ret;
+}
+
+void DisplayState::invalidate() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    for (auto& entry : mNodes)
+        entry.second.valid = false;
+}
+
+void DisplayState::onUevent(const char* msg) {
+    // The header is "action@devpath"
+    for (const char* devpath : kUeventDevpaths) {
+        if (strstr(msg, devpath) != nullptr) {
+            LOG(DEBUG) << "Display state invalidated by " << msg;
+            invalidate();
+            break;
+        }
+    }
+}
+
+void DisplayState::ueventLoop() {
+    char msg[kUeventMsgLen + 2];
+
+    android::base::unique_fd fd(uevent_open_socket(kUeventBufSize, true));
+    if (!fd.ok()) {
+        LOG(ERROR) << "Failed to open uevent socket, display state is never invalidated";
+        return;
+    }
+
+    while (true) {
+        ssize_t n = uevent_kernel_multicast_recv(fd.get(), msg, kUeventMsgLen);
+        if (n <= 0 || n >= kUeventMsgLen)
+            continue;
+
+        msg[n] = '\0';
+        onUevent(msg);
+    }
+}
+
+}  // namespace samsung
+}  // namespace V2_0
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019-2022 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_0 {
+namespace samsung {
+
+/*
+ * In-memory view of the panel sysfs nodes shared by every LiveDisplay
+ * feature. Nodes are opened once; reads are served from the cache until a
+ * display uevent invalidates it, and writes of the value already in the
+ * node are dropped.
+ */
+class DisplayState {
+  public:
+    struct Write {
+        const char* path;
+        std::string value;
+    };
+
+    static DisplayState& getInstance();
+
+    // Trimmed contents of the node, false if it can't be read.
+    bool read(const char* path, std::string* out);
+    bool readInt(const char* path, int32_t* out);
+
+    bool write(const char* path, const std::string& value);
+    // Applies the writes in order under one lock. When a node appears more
+    // than once only its last value is written. Returns false if any write
+    // failed; the remaining writes are still attempted.
+    bool apply(const std::vector<Write>& writes);
+
+    // Forgets every cached value; the next read goes to the node again.
+    void invalidate();
+    // Invalidates if the uevent message comes from a display device.
+    void onUevent(const char* msg);
+
+  private:
+    struct Node {
+        android::base::unique_fd fd;
+        std::string value;
+        bool valid = false;
+    };
+
+    DisplayState();
+
+    Node* openLocked(const char* path);
+    bool writeLocked(const char* path, const std::string& value);
+    void ueventLoop();
+
+    std::mutex mLock;
+    std::unordered_map<std::string, Node> mNodes;
+};
+
+}  // namespace samsung
+}  // namespace V2_0
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
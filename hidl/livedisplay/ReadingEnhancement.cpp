@@ -14,17 +14,11 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
-
 #include <fstream>
 
+#include "DisplayState.h"
 #include "ReadingEnhancement.h"
 
-using android::base::ReadFileToString;
-using android::base::Trim;
-using android::base::WriteStringToFile;
-
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -43,15 +37,13 @@ bool ReadingEnhancement::isSupported() {
 Return<bool> ReadingEnhancement::isEnabled() {
     std::string contents;
 
-    if (ReadFileToString(kREPath, &contents)) {
-        contents = Trim(contents);
-    }
+    DisplayState::getInstance().read(kREPath, &contents);
 
     return !contents.compare("Current accessibility : DSI0 : GRAYSCALE") || !contents.compare("4");
 }
 
 Return<bool> ReadingEnhancement::setEnabled(bool enabled) {
-    return WriteStringToFile(enabled ? "4" : "0", kREPath, true);
+    return DisplayState::getInstance().write(kREPath, enabled ? "4" : "0");
 }
 
 // Methods from ::android::hidl::base::V1_0::IBase follow.
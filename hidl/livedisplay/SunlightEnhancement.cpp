@@ -14,17 +14,11 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
-
 #include <fstream>
 
+#include "DisplayState.h"
 #include "SunlightEnhancement.h"
 
-using android::base::ReadFileToString;
-using android::base::Trim;
-using android::base::WriteStringToFile;
-
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -48,26 +42,28 @@ bool SunlightEnhancement::isSupported() {
 
 // Methods from ::vendor::lineage::livedisplay::V2_0::IAdaptiveBacklight follow.
 Return<bool> SunlightEnhancement::isEnabled() {
-    std::string tmp;
+    DisplayState& state = DisplayState::getInstance();
     int32_t statusSRE = 0;
     int32_t statusHBM = 0;
-    if (ReadFileToString(kSREPath, &tmp)) {
-        statusSRE = std::stoi(Trim(tmp));
-    }
 
-    if (mHasHBM && ReadFileToString(kHBMPath, &tmp)) {
-        statusHBM = std::stoi(Trim(tmp));
+    state.readInt(kSREPath, &statusSRE);
+
+    if (mHasHBM) {
+        state.readInt(kHBMPath, &statusHBM);
     }
 
     return ((statusSRE == 1 && statusHBM == 6) || statusSRE == 1);
 }
 
 Return<bool> SunlightEnhancement::setEnabled(bool enabled) {
+    std::vector<DisplayState::Write> writes;
+
     if (mHasHBM) {
-        WriteStringToFile(enabled ? "6" : "0", kHBMPath, true);
+        writes.push_back({kHBMPath, enabled ? "6" : "0"});
     }
+    writes.push_back({kSREPath, enabled ? "1" : "0"});
 
-    return WriteStringToFile(enabled ? "1" : "0", kSREPath, true);
+    return DisplayState::getInstance().apply(writes);
 }
 
 }  // namespace samsung
@@ -14,17 +14,11 @@
  * limitations under the License.
  */
 
-#include <android-base/file.h>
-#include <android-base/strings.h>
-
 #include <fstream>
 
+#include "DisplayState.h"
 #include "SunlightEnhancementExynos.h"
 
-using android::base::ReadFileToString;
-using android::base::Trim;
-using android::base::WriteStringToFile;
-
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -41,19 +35,16 @@ bool SunlightEnhancementExynos::isSupported() {
 
 // Methods from ::vendor::lineage::livedisplay::V2_0::IAdaptiveBacklight follow.
 Return<bool> SunlightEnhancementExynos::isEnabled() {
-    std::string tmp;
     int32_t contents = 0;
 
-    if (ReadFileToString(kLUXPath, &tmp)) {
-        contents = std::stoi(Trim(tmp));
-    }
+    DisplayState::getInstance().readInt(kLUXPath, &contents);
 
     return contents > 0;
 }
 
 Return<bool> SunlightEnhancementExynos::setEnabled(bool enabled) {
     /* see drivers/video/fbdev/exynos/decon_7880/panels/mdnie_lite_table*, get_hbm_index */
-    return WriteStringToFile(enabled ? "40000" : "0", kLUXPath, true);
+    return DisplayState::getInstance().write(kLUXPath, enabled ? "40000" : "0");
 }
 
 }  // namespace samsung
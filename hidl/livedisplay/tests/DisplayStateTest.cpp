@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DisplayState.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using ::android::base::ReadFileToString;
+using ::android::base::WriteStringToFile;
+using ::vendor::lineage::livedisplay::V2_0::samsung::DisplayState;
+
+namespace {
+
+// Each test gets its own node directory, so the shared instance starts
+// with nothing cached for the nodes it touches.
+class DisplayStateTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mA = std::string(mDir.path) + "/a";
+        mB = std::string(mDir.path) + "/b";
+        ASSERT_TRUE(WriteStringToFile("0\n", mA));
+        ASSERT_TRUE(WriteStringToFile("0\n", mB));
+    }
+
+    // Changes the node behind the cache's back, like the kernel would
+    static void clobber(const std::string& path, const std::string& value) {
+        ASSERT_TRUE(WriteStringToFile(value, path));
+    }
+
+    // pwrite() does not truncate a plain file, so only the first line is current
+    static std::string node(const std::string& path) {
+        std::string value;
+        EXPECT_TRUE(ReadFileToString(path, &value));
+        return value.substr(0, value.find('\n'));
+    }
+
+    std::string cached(const std::string& path) {
+        std::string value;
+        EXPECT_TRUE(mState.read(path.c_str(), &value));
+        return value;
+    }
+
+    TemporaryDir mDir;
+    std::string mA;
+    std::string mB;
+    DisplayState& mState = DisplayState::getInstance();
+};
+
+TEST_F(DisplayStateTest, ReadsAreCachedUntilInvalidated) {
+    int32_t value = -1;
+
+    ASSERT_TRUE(mState.readInt(mA.c_str(), &value));
+    EXPECT_EQ(0, value);
+
+    clobber(mA, "5\n");
+    EXPECT_EQ("0", cached(mA));
+
+    mState.invalidate();
+    EXPECT_EQ("5", cached(mA));
+}
+
+TEST_F(DisplayStateTest, WriteOfCurrentValueIsDropped) {
+    EXPECT_EQ("0", cached(mA));
+
+    clobber(mA, "7");
+    ASSERT_TRUE(mState.write(mA.c_str(), "0"));
+    EXPECT_EQ("7", node(mA));
+
+    ASSERT_TRUE(mState.write(mA.c_str(), "1"));
+    EXPECT_EQ("1", node(mA));
+}
+
+TEST_F(DisplayStateTest, WriteUpdatesCache) {
+    ASSERT_TRUE(mState.write(mA.c_str(), "3"));
+
+    clobber(mA, "4");
+    EXPECT_EQ("3", cached(mA));
+}
+
+TEST_F(DisplayStateTest, ApplyWritesOnlyLastValuePerNode) {
+    EXPECT_EQ("0", cached(mB));
+    clobber(mB, "9");
+
+    // b=6 is superseded and b=0 is already cached, so b is never written
+    ASSERT_TRUE(mState.apply({{mB.c_str(), "6"}, {mA.c_str(), "1"}, {mB.c_str(), "0"}}));
+    EXPECT_EQ("9", node(mB));
+    EXPECT_EQ("1", node(mA));
+    EXPECT_EQ("0", cached(mB));
+}
+
+TEST_F(DisplayStateTest, ApplyContinuesPastFailure) {
+    std::string missing = std::string(mDir.path) + "/missing";
+
+    EXPECT_FALSE(mState.apply({{missing.c_str(), "1"}, {mA.c_str(), "2"}}));
+    EXPECT_EQ("2", node(mA));
+}
+
+TEST_F(DisplayStateTest, DisplayUeventsInvalidate) {
+    EXPECT_EQ("0", cached(mA));
+    clobber(mA, "5\n");
+
+    mState.onUevent("change@/devices/platform/usb/usb1");
+    EXPECT_EQ("0", cached(mA));
+
+    mState.onUevent("change@/devices/virtual/mdnie/mdnie");
+    EXPECT_EQ("5", cached(mA));
+
+    clobber(mA, "6\n");
+    mState.onUevent("change@/devices/virtual/lcd/panel");
+    EXPECT_EQ("6", cached(mA));
+}
+
+TEST_F(DisplayStateTest, MissingOrBadNode) {
+    std::string missing = std::string(mDir.path) + "/missing";
+    std::string value;
+    int32_t number;
+
+    EXPECT_FALSE(mState.read(missing.c_str(), &value));
+    EXPECT_FALSE(mState.write(missing.c_str(), "1"));
+
+    clobber(mA, "on\n");
+    mState.invalidate();
+    EXPECT_FALSE(mState.readInt(mA.c_str(), &number));
+}
+
+}  // namespace
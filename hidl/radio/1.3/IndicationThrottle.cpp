@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2019, The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.1
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IndicationThrottle.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace vendor {
+namespace samsung {
+namespace hardware {
+namespace radio {
+namespace V1_2 {
+namespace implementation {
+
+using ::android::hardware::radio::V1_2::AccessNetwork;
+using ::android::hardware::radio::V1_2::IndicationFilter;
+
+namespace {
+
+constexpr int32_t kInvalidDbm = std::numeric_limits<int32_t>::max();
+
+// Filter bits that follow the screen alone. LINK_CAPACITY_ESTIMATE and
+// PHYSICAL_CHANNEL_CONFIG also depend on charging and tethering, so they can
+// be off with the screen on.
+constexpr uint32_t kScreenOnFilter =
+    static_cast<uint32_t>(IndicationFilter::SIGNAL_STRENGTH) |
+    static_cast<uint32_t>(IndicationFilter::FULL_NETWORK_STATE);
+
+const char* const kTypeNames[IndicationThrottle::TYPE_COUNT] = {
+    "signalStrength",
+    "cellInfoList",
+    "physicalChannelConfigs",
+    "linkCapacityEstimate",
+};
+
+int32_t asuToDbm(int64_t asu) {
+    if (asu < 0 || asu > 31) return kInvalidDbm;
+    return -113 + 2 * static_cast<int32_t>(asu);
+}
+
+// The measurement the reporting criteria of each access network apply to
+int32_t measureDbm(const ::android::hardware::radio::V1_2::SignalStrength& ss, AccessNetwork an) {
+    switch (an) {
+        case AccessNetwork::GERAN:
+            return asuToDbm(static_cast<int64_t>(ss.gsm.signalStrength));
+        case AccessNetwork::UTRAN:
+            return asuToDbm(static_cast<int64_t>(ss.wcdma.base.signalStrength));
+        case AccessNetwork::EUTRAN:
+            if (ss.lte.rsrp < 44 || ss.lte.rsrp > 140) return kInvalidDbm;
+            return -static_cast<int32_t>(ss.lte.rsrp);
+        case AccessNetwork::CDMA2000:
+            if (ss.cdma.dbm == 0 || ss.cdma.dbm > 120) return kInvalidDbm;
+            return -static_cast<int32_t>(ss.cdma.dbm);
+        default:
+            return kInvalidDbm;
+    }
+}
+
+bool crossesThreshold(int32_t from, int32_t to, const std::vector<int32_t>& thresholds) {
+    for (int32_t threshold : thresholds) {
+        if ((from < threshold) != (to < threshold)) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+void IndicationThrottle::setIndicationFilter(
+    hidl_bitfield<::android::hardware::radio::V1_2::IndicationFilter> indicationFilter) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mFilter = static_cast<uint32_t>(indicationFilter);
+}
+
+void IndicationThrottle::setSignalStrengthReportingCriteria(
+    int32_t hysteresisMs, int32_t hysteresisDb, const hidl_vec<int32_t>& thresholdsDbm,
+    AccessNetwork accessNetwork) {
+    auto an = static_cast<size_t>(accessNetwork);
+    if (an >= sizeof(mCriteria) / sizeof(mCriteria[0])) return;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    Criteria& criteria = mCriteria[an];
+    criteria.set = true;
+    criteria.hysteresis = std::chrono::milliseconds(std::max(hysteresisMs, 0));
+    criteria.hysteresisDb = std::max(hysteresisDb, 0);
+    criteria.thresholdsDbm.assign(thresholdsDbm.begin(), thresholdsDbm.end());
+}
+
+void IndicationThrottle::setSignalStrengthCallback(SignalStrengthCallback callback) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mSignalCallback = std::move(callback);
+}
+
+IndicationThrottle::~IndicationThrottle() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+    }
+    mHeldSignalCond.notify_one();
+    if (mHeldSignalThread.joinable()) mHeldSignalThread.join();
+}
+
+bool IndicationThrottle::screenOffLocked() const {
+    return (mFilter & kScreenOnFilter) != kScreenOnFilter;
+}
+
+bool IndicationThrottle::filteredLocked(Type type) const {
+    IndicationFilter bit;
+
+    switch (type) {
+        case SIGNAL_STRENGTH:
+            bit = IndicationFilter::SIGNAL_STRENGTH;
+            break;
+        case PHYSICAL_CHANNEL_CONFIG:
+            bit = IndicationFilter::PHYSICAL_CHANNEL_CONFIG;
+            break;
+        case LINK_CAPACITY_ESTIMATE:
+            bit = IndicationFilter::LINK_CAPACITY_ESTIMATE;
+            break;
+        default:
+            // Governed by setCellInfoListRate(), not the indication filter
+            return false;
+    }
+    return (mFilter & static_cast<uint32_t>(bit)) == 0;
+}
+
+bool IndicationThrottle::countLocked(Type type, bool forward) {
+    if (forward) {
+        mForwarded[type]++;
+    } else {
+        mSuppressed[type]++;
+    }
+    return forward;
+}
+
+// When next may be forwarded, or time_point::max() if it is not significant
+std::chrono::steady_clock::time_point IndicationThrottle::signalDueLocked(
+    const ::android::hardware::radio::V1_2::SignalStrength& next) const {
+    bool significant = false;
+    auto interval = std::chrono::milliseconds::max();
+
+    for (auto an : {AccessNetwork::GERAN, AccessNetwork::UTRAN, AccessNetwork::EUTRAN,
+                    AccessNetwork::CDMA2000}) {
+        int32_t from = measureDbm(mSignal, an);
+        int32_t to = measureDbm(next, an);
+        if (from == to) continue;
+
+        const Criteria& criteria = mCriteria[static_cast<size_t>(an)];
+        if (from != kInvalidDbm && to != kInvalidDbm && criteria.set) {
+            if (abs(to - from) < criteria.hysteresisDb) continue;
+            if (!criteria.thresholdsDbm.empty() &&
+                !crossesThreshold(from, to, criteria.thresholdsDbm))
+                continue;
+        }
+
+        // Gaining or losing a measurement always counts
+        significant = true;
+        interval = std::min(interval, criteria.hysteresis);
+    }
+
+    if (!significant) return std::chrono::steady_clock::time_point::max();
+    return mSignalTime + interval;
+}
+
+void IndicationThrottle::holdSignalLocked(
+    const ::android::hardware::radio::V1_2::SignalStrength& signalStrength,
+    std::chrono::steady_clock::time_point due) {
+    mHeldSignal = signalStrength;
+    mHeldSignalDue = due;
+    mHaveHeldSignal = true;
+    if (!mHeldSignalThread.joinable()) {
+        mHeldSignalThread = std::thread(&IndicationThrottle::deliverHeldSignals, this);
+    }
+    mHeldSignalCond.notify_one();
+}
+
+void IndicationThrottle::deliverHeldSignals() {
+    std::unique_lock<std::mutex> lock(mLock);
+
+    while (!mStopping) {
+        if (!mHaveHeldSignal) {
+            mHeldSignalCond.wait(lock);
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now < mHeldSignalDue) {
+            mHeldSignalCond.wait_until(lock, mHeldSignalDue);
+            continue;
+        }
+
+        // Delivered with the lock held so a later report cannot overtake it
+        mHaveHeldSignal = false;
+        if (filteredLocked(SIGNAL_STRENGTH) || !mSignalCallback) continue;
+        mSignal = mHeldSignal;
+        mSignalTime = now;
+        mDelayedSignals++;
+        mSignalCallback(mSignal);
+    }
+}
+
+bool IndicationThrottle::shouldForward(
+    const ::android::hardware::radio::V1_0::SignalStrength& signalStrength) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool forward = !screenOffLocked() ||
+                   (!filteredLocked(SIGNAL_STRENGTH) &&
+                    (!mHaveSignal_1_0 || !(signalStrength == mSignal_1_0)));
+    if (forward) {
+        mSignal_1_0 = signalStrength;
+        mHaveSignal_1_0 = true;
+    }
+    return countLocked(SIGNAL_STRENGTH, forward);
+}
+
+bool IndicationThrottle::shouldForward(
+    const ::android::hardware::radio::V1_2::SignalStrength& signalStrength) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto now = std::chrono::steady_clock::now();
+    bool forward;
+
+    if (!screenOffLocked()) {
+        forward = true;
+    } else if (filteredLocked(SIGNAL_STRENGTH)) {
+        forward = false;
+    } else if (!mHaveSignal) {
+        forward = true;
+    } else {
+        auto due = signalDueLocked(signalStrength);
+        forward = now >= due;
+        if (due == std::chrono::steady_clock::time_point::max()) {
+            // Back where the framework last saw it, so nothing is owed
+            mHaveHeldSignal = false;
+        } else if (!forward) {
+            holdSignalLocked(signalStrength, due);
+        }
+    }
+
+    if (forward) {
+        mSignal = signalStrength;
+        mSignalTime = now;
+        mHaveSignal = true;
+        mHaveHeldSignal = false;
+    }
+    return countLocked(SIGNAL_STRENGTH, forward);
+}
+
+bool IndicationThrottle::shouldForward(
+    const hidl_vec<::android::hardware::radio::V1_2::CellInfo>& records) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool forward = !screenOffLocked() || !mHaveCellInfo || !(records == mCellInfo);
+    if (forward) {
+        mCellInfo = records;
+        mHaveCellInfo = true;
+    }
+    return countLocked(CELL_INFO, forward);
+}
+
+bool IndicationThrottle::shouldForward(
+    const hidl_vec<::android::hardware::radio::V1_2::PhysicalChannelConfig>& configs) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool forward = !screenOffLocked() ||
+                   (!filteredLocked(PHYSICAL_CHANNEL_CONFIG) &&
+                    (!mHavePhysicalChannelConfigs || !(configs == mPhysicalChannelConfigs)));
+    if (forward) {
+        mPhysicalChannelConfigs = configs;
+        mHavePhysicalChannelConfigs = true;
+    }
+    return countLocked(PHYSICAL_CHANNEL_CONFIG, forward);
+}
+
+bool IndicationThrottle::shouldForward(
+    const ::android::hardware::radio::V1_2::LinkCapacityEstimate& lce) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool forward = !screenOffLocked() ||
+                   (!filteredLocked(LINK_CAPACITY_ESTIMATE) &&
+                    (!mHaveLinkCapacityEstimate || !(lce == mLinkCapacityEstimate)));
+    if (forward) {
+        mLinkCapacityEstimate = lce;
+        mHaveLinkCapacityEstimate = true;
+    }
+    return countLocked(LINK_CAPACITY_ESTIMATE, forward);
+}
+
+void IndicationThrottle::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    dprintf(fd, "Indication filter: 0x%x (screen %s)\n", mFilter,
+            screenOffLocked() ? "off" : "on");
+    for (size_t an = 0; an < sizeof(mCriteria) / sizeof(mCriteria[0]); an++) {
+        const Criteria& criteria = mCriteria[an];
+        if (!criteria.set) continue;
+        dprintf(fd, "Signal criteria (access network %zu): %lldms %ddB, %zu thresholds\n", an,
+                static_cast<long long>(criteria.hysteresis.count()), criteria.hysteresisDb,
+                criteria.thresholdsDbm.size());
+    }
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        dprintf(fd, "%-24s forwarded %" PRIu64 " suppressed %" PRIu64 "\n", kTypeNames[type],
+                mForwarded[type], mSuppressed[type]);
+    }
+    dprintf(fd, "%-24s delivered after hysteresis %" PRIu64 "%s\n", kTypeNames[SIGNAL_STRENGTH],
+            mDelayedSignals, mHaveHeldSignal ? ", one held" : "");
+}
+
+}  // namespace implementation
+}  // namespace V1_2
+}  // namespace radio
+}  // namespace hardware
+}  // namespace samsung
+}  // namespace vendor
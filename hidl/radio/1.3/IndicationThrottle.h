@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019, The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.1
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/hardware/radio/1.2/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vendor {
+namespace samsung {
+namespace hardware {
+namespace radio {
+namespace V1_2 {
+namespace implementation {
+
+using ::android::hardware::hidl_bitfield;
+using ::android::hardware::hidl_vec;
+
+// Applies the indication filter and signal strength reporting criteria the
+// framework asked for, since the vendor RIL takes them but does not honour
+// them. While the screen is off (the framework cleared SIGNAL_STRENGTH or
+// FULL_NETWORK_STATE from the indication filter), filtered out indications
+// are dropped, signal strength reports within the recorded hysteresis are
+// dropped, and other reports identical to the last one forwarded are dropped.
+// A signal strength report held back only by the hysteresis interval is kept,
+// replaced by any later one, and delivered through the signal strength
+// callback once the interval expires. With the screen on everything passes.
+class IndicationThrottle {
+  public:
+    using SignalStrengthCallback =
+        std::function<void(const ::android::hardware::radio::V1_2::SignalStrength&)>;
+
+    enum Type {
+        SIGNAL_STRENGTH,
+        CELL_INFO,
+        PHYSICAL_CHANNEL_CONFIG,
+        LINK_CAPACITY_ESTIMATE,
+        TYPE_COUNT,
+    };
+
+    void setIndicationFilter(
+        hidl_bitfield<::android::hardware::radio::V1_2::IndicationFilter> indicationFilter);
+    void setSignalStrengthReportingCriteria(
+        int32_t hysteresisMs, int32_t hysteresisDb, const hidl_vec<int32_t>& thresholdsDbm,
+        ::android::hardware::radio::V1_2::AccessNetwork accessNetwork);
+    // Called with the lock held, so it must not call back into the throttle
+    void setSignalStrengthCallback(SignalStrengthCallback callback);
+
+    ~IndicationThrottle();
+
+    // Each returns whether the indication should reach the framework, and
+    // counts it as forwarded or suppressed.
+    bool shouldForward(const ::android::hardware::radio::V1_0::SignalStrength& signalStrength);
+    bool shouldForward(const ::android::hardware::radio::V1_2::SignalStrength& signalStrength);
+    bool shouldForward(const hidl_vec<::android::hardware::radio::V1_2::CellInfo>& records);
+    bool shouldForward(
+        const hidl_vec<::android::hardware::radio::V1_2::PhysicalChannelConfig>& configs);
+    bool shouldForward(const ::android::hardware::radio::V1_2::LinkCapacityEstimate& lce);
+
+    void dump(int fd);
+
+  private:
+    struct Criteria {
+        bool set = false;
+        std::chrono::milliseconds hysteresis{0};
+        int32_t hysteresisDb = 0;
+        std::vector<int32_t> thresholdsDbm;
+    };
+
+    bool screenOffLocked() const;
+    bool filteredLocked(Type type) const;
+    bool countLocked(Type type, bool forward);
+    std::chrono::steady_clock::time_point signalDueLocked(
+        const ::android::hardware::radio::V1_2::SignalStrength& next) const;
+    void holdSignalLocked(const ::android::hardware::radio::V1_2::SignalStrength& signalStrength,
+                          std::chrono::steady_clock::time_point due);
+    void deliverHeldSignals();
+
+    std::mutex mLock;
+    std::condition_variable mHeldSignalCond;
+    uint32_t mFilter = ~0u;
+    // Indexed by AccessNetwork, GERAN (1) through IWLAN (5)
+    Criteria mCriteria[6];
+
+    // Last report of each kind that reached the framework
+    bool mHaveSignal = false;
+    bool mHaveSignal_1_0 = false;
+    bool mHaveCellInfo = false;
+    bool mHavePhysicalChannelConfigs = false;
+    bool mHaveLinkCapacityEstimate = false;
+    ::android::hardware::radio::V1_2::SignalStrength mSignal;
+    std::chrono::steady_clock::time_point mSignalTime;
+    ::android::hardware::radio::V1_0::SignalStrength mSignal_1_0;
+    hidl_vec<::android::hardware::radio::V1_2::CellInfo> mCellInfo;
+    hidl_vec<::android::hardware::radio::V1_2::PhysicalChannelConfig> mPhysicalChannelConfigs;
+    ::android::hardware::radio::V1_2::LinkCapacityEstimate mLinkCapacityEstimate;
+
+    // Latest report held back by the hysteresis interval, and when it is due
+    bool mHaveHeldSignal = false;
+    ::android::hardware::radio::V1_2::SignalStrength mHeldSignal;
+    std::chrono::steady_clock::time_point mHeldSignalDue;
+    SignalStrengthCallback mSignalCallback;
+    std::thread mHeldSignalThread;
+    bool mStopping = false;
+
+    uint64_t mForwarded[TYPE_COUNT] = {};
+    uint64_t mSuppressed[TYPE_COUNT] = {};
+    uint64_t mDelayedSignals = 0;
+};
+
+}  // namespace implementation
+}  // namespace V1_2
+}  // namespace radio
+}  // namespace hardware
+}  // namespace samsung
+}  // namespace vendor
@@ -22,7 +22,8 @@ namespace radio {
 namespace V1_3 {
 namespace implementation {
 
-Radio::Radio(const std::string& interfaceName) : interfaceName(interfaceName) {}
+Radio::Radio(const std::string& interfaceName)
+    : interfaceName(interfaceName), indicationThrottle(std::make_shared<IndicationThrottle>()) {}
 
 sp<::vendor::samsung::hardware::radio::V1_2::IRadio> Radio::getSecIRadio() {
     std::lock_guard<std::mutex> lock(secIRadioMutex);
@@ -44,7 +45,8 @@ Return<void> Radio::setResponseFunctions(
     sp<::vendor::samsung::hardware::radio::V1_2::IRadioIndication> secRadioIndication =
         new SecRadioIndication(
             ::android::hardware::radio::V1_2::IRadioIndication::castFrom(radioIndication)
-                .withDefault(nullptr));
+                .withDefault(nullptr),
+            indicationThrottle);
     getSecIRadio()->setResponseFunctions(secRadioResponse, secRadioIndication);
     return Void();
 }
@@ -735,6 +737,7 @@ Return<void> Radio::sendDeviceState(
 Return<void> Radio::setIndicationFilter(
     int32_t serial,
     hidl_bitfield<::android::hardware::radio::V1_2::IndicationFilter> indicationFilter) {
+    indicationThrottle->setIndicationFilter(indicationFilter);
     getSecIRadio()->setIndicationFilter(serial, indicationFilter);
     return Void();
 }
@@ -794,6 +797,7 @@ Return<void> Radio::startNetworkScan_1_2(
 Return<void> Radio::setIndicationFilter_1_2(
     int32_t serial,
     hidl_bitfield<::android::hardware::radio::V1_2::IndicationFilter> indicationFilter) {
+    indicationThrottle->setIndicationFilter(indicationFilter);
     getSecIRadio()->setIndicationFilter_1_2(serial, indicationFilter);
     return Void();
 }
@@ -802,6 +806,8 @@ Return<void> Radio::setSignalStrengthReportingCriteria(
     int32_t serial, int32_t hysteresisMs, int32_t hysteresisDb,
     const hidl_vec<int32_t>& thresholdsDbm,
     ::android::hardware::radio::V1_2::AccessNetwork accessNetwork) {
+    indicationThrottle->setSignalStrengthReportingCriteria(hysteresisMs, hysteresisDb,
+                                                           thresholdsDbm, accessNetwork);
     getSecIRadio()->setSignalStrengthReportingCriteria(serial, hysteresisMs, hysteresisDb,
                                                        thresholdsDbm, accessNetwork);
     return Void();
@@ -847,6 +853,14 @@ Return<void> Radio::getModemStackStatus(int32_t) {
     return Void();
 }
 
+// Methods from ::android::hidl::base::V1_0::IBase follow.
+Return<void> Radio::debug(const hidl_handle& fd, const hidl_vec<hidl_string>&) {
+    if (fd.getNativeHandle() != nullptr && fd->numFds > 0) {
+        indicationThrottle->dump(fd->data[0]);
+    }
+    return Void();
+}
+
 }  // namespace implementation
 }  // namespace V1_3
 }  // namespace radio
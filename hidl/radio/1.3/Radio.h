@@ -21,6 +21,9 @@
 #include <hidl/Status.h>
 #include <vendor/samsung/hardware/radio/1.2/IRadio.h>
 
+#include <memory>
+
+#include "IndicationThrottle.h"
 #include "SecRadioIndication.h"
 #include "SecRadioResponse.h"
 
@@ -35,11 +38,13 @@ namespace implementation {
 
 using ::android::sp;
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
 using ::android::hardware::Return;
 using ::android::hardware::Void;
+using ::vendor::samsung::hardware::radio::V1_2::implementation::IndicationThrottle;
 using ::vendor::samsung::hardware::radio::V1_2::implementation::SecRadioIndication;
 using ::vendor::samsung::hardware::radio::V1_2::implementation::SecRadioResponse;
 
@@ -47,6 +52,8 @@ struct Radio : public IRadio {
     std::string interfaceName;
     std::mutex secIRadioMutex;
     sp<::vendor::samsung::hardware::radio::V1_2::IRadio> secIRadio;
+    // Outlives the indication objects so filters and criteria persist
+    std::shared_ptr<IndicationThrottle> indicationThrottle;
 
     Radio(const std::string& interfaceName);
 
@@ -294,6 +301,9 @@ struct Radio : public IRadio {
         const hidl_vec<::android::hardware::radio::V1_1::RadioAccessSpecifier>& specifiers) override;
     Return<void> enableModem(int32_t serial, bool on) override;
     Return<void> getModemStackStatus(int32_t serial) override;
+
+    // Methods from ::android::hidl::base::V1_0::IBase follow.
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) override;
 };
 
 }  // namespace implementation
@@ -24,8 +24,22 @@ namespace V1_2 {
 namespace implementation {
 
 SecRadioIndication::SecRadioIndication(
-    const sp<::android::hardware::radio::V1_2::IRadioIndication>& radioIndication)
-    : radioIndication(radioIndication) {}
+    const sp<::android::hardware::radio::V1_2::IRadioIndication>& radioIndication,
+    const std::shared_ptr<IndicationThrottle>& throttle)
+    : radioIndication(radioIndication), throttle(throttle) {
+    if (radioIndication == nullptr) {
+        throttle->setSignalStrengthCallback(nullptr);
+        return;
+    }
+    // Reports the throttle held back reach the framework without a vendor
+    // RIL behind them, so they are sent without asking for an ack.
+    throttle->setSignalStrengthCallback(
+        [radioIndication](const ::android::hardware::radio::V1_2::SignalStrength& signalStrength) {
+            radioIndication->currentSignalStrength_1_2(
+                ::android::hardware::radio::V1_0::RadioIndicationType::UNSOLICITED,
+                signalStrength);
+        });
+}
 
 // Methods from ::android::hardware::radio::V1_0::IRadioIndication follow.
 Return<void> SecRadioIndication::radioStateChanged(
@@ -82,7 +96,9 @@ Return<void> SecRadioIndication::nitzTimeReceived(
 Return<void> SecRadioIndication::currentSignalStrength(
     ::android::hardware::radio::V1_0::RadioIndicationType type,
     const ::android::hardware::radio::V1_0::SignalStrength& signalStrength) {
-    radioIndication->currentSignalStrength(type, signalStrength);
+    if (throttle->shouldForward(signalStrength)) {
+        radioIndication->currentSignalStrength(type, signalStrength);
+    }
     return Void();
 }
 
@@ -350,28 +366,36 @@ Return<void> SecRadioIndication::networkScanResult_1_2(
 Return<void> SecRadioIndication::cellInfoList_1_2(
     ::android::hardware::radio::V1_0::RadioIndicationType type,
     const hidl_vec<::android::hardware::radio::V1_2::CellInfo>& records) {
-    radioIndication->cellInfoList_1_2(type, records);
+    if (throttle->shouldForward(records)) {
+        radioIndication->cellInfoList_1_2(type, records);
+    }
     return Void();
 }
 
 Return<void> SecRadioIndication::currentLinkCapacityEstimate(
     ::android::hardware::radio::V1_0::RadioIndicationType type,
     const ::android::hardware::radio::V1_2::LinkCapacityEstimate& lce) {
-    radioIndication->currentLinkCapacityEstimate(type, lce);
+    if (throttle->shouldForward(lce)) {
+        radioIndication->currentLinkCapacityEstimate(type, lce);
+    }
     return Void();
 }
 
 Return<void> SecRadioIndication::currentPhysicalChannelConfigs(
     ::android::hardware::radio::V1_0::RadioIndicationType type,
     const hidl_vec<::android::hardware::radio::V1_2::PhysicalChannelConfig>& configs) {
-    radioIndication->currentPhysicalChannelConfigs(type, configs);
+    if (throttle->shouldForward(configs)) {
+        radioIndication->currentPhysicalChannelConfigs(type, configs);
+    }
     return Void();
 }
 
 Return<void> SecRadioIndication::currentSignalStrength_1_2(
     ::android::hardware::radio::V1_0::RadioIndicationType type,
     const ::android::hardware::radio::V1_2::SignalStrength& signalStrength) {
-    radioIndication->currentSignalStrength_1_2(type, signalStrength);
+    if (throttle->shouldForward(signalStrength)) {
+        radioIndication->currentSignalStrength_1_2(type, signalStrength);
+    }
     return Void();
 }
 
@@ -384,7 +408,9 @@ Return<void> SecRadioIndication::secCurrentSignalStrength(
         // Set lte signal to invalid
         newSignalStrength.lte.timingAdvance = std::numeric_limits<int>::max();
     }
-    radioIndication->currentSignalStrength_1_2(type, newSignalStrength);
+    if (throttle->shouldForward(newSignalStrength)) {
+        radioIndication->currentSignalStrength_1_2(type, newSignalStrength);
+    }
     return Void();
 }
 
@@ -20,6 +20,10 @@
 #include <hidl/Status.h>
 #include <vendor/samsung/hardware/radio/1.2/IRadioIndication.h>
 
+#include <memory>
+
+#include "IndicationThrottle.h"
+
 namespace vendor {
 namespace samsung {
 namespace hardware {
@@ -37,8 +41,10 @@ using ::android::hardware::Void;
 
 struct SecRadioIndication : public IRadioIndication {
     sp<::android::hardware::radio::V1_2::IRadioIndication> radioIndication;
+    std::shared_ptr<IndicationThrottle> throttle;
 
-    SecRadioIndication(const sp<::android::hardware::radio::V1_2::IRadioIndication>& radioIndication);
+    SecRadioIndication(const sp<::android::hardware::radio::V1_2::IRadioIndication>& radioIndication,
+                       const std::shared_ptr<IndicationThrottle>& throttle);
 
     // Methods from ::android::hardware::radio::V1_0::IRadioIndication follow.
     Return<void> radioStateChanged(::android::hardware::radio::V1_0::RadioIndicationType type,
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2019, The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.1
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android/hardware/radio/1.2/IRadioIndication.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using ::android::hardware::hidl_string;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::Return;
+using ::android::hardware::Void;
+
+// Stands in for the framework: records what SecRadioIndication forwards to it
+struct FakeRadioIndication : public ::android::hardware::radio::V1_2::IRadioIndication {
+    struct SignalReport {
+        ::android::hardware::radio::V1_0::RadioIndicationType type;
+        ::android::hardware::radio::V1_2::SignalStrength signalStrength;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    std::vector<SignalReport> signalStrengths() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mSignalStrengths;
+    }
+
+    // Waits until count signal strength reports arrived, or timeout passed
+    bool waitForSignalStrengths(size_t count, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCond.wait_for(lock, timeout, [&] { return mSignalStrengths.size() >= count; });
+    }
+
+    int cellInfoLists() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mCellInfoLists;
+    }
+
+    int linkCapacityEstimates() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mLinkCapacityEstimates;
+    }
+
+    int physicalChannelConfigs() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mPhysicalChannelConfigs;
+    }
+
+    int signalStrengths_1_0() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mSignalStrengths_1_0;
+    }
+
+    // Methods from ::android::hardware::radio::V1_0::IRadioIndication follow.
+    Return<void> radioStateChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        ::android::hardware::radio::V1_0::RadioState radioState) override {
+        return Void();
+    }
+    Return<void> callStateChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> networkStateChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> newSms(::android::hardware::radio::V1_0::RadioIndicationType type,
+                        const hidl_vec<uint8_t>& pdu) override {
+        return Void();
+    }
+    Return<void> newSmsStatusReport(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                    const hidl_vec<uint8_t>& pdu) override {
+        return Void();
+    }
+    Return<void> newSmsOnSim(::android::hardware::radio::V1_0::RadioIndicationType type,
+                             int32_t recordNumber) override {
+        return Void();
+    }
+    Return<void> onUssd(::android::hardware::radio::V1_0::RadioIndicationType type,
+                        ::android::hardware::radio::V1_0::UssdModeType modeType,
+                        const hidl_string& msg) override {
+        return Void();
+    }
+    Return<void> nitzTimeReceived(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                  const hidl_string& nitzTime, uint64_t receivedTime) override {
+        return Void();
+    }
+    Return<void> currentSignalStrength(
+        ::android::hardware::radio::V1_0::RadioIndicationType,
+        const ::android::hardware::radio::V1_0::SignalStrength&) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mSignalStrengths_1_0++;
+        return Void();
+    }
+    Return<void> dataCallListChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const hidl_vec<::android::hardware::radio::V1_0::SetupDataCallResult>& dcList) override {
+        return Void();
+    }
+    Return<void> suppSvcNotify(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::SuppSvcNotification& suppSvc) override {
+        return Void();
+    }
+    Return<void> stkSessionEnd(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> stkProactiveCommand(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                     const hidl_string& cmd) override {
+        return Void();
+    }
+    Return<void> stkEventNotify(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                const hidl_string& cmd) override {
+        return Void();
+    }
+    Return<void> stkCallSetup(::android::hardware::radio::V1_0::RadioIndicationType type,
+                              int64_t timeout) override {
+        return Void();
+    }
+    Return<void> simSmsStorageFull(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> simRefresh(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::SimRefreshResult& refreshResult) override {
+        return Void();
+    }
+    Return<void> callRing(
+        ::android::hardware::radio::V1_0::RadioIndicationType type, bool isGsm,
+        const ::android::hardware::radio::V1_0::CdmaSignalInfoRecord& record) override {
+        return Void();
+    }
+    Return<void> simStatusChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> cdmaNewSms(::android::hardware::radio::V1_0::RadioIndicationType type,
+                            const ::android::hardware::radio::V1_0::CdmaSmsMessage& msg) override {
+        return Void();
+    }
+    Return<void> newBroadcastSms(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                 const hidl_vec<uint8_t>& data) override {
+        return Void();
+    }
+    Return<void> cdmaRuimSmsStorageFull(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> restrictedStateChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        ::android::hardware::radio::V1_0::PhoneRestrictedState state) override {
+        return Void();
+    }
+    Return<void> enterEmergencyCallbackMode(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> cdmaCallWaiting(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::CdmaCallWaiting& callWaitingRecord) override {
+        return Void();
+    }
+    Return<void> cdmaOtaProvisionStatus(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        ::android::hardware::radio::V1_0::CdmaOtaProvisionStatus status) override {
+        return Void();
+    }
+    Return<void> cdmaInfoRec(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::CdmaInformationRecords& records) override {
+        return Void();
+    }
+    Return<void> indicateRingbackTone(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                      bool start) override {
+        return Void();
+    }
+    Return<void> resendIncallMute(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> cdmaSubscriptionSourceChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        ::android::hardware::radio::V1_0::CdmaSubscriptionSource cdmaSource) override {
+        return Void();
+    }
+    Return<void> cdmaPrlChanged(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                int32_t version) override {
+        return Void();
+    }
+    Return<void> exitEmergencyCallbackMode(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> rilConnected(::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> voiceRadioTechChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        ::android::hardware::radio::V1_0::RadioTechnology rat) override {
+        return Void();
+    }
+    Return<void> cellInfoList(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const hidl_vec<::android::hardware::radio::V1_0::CellInfo>& records) override {
+        return Void();
+    }
+    Return<void> imsNetworkStateChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type) override {
+        return Void();
+    }
+    Return<void> subscriptionStatusChanged(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                           bool activate) override {
+        return Void();
+    }
+    Return<void> srvccStateNotify(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                  ::android::hardware::radio::V1_0::SrvccState state) override {
+        return Void();
+    }
+    Return<void> hardwareConfigChanged(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const hidl_vec<::android::hardware::radio::V1_0::HardwareConfig>& configs) override {
+        return Void();
+    }
+    Return<void> radioCapabilityIndication(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::RadioCapability& rc) override {
+        return Void();
+    }
+    Return<void> onSupplementaryServiceIndication(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_0::StkCcUnsolSsResult& ss) override {
+        return Void();
+    }
+    Return<void> stkCallControlAlphaNotify(::android::hardware::radio::V1_0::RadioIndicationType type,
+                                           const hidl_string& alpha) override {
+        return Void();
+    }
+    Return<void> lceData(::android::hardware::radio::V1_0::RadioIndicationType type,
+                         const ::android::hardware::radio::V1_0::LceDataInfo& lce) override {
+        return Void();
+    }
+    Return<void> pcoData(::android::hardware::radio::V1_0::RadioIndicationType type,
+                         const ::android::hardware::radio::V1_0::PcoDataInfo& pco) override {
+        return Void();
+    }
+    Return<void> modemReset(::android::hardware::radio::V1_0::RadioIndicationType type,
+                            const hidl_string& reason) override {
+        return Void();
+    }
+    // Methods from ::android::hardware::radio::V1_1::IRadioIndication follow.
+    Return<void> carrierInfoForImsiEncryption(
+        ::android::hardware::radio::V1_0::RadioIndicationType info) override {
+        return Void();
+    }
+    Return<void> networkScanResult(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_1::NetworkScanResult& result) override {
+        return Void();
+    }
+    Return<void> keepaliveStatus(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_1::KeepaliveStatus& status) override {
+        return Void();
+    }
+    // Methods from ::android::hardware::radio::V1_2::IRadioIndication follow.
+    Return<void> networkScanResult_1_2(
+        ::android::hardware::radio::V1_0::RadioIndicationType type,
+        const ::android::hardware::radio::V1_2::NetworkScanResult& result) override {
+        return Void();
+    }
+    Return<void> cellInfoList_1_2(
+        ::android::hardware::radio::V1_0::RadioIndicationType,
+        const hidl_vec<::android::hardware::radio::V1_2::CellInfo>&) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mCellInfoLists++;
+        return Void();
+    }
+    Return<void> currentLinkCapacityEstimate(
+        ::android::hardware::radio::V1_0::RadioIndicationType,
+        const ::android::hardware::radio::V1_2::LinkCapacityEstimate&) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mLinkCapacityEstimates++;
+        return Void();
+    }
+    Return<void> currentPhysicalChannelConfigs(
+        ::android::hardware::radio::V1_0::RadioIndicationType,
+        const hidl_vec<::android::hardware::radio::V1_2::PhysicalChannelConfig>&) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mPhysicalChannelConfigs++;
+        return Void();
+    }
+    Return<void> currentSignalStrength(
+        ::android::hardware::radio::V1_0::RadioIndicationType,
+        const ::android::hardware::radio::V1_0::SignalStrength&) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mSignalStrengths_1_0++;
+        return Void();
+    }_1_2
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::vector<SignalReport> mSignalStrengths;
+    int mSignalStrengths_1_0 = 0;
+    int mCellInfoLists = 0;
+    int mLinkCapacityEstimates = 0;
+    int mPhysicalChannelConfigs = 0;
+};
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2019, The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.1 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.1
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FakeRadioIndication.h"
+#include "IndicationThrottle.h"
+#include "SecRadioIndication.h"
+
+using ::android::sp;
+using ::android::hardware::radio::V1_0::RadioIndicationType;
+using ::android::hardware::radio::V1_2::AccessNetwork;
+using ::android::hardware::radio::V1_2::IndicationFilter;
+using ::android::hardware::radio::V1_2::LinkCapacityEstimate;
+using ::android::hardware::radio::V1_2::SignalStrength;
+using ::vendor::samsung::hardware::radio::V1_2::implementation::IndicationThrottle;
+using ::vendor::samsung::hardware::radio::V1_2::implementation::SecRadioIndication;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint32_t kScreenOn = static_cast<uint32_t>(IndicationFilter::SIGNAL_STRENGTH) |
+                               static_cast<uint32_t>(IndicationFilter::FULL_NETWORK_STATE);
+// What the framework leaves set with the screen off while it still wants
+// signal strength, e.g. to show it on an always-on display
+constexpr uint32_t kScreenOffWithSignal = static_cast<uint32_t>(IndicationFilter::SIGNAL_STRENGTH);
+
+const hidl_vec<int32_t> kThresholds = {-120, -110, -100, -90, -80};
+
+// An LTE-only report, every other measurement invalid
+SignalStrength lte(int32_t dbm) {
+    SignalStrength ss = {};
+
+    ss.gsm.signalStrength = 99;
+    ss.wcdma.base.signalStrength = 99;
+    ss.lte.signalStrength = 99;
+    ss.lte.rsrp = -dbm;
+    return ss;
+}
+
+int32_t dbm(const SignalStrength& ss) {
+    return -static_cast<int32_t>(ss.lte.rsrp);
+}
+
+// Index of the threshold band dbm falls in
+size_t band(int32_t dbm) {
+    size_t i = 0;
+    while (i < kThresholds.size() && dbm >= kThresholds[i]) i++;
+    return i;
+}
+
+class IndicationReplayTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mThrottle = std::make_shared<IndicationThrottle>();
+        mFake = new FakeRadioIndication();
+        mIndication = new SecRadioIndication(mFake, mThrottle);
+    }
+
+    void criteria(std::chrono::milliseconds hysteresis, int32_t hysteresisDb = 2) {
+        mThrottle->setSignalStrengthReportingCriteria(hysteresis.count(), hysteresisDb,
+                                                      kThresholds, AccessNetwork::EUTRAN);
+    }
+
+    void report(const SignalStrength& ss) {
+        mIndication->currentSignalStrength_1_2(RadioIndicationType::UNSOLICITED_ACK_EXP, ss);
+    }
+
+    std::shared_ptr<IndicationThrottle> mThrottle;
+    sp<FakeRadioIndication> mFake;
+    sp<SecRadioIndication> mIndication;
+};
+
+TEST_F(IndicationReplayTest, ScreenFollowsSignalAndNetworkStateOnly) {
+    LinkCapacityEstimate lce = {};
+
+    // Link capacity and channel config reporting off does not mean the
+    // screen is: repeats still pass
+    mThrottle->setIndicationFilter(kScreenOn);
+    report(lte(-100));
+    report(lte(-100));
+    mIndication->currentLinkCapacityEstimate(RadioIndicationType::UNSOLICITED, lce);
+    EXPECT_EQ(2u, mFake->signalStrengths().size());
+    EXPECT_EQ(1, mFake->linkCapacityEstimates());
+
+    // Without FULL_NETWORK_STATE it is off: repeats and filtered kinds go
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+    report(lte(-100));
+    mIndication->currentLinkCapacityEstimate(RadioIndicationType::UNSOLICITED, lce);
+    EXPECT_EQ(2u, mFake->signalStrengths().size());
+    EXPECT_EQ(1, mFake->linkCapacityEstimates());
+
+    // Without SIGNAL_STRENGTH nothing gets through
+    mThrottle->setIndicationFilter(static_cast<uint32_t>(IndicationFilter::FULL_NETWORK_STATE));
+    report(lte(-70));
+    EXPECT_EQ(2u, mFake->signalStrengths().size());
+}
+
+TEST_F(IndicationReplayTest, HeldReportDeliveredWhenHysteresisExpires) {
+    criteria(200ms);
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+
+    report(lte(-115));
+    report(lte(-95));  // crosses two thresholds, but too early
+    report(lte(-85));  // replaces it
+    ASSERT_EQ(1u, mFake->signalStrengths().size());
+
+    ASSERT_TRUE(mFake->waitForSignalStrengths(2, 2s));
+    auto reports = mFake->signalStrengths();
+    EXPECT_EQ(-85, dbm(reports[1].signalStrength));
+    EXPECT_EQ(RadioIndicationType::UNSOLICITED, reports[1].type);
+    EXPECT_GE(reports[1].time - reports[0].time, 190ms);
+
+    // Delivered once only
+    std::this_thread::sleep_for(400ms);
+    EXPECT_EQ(2u, mFake->signalStrengths().size());
+}
+
+TEST_F(IndicationReplayTest, HeldReportDroppedWhenSignalReturns) {
+    criteria(100ms);
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+
+    report(lte(-115));
+    report(lte(-95));
+    report(lte(-116));  // same band as the framework last saw
+
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(1u, mFake->signalStrengths().size());
+}
+
+TEST_F(IndicationReplayTest, HeldReportDroppedWhenFiltered) {
+    criteria(100ms);
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+
+    report(lte(-115));
+    report(lte(-95));
+    mThrottle->setIndicationFilter(0);
+
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(1u, mFake->signalStrengths().size());
+}
+
+TEST_F(IndicationReplayTest, HeldReportGoesToLatestIndication) {
+    sp<FakeRadioIndication> restarted = new FakeRadioIndication();
+
+    criteria(100ms);
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+
+    report(lte(-115));
+    report(lte(-95));
+
+    // The framework set new response functions in the meantime
+    mIndication = new SecRadioIndication(restarted, mThrottle);
+
+    ASSERT_TRUE(restarted->waitForSignalStrengths(1, 2s));
+    EXPECT_EQ(-95, dbm(restarted->signalStrengths()[0].signalStrength));
+    EXPECT_EQ(1u, mFake->signalStrengths().size());
+}
+
+// Replays a noisy random walk a few times faster than the hysteresis and
+// checks what the framework ends up seeing.
+TEST_F(IndicationReplayTest, ReplayRandomWalk) {
+    constexpr auto kHysteresis = 20ms;
+    constexpr int kReports = 2000;
+    int32_t level = -100;
+
+    srand(1);
+    criteria(kHysteresis, 0);
+    mThrottle->setIndicationFilter(kScreenOffWithSignal);
+
+    for (int i = 0; i < kReports; i++) {
+        level = std::min(-60, std::max(-135, level + rand() % 7 - 3));
+        report(lte(level));
+        std::this_thread::sleep_for(500us);
+    }
+
+    // Let a report held at the end go out
+    std::this_thread::sleep_for(kHysteresis * 10);
+    auto reports = mFake->signalStrengths();
+    ASSERT_FALSE(reports.empty());
+
+    for (size_t i = 1; i < reports.size(); i++) {
+        int32_t from = dbm(reports[i - 1].signalStrength);
+        int32_t to = dbm(reports[i].signalStrength);
+
+        // Every report crossed a threshold, and none came early
+        EXPECT_NE(band(from), band(to)) << "report " << i;
+        EXPECT_GE(reports[i].time - reports[i - 1].time, kHysteresis - 5ms) << "report " << i;
+    }
+
+    // The framework is left in the band the modem last reported
+    EXPECT_EQ(band(level), band(dbm(reports.back().signalStrength)));
+    EXPECT_LT(reports.size(), static_cast<size_t>(kReports / 10));
+}
+
+}  // namespace
@@ -56,11 +56,21 @@ static Result ResultFromStatus(status_t err) {
 }
 
 Sensors::Sensors()
+    : Sensors(nullptr) {
+}
+
+/*
+ * A module passed in is opened instead of the one hw_get_module() finds,
+ * so the poll path can be exercised against a fake device.
+ */
+Sensors::Sensors(sensors_module_t *module)
     : mInitCheck(NO_INIT),
-      mSensorModule(nullptr),
+      mSensorModule(module),
       mSensorDevice(nullptr) {
     status_t err = OK;
-    if (UseMultiHal()) {
+    if (mSensorModule != nullptr) {
+        // Supplied by the caller
+    } else if (UseMultiHal()) {
         mSensorModule = ::get_multi_hal_module_info();
     } else {
         err = hw_get_module(
@@ -187,44 +197,46 @@ Return<void> Sensors::poll(int32_t maxCount, poll_cb _hidl_cb) {
     hidl_vec<Event> out;
     hidl_vec<SensorInfo> dynamicSensorsAdded;
 
-    std::unique_ptr<sensors_event_t[]> data;
     int err = android::NO_ERROR;
 
-    { // scope of reentry lock
-
-        // This enforces a single client, meaning that a maximum of one client can call poll().
-        // If this function is re-entred, it means that we are stuck in a state that may prevent
-        // the system from proceeding normally.
-        //
-        // Exit and let the system restart the sensor-hal-implementation hidl service.
-        //
-        // This function must not call _hidl_cb(...) or return until there is no risk of blocking.
-        std::unique_lock<std::mutex> lock(mPollLock, std::try_to_lock);
-        if(!lock.owns_lock()){
-            // cannot get the lock, hidl service will go into deadlock if it is not restarted.
-            // This is guaranteed to not trigger in passthrough mode.
-            LOG(ERROR) <<
-                    "ISensors::poll() re-entry. I do not know what to do except killing myself.";
-            ::exit(-1);
-        }
+    // This enforces a single client, meaning that a maximum of one client can call poll().
+    // If this function is re-entred, it means that we are stuck in a state that may prevent
+    // the system from proceeding normally.
+    //
+    // Exit and let the system restart the sensor-hal-implementation hidl service.
+    //
+    // The lock also guards the persistent event buffers, so it is held until _hidl_cb(...)
+    // has consumed them; the callback only writes the reply and does not block.
+    std::unique_lock<std::mutex> lock(mPollLock, std::try_to_lock);
+    if(!lock.owns_lock()){
+        // cannot get the lock, hidl service will go into deadlock if it is not restarted.
+        // This is guaranteed to not trigger in passthrough mode.
+        LOG(ERROR) <<
+                "ISensors::poll() re-entry. I do not know what to do except killing myself.";
+        ::exit(-1);
+    }
 
-        if (maxCount <= 0) {
-            err = android::BAD_VALUE;
-        } else {
-            int bufferSize = maxCount <= kPollMaxBufferSize ? maxCount : kPollMaxBufferSize;
-            data.reset(new sensors_event_t[bufferSize]);
-            err = mSensorDevice->poll(
-                    reinterpret_cast<sensors_poll_device_t *>(mSensorDevice),
-                    data.get(), bufferSize);
+    if (maxCount <= 0) {
+        err = android::BAD_VALUE;
+    } else {
+        size_t bufferSize = maxCount <= kPollMaxBufferSize ? maxCount : kPollMaxBufferSize;
+        if (mPollBuffer.size() < bufferSize) {
+            mPollBuffer.resize(bufferSize);
+            mPollEvents.resize(bufferSize);
         }
+        err = mSensorDevice->poll(
+                reinterpret_cast<sensors_poll_device_t *>(mSensorDevice),
+                mPollBuffer.data(), bufferSize);
     }
 
     if (err < 0) {
+        lock.unlock();
         _hidl_cb(ResultFromStatus(err), out, dynamicSensorsAdded);
         return Void();
     }
 
     const size_t count = (size_t)err;
+    const sensors_event_t *data = mPollBuffer.data();
 
     for (size_t i = 0; i < count; ++i) {
         if (data[i].type != SENSOR_TYPE_DYNAMIC_SENSOR_META) {
@@ -248,8 +260,8 @@ Return<void> Sensors::poll(int32_t maxCount, poll_cb _hidl_cb) {
         dynamicSensorsAdded[numDynamicSensors] = info;
     }
 
-    out.resize(count);
-    convertFromSensorEvents(err, data.get(), &out);
+    convertFromSensorEvents(count, data, mPollEvents.data());
+    out.setToExternal(mPollEvents.data(), count);
 
     _hidl_cb(Result::OK, out, dynamicSensorsAdded);
 
@@ -357,12 +369,9 @@ Return<void> Sensors::configDirectReport(
 void Sensors::convertFromSensorEvents(
         size_t count,
         const sensors_event_t *srcArray,
-        hidl_vec<Event> *dstVec) {
+        Event *dstArray) {
     for (size_t i = 0; i < count; ++i) {
-        const sensors_event_t &src = srcArray[i];
-        Event *dst = &(*dstVec)[i];
-
-        convertFromSensorEvent(src, dst);
+        convertFromSensorEvent(srcArray[i], &dstArray[i]);
     }
 }
 
@@ -22,6 +22,7 @@
 #include <android/hardware/sensors/1.0/ISensors.h>
 #include <hardware/sensors.h>
 #include <mutex>
+#include <vector>
 
 namespace android {
 namespace hardware {
@@ -32,6 +33,7 @@ namespace implementation {
 
 struct Sensors : public ::android::hardware::sensors::V1_0::ISensors {
     Sensors();
+    explicit Sensors(sensors_module_t *module);
 
     status_t initCheck() const;
 
@@ -69,10 +71,14 @@ private:
     sensors_poll_device_1_t *mSensorDevice;
     std::mutex mPollLock;
 
+    // Reused by every poll(), grown to the largest batch size seen; guarded by mPollLock
+    std::vector<sensors_event_t> mPollBuffer;
+    std::vector<Event> mPollEvents;
+
     int getHalDeviceVersion() const;
 
     static void convertFromSensorEvents(
-            size_t count, const sensors_event_t *src, hidl_vec<Event> *dst);
+            size_t count, const sensors_event_t *src, Event *dst);
 
     DISALLOW_COPY_AND_ASSIGN(Sensors);
 };
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <hardware/sensors.h>
+#include <string.h>
+
+/*
+ * Sensors module with a poll device that has sBatch accelerometer events
+ * ready on every poll.
+ */
+namespace fake_poll_device {
+
+constexpr int32_t kHandle = 1;
+
+static int sBatch = 16;
+static int sLastPollCount;
+static int64_t sTimestamp;
+
+static int close(hw_device_t * /* device */) {
+    return 0;
+}
+
+static int activate(sensors_poll_device_t * /* dev */, int /* handle */, int /* enabled */) {
+    return 0;
+}
+
+static int setDelay(sensors_poll_device_t * /* dev */, int /* handle */, int64_t /* ns */) {
+    return 0;
+}
+
+static int poll(sensors_poll_device_t * /* dev */, sensors_event_t *data, int count) {
+    int n = count < sBatch ? count : sBatch;
+
+    sLastPollCount = count;
+    for (int i = 0; i < n; i++) {
+        memset(&data[i], 0, sizeof(data[i]));
+        data[i].version = sizeof(sensors_event_t);
+        data[i].sensor = kHandle;
+        data[i].type = SENSOR_TYPE_ACCELEROMETER;
+        data[i].timestamp = ++sTimestamp;
+        data[i].acceleration.x = i;
+        data[i].acceleration.y = -i;
+        data[i].acceleration.z = 9.81f;
+        data[i].acceleration.status = SENSOR_STATUS_ACCURACY_HIGH;
+    }
+
+    return n;
+}
+
+static int batch(sensors_poll_device_1 * /* dev */, int /* handle */, int /* flags */,
+                 int64_t /* period */, int64_t /* latency */) {
+    return 0;
+}
+
+static int flush(sensors_poll_device_1 * /* dev */, int /* handle */) {
+    return 0;
+}
+
+static int open(const hw_module_t *module, const char * /* id */, hw_device_t **device) {
+    static sensors_poll_device_1_t dev;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.common.tag = HARDWARE_DEVICE_TAG;
+    dev.common.version = SENSORS_DEVICE_API_VERSION_1_3;
+    dev.common.module = const_cast<hw_module_t *>(module);
+    dev.common.close = close;
+    dev.activate = activate;
+    dev.setDelay = setDelay;
+    dev.poll = poll;
+    dev.batch = batch;
+    dev.flush = flush;
+
+    *device = &dev.common;
+    return 0;
+}
+
+static int getSensorsList(sensors_module_t * /* module */, sensor_t const **list) {
+    static const sensor_t sensor = {
+        .name = "Fake accelerometer",
+        .vendor = "LineageOS",
+        .version = 1,
+        .handle = kHandle,
+        .type = SENSOR_TYPE_ACCELEROMETER,
+        .maxRange = 78.4f,
+        .resolution = 0.01f,
+        .power = 0.1f,
+        .minDelay = 5000,
+        .stringType = SENSOR_STRING_TYPE_ACCELEROMETER,
+        .flags = SENSOR_FLAG_CONTINUOUS_MODE,
+    };
+
+    *list = &sensor;
+    return 1;
+}
+
+static hw_module_methods_t sMethods = {
+    .open = open,
+};
+
+static sensors_module_t sModule = {
+    .common = {
+        .tag = HARDWARE_MODULE_TAG,
+        .id = SENSORS_HARDWARE_MODULE_ID,
+        .name = "Fake sensors module",
+        .methods = &sMethods,
+    },
+    .get_sensors_list = getSensorsList,
+};
+
+}  // namespace fake_poll_device
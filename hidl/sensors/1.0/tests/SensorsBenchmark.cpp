@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "FakePollDevice.h"
+#include "Sensors.h"
+
+using ::android::sp;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::sensors::V1_0::Event;
+using ::android::hardware::sensors::V1_0::ISensors;
+using ::android::hardware::sensors::V1_0::Result;
+using ::android::hardware::sensors::V1_0::SensorInfo;
+using ::android::hardware::sensors::V1_0::implementation::Sensors;
+
+// poll() latency against a device that always has a full batch ready
+static void BM_Poll(benchmark::State& state) {
+    sp<Sensors> sensors = new Sensors(&fake_poll_device::sModule);
+    ISensors::poll_cb cb = [&](Result /* result */, const hidl_vec<Event>& out,
+                               const hidl_vec<SensorInfo>& /* dynamicSensors */) {
+        benchmark::DoNotOptimize(out.data());
+    };
+
+    fake_poll_device::sBatch = state.range(0);
+    for (auto _ : state)
+        sensors->poll(state.range(0), cb);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Poll)->Arg(1)->Arg(16)->Arg(128);
+
+BENCHMARK_MAIN();
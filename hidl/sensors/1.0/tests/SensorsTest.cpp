@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#include "FakePollDevice.h"
+#include "Sensors.h"
+
+using ::android::sp;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::sensors::V1_0::Event;
+using ::android::hardware::sensors::V1_0::ISensors;
+using ::android::hardware::sensors::V1_0::Result;
+using ::android::hardware::sensors::V1_0::SensorInfo;
+using ::android::hardware::sensors::V1_0::SensorType;
+using ::android::hardware::sensors::V1_0::implementation::Sensors;
+
+// Every C++ allocation made by the test binary
+static std::atomic<size_t> sAllocations;
+
+void *operator new(size_t size) {
+    void *p = malloc(size);
+
+    if (p == nullptr)
+        abort();
+    sAllocations++;
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+namespace {
+
+class SensorsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake_poll_device::sBatch = 16;
+        fake_poll_device::sTimestamp = 0;
+        mSensors = new Sensors(&fake_poll_device::sModule);
+        ASSERT_EQ(::android::OK, mSensors->initCheck());
+    }
+
+    Result poll(int32_t maxCount) {
+        Result result = Result::INVALID_OPERATION;
+
+        mSensors->poll(maxCount, [&](Result r, const hidl_vec<Event>& events,
+                                     const hidl_vec<SensorInfo>& /* dynamicSensors */) {
+            result = r;
+            mEvents = events;
+        });
+        return result;
+    }
+
+    sp<Sensors> mSensors;
+    std::vector<Event> mEvents;
+};
+
+TEST_F(SensorsTest, PollConvertsEvents) {
+    ASSERT_EQ(Result::OK, poll(64));
+
+    ASSERT_EQ(16u, mEvents.size());
+    for (size_t i = 0; i < mEvents.size(); i++) {
+        EXPECT_EQ(fake_poll_device::kHandle, mEvents[i].sensorHandle);
+        EXPECT_EQ(SensorType::ACCELEROMETER, mEvents[i].sensorType);
+        EXPECT_EQ(static_cast<int64_t>(i + 1), mEvents[i].timestamp);
+        EXPECT_EQ(static_cast<float>(i), mEvents[i].u.vec3.x);
+        EXPECT_EQ(-static_cast<float>(i), mEvents[i].u.vec3.y);
+    }
+}
+
+TEST_F(SensorsTest, BufferGrowsWithMaxCount) {
+    fake_poll_device::sBatch = 128;
+
+    ASSERT_EQ(Result::OK, poll(4));
+    EXPECT_EQ(4, fake_poll_device::sLastPollCount);
+    ASSERT_EQ(4u, mEvents.size());
+
+    ASSERT_EQ(Result::OK, poll(64));
+    EXPECT_EQ(64, fake_poll_device::sLastPollCount);
+    ASSERT_EQ(64u, mEvents.size());
+    EXPECT_EQ(68, mEvents.back().timestamp);
+
+    // A smaller request after a larger one still asks for no more than requested
+    ASSERT_EQ(Result::OK, poll(8));
+    EXPECT_EQ(8, fake_poll_device::sLastPollCount);
+    EXPECT_EQ(8u, mEvents.size());
+}
+
+TEST_F(SensorsTest, MaxCountCapped) {
+    ASSERT_EQ(Result::OK, poll(100000));
+    EXPECT_EQ(128, fake_poll_device::sLastPollCount);
+}
+
+TEST_F(SensorsTest, BadMaxCount) {
+    EXPECT_EQ(Result::BAD_VALUE, poll(0));
+    EXPECT_EQ(Result::BAD_VALUE, poll(-1));
+}
+
+TEST_F(SensorsTest, SteadyStatePollDoesNotAllocate) {
+    size_t events = 0;
+    ISensors::poll_cb cb = [&](Result /* result */, const hidl_vec<Event>& out,
+                               const hidl_vec<SensorInfo>& /* dynamicSensors */) {
+        events += out.size();
+    };
+
+    fake_poll_device::sBatch = 128;
+    mSensors->poll(128, cb);
+
+    size_t before = sAllocations;
+    for (int i = 0; i < 1000; i++)
+        mSensors->poll(128, cb);
+
+    EXPECT_EQ(before, sAllocations);
+    EXPECT_EQ(128u * 1001, events);
+}
+
+}  // namespace
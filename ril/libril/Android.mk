@@ -70,4 +70,6 @@ LOCAL_SANITIZE := integer
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif # BOARD_PROVIDES_LIBRIL
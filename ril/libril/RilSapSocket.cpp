@@ -30,6 +30,12 @@
 
 static RilSapSocket::RilSapSocketList *head = NULL;
 
+static_assert(SAP_REQUEST_POOL_SIZE < 32, "requestPoolUsed is a 32 bit mask");
+
+RilSapSocket::SapRequestSlot RilSapSocket::requestPool[SAP_REQUEST_POOL_SIZE];
+uint32_t RilSapSocket::requestPoolUsed = 0;
+pthread_mutex_t RilSapSocket::requestPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
 extern "C" void
 RIL_requestTimedCallback (RIL_TimedCallback callback, void *param,
         const struct timeval *relativeTime);
@@ -55,10 +61,7 @@ void RilSapSocket::sOnRequestComplete (RIL_Token t,
         sap_socket->onRequestComplete(t,e,response,responselen);
     } else {
         RLOGE("Invalid socket id");
-        if (request->curr) {
-            free(request->curr);
-        }
-        free(request);
+        releaseRequest(request);
     }
 }
 
@@ -97,9 +100,6 @@ RilSapSocket *RilSapSocket::getSocketById(RIL_SOCKET_ID socketId) {
     RilSapSocket *sap_socket;
     RilSapSocketList *current = head;
 
-    RLOGD("Entered getSocketById");
-    printList();
-
     while(NULL != current) {
         if(socketId == current->socket->id) {
             sap_socket = current->socket;
@@ -197,24 +197,58 @@ RilSapSocket::RilSapSocket(const char *socketName,
     }
 }
 
+RilSapSocket::SapSocketRequest* RilSapSocket::allocRequest() {
+    SapRequestSlot *slot = NULL;
+
+    pthread_mutex_lock(&requestPoolLock);
+    if (requestPoolUsed != (1u << SAP_REQUEST_POOL_SIZE) - 1) {
+        int i = __builtin_ctz(~requestPoolUsed);
+        requestPoolUsed |= 1u << i;
+        slot = &requestPool[i];
+    }
+    pthread_mutex_unlock(&requestPoolLock);
+
+    if (!slot) {
+        slot = (SapRequestSlot *)malloc(sizeof(SapRequestSlot));
+        if (!slot) {
+            return NULL;
+        }
+    }
+
+    slot->request.curr = &slot->hdr;
+    return &slot->request;
+}
+
+void RilSapSocket::releaseRequest(SapSocketRequest *request) {
+    SapRequestSlot *slot = (SapRequestSlot *)request;
+
+    if (slot >= requestPool && slot < requestPool + SAP_REQUEST_POOL_SIZE) {
+        pthread_mutex_lock(&requestPoolLock);
+        requestPoolUsed &= ~(1u << (slot - requestPool));
+        pthread_mutex_unlock(&requestPoolLock);
+    } else {
+        free(slot);
+    }
+}
+
 void RilSapSocket::dispatchRequest(MsgHeader *req) {
-    // SapSocketRequest will be deallocated in onRequestComplete()
-    SapSocketRequest* currRequest=(SapSocketRequest*)malloc(sizeof(SapSocketRequest));
+    // SapSocketRequest will be released in onRequestComplete()
+    SapSocketRequest* currRequest = allocRequest();
     if (!currRequest) {
         RLOGE("dispatchRequest: OOM");
-        // Free MsgHeader allocated in pushRecord()
-        free(req);
         return;
     }
+    *currRequest->curr = *req;
+    // The payload belongs to the caller and is only valid during onRequest
+    currRequest->curr->payload = NULL;
     currRequest->token = req->token;
-    currRequest->curr = req;
     currRequest->p_next = NULL;
     currRequest->socketId = id;
 
     pendingResponseQueue.enqueue(currRequest);
 
     if (uimFuncs) {
-        RLOGI("RilSapSocket::dispatchRequest [%d] > SAP REQUEST type: %d. id: %d. error: %d, \
+        RLOGD("RilSapSocket::dispatchRequest [%d] > SAP REQUEST type: %d. id: %d. error: %d, \
                 token 0x%p",
                 req->token,
                 req->type,
@@ -240,47 +274,61 @@ void RilSapSocket::onRequestComplete(RIL_Token t, RIL_Errno e, void *response,
     }
 
     MsgHeader *hdr = request->curr;
+    SapPayloadBuffer inlinePayload;
+
+    if (!response) {
+        response_len = 0;
+    }
 
     MsgHeader rsp;
     rsp.token = request->curr->token;
     rsp.type = MsgType_RESPONSE;
     rsp.id = request->curr->id;
     rsp.error = (Error)e;
-    rsp.payload = (pb_bytes_array_t *)calloc(1, sizeof(pb_bytes_array_t) + response_len);
+    if (response_len <= SAP_INLINE_PAYLOAD_SIZE) {
+        rsp.payload = &inlinePayload.array;
+    } else {
+        rsp.payload = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 + response_len);
+    }
     if (!rsp.payload) {
         RLOGE("onRequestComplete: OOM");
     } else {
-        if (response && response_len > 0) {
+        if (response_len > 0) {
             memcpy(rsp.payload->bytes, response, response_len);
-            rsp.payload->size = response_len;
-        } else {
-            rsp.payload->size = 0;
         }
+        rsp.payload->size = response_len;
 
-        RLOGE("RilSapSocket::onRequestComplete: Token:%d, MessageId:%d ril token 0x%p",
+        RLOGD("RilSapSocket::onRequestComplete: Token:%d, MessageId:%d ril token 0x%p",
                 hdr->token, hdr->id, t);
 
         sap::processResponse(&rsp, this);
-        free(rsp.payload);
+        if (rsp.payload != &inlinePayload.array) {
+            free(rsp.payload);
+        }
     }
 
-    // Deallocate SapSocketRequest
     if(!pendingResponseQueue.checkAndDequeue(hdr->id, hdr->token)) {
         RLOGE("Token:%d, MessageId:%d", hdr->token, hdr->id);
         RLOGE ("RilSapSocket::onRequestComplete: invalid Token or Message Id");
     }
 
-    // Deallocate MsgHeader
-    free(hdr);
+    // Release SapSocketRequest and its MsgHeader
+    releaseRequest(request);
 }
 
 void RilSapSocket::onUnsolicitedResponse(int unsolResponse, void *data, size_t datalen) {
     if (data && datalen > 0) {
-        pb_bytes_array_t *payload = (pb_bytes_array_t *)calloc(1,
-                sizeof(pb_bytes_array_t) + datalen);
-        if (!payload) {
-            RLOGE("onUnsolicitedResponse: OOM");
-            return;
+        SapPayloadBuffer inlinePayload;
+        pb_bytes_array_t *payload;
+
+        if (datalen <= SAP_INLINE_PAYLOAD_SIZE) {
+            payload = &inlinePayload.array;
+        } else {
+            payload = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 + datalen);
+            if (!payload) {
+                RLOGE("onUnsolicitedResponse: OOM");
+                return;
+            }
         }
         memcpy(payload->bytes, data, datalen);
         payload->size = datalen;
@@ -290,6 +338,8 @@ void RilSapSocket::onUnsolicitedResponse(int unsolResponse, void *data, size_t d
         rsp.id = (MsgId)unsolResponse;
         rsp.error = Error_RIL_E_SUCCESS;
         sap::processUnsolResponse(&rsp, this);
-        free(payload);
+        if (payload != &inlinePayload.array) {
+            free(payload);
+        }
     }
 }
\ No newline at end of file
@@ -21,6 +21,25 @@
 #include "RilSocket.h"
 #include <hardware/ril/librilutils/proto/sap-api.pb.h>
 
+/**
+ * Payloads up to this size are carried in buffers on the stack or per
+ * thread; larger ones fall back to the heap.
+ */
+#define SAP_INLINE_PAYLOAD_SIZE 1024
+
+/**
+ * Storage for a pb_bytes_array_t holding up to SAP_INLINE_PAYLOAD_SIZE bytes.
+ */
+typedef union SapPayloadBuffer {
+    pb_bytes_array_t array;
+    uint8_t raw[sizeof(pb_bytes_array_t) - 1 + SAP_INLINE_PAYLOAD_SIZE];
+} SapPayloadBuffer;
+
+/**
+ * Number of in-flight requests served from the fixed request pool.
+ */
+#define SAP_REQUEST_POOL_SIZE 8
+
 /**
  * RilSapSocket is a derived class, derived from the RilSocket abstract
  * class, representing sockets for communication between bluetooth SAP module and
@@ -51,6 +70,23 @@ class RilSapSocket : public RilSocket {
         RIL_SOCKET_ID socketId;
     } SapSocketRequest;
 
+    /**
+     * A request together with its own copy of the message header, so a
+     * dispatched request needs a single pool slot.
+     */
+    typedef struct SapRequestSlot {
+        SapSocketRequest request;
+        MsgHeader hdr;
+    } SapRequestSlot;
+
+    /**
+     * Fixed pool of request slots shared by all sap sockets, and the bitmap
+     * of the slots in use. Guarded by requestPoolLock.
+     */
+    static SapRequestSlot requestPool[SAP_REQUEST_POOL_SIZE];
+    static uint32_t requestPoolUsed;
+    static pthread_mutex_t requestPoolLock;
+
     /**
      * Queue for requests that are pending dispatch.
      */
@@ -86,7 +122,9 @@ class RilSapSocket : public RilSocket {
          * Dispatches the request to the lower layers.
          * It calls the on request function.
          *
-         * @param request The request message.
+         * @param request The request message. It is copied, and its payload
+         *                is only used until this returns, so both may live
+         *                on the caller's stack.
          */
         void dispatchRequest(MsgHeader *request);
 
@@ -148,6 +186,21 @@ class RilSapSocket : public RilSocket {
         static bool SocketExists(const char *socketName);
 
     private:
+        /**
+         * Take a request slot from the pool, or from the heap if every
+         * pooled slot is in flight.
+         *
+         * @return the request, with curr pointing at the slot's header.
+         */
+        static SapSocketRequest* allocRequest();
+
+        /**
+         * Return a request obtained from allocRequest().
+         *
+         * @param The request.
+         */
+        static void releaseRequest(SapSocketRequest *request);
+
         /**
          * Constructor.
          *
@@ -31,6 +31,7 @@
 #include <sys/system_properties.h>
 #include <pwd.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
@@ -47,6 +48,8 @@
 #include <RilSapSocket.h>
 #include <ril_service.h>
 #include <sap_service.h>
+#include "ril_unsol_index.h"
+#include <atomic>
 
 extern "C" void
 RIL_onRequestComplete(RIL_Token t, RIL_Errno e, void *response, size_t responselen);
@@ -154,7 +157,18 @@ static const struct timeval TIMEVAL_WAKE_TIMEOUT = {ANDROID_WAKE_LOCK_SECS,ANDRO
 static pthread_mutex_t s_startupMutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t s_startupCond = PTHREAD_COND_INITIALIZER;
 
-static UserCallbackInfo *s_last_wake_timeout_info = NULL;
+/*
+ * Partial wake lock shared by solicited responses that expect an ack and by
+ * WAKE_PARTIAL unsolicited responses. The kernel lock is only taken on the
+ * first grab and dropped when the last holder releases it or the timeout
+ * expires. The timeout is a single deadline, pushed out by every grab; its
+ * event sits on the timer list at most once and re-arms itself for the
+ * remainder when it fires early. All of it is guarded by s_wakeLockCountMutex.
+ */
+static struct ril_event s_wakeTimeoutEvent;
+static bool s_wakeTimeoutArmed = false;
+static struct timeval s_wakeDeadline;
+static WakeLockStats s_wakeLockStats;
 
 static void *s_lastNITZTimeData = NULL;
 static size_t s_lastNITZTimeDataSize;
@@ -166,7 +180,10 @@ static size_t s_lastNITZTimeDataSize;
 /*******************************************************************/
 static void grabPartialWakeLock();
 void releaseWakeLock();
-static void wakeTimeoutCallback(void *);
+static void armWakeTimeout();
+static void wakeTimeoutCallback(int fd, short flags, void *param);
+static int64_t getMonotonicNs();
+static void recordRequestLatency(RequestInfo *pRI);
 
 #ifdef RIL_SHLIB
 #if defined(ANDROID_MULTI_SIM)
@@ -205,6 +222,34 @@ static UnsolResponseInfo s_unsolResponses_v[] = {
 #include <telephony/ril_unsol_commands_vendor.h>
 };
 
+/**
+ * Length of the leading block of s_unsolResponses_v where
+ * index == requestNumber - SAMSUNG_UNSOL_RESPONSE_BASE. Set by RIL_register().
+ */
+static int32_t s_numDenseUnsolResponses_v = 0;
+
+/*
+ * Completion latency of each request number, in power of two buckets:
+ * bucket i counts latencies in [2^(i-1), 2^i) us, the last one everything
+ * slower. Updated with relaxed atomics from whichever thread completes the
+ * request, so recording never takes a lock.
+ */
+#define LATENCY_BUCKETS 28
+
+typedef struct RequestLatency {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> acked;
+    std::atomic<uint64_t> totalUs;
+    std::atomic<uint64_t> ackTotalUs;
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+} RequestLatency;
+
+static RequestLatency s_requestLatency[NUM_ELEMS(s_commands)];
+static RequestLatency s_requestLatency_v[NUM_ELEMS(s_commands_v)];
+
+/* Number of pending requests listed by dumpRequestStats() */
+#define DUMP_PENDING_MAX 10
+
 char * RIL_getServiceName() {
     return ril_service_name;
 }
@@ -260,6 +305,7 @@ addRequestToList(int serial, int slotId, int request) {
     pRI->token = serial;
     pRI->pCI = pCI;
     pRI->socket_id = socket_id;
+    pRI->submitTimeNs = getMonotonicNs();
 
     ret = pthread_mutex_lock(pendingRequestsMutexHook);
     assert (ret == 0);
@@ -367,12 +413,6 @@ static void userTimerCallback (int fd, short flags, void *param) {
 
     p_info->p_callback(p_info->userParam);
 
-
-    // FIXME generalize this...there should be a cancel mechanism
-    if (s_last_wake_timeout_info != NULL && s_last_wake_timeout_info == p_info) {
-        s_last_wake_timeout_info = NULL;
-    }
-
     free(p_info);
 }
 
@@ -493,6 +533,9 @@ RIL_register (const RIL_RadioFunctions *callbacks) {
                 == s_unsolResponses[i].requestNumber);
     }
 
+    s_numDenseUnsolResponses_v = denseResponseCount(s_unsolResponses_v,
+            (int32_t)NUM_ELEMS(s_unsolResponses_v), SAMSUNG_UNSOL_RESPONSE_BASE);
+
     radio::registerService(&s_callbacks, s_commands);
     RLOGI("RILHIDL called registerService");
 
@@ -576,6 +619,7 @@ checkAndDequeueRequestInfoIfAck(struct RequestInfo *pRI, bool isAck) {
                     RLOGD("Ack was already sent for %s", requestToString(pRI->pCI->requestNumber));
                 } else {
                     pRI->wasAckSent = 1;
+                    pRI->ackTimeNs = getMonotonicNs();
                 }
             } else {
                 *ppCur = (*ppCur)->p_next;
@@ -640,6 +684,8 @@ RIL_onRequestComplete(RIL_Token t, RIL_Errno e, void *response, size_t responsel
     RLOGD("RequestComplete, %s", rilSocketIdToString(socket_id));
 #endif
 
+    recordRequestLatency(pRI);
+
     if (pRI->local > 0) {
         // Locally issued command...void only!
         // response does not go back up the command socket
@@ -681,77 +727,331 @@ RIL_onRequestComplete(RIL_Token t, RIL_Errno e, void *response, size_t responsel
     free(pRI);
 }
 
+static int64_t
+getMonotonicNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static RequestLatency *
+getRequestLatency(CommandInfo *pCI) {
+    if (pCI >= s_commands && pCI < s_commands + NUM_ELEMS(s_commands)) {
+        return &s_requestLatency[pCI - s_commands];
+    }
+    if (pCI >= s_commands_v && pCI < s_commands_v + NUM_ELEMS(s_commands_v)) {
+        return &s_requestLatency_v[pCI - s_commands_v];
+    }
+    return NULL;
+}
+
+static int
+latencyBucket(uint64_t us) {
+    int bucket = 0;
+
+    while (us != 0 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
 static void
-grabPartialWakeLock() {
-    if (s_callbacks.version >= 13) {
-        int ret;
-        ret = pthread_mutex_lock(&s_wakeLockCountMutex);
-        assert(ret == 0);
-        acquire_wake_lock(PARTIAL_WAKE_LOCK, ANDROID_WAKE_LOCK_NAME);
-
-        UserCallbackInfo *p_info =
-                internalRequestTimedCallback(wakeTimeoutCallback, NULL, &TIMEVAL_WAKE_TIMEOUT);
-        if (p_info == NULL) {
-            release_wake_lock(ANDROID_WAKE_LOCK_NAME);
-        } else {
-            s_wakelock_count++;
-            if (s_last_wake_timeout_info != NULL) {
-                s_last_wake_timeout_info->userParam = (void *)1;
-            }
-            s_last_wake_timeout_info = p_info;
+recordRequestLatency(RequestInfo *pRI) {
+    RequestLatency *latency = getRequestLatency(pRI->pCI);
+    if (latency == NULL) {
+        return;
+    }
+
+    uint64_t us = (getMonotonicNs() - pRI->submitTimeNs) / 1000;
+
+    latency->count.fetch_add(1, std::memory_order_relaxed);
+    latency->totalUs.fetch_add(us, std::memory_order_relaxed);
+    latency->buckets[latencyBucket(us)].fetch_add(1, std::memory_order_relaxed);
+
+    if (pRI->ackTimeNs != 0) {
+        latency->acked.fetch_add(1, std::memory_order_relaxed);
+        latency->ackTotalUs.fetch_add((pRI->ackTimeNs - pRI->submitTimeNs) / 1000,
+                std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Upper bound in us of the bucket holding the given fraction of the samples
+ */
+static uint64_t
+latencyPercentile(const uint32_t *buckets, uint32_t count, int percent) {
+    uint64_t target = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return 1ULL << i;
         }
-        ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
-        assert(ret == 0);
-    } else {
-        acquire_wake_lock(PARTIAL_WAKE_LOCK, ANDROID_WAKE_LOCK_NAME);
     }
+    return 1ULL << (LATENCY_BUCKETS - 1);
+}
+
+static void
+dumpRequestLatency(int fd, RequestLatency *latency, int request) {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count = latency->count.load(std::memory_order_relaxed);
+    uint32_t acked = latency->acked.load(std::memory_order_relaxed);
+
+    if (count == 0) {
+        return;
+    }
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        buckets[i] = latency->buckets[i].load(std::memory_order_relaxed);
+    }
+
+    dprintf(fd, "  %-40s count=%u avg=%" PRIu64 " p50<%" PRIu64 " p90<%" PRIu64
+            " p99<%" PRIu64, requestToString(request), count,
+            latency->totalUs.load(std::memory_order_relaxed) / count,
+            latencyPercentile(buckets, count, 50), latencyPercentile(buckets, count, 90),
+            latencyPercentile(buckets, count, 99));
+    if (acked != 0) {
+        dprintf(fd, " acked=%u ackAvg=%" PRIu64, acked,
+                latency->ackTotalUs.load(std::memory_order_relaxed) / acked);
+    }
+    dprintf(fd, "\n");
+}
+
+typedef struct PendingRequest {
+    int64_t submitTimeNs;
+    int32_t token;
+    int request;
+    RIL_SOCKET_ID socket_id;
+    int wasAckSent;
+} PendingRequest;
+
+static void
+collectPendingRequests(pthread_mutex_t *mutex, RequestInfo *list,
+        PendingRequest *oldest, int *numOldest) {
+    pthread_mutex_lock(mutex);
+
+    for (RequestInfo *pRI = list; pRI != NULL; pRI = pRI->p_next) {
+        if (pRI->pCI == NULL) {
+            continue;
+        }
+
+        // Keep the DUMP_PENDING_MAX oldest, sorted oldest first
+        int pos = *numOldest;
+        while (pos > 0 && oldest[pos - 1].submitTimeNs > pRI->submitTimeNs) {
+            pos--;
+        }
+        if (pos == DUMP_PENDING_MAX) {
+            continue;
+        }
+        if (*numOldest < DUMP_PENDING_MAX) {
+            (*numOldest)++;
+        }
+        memmove(&oldest[pos + 1], &oldest[pos], (*numOldest - pos - 1) * sizeof(*oldest));
+        oldest[pos].submitTimeNs = pRI->submitTimeNs;
+        oldest[pos].token = pRI->token;
+        oldest[pos].request = pRI->pCI->requestNumber;
+        oldest[pos].socket_id = pRI->socket_id;
+        oldest[pos].wasAckSent = pRI->wasAckSent;
+    }
+
+    pthread_mutex_unlock(mutex);
+}
+
+void
+dumpRequestStats(int fd) {
+    PendingRequest oldest[DUMP_PENDING_MAX];
+    int numOldest = 0;
+    int64_t now = getMonotonicNs();
+
+    dprintf(fd, "Request completion latency (us):\n");
+    for (int i = 0; i < (int)NUM_ELEMS(s_commands); i++) {
+        dumpRequestLatency(fd, &s_requestLatency[i], s_commands[i].requestNumber);
+    }
+    for (int i = 0; i < (int)NUM_ELEMS(s_commands_v); i++) {
+        dumpRequestLatency(fd, &s_requestLatency_v[i], s_commands_v[i].requestNumber);
+    }
+
+    collectPendingRequests(&s_pendingRequestsMutex, s_pendingRequests, oldest, &numOldest);
+#if (SIM_COUNT >= 2)
+    collectPendingRequests(&s_pendingRequestsMutex_socket2, s_pendingRequests_socket2,
+            oldest, &numOldest);
+#endif
+#if (SIM_COUNT >= 3)
+    collectPendingRequests(&s_pendingRequestsMutex_socket3, s_pendingRequests_socket3,
+            oldest, &numOldest);
+#endif
+#if (SIM_COUNT >= 4)
+    collectPendingRequests(&s_pendingRequestsMutex_socket4, s_pendingRequests_socket4,
+            oldest, &numOldest);
+#endif
+
+    dprintf(fd, "Oldest pending requests:\n");
+    for (int i = 0; i < numOldest; i++) {
+        dprintf(fd, "  [%04d] %s %s age=%" PRId64 "ms%s\n", oldest[i].token,
+                rilSocketIdToString(oldest[i].socket_id), requestToString(oldest[i].request),
+                (now - oldest[i].submitTimeNs) / 1000000, oldest[i].wasAckSent ? " acked" : "");
+    }
+}
+
+static void
+getMonotonicNow(struct timeval *tv) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    tv->tv_sec = ts.tv_sec;
+    tv->tv_usec = ts.tv_nsec / 1000;
+}
+
+/**
+ * Take a reference on the wake lock. Called with s_wakeLockCountMutex held.
+ */
+static void
+acquireWakeLockLocked() {
+    s_wakeLockStats.grabCount++;
+
+    if (s_wakelock_count++ > 0) {
+        return;
+    }
+
+    acquire_wake_lock(PARTIAL_WAKE_LOCK, ANDROID_WAKE_LOCK_NAME);
+    s_wakeLockStats.acquireCount++;
+    s_wakeLockStats.heldSinceMs = android::elapsedRealtime();
+}
+
+/**
+ * Drop every reference on the wake lock. Called with s_wakeLockCountMutex held.
+ */
+static void
+releaseWakeLockLocked() {
+    if (s_wakelock_count == 0) {
+        return;
+    }
+
+    s_wakelock_count = 0;
+    release_wake_lock(ANDROID_WAKE_LOCK_NAME);
+    s_wakeLockStats.heldMs += android::elapsedRealtime() - s_wakeLockStats.heldSinceMs;
+    s_wakeLockStats.heldSinceMs = 0;
+}
+
+/**
+ * Push the wake lock timeout out to TIMEVAL_WAKE_TIMEOUT from now. Called with
+ * s_wakeLockCountMutex held.
+ */
+static void
+armWakeTimeoutLocked() {
+    struct timeval now;
+    struct timeval timeout = TIMEVAL_WAKE_TIMEOUT;
+
+    getMonotonicNow(&now);
+    timeradd(&now, &timeout, &s_wakeDeadline);
+
+    if (s_wakeTimeoutArmed) {
+        // The pending event re-arms itself up to the new deadline
+        return;
+    }
+
+    ril_event_set(&s_wakeTimeoutEvent, -1, false, wakeTimeoutCallback, NULL);
+    ril_timer_add(&s_wakeTimeoutEvent, &timeout);
+    s_wakeTimeoutArmed = true;
+    triggerEvLoop();
+}
+
+static void
+armWakeTimeout() {
+    int ret;
+
+    ret = pthread_mutex_lock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+    armWakeTimeoutLocked();
+    ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+}
+
+static void
+grabPartialWakeLock() {
+    int ret;
+
+    ret = pthread_mutex_lock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+
+    acquireWakeLockLocked();
+    armWakeTimeoutLocked();
+
+    ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
+    assert(ret == 0);
 }
 
 void
 releaseWakeLock() {
-    if (s_callbacks.version >= 13) {
-        int ret;
-        ret = pthread_mutex_lock(&s_wakeLockCountMutex);
-        assert(ret == 0);
+    int ret;
 
-        if (s_wakelock_count > 1) {
-            s_wakelock_count--;
-        } else {
-            s_wakelock_count = 0;
-            release_wake_lock(ANDROID_WAKE_LOCK_NAME);
-            if (s_last_wake_timeout_info != NULL) {
-                s_last_wake_timeout_info->userParam = (void *)1;
-            }
-        }
+    ret = pthread_mutex_lock(&s_wakeLockCountMutex);
+    assert(ret == 0);
 
-        ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
-        assert(ret == 0);
+    if (s_wakelock_count > 1) {
+        s_wakelock_count--;
     } else {
-        release_wake_lock(ANDROID_WAKE_LOCK_NAME);
+        // The armed timeout finds nothing to release and doesn't re-arm
+        releaseWakeLockLocked();
     }
+
+    ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+}
+
+void
+getWakeLockStats(WakeLockStats *stats) {
+    int ret;
+
+    ret = pthread_mutex_lock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+    *stats = s_wakeLockStats;
+    ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
+    assert(ret == 0);
 }
 
 /**
  * Timer callback to put us back to sleep before the default timeout
  */
 static void
-wakeTimeoutCallback (void *param) {
-    // We're using "param != NULL" as a cancellation mechanism
-    if (s_callbacks.version >= 13) {
-        if (param == NULL) {
-            int ret;
-            ret = pthread_mutex_lock(&s_wakeLockCountMutex);
-            assert(ret == 0);
-            s_wakelock_count = 0;
-            release_wake_lock(ANDROID_WAKE_LOCK_NAME);
-            ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
-            assert(ret == 0);
-        }
-    } else {
-        if (param == NULL) {
-            releaseWakeLock();
+wakeTimeoutCallback(int fd, short flags, void *param) {
+    struct timeval now;
+    struct timeval remaining;
+    int ret;
+
+    ret = pthread_mutex_lock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+
+    s_wakeTimeoutArmed = false;
+
+    if (s_wakelock_count > 0) {
+        getMonotonicNow(&now);
+        if (timercmp(&now, &s_wakeDeadline, <)) {
+            // Grabbed again since this was armed
+            timersub(&s_wakeDeadline, &now, &remaining);
+            ril_event_set(&s_wakeTimeoutEvent, -1, false, wakeTimeoutCallback, NULL);
+            ril_timer_add(&s_wakeTimeoutEvent, &remaining);
+            s_wakeTimeoutArmed = true;
+        } else {
+            s_wakeLockStats.timeoutCount++;
+            releaseWakeLockLocked();
         }
     }
+
+    ret = pthread_mutex_unlock(&s_wakeLockCountMutex);
+    assert(ret == 0);
+}
+
+/**
+ * Index of a Samsung unsolicited response in s_unsolResponses_v, -1 if unknown
+ */
+static int32_t
+vendorUnsolResponseIndex(int unsolResponse) {
+    return responseIndex(s_unsolResponses_v, (int32_t)NUM_ELEMS(s_unsolResponses_v),
+            s_numDenseUnsolResponses_v, SAMSUNG_UNSOL_RESPONSE_BASE, unsolResponse);
 }
 
 #if defined(ANDROID_MULTI_SIM)
@@ -789,21 +1089,7 @@ void RIL_onUnsolicitedResponse(int unsolResponse, const void *data,
     if (unsolResponse > SAMSUNG_UNSOL_RESPONSE_BASE) {
         pRI = s_unsolResponses_v;
         pRI_elements = (int32_t)NUM_ELEMS(s_unsolResponses_v);
-
-        /*
-         * Some of the vendor response codes cannot be found by calculating their index anymore,
-         * because they have an even higher offset and are not ordered in the array.
-         * Example: RIL_UNSOL_SNDMGR_WB_AMR_REPORT = 20017, but it's at index 33 in the vendor
-         * response array.
-         * Thus, look through all the vendor URIs (Unsol Response Info) and pick the correct index.
-         * This has a cost of O(N).
-         */
-        int pRI_index;
-        for (pRI_index = 0; pRI_index < pRI_elements; pRI_index++) {
-            if (pRI[pRI_index].requestNumber == unsolResponse) {
-                unsolResponseIndex = pRI_index;
-            }
-        }
+        unsolResponseIndex = vendorUnsolResponseIndex(unsolResponse);
 
         RLOGD("SAMSUNG: unsolResponse=%d, unsolResponseIndex=%d", unsolResponse, unsolResponseIndex);
     }
@@ -868,18 +1154,9 @@ void RIL_onUnsolicitedResponse(int unsolResponse, const void *data,
 
     if (s_callbacks.version < 13) {
         if (shouldScheduleTimeout) {
-            UserCallbackInfo *p_info = internalRequestTimedCallback(wakeTimeoutCallback, NULL,
-                    &TIMEVAL_WAKE_TIMEOUT);
-
-            if (p_info == NULL) {
-                goto error_exit;
-            } else {
-                // Cancel the previous request
-                if (s_last_wake_timeout_info != NULL) {
-                    s_last_wake_timeout_info->userParam = (void *)1;
-                }
-                s_last_wake_timeout_info = p_info;
-            }
+            // Older RIL.java doesn't ack unsolicited responses, so the timeout
+            // counts from the response rather than from the grab
+            armWakeTimeout();
         }
     }
 
@@ -16,6 +16,8 @@
 
 #include "pb_decode.h"
 #include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <hardware/ril/librilutils/proto/sap-api.pb.h>
 #include <utils/Log.h>
 
@@ -28,13 +30,23 @@ using namespace std;
  * <ul>
  *     <li>Enqueue.
  *     <li>Dequeue.
+ *     <li>Batch dequeue.
  *     <li>Check and dequeue.
  * </ul>
+ * <p>
+ * Elements are kept in FIFO order in a fixed ring of Capacity slots, indexed
+ * by (message id, token) so checkAndDequeue() does not walk the queue. When
+ * the ring is full, further elements wait in a list linked through p_next
+ * and move into the ring as it drains, so enqueue() never blocks or fails.
+ * T must provide token, curr->id and p_next.
  */
 
-template <typename T>
+template <typename T, size_t Capacity = 32>
 class Ril_queue {
 
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0 && Capacity <= INT16_MAX,
+            "Capacity must be a power of two that fits an int16_t");
+
    /**
      * Mutex attribute used in queue mutex initialization.
      */
@@ -51,21 +63,69 @@ class Ril_queue {
     pthread_cond_t cond;
 
    /**
-     * Front of the queue.
+     * Number of threads blocked on cond.
+     */
+    int waiters;
+
+   /**
+     * Ring of queued elements, oldest at head. Slots emptied by
+     * checkAndDequeue() are NULL until head moves past them; head itself
+     * never points at an empty slot while the ring is in use.
+     */
+    T *ring[Capacity];
+    size_t head;
+    size_t used;
+
+   /**
+     * Elements queued while the ring was full, oldest first.
+     */
+    T *overflowHead;
+    T *overflowTail;
+
+   /**
+     * Number of elements in the ring and the overflow list together.
+     */
+    size_t count;
+
+   /**
+     * Hash chains over the ring slots by (message id, token): bucket holds
+     * the first slot of each chain and chain the next one, -1 ending it.
      */
-    T *front;
+    int16_t bucket[Capacity];
+    int16_t chain[Capacity];
+
+    static size_t hash(MsgId id, int token) {
+        return ((size_t)id * 31 + (unsigned int)token) & (Capacity - 1);
+    }
+
+    void indexSlot(size_t slot);
+    void unindexSlot(size_t slot);
+    void pushLocked(T* request);
+    T* popLocked(void);
+    void compactLocked(void);
 
     public:
 
        /**
-         * Remove the first element of the queue.
+         * Remove the first element of the queue, waiting for one if the
+         * queue is empty.
          *
          * @return first element of the queue.
          */
         T* dequeue(void);
 
        /**
-         * Add a request to the front of the queue.
+         * Remove up to max elements from the front of the queue, waiting
+         * for at least one if the queue is empty.
+         *
+         * @param Array receiving the elements, oldest first.
+         * @param Size of the array.
+         * @return number of elements removed.
+         */
+        size_t dequeueBatch(T** requests, size_t max);
+
+       /**
+         * Add a request to the back of the queue.
          *
          * @param Request to be added.
          */
@@ -78,9 +138,12 @@ class Ril_queue {
 
        /**
          * Check and remove an element with a particular message id and token.
+         * If several match, the most recently enqueued one is removed. The
+         * element is only unlinked; releasing it is up to the caller.
          *
          * @param Request message id.
          * @param Request token.
+         * @return 1 if the element was found, 0 otherwise.
          */
         int checkAndDequeue( MsgId id, int token);
 
@@ -90,63 +153,184 @@ class Ril_queue {
         Ril_queue(void);
 };
 
-template <typename T>
-Ril_queue<T>::Ril_queue(void) {
+template <typename T, size_t Capacity>
+Ril_queue<T, Capacity>::Ril_queue(void) {
     pthread_mutexattr_init(&attr);
     pthread_mutex_init(&mutex_instance, &attr);
     cond = PTHREAD_COND_INITIALIZER;
-    front = NULL;
+    waiters = 0;
+    head = 0;
+    used = 0;
+    count = 0;
+    overflowHead = NULL;
+    overflowTail = NULL;
+    for (size_t i = 0; i < Capacity; i++) {
+        ring[i] = NULL;
+        bucket[i] = -1;
+        chain[i] = -1;
+    }
+}
+
+template <typename T, size_t Capacity>
+void Ril_queue<T, Capacity>::indexSlot(size_t slot) {
+    size_t h = hash(ring[slot]->curr->id, ring[slot]->token);
+
+    chain[slot] = bucket[h];
+    bucket[h] = slot;
+}
+
+template <typename T, size_t Capacity>
+void Ril_queue<T, Capacity>::unindexSlot(size_t slot) {
+    size_t h = hash(ring[slot]->curr->id, ring[slot]->token);
+
+    for (int16_t *pCur = &bucket[h]; *pCur != -1; pCur = &chain[*pCur]) {
+        if ((size_t)*pCur == slot) {
+            *pCur = chain[slot];
+            break;
+        }
+    }
+}
+
+template <typename T, size_t Capacity>
+void Ril_queue<T, Capacity>::pushLocked(T* request) {
+    size_t slot = (head + used) & (Capacity - 1);
+
+    ring[slot] = request;
+    indexSlot(slot);
+    used++;
+}
+
+template <typename T, size_t Capacity>
+void Ril_queue<T, Capacity>::compactLocked(void) {
+    // Drop emptied slots at the head, then move waiting elements in
+    while (used > 0 && ring[head] == NULL) {
+        head = (head + 1) & (Capacity - 1);
+        used--;
+    }
+
+    while (overflowHead != NULL && used < Capacity) {
+        T* request = overflowHead;
+
+        overflowHead = request->p_next;
+        if (overflowHead == NULL) {
+            overflowTail = NULL;
+        }
+        request->p_next = NULL;
+        pushLocked(request);
+    }
+}
+
+template <typename T, size_t Capacity>
+T* Ril_queue<T, Capacity>::popLocked(void) {
+    T* temp = ring[head];
+
+    unindexSlot(head);
+    ring[head] = NULL;
+    count--;
+    compactLocked();
+
+    return temp;
 }
 
-template <typename T>
-T* Ril_queue<T>::dequeue(void) {
+template <typename T, size_t Capacity>
+T* Ril_queue<T, Capacity>::dequeue(void) {
     T* temp = NULL;
 
     pthread_mutex_lock(&mutex_instance);
     while(empty()) {
+        waiters++;
         pthread_cond_wait(&cond, &mutex_instance);
+        waiters--;
     }
-    temp = this->front;
-    if(NULL != this->front->p_next) {
-        this->front = this->front->p_next;
-    } else {
-        this->front = NULL;
-    }
+    temp = popLocked();
     pthread_mutex_unlock(&mutex_instance);
 
     return temp;
 }
 
-template <typename T>
-void Ril_queue<T>::enqueue(T* request) {
+template <typename T, size_t Capacity>
+size_t Ril_queue<T, Capacity>::dequeueBatch(T** requests, size_t max) {
+    size_t n = 0;
 
     pthread_mutex_lock(&mutex_instance);
+    while(empty()) {
+        waiters++;
+        pthread_cond_wait(&cond, &mutex_instance);
+        waiters--;
+    }
+    while (n < max && !empty()) {
+        requests[n++] = popLocked();
+    }
+    pthread_mutex_unlock(&mutex_instance);
 
-    if(NULL == this->front) {
-        this->front = request;
-        request->p_next = NULL;
+    return n;
+}
+
+template <typename T, size_t Capacity>
+void Ril_queue<T, Capacity>::enqueue(T* request) {
+
+    pthread_mutex_lock(&mutex_instance);
+
+    request->p_next = NULL;
+    if (overflowHead == NULL && used < Capacity) {
+        pushLocked(request);
+    } else if (overflowHead == NULL) {
+        overflowHead = request;
+        overflowTail = request;
     } else {
-        request->p_next = this->front;
-        this->front = request;
+        overflowTail->p_next = request;
+        overflowTail = request;
+    }
+    count++;
+
+    // Each element can satisfy one waiter only
+    if (waiters > 0) {
+        pthread_cond_signal(&cond);
     }
-    pthread_cond_broadcast(&cond);
     pthread_mutex_unlock(&mutex_instance);
 }
 
-template <typename T>
-int Ril_queue<T>::checkAndDequeue(MsgId id, int token) {
+template <typename T, size_t Capacity>
+int Ril_queue<T, Capacity>::checkAndDequeue(MsgId id, int token) {
     int ret = 0;
-    T* temp;
+    T *match = NULL;
+    T *matchPrev = NULL;
 
     pthread_mutex_lock(&mutex_instance);
 
-    for(T **ppCur = &(this->front); *ppCur != NULL; ppCur = &((*ppCur)->p_next)) {
-        if (token == (*ppCur)->token && id == (*ppCur)->curr->id) {
+    // Like the list this replaced, remove the newest match if (id, token)
+    // is queued more than once. Elements still waiting for room in the ring
+    // are newer than any in it, and are not indexed, so look there first.
+    T *prev = NULL;
+    for (T *cur = overflowHead; cur != NULL; prev = cur, cur = cur->p_next) {
+        if (token == cur->token && id == cur->curr->id) {
+            match = cur;
+            matchPrev = prev;
+        }
+    }
+
+    if (match != NULL) {
+        ret = 1;
+        if (matchPrev == NULL) {
+            overflowHead = match->p_next;
+        } else {
+            matchPrev->p_next = match->p_next;
+        }
+        if (overflowTail == match) {
+            overflowTail = matchPrev;
+        }
+        count--;
+    }
+
+    // Slots are indexed in queue order at the front of their chain, so the
+    // first match in the chain is the newest one in the ring.
+    for (int16_t slot = bucket[hash(id, token)]; !ret && slot != -1; slot = chain[slot]) {
+        if (token == ring[slot]->token && id == ring[slot]->curr->id) {
             ret = 1;
-            temp = *ppCur;
-            *ppCur = (*ppCur)->p_next;
-            free(temp);
-            break;
+            unindexSlot(slot);
+            ring[slot] = NULL;
+            count--;
+            compactLocked();
         }
     }
 
@@ -156,10 +340,10 @@ int Ril_queue<T>::checkAndDequeue(MsgId id, int token) {
 }
 
 
-template <typename T>
-int Ril_queue<T>::empty(void) {
+template <typename T, size_t Capacity>
+int Ril_queue<T, Capacity>::empty(void) {
 
-    if(this->front == NULL) {
+    if(this->count == 0) {
         return 1;
     } else {
         return 0;
@@ -77,6 +77,8 @@ typedef struct RequestInfo {
     char local;         // responses to local commands do not go back to command process
     RIL_SOCKET_ID socket_id;
     int wasAckSent;    // Indicates whether an ack was sent earlier
+    int64_t submitTimeNs;   // CLOCK_MONOTONIC, set by addRequestToList()
+    int64_t ackTimeNs;      // CLOCK_MONOTONIC, 0 until RIL_onRequestAck()
 } RequestInfo;
 
 typedef struct CommandInfo {
@@ -91,6 +93,19 @@ char * RIL_getServiceName();
 
 void releaseWakeLock();
 
+typedef struct WakeLockStats {
+    int64_t grabCount;      // grabs, including ones on an already held lock
+    int64_t acquireCount;   // kernel acquisitions, i.e. 0 -> 1 transitions
+    int64_t timeoutCount;   // releases by timeout rather than by the last ack
+    int64_t heldMs;         // total hold time of completed holds
+    int64_t heldSinceMs;    // elapsedRealtime() the current hold began, 0 if not held
+} WakeLockStats;
+
+void getWakeLockStats(WakeLockStats *stats);
+
+/* Writes request latency histograms and the oldest pending requests to fd */
+void dumpRequestStats(int fd);
+
 void onNewCommandConnect(RIL_SOCKET_ID socket_id);
 
 }   // namespace android
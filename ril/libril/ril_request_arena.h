@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_RIL_REQUEST_ARENA_H
+#define ANDROID_RIL_REQUEST_ARENA_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Bump allocator for the temporary RIL-side copies of a request, one per binder thread.
+ * Allocations are only rewound by reset(); the chunks are kept, so owns() stays valid for the
+ * pointers of the request being torn down. Requests that outgrow the chunks fall back to calloc().
+ */
+class RequestArena {
+public:
+    RequestArena() : mNumChunks(0), mChunk(0), mUsed(0), mHeapAllocations(0) {}
+
+    ~RequestArena() {
+        for (int i = 0; i < mNumChunks; i++) {
+            free(mChunks[i]);
+        }
+    }
+
+    // Zeroed, or NULL if the arena is exhausted
+    void *alloc(size_t size) {
+        size = (size + kAlign - 1) & ~(kAlign - 1);
+        if (size > kChunkSize) {
+            return NULL;
+        }
+
+        if (mChunk < mNumChunks && mUsed + size > kChunkSize) {
+            mChunk++;
+            mUsed = 0;
+        }
+
+        if (mChunk == mNumChunks) {
+            if (mNumChunks == kMaxChunks) {
+                return NULL;
+            }
+            mChunks[mNumChunks] = (char *)malloc(kChunkSize);
+            if (mChunks[mNumChunks] == NULL) {
+                return NULL;
+            }
+            mNumChunks++;
+            mHeapAllocations++;
+        }
+
+        void *ptr = mChunks[mChunk] + mUsed;
+        mUsed += size;
+        memset(ptr, 0, size);
+        return ptr;
+    }
+
+    bool owns(const void *ptr) const {
+        for (int i = 0; i < mNumChunks; i++) {
+            if (ptr >= mChunks[i] && ptr < mChunks[i] + kChunkSize) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reset() {
+        mChunk = 0;
+        mUsed = 0;
+    }
+
+    // Chunks plus the calloc() fallbacks counted by countHeapAllocation()
+    size_t heapAllocations() const {
+        return mHeapAllocations;
+    }
+
+    void countHeapAllocation() {
+        mHeapAllocations++;
+    }
+
+private:
+    static const size_t kChunkSize = 4096;
+    static const size_t kAlign = sizeof(void *);
+    static const int kMaxChunks = 4;
+
+    char *mChunks[kMaxChunks];
+    int mNumChunks;
+    int mChunk;
+    size_t mUsed;
+    size_t mHeapAllocations;
+};
+
+/**
+ * Zeroed storage for count elements of size bytes, from the arena or from calloc() if it doesn't
+ * fit. NULL if out of memory.
+ */
+static inline void *requestArenaAlloc(RequestArena &arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+
+    void *ptr = arena.alloc(count * size);
+    if (ptr == NULL) {
+        ptr = calloc(count, size);
+        arena.countHeapAllocation();
+    }
+    return ptr;
+}
+
+// Arena allocations go away with the arena
+static inline void requestArenaFree(RequestArena &arena, void *ptr) {
+    if (!arena.owns(ptr)) {
+        free(ptr);
+    }
+}
+
+#endif /* ANDROID_RIL_REQUEST_ARENA_H */
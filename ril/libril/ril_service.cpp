@@ -22,6 +22,7 @@
 #include <hwbinder/IPCThreadState.h>
 #include <hwbinder/ProcessState.h>
 #include <ril_service.h>
+#include <ril_request_arena.h>
 #include <hidl/HidlTransportSupport.h>
 #include <utils/SystemClock.h>
 #include <inttypes.h>
@@ -40,6 +41,7 @@ using ::android::hardware::Return;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::Void;
 using android::CommandInfo;
 using android::RequestInfo;
@@ -50,15 +52,39 @@ using android::sp;
 #define ATOI_NULL_HANDLED(x) (x ? atoi(x) : -1)
 #define ATOI_NULL_HANDLED_DEF(x, defaultVal) (x ? atoi(x) : defaultVal)
 
+// The vendor RIL doesn't keep request data past onRequest(), so the request arena of this thread
+// is rewound as soon as it returns
 #if defined(ANDROID_MULTI_SIM)
 #define CALL_ONREQUEST(a, b, c, d, e) \
-        s_vendorFunctions->onRequest((a), (b), (c), (d), ((RIL_SOCKET_ID)(e)))
+        do { \
+            s_vendorFunctions->onRequest((a), (b), (c), (d), ((RIL_SOCKET_ID)(e))); \
+            s_requestArena.reset(); \
+        } while (0)
 #define CALL_ONSTATEREQUEST(a) s_vendorFunctions->onStateRequest((RIL_SOCKET_ID)(a))
 #else
-#define CALL_ONREQUEST(a, b, c, d, e) s_vendorFunctions->onRequest((a), (b), (c), (d))
+#define CALL_ONREQUEST(a, b, c, d, e) \
+        do { \
+            s_vendorFunctions->onRequest((a), (b), (c), (d)); \
+            s_requestArena.reset(); \
+        } while (0)
 #define CALL_ONSTATEREQUEST(a) s_vendorFunctions->onStateRequest()
 #endif
 
+// Request-side scratch memory of this binder thread, rewound by CALL_ONREQUEST
+static thread_local RequestArena s_requestArena;
+
+/**
+ * Zeroed storage for a request that is released with freeRequestMemory() once the request is torn
+ * down, or NULL if out of memory.
+ */
+static void *allocRequestMemory(size_t count, size_t size) {
+    return requestArenaAlloc(s_requestArena, count, size);
+}
+
+static void freeRequestMemory(void *ptr) {
+    requestArenaFree(s_requestArena, ptr);
+}
+
 #ifdef OEM_HOOK_DISABLED
 constexpr bool kOemHookEnabled = false;
 #else
@@ -132,6 +158,8 @@ struct RadioImpl : public IRadio {
             const ::android::sp<IRadioResponse>& radioResponse,
             const ::android::sp<IRadioIndication>& radioIndication);
 
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options);
+
     Return<void> getIccCardStatus(int32_t serial);
 
     Return<void> supplyIccPinForApp(int32_t serial, const hidl_string& pin,
@@ -478,7 +506,7 @@ void memsetAndFreeStrings(int numPointers, ...) {
             // TODO: Should pass in the maximum length of the string
             memsetString(ptr);
 #endif
-            free(ptr);
+            freeRequestMemory(ptr);
         }
     }
     va_end(ap);
@@ -504,7 +532,7 @@ bool copyHidlStringToRil(char **dest, const hidl_string &src, RequestInfo *pRI,
         *dest = NULL;
         return true;
     }
-    *dest = (char *) calloc(len + 1, sizeof(char));
+    *dest = (char *) allocRequestMemory(len + 1, sizeof(char));
     if (*dest == NULL) {
         RLOGE("Memory allocation failed for request %s", requestToString(pRI->pCI->requestNumber));
         sendErrorResponse(pRI, RIL_E_NO_MEMORY);
@@ -565,7 +593,7 @@ bool dispatchStrings(int serial, int slotId, int request, bool allowEmpty, int c
     }
 
     char **pStrings;
-    pStrings = (char **)calloc(countStrings, sizeof(char *));
+    pStrings = (char **)allocRequestMemory(countStrings, sizeof(char *));
     if (pStrings == NULL) {
         RLOGE("Memory allocation failed for request %s", requestToString(request));
         sendErrorResponse(pRI, RIL_E_NO_MEMORY);
@@ -580,7 +608,7 @@ bool dispatchStrings(int serial, int slotId, int request, bool allowEmpty, int c
             for (int j = 0; j < i; j++) {
                 memsetAndFreeStrings(1, pStrings[j]);
             }
-            free(pStrings);
+            freeRequestMemory(pStrings);
             return false;
         }
     }
@@ -596,7 +624,7 @@ bool dispatchStrings(int serial, int slotId, int request, bool allowEmpty, int c
 #ifdef MEMSET_FREED
         memset(pStrings, 0, countStrings * sizeof(char *));
 #endif
-        free(pStrings);
+        freeRequestMemory(pStrings);
     }
     return true;
 }
@@ -609,7 +637,7 @@ bool dispatchStrings(int serial, int slotId, int request, const hidl_vec<hidl_st
 
     int countStrings = data.size();
     char **pStrings;
-    pStrings = (char **)calloc(countStrings, sizeof(char *));
+    pStrings = (char **)allocRequestMemory(countStrings, sizeof(char *));
     if (pStrings == NULL) {
         RLOGE("Memory allocation failed for request %s", requestToString(request));
         sendErrorResponse(pRI, RIL_E_NO_MEMORY);
@@ -621,7 +649,7 @@ bool dispatchStrings(int serial, int slotId, int request, const hidl_vec<hidl_st
             for (int j = 0; j < i; j++) {
                 memsetAndFreeStrings(1, pStrings[j]);
             }
-            free(pStrings);
+            freeRequestMemory(pStrings);
             return false;
         }
     }
@@ -636,7 +664,7 @@ bool dispatchStrings(int serial, int slotId, int request, const hidl_vec<hidl_st
 #ifdef MEMSET_FREED
         memset(pStrings, 0, countStrings * sizeof(char *));
 #endif
-        free(pStrings);
+        freeRequestMemory(pStrings);
     }
     return true;
 }
@@ -647,7 +675,7 @@ bool dispatchInts(int serial, int slotId, int request, int countInts, ...) {
         return false;
     }
 
-    int *pInts = (int *)calloc(countInts, sizeof(int));
+    int *pInts = (int *)allocRequestMemory(countInts, sizeof(int));
 
     if (pInts == NULL) {
         RLOGE("Memory allocation failed for request %s", requestToString(request));
@@ -667,7 +695,7 @@ bool dispatchInts(int serial, int slotId, int request, int countInts, ...) {
 #ifdef MEMSET_FREED
         memset(pInts, 0, countInts * sizeof(int));
 #endif
-        free(pInts);
+        freeRequestMemory(pInts);
     }
     return true;
 }
@@ -806,6 +834,25 @@ Return<void> RadioImpl::setResponseFunctions(
     return Void();
 }
 
+Return<void> RadioImpl::debug(const hidl_handle& fd, const hidl_vec<hidl_string>& /*options*/) {
+    if (fd.getNativeHandle() == nullptr || fd->numFds < 1) {
+        return Void();
+    }
+
+    int dumpFd = fd->data[0];
+    android::WakeLockStats wakeLockStats;
+
+    android::getWakeLockStats(&wakeLockStats);
+    dprintf(dumpFd, "Wake lock: grabs=%" PRId64 " acquires=%" PRId64 " timeouts=%" PRId64
+            " held=%" PRId64 "ms%s\n", wakeLockStats.grabCount, wakeLockStats.acquireCount,
+            wakeLockStats.timeoutCount, wakeLockStats.heldMs,
+            wakeLockStats.heldSinceMs != 0 ? " (held now)" : "");
+
+    android::dumpRequestStats(dumpFd);
+
+    return Void();
+}
+
 Return<void> RadioImpl::getIccCardStatus(int32_t serial) {
 #if VDBG
     RLOGD("getIccCardStatus: serial %d", serial);
@@ -2044,7 +2091,7 @@ bool dispatchImsGsmSms(const ImsSmsMessage& message, RequestInfo *pRI) {
         return false;
     }
 
-    pStrings = (char **)calloc(countStrings, sizeof(char *));
+    pStrings = (char **)allocRequestMemory(countStrings, sizeof(char *));
     if (pStrings == NULL) {
         RLOGE("dispatchImsGsmSms: Memory allocation failed for request %s",
                 requestToString(pRI->pCI->requestNumber));
@@ -2056,7 +2103,7 @@ bool dispatchImsGsmSms(const ImsSmsMessage& message, RequestInfo *pRI) {
 #ifdef MEMSET_FREED
         memset(pStrings, 0, datalen);
 #endif
-        free(pStrings);
+        freeRequestMemory(pStrings);
         return false;
     }
 
@@ -2065,7 +2112,7 @@ bool dispatchImsGsmSms(const ImsSmsMessage& message, RequestInfo *pRI) {
 #ifdef MEMSET_FREED
         memset(pStrings, 0, datalen);
 #endif
-        free(pStrings);
+        freeRequestMemory(pStrings);
         return false;
     }
 
@@ -2080,7 +2127,7 @@ bool dispatchImsGsmSms(const ImsSmsMessage& message, RequestInfo *pRI) {
 #ifdef MEMSET_FREED
     memset(pStrings, 0, datalen);
 #endif
-    free(pStrings);
+    freeRequestMemory(pStrings);
 
     return true;
 }
@@ -2351,8 +2398,8 @@ void freeSetDataProfileData(int numProfiles, T *dataProfiles, T **dataProfilePtr
     memset(dataProfiles, 0, numProfiles * sizeof(T));
     memset(dataProfilePtrs, 0, numProfiles * sizeof(T *));
 #endif
-    free(dataProfiles);
-    free(dataProfilePtrs);
+    freeRequestMemory(dataProfiles);
+    freeRequestMemory(dataProfilePtrs);
 }
 
 Return<void> RadioImpl::setDataProfile(int32_t serial, const hidl_vec<DataProfileInfo>& profiles,
@@ -2371,7 +2418,7 @@ Return<void> RadioImpl::setDataProfile(int32_t serial, const hidl_vec<DataProfil
     if (s_vendorFunctions->version <= 14) {
 
         RIL_DataProfileInfo *dataProfiles =
-            (RIL_DataProfileInfo *) calloc(num, sizeof(RIL_DataProfileInfo));
+            (RIL_DataProfileInfo *) allocRequestMemory(num, sizeof(RIL_DataProfileInfo));
 
         if (dataProfiles == NULL) {
             RLOGE("Memory allocation failed for request %s",
@@ -2381,11 +2428,11 @@ Return<void> RadioImpl::setDataProfile(int32_t serial, const hidl_vec<DataProfil
         }
 
         RIL_DataProfileInfo **dataProfilePtrs =
-            (RIL_DataProfileInfo **) calloc(num, sizeof(RIL_DataProfileInfo *));
+            (RIL_DataProfileInfo **) allocRequestMemory(num, sizeof(RIL_DataProfileInfo *));
         if (dataProfilePtrs == NULL) {
             RLOGE("Memory allocation failed for request %s",
                     requestToString(pRI->pCI->requestNumber));
-            free(dataProfiles);
+            freeRequestMemory(dataProfiles);
             sendErrorResponse(pRI, RIL_E_NO_MEMORY);
             return Void();
         }
@@ -2435,7 +2482,7 @@ Return<void> RadioImpl::setDataProfile(int32_t serial, const hidl_vec<DataProfil
                 &RIL_DataProfileInfo::user, &RIL_DataProfileInfo::password);
     } else {
         RIL_DataProfileInfo_v15 *dataProfiles =
-            (RIL_DataProfileInfo_v15 *) calloc(num, sizeof(RIL_DataProfileInfo_v15));
+            (RIL_DataProfileInfo_v15 *) allocRequestMemory(num, sizeof(RIL_DataProfileInfo_v15));
 
         if (dataProfiles == NULL) {
             RLOGE("Memory allocation failed for request %s",
@@ -2445,11 +2492,11 @@ Return<void> RadioImpl::setDataProfile(int32_t serial, const hidl_vec<DataProfil
         }
 
         RIL_DataProfileInfo_v15 **dataProfilePtrs =
-            (RIL_DataProfileInfo_v15 **) calloc(num, sizeof(RIL_DataProfileInfo_v15 *));
+            (RIL_DataProfileInfo_v15 **) allocRequestMemory(num, sizeof(RIL_DataProfileInfo_v15 *));
         if (dataProfilePtrs == NULL) {
             RLOGE("Memory allocation failed for request %s",
                     requestToString(pRI->pCI->requestNumber));
-            free(dataProfiles);
+            freeRequestMemory(dataProfiles);
             sendErrorResponse(pRI, RIL_E_NO_MEMORY);
             return Void();
         }
@@ -2606,7 +2653,8 @@ Return<void> RadioImpl::setAllowedCarriers(int32_t serial, bool allAllowed,
     RIL_Carrier *excludedCarriers = NULL;
 
     cr.len_allowed_carriers = carriers.allowedCarriers.size();
-    allowedCarriers = (RIL_Carrier *)calloc(cr.len_allowed_carriers, sizeof(RIL_Carrier));
+    allowedCarriers = (RIL_Carrier *)allocRequestMemory(cr.len_allowed_carriers,
+            sizeof(RIL_Carrier));
     if (allowedCarriers == NULL) {
         RLOGE("setAllowedCarriers: Memory allocation failed for request %s",
                 requestToString(pRI->pCI->requestNumber));
@@ -2616,7 +2664,8 @@ Return<void> RadioImpl::setAllowedCarriers(int32_t serial, bool allAllowed,
     cr.allowed_carriers = allowedCarriers;
 
     cr.len_excluded_carriers = carriers.excludedCarriers.size();
-    excludedCarriers = (RIL_Carrier *)calloc(cr.len_excluded_carriers, sizeof(RIL_Carrier));
+    excludedCarriers = (RIL_Carrier *)allocRequestMemory(cr.len_excluded_carriers,
+            sizeof(RIL_Carrier));
     if (excludedCarriers == NULL) {
         RLOGE("setAllowedCarriers: Memory allocation failed for request %s",
                 requestToString(pRI->pCI->requestNumber));
@@ -2624,7 +2673,7 @@ Return<void> RadioImpl::setAllowedCarriers(int32_t serial, bool allAllowed,
 #ifdef MEMSET_FREED
         memset(allowedCarriers, 0, cr.len_allowed_carriers * sizeof(RIL_Carrier));
 #endif
-        free(allowedCarriers);
+        freeRequestMemory(allowedCarriers);
         return Void();
     }
     cr.excluded_carriers = excludedCarriers;
@@ -2650,8 +2699,8 @@ Return<void> RadioImpl::setAllowedCarriers(int32_t serial, bool allAllowed,
     memset(allowedCarriers, 0, cr.len_allowed_carriers * sizeof(RIL_Carrier));
     memset(excludedCarriers, 0, cr.len_excluded_carriers * sizeof(RIL_Carrier));
 #endif
-    free(allowedCarriers);
-    free(excludedCarriers);
+    freeRequestMemory(allowedCarriers);
+    freeRequestMemory(excludedCarriers);
     return Void();
 }
 
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_RIL_UNSOL_INDEX_H
+#define ANDROID_RIL_UNSOL_INDEX_H
+
+#include <stdint.h>
+
+/**
+ * Length of the leading block of table where
+ * index == table[index].requestNumber - base.
+ */
+template <typename T>
+static int32_t
+denseResponseCount(const T *table, int32_t count, int base) {
+    int32_t dense = 0;
+
+    while (dense < count && table[dense].requestNumber == base + dense) {
+        dense++;
+    }
+
+    return dense;
+}
+
+/**
+ * Index of code in table, -1 if unknown. Codes in the dense block are
+ * looked up directly. Some of the vendor response codes cannot be found by
+ * calculating their index, because they have an even higher offset. They
+ * follow the dense block.
+ * Example: RIL_UNSOL_SNDMGR_WB_AMR_REPORT = 20017, but it's at index 33 in the vendor
+ * response array.
+ */
+template <typename T>
+static int32_t
+responseIndex(const T *table, int32_t count, int32_t dense, int base, int code) {
+    int32_t index = code - base;
+
+    if (index >= 0 && index < dense) {
+        return index;
+    }
+
+    for (index = dense; index < count; index++) {
+        if (table[index].requestNumber == code) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+#endif /* ANDROID_RIL_UNSOL_INDEX_H */
@@ -65,9 +65,8 @@ struct SapImpl : public ISap {
 
     Return<void> setTransferProtocolReq(int32_t token, SapTransferProtocol transferProtocol);
 
-    MsgHeader* createMsgHeader(MsgId msgId, int32_t token);
-
-    Return<void> addPayloadAndDispatchRequest(MsgHeader *msg, uint16_t reqLen, uint8_t *reqPtr);
+    Return<void> encodeAndDispatchRequest(MsgId msgId, int32_t token, const pb_field_t fields[],
+            const void *req);
 
     void sendFailedResponse(MsgId msgId, int32_t token, int numPointers, ...);
 
@@ -91,42 +90,59 @@ Return<void> SapImpl::setCallback(const ::android::sp<ISapCallback>& sapCallback
     return Void();
 }
 
-MsgHeader* SapImpl::createMsgHeader(MsgId msgId, int32_t token) {
-    // Memory for msg will be freed by RilSapSocket::onRequestComplete()
-    MsgHeader *msg = (MsgHeader *)calloc(1, sizeof(MsgHeader));
-    if (msg == NULL) {
-        return NULL;
-    }
-    msg->token = token;
-    msg->type = MsgType_REQUEST;
-    msg->id = msgId;
-    msg->error = Error_RIL_E_SUCCESS;
-    return msg;
-}
+Return<void> SapImpl::encodeAndDispatchRequest(MsgId msgId, int32_t token,
+        const pb_field_t fields[], const void *req) {
+    // Requests are encoded in a single pass straight into a per-thread
+    // payload buffer. Only messages that do not fit it are sized and
+    // encoded a second time into a heap buffer.
+    static thread_local SapPayloadBuffer sPayloadBuffer;
+    pb_bytes_array_t *payload = &sPayloadBuffer.array;
+    pb_bytes_array_t *heapPayload = NULL;
+
+    pb_ostream_t stream = pb_ostream_from_buffer(payload->bytes, SAP_INLINE_PAYLOAD_SIZE);
+    if (!pb_encode(&stream, fields, req)) {
+        size_t encodedSize = 0;
+        if (!pb_get_encoded_size(&encodedSize, fields, req)) {
+            RLOGE("SapImpl::encodeAndDispatchRequest: Error getting encoded size for msg %d",
+                    msgId);
+            sendFailedResponse(msgId, token, 0);
+            return Void();
+        }
 
-Return<void> SapImpl::addPayloadAndDispatchRequest(MsgHeader *msg, uint16_t reqLen,
-        uint8_t *reqPtr) {
-    pb_bytes_array_t *payload = (pb_bytes_array_t *) malloc(sizeof(pb_bytes_array_t) - 1 + reqLen);
-    if (payload == NULL) {
-        sendFailedResponse(msg->id, msg->token, 2, reqPtr, msg);
-        return Void();
+        heapPayload = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 + encodedSize);
+        if (heapPayload == NULL) {
+            RLOGE("SapImpl::encodeAndDispatchRequest: Error allocating memory for buffer");
+            sendFailedResponse(msgId, token, 0);
+            return Void();
+        }
+        payload = heapPayload;
+
+        stream = pb_ostream_from_buffer(payload->bytes, encodedSize);
+        if (!pb_encode(&stream, fields, req)) {
+            RLOGE("SapImpl::encodeAndDispatchRequest: Error encoding msg %d", msgId);
+            sendFailedResponse(msgId, token, 1, heapPayload);
+            return Void();
+        }
     }
+    payload->size = stream.bytes_written;
 
-    msg->payload = payload;
-    msg->payload->size = reqLen;
-    memcpy(msg->payload->bytes, reqPtr, reqLen);
+    /* encoded req is payload; dispatchRequest() keeps its own copy of msg */
+    MsgHeader msg;
+    msg.token = token;
+    msg.type = MsgType_REQUEST;
+    msg.id = msgId;
+    msg.error = Error_RIL_E_SUCCESS;
+    msg.payload = payload;
 
     RilSapSocket *sapSocket = RilSapSocket::getSocketById(rilSocketId);
     if (sapSocket) {
-        RLOGD("SapImpl::addPayloadAndDispatchRequest: calling dispatchRequest");
-        sapSocket->dispatchRequest(msg);
+        sapSocket->dispatchRequest(&msg);
     } else {
-        RLOGE("SapImpl::addPayloadAndDispatchRequest: sapSocket is null");
-        sendFailedResponse(msg->id, msg->token, 3, payload, reqPtr, msg);
+        RLOGE("SapImpl::encodeAndDispatchRequest: sapSocket is null");
+        sendFailedResponse(msgId, token, 1, heapPayload);
         return Void();
     }
-    free(msg->payload);
-    free(reqPtr);
+    free(heapPayload);
     return Void();
 }
 
@@ -186,350 +202,116 @@ void SapImpl::sendFailedResponse(MsgId msgId, int32_t token, int numPointers, ..
 
 Return<void> SapImpl::connectReq(int32_t token, int32_t maxMsgSize) {
     RLOGD("SapImpl::connectReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_CONNECT, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::connectReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_CONNECT_REQ *****/
     RIL_SIM_SAP_CONNECT_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_CONNECT_REQ));
     req.max_message_size = maxMsgSize;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_CONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::connectReq: Error getting encoded size for RIL_SIM_SAP_CONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::connectReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 1, msg);
-        return Void();
-    }
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::connectReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_CONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::connectReq: Error encoding RIL_SIM_SAP_CONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_CONNECT, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_CONNECT_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_CONNECT, token,
+            RIL_SIM_SAP_CONNECT_REQ_fields, &req);
 }
 
 Return<void> SapImpl::disconnectReq(int32_t token) {
     RLOGD("SapImpl::disconnectReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_DISCONNECT, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::disconnectReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_DISCONNECT_REQ *****/
     RIL_SIM_SAP_DISCONNECT_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_DISCONNECT_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_DISCONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::disconnectReq: Error getting encoded size for RIL_SIM_SAP_DISCONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::disconnectReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::disconnectReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_DISCONNECT_REQ_fields, &req)) {
-        RLOGE("SapImpl::disconnectReq: Error encoding RIL_SIM_SAP_DISCONNECT_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_DISCONNECT, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_DISCONNECT_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_DISCONNECT, token,
+            RIL_SIM_SAP_DISCONNECT_REQ_fields, &req);
 }
 
 Return<void> SapImpl::apduReq(int32_t token, SapApduType type, const hidl_vec<uint8_t>& command) {
     RLOGD("SapImpl::apduReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_APDU, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::apduReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_APDU_REQ *****/
     RIL_SIM_SAP_APDU_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_APDU_REQ));
     req.type = (RIL_SIM_SAP_APDU_REQ_Type)type;
 
+    // The command is only read while encoding; small ones are staged per
+    // thread rather than on the heap.
+    static thread_local SapPayloadBuffer sCommandBuffer;
+    pb_bytes_array_t *heapCommand = NULL;
     if (command.size() > 0) {
-        req.command = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 + command.size());
-        if (req.command == NULL) {
-            RLOGE("SapImpl::apduReq: Error allocating memory for req.command");
-            sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 1, msg);
-            return Void();
+        if (command.size() <= SAP_INLINE_PAYLOAD_SIZE) {
+            req.command = &sCommandBuffer.array;
+        } else {
+            heapCommand = (pb_bytes_array_t *)malloc(sizeof(pb_bytes_array_t) - 1 +
+                    command.size());
+            if (heapCommand == NULL) {
+                RLOGE("SapImpl::apduReq: Error allocating memory for req.command");
+                sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 0);
+                return Void();
+            }
+            req.command = heapCommand;
         }
         req.command->size = command.size();
         memcpy(req.command->bytes, command.data(), command.size());
     }
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_APDU_REQ_fields, &req)) {
-        RLOGE("SapImpl::apduReq: Error getting encoded size for RIL_SIM_SAP_APDU_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 2, req.command, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::apduReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 2, req.command, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::apduReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_APDU_REQ_fields, &req)) {
-        RLOGE("SapImpl::apduReq: Error encoding RIL_SIM_SAP_APDU_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_APDU, token, 3, req.command, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_APDU_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_APDU, token, RIL_SIM_SAP_APDU_REQ_fields, &req);
+    free(heapCommand);
+    return Void();
 }
 
 Return<void> SapImpl::transferAtrReq(int32_t token) {
     RLOGD("SapImpl::transferAtrReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::transferAtrReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_TRANSFER_ATR_REQ *****/
     RIL_SIM_SAP_TRANSFER_ATR_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_TRANSFER_ATR_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferAtrReq: Error getting encoded size for "
-                "RIL_SIM_SAP_TRANSFER_ATR_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::transferAtrReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::transferAtrReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferAtrReq: Error encoding RIL_SIM_SAP_TRANSFER_ATR_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_TRANSFER_ATR_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_TRANSFER_ATR, token,
+            RIL_SIM_SAP_TRANSFER_ATR_REQ_fields, &req);
 }
 
 Return<void> SapImpl::powerReq(int32_t token, bool state) {
     RLOGD("SapImpl::powerReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_POWER, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::powerReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_POWER_REQ *****/
     RIL_SIM_SAP_POWER_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_POWER_REQ));
     req.state = state;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_POWER_REQ_fields, &req)) {
-        RLOGE("SapImpl::powerReq: Error getting encoded size for RIL_SIM_SAP_POWER_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::powerReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::powerReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_POWER_REQ_fields, &req)) {
-        RLOGE("SapImpl::powerReq: Error encoding RIL_SIM_SAP_POWER_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_POWER, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_POWER_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_POWER, token,
+            RIL_SIM_SAP_POWER_REQ_fields, &req);
 }
 
 Return<void> SapImpl::resetSimReq(int32_t token) {
     RLOGD("SapImpl::resetSimReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_RESET_SIM, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::resetSimReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_RESET_SIM_REQ *****/
     RIL_SIM_SAP_RESET_SIM_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_RESET_SIM_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_RESET_SIM_REQ_fields, &req)) {
-        RLOGE("SapImpl::resetSimReq: Error getting encoded size for RIL_SIM_SAP_RESET_SIM_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::resetSimReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::resetSimReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_RESET_SIM_REQ_fields, &req)) {
-        RLOGE("SapImpl::resetSimReq: Error encoding RIL_SIM_SAP_RESET_SIM_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_RESET_SIM, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_RESET_SIM_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_RESET_SIM, token,
+            RIL_SIM_SAP_RESET_SIM_REQ_fields, &req);
 }
 
 Return<void> SapImpl::transferCardReaderStatusReq(int32_t token) {
     RLOGD("SapImpl::transferCardReaderStatusReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ *****/
     RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ));
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields,
-            &req)) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error getting encoded size for "
-                "RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::transferCardReaderStatusReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields, &req)) {
-        RLOGE("SapImpl::transferCardReaderStatusReq: Error encoding "
-                "RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS, token,
+            RIL_SIM_SAP_TRANSFER_CARD_READER_STATUS_REQ_fields, &req);
 }
 
 Return<void> SapImpl::setTransferProtocolReq(int32_t token, SapTransferProtocol transferProtocol) {
     RLOGD("SapImpl::setTransferProtocolReq");
-    MsgHeader *msg = createMsgHeader(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token);
-    if (msg == NULL) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error allocating memory for msg");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 0);
-        return Void();
-    }
 
     /***** Encode RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ *****/
     RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ req;
     memset(&req, 0, sizeof(RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ));
     req.protocol = (RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_Protocol)transferProtocol;
 
-    size_t encodedSize = 0;
-    if (!pb_get_encoded_size(&encodedSize, RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req)) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error getting encoded size for "
-                "RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 1, msg);
-        return Void();
-    }
-
-    uint8_t *buffer = (uint8_t *)calloc(1, encodedSize);
-    if (buffer == NULL) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error allocating memory for buffer");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 1, msg);
-        return Void();
-    }
-
-    pb_ostream_t stream = pb_ostream_from_buffer(buffer, encodedSize);
-
-    RLOGD("SapImpl::setTransferProtocolReq calling pb_encode");
-    if (!pb_encode(&stream, RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req)) {
-        RLOGE("SapImpl::setTransferProtocolReq: Error encoding "
-                "RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ");
-        sendFailedResponse(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token, 2, buffer, msg);
-        return Void();
-    }
-    /***** Encode RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ done *****/
-
-    /* encoded req is payload */
-    return addPayloadAndDispatchRequest(msg, stream.bytes_written, buffer);
+    return encodeAndDispatchRequest(MsgId_RIL_SIM_SAP_SET_TRANSFER_PROTOCOL, token,
+            RIL_SIM_SAP_SET_TRANSFER_PROTOCOL_REQ_fields, &req);
 }
 
 void *sapDecodeMessage(MsgId msgId, MsgType msgType, uint8_t *payloadPtr, size_t payloadLen) {
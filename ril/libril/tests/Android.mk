@@ -0,0 +1,59 @@
+# Copyright (C) 2024 The LineageOS Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libril_unsol_index_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_SRC_FILES := \
+    ril_unsol_index_test.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(LOCAL_PATH)/../include \
+    hardware/ril/include
+
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libril_socket_queue_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_VENDOR_MODULE := true
+LOCAL_SRC_FILES := \
+    rilSocketQueue_test.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    liblog \
+    librilutils
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    external/nanopb-c
+
+include $(BUILD_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := libril_request_arena_benchmark
+LOCAL_MODULE_TAGS := optional
+LOCAL_VENDOR_MODULE := true
+LOCAL_SRC_FILES := \
+    ril_request_arena_benchmark.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/..
+
+include $(BUILD_NATIVE_BENCHMARK)
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rilSocketQueue.h"
+
+// Same members Ril_queue uses from SapSocketRequest
+struct Request {
+    int token;
+    MsgHeader *curr;
+    Request *p_next;
+};
+
+// A small ring keeps the overflow list busy
+typedef Ril_queue<Request, 8> TestQueue;
+
+class RilSocketQueueTest : public ::testing::Test {
+protected:
+    Request *request(MsgId id, int token)
+    {
+        std::unique_ptr<MsgHeader> header(new MsgHeader());
+        std::unique_ptr<Request> r(new Request());
+
+        header->id = id;
+        r->token = token;
+        r->curr = header.get();
+        r->p_next = NULL;
+
+        mHeaders.push_back(std::move(header));
+        mRequests.push_back(std::move(r));
+        return mRequests.back().get();
+    }
+
+    static MsgId randomId(void)
+    {
+        return rand() % 2 ? MsgId_RIL_SIM_SAP_CONNECT : MsgId_RIL_SIM_SAP_DISCONNECT;
+    }
+
+    /*
+     * Runs random operations against the queue and a std::deque model,
+     * oldest at its front. checkAndDequeue() must remove the newest match,
+     * which the model finds from its back; every dequeue then shows
+     * whether the right one went.
+     */
+    void runModel(TestQueue &q, int ops, int tokens)
+    {
+        std::deque<Request *> model;
+        int next = 0;
+
+        for (int i = 0; i < ops; i++) {
+            int op = rand() % 4;
+
+            if (op <= 1 || model.empty()) {
+                Request *r = request(randomId(), tokens ? rand() % tokens : next++);
+                q.enqueue(r);
+                model.push_back(r);
+            } else if (op == 2 && rand() % 2) {
+                ASSERT_EQ(model.front(), q.dequeue()) << "op " << i;
+                model.pop_front();
+            } else if (op == 2) {
+                Request *batch[3];
+                size_t n = q.dequeueBatch(batch, 3);
+
+                ASSERT_EQ(std::min<size_t>(3, model.size()), n) << "op " << i;
+                for (size_t k = 0; k < n; k++) {
+                    ASSERT_EQ(model.front(), batch[k]) << "op " << i;
+                    model.pop_front();
+                }
+            } else {
+                Request *pick = model[rand() % model.size()];
+                MsgId id = rand() % 5 ? pick->curr->id : randomId();
+                int token = rand() % 5 ? pick->token : -1;
+                auto match = std::find_if(model.rbegin(), model.rend(), [&](Request *r) {
+                    return r->token == token && r->curr->id == id;
+                });
+
+                ASSERT_EQ(match != model.rend(), q.checkAndDequeue(id, token)) << "op " << i;
+                if (match != model.rend())
+                    model.erase(std::next(match).base());
+            }
+
+            ASSERT_EQ(model.empty(), q.empty() != 0) << "op " << i;
+        }
+
+        while (!model.empty()) {
+            ASSERT_EQ(model.front(), q.dequeue());
+            model.pop_front();
+        }
+        EXPECT_TRUE(q.empty());
+    }
+
+    std::vector<std::unique_ptr<MsgHeader>> mHeaders;
+    std::vector<std::unique_ptr<Request>> mRequests;
+};
+
+TEST_F(RilSocketQueueTest, FifoThroughOverflow)
+{
+    TestQueue q;
+    std::vector<Request *> queued;
+
+    for (int i = 0; i < 20; i++) {
+        queued.push_back(request(MsgId_RIL_SIM_SAP_CONNECT, i));
+        q.enqueue(queued.back());
+    }
+    for (int i = 0; i < 20; i++)
+        ASSERT_EQ(queued[i], q.dequeue());
+    EXPECT_TRUE(q.empty());
+}
+
+TEST_F(RilSocketQueueTest, CheckAndDequeueMatchesIdAndToken)
+{
+    TestQueue q;
+    Request *a = request(MsgId_RIL_SIM_SAP_CONNECT, 1);
+    Request *b = request(MsgId_RIL_SIM_SAP_DISCONNECT, 1);
+
+    q.enqueue(a);
+    q.enqueue(b);
+
+    EXPECT_EQ(0, q.checkAndDequeue(MsgId_RIL_SIM_SAP_CONNECT, 2));
+    EXPECT_EQ(1, q.checkAndDequeue(MsgId_RIL_SIM_SAP_DISCONNECT, 1));
+    EXPECT_EQ(0, q.checkAndDequeue(MsgId_RIL_SIM_SAP_DISCONNECT, 1));
+    EXPECT_EQ(a, q.dequeue());
+    EXPECT_TRUE(q.empty());
+}
+
+TEST_F(RilSocketQueueTest, DuplicateRemovesNewest)
+{
+    TestQueue q;
+    Request *older = request(MsgId_RIL_SIM_SAP_CONNECT, 7);
+    Request *newer = request(MsgId_RIL_SIM_SAP_CONNECT, 7);
+
+    q.enqueue(older);
+    q.enqueue(newer);
+
+    ASSERT_EQ(1, q.checkAndDequeue(MsgId_RIL_SIM_SAP_CONNECT, 7));
+    EXPECT_EQ(older, q.dequeue());
+}
+
+TEST_F(RilSocketQueueTest, DuplicateInOverflowRemovesNewest)
+{
+    Ril_queue<Request, 2> q;
+    Request *ring = request(MsgId_RIL_SIM_SAP_CONNECT, 7);
+    Request *other = request(MsgId_RIL_SIM_SAP_CONNECT, 8);
+    Request *first = request(MsgId_RIL_SIM_SAP_CONNECT, 7);
+    Request *second = request(MsgId_RIL_SIM_SAP_CONNECT, 7);
+
+    // ring holds the first two, the other two wait behind them
+    q.enqueue(ring);
+    q.enqueue(other);
+    q.enqueue(first);
+    q.enqueue(second);
+
+    ASSERT_EQ(1, q.checkAndDequeue(MsgId_RIL_SIM_SAP_CONNECT, 7));
+    ASSERT_EQ(1, q.checkAndDequeue(MsgId_RIL_SIM_SAP_CONNECT, 7));
+    EXPECT_EQ(ring, q.dequeue());
+    EXPECT_EQ(other, q.dequeue());
+    EXPECT_TRUE(q.empty());
+}
+
+TEST_F(RilSocketQueueTest, ModelUniqueTokens)
+{
+    TestQueue q;
+
+    srand(1);
+    runModel(q, 200000, 0);
+}
+
+TEST_F(RilSocketQueueTest, ModelDuplicateTokens)
+{
+    TestQueue q;
+
+    srand(2);
+    runModel(q, 200000, 4);
+}
+
+TEST_F(RilSocketQueueTest, DequeueWaitsForEnqueue)
+{
+    TestQueue q;
+    Request *r = request(MsgId_RIL_SIM_SAP_CONNECT, 1);
+    Request *got = NULL;
+    std::thread waiter([&]() { got = q.dequeue(); });
+
+    // the waiter may or may not be blocked yet; either way it gets r
+    q.enqueue(r);
+    waiter.join();
+
+    EXPECT_EQ(r, got);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST_F(RilSocketQueueTest, EachEnqueueWakesOneWaiter)
+{
+    const int kWaiters = 4;
+    TestQueue q;
+    std::vector<std::thread> waiters;
+    std::vector<Request *> got(kWaiters);
+
+    for (int i = 0; i < kWaiters; i++)
+        waiters.emplace_back([&, i]() { got[i] = q.dequeue(); });
+    for (int i = 0; i < kWaiters; i++)
+        q.enqueue(request(MsgId_RIL_SIM_SAP_CONNECT, i));
+    for (auto &waiter : waiters)
+        waiter.join();
+
+    std::sort(got.begin(), got.end());
+    EXPECT_EQ(got.end(), std::adjacent_find(got.begin(), got.end()));
+    EXPECT_EQ(got.end(), std::find(got.begin(), got.end(), (Request *)NULL));
+    EXPECT_TRUE(q.empty());
+}
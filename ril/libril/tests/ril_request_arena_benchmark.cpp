@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ril_request_arena.h"
+
+/**
+ * Request-side allocations of one message as ril_service.cpp makes them: the pointer array or
+ * struct array first, then one copy per string, all released once onRequest() returns.
+ */
+struct Message {
+    const char *name;
+    std::vector<size_t> buffers;
+};
+
+static const std::vector<Message> kReplay = {
+    // dispatchStrings(): 7 pointers, then radio tech, profile, apn, user, password, auth, protocol
+    {"setupDataCall", {7 * sizeof(char *), 3, 2, 9, 1, 1, 2, 7}},
+    // smsc address and a full PDU
+    {"sendSms", {2 * sizeof(char *), 13, 353}},
+    {"sendImsSms", {2 * sizeof(char *), 13, 353}},
+    // dispatchInts()
+    {"setNetworkSelectionModeManual", {2 * sizeof(char *), 6, 2}},
+    {"setPreferredNetworkType", {1 * sizeof(int)}},
+    {"setSuppServiceNotifications", {1 * sizeof(int)}},
+    // dispatchString()
+    {"dial", {12}},
+    {"sendEnvelope", {511}},
+    // setDataProfile(): 4 v15 profiles, the pointer array, then 5 strings per profile
+    {"setDataProfile", {4 * 96, 4 * sizeof(void *),
+                        9, 7, 7, 1, 1, 9, 7, 7, 1, 1, 4, 7, 7, 1, 1, 4, 7, 7, 1, 1}},
+    // setAllowedCarriers(): allowed and excluded lists
+    {"setAllowedCarriers", {2 * 32, 1 * 32}},
+    // OEM hook strings bigger than a chunk go to calloc()
+    {"sendRequestStrings", {2 * sizeof(char *), 6000, 9}},
+};
+
+static size_t replayMessages() {
+    size_t buffers = 0;
+
+    for (const Message &message : kReplay) {
+        buffers += message.buffers.size();
+    }
+    return buffers;
+}
+
+static void touch(void *ptr, size_t size) {
+    memset(ptr, 'x', size);
+    benchmark::DoNotOptimize(ptr);
+}
+
+// Every buffer from calloc(), as before the request arena
+static void BM_ReplayHeap(benchmark::State &state) {
+    std::vector<void *> ptrs;
+    size_t heapAllocations = 0;
+
+    for (auto _ : state) {
+        for (const Message &message : kReplay) {
+            for (size_t size : message.buffers) {
+                void *ptr = calloc(size, 1);
+                heapAllocations++;
+                touch(ptr, size);
+                ptrs.push_back(ptr);
+            }
+            benchmark::ClobberMemory();
+            for (void *ptr : ptrs) {
+                free(ptr);
+            }
+            ptrs.clear();
+        }
+    }
+
+    state.counters["allocs/msg"] = benchmark::Counter((double)heapAllocations /
+            (state.iterations() * kReplay.size()));
+    state.counters["buffers/msg"] = (double)replayMessages() / kReplay.size();
+}
+BENCHMARK(BM_ReplayHeap);
+
+// Through the request arena, rewound after each message like CALL_ONREQUEST does
+static void BM_ReplayArena(benchmark::State &state) {
+    RequestArena arena;
+    std::vector<void *> ptrs;
+
+    for (auto _ : state) {
+        for (const Message &message : kReplay) {
+            for (size_t size : message.buffers) {
+                void *ptr = requestArenaAlloc(arena, size, 1);
+                touch(ptr, size);
+                ptrs.push_back(ptr);
+            }
+            benchmark::ClobberMemory();
+            arena.reset();
+            for (void *ptr : ptrs) {
+                requestArenaFree(arena, ptr);
+            }
+            ptrs.clear();
+        }
+    }
+
+    state.counters["allocs/msg"] = benchmark::Counter((double)arena.heapAllocations() /
+            (state.iterations() * kReplay.size()));
+    state.counters["buffers/msg"] = (double)replayMessages() / kReplay.size();
+}
+BENCHMARK(BM_ReplayArena);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <set>
+
+#include <gtest/gtest.h>
+#include <telephony/ril.h>
+
+#include "ril_unsol_index.h"
+
+#define NUM_ELEMS(a)     (sizeof (a) / sizeof (a)[0])
+
+// Same layout as UnsolResponseInfo in ril.cpp, minus the response functions
+enum WakeType {DONT_WAKE, WAKE_PARTIAL};
+
+typedef struct {
+    int requestNumber;
+    void *responseFunction;
+    WakeType wakeType;
+} UnsolResponseInfo;
+
+static UnsolResponseInfo s_unsolResponses_v[] = {
+#include <telephony/ril_unsol_commands_vendor.h>
+};
+
+static const int32_t kNumUnsolResponses_v = (int32_t)NUM_ELEMS(s_unsolResponses_v);
+
+/**
+ * The lookup RIL_onUnsolicitedResponse() did before the table was indexed:
+ * a scan of the whole table that keeps the last match.
+ */
+static int32_t
+linearIndex(const UnsolResponseInfo *table, int32_t count, int code) {
+    int32_t index = -1;
+
+    for (int32_t i = 0; i < count; i++) {
+        if (table[i].requestNumber == code) {
+            index = i;
+        }
+    }
+
+    return index;
+}
+
+static int32_t
+vendorIndex(int code) {
+    int32_t dense = denseResponseCount(s_unsolResponses_v, kNumUnsolResponses_v,
+            SAMSUNG_UNSOL_RESPONSE_BASE);
+
+    return responseIndex(s_unsolResponses_v, kNumUnsolResponses_v, dense,
+            SAMSUNG_UNSOL_RESPONSE_BASE, code);
+}
+
+TEST(RilUnsolIndexTest, VendorCodesUnique) {
+    std::set<int> codes;
+
+    // With duplicates the linear scan would pick the last entry, the index the first
+    for (int32_t i = 0; i < kNumUnsolResponses_v; i++) {
+        EXPECT_TRUE(codes.insert(s_unsolResponses_v[i].requestNumber).second)
+                << "duplicate code " << s_unsolResponses_v[i].requestNumber;
+    }
+}
+
+TEST(RilUnsolIndexTest, EveryVendorCodeMatchesLinearScan) {
+    for (int32_t i = 0; i < kNumUnsolResponses_v; i++) {
+        int code = s_unsolResponses_v[i].requestNumber;
+
+        EXPECT_EQ(linearIndex(s_unsolResponses_v, kNumUnsolResponses_v, code), vendorIndex(code))
+                << "code " << code;
+        EXPECT_EQ(i, vendorIndex(code)) << "code " << code;
+    }
+}
+
+TEST(RilUnsolIndexTest, EveryCodeInRangeMatchesLinearScan) {
+    // Covers the dense block, the gap after it, the sparse codes and beyond
+    for (int code = SAMSUNG_UNSOL_RESPONSE_BASE - 100; code < 21000; code++) {
+        ASSERT_EQ(linearIndex(s_unsolResponses_v, kNumUnsolResponses_v, code), vendorIndex(code))
+                << "code " << code;
+    }
+}
+
+TEST(RilUnsolIndexTest, DenseBlock) {
+    int32_t dense = denseResponseCount(s_unsolResponses_v, kNumUnsolResponses_v,
+            SAMSUNG_UNSOL_RESPONSE_BASE);
+
+    EXPECT_EQ(RIL_UNSOL_MIP_CONNECT_STATUS - SAMSUNG_UNSOL_RESPONSE_BASE + 1, dense);
+    EXPECT_LE(dense, kNumUnsolResponses_v);
+}
+
+TEST(RilUnsolIndexTest, NoDenseBlock) {
+    static const UnsolResponseInfo table[] = {
+        {20017, NULL, WAKE_PARTIAL},
+        {11001, NULL, WAKE_PARTIAL},
+        {20022, NULL, WAKE_PARTIAL},
+    };
+    int32_t count = (int32_t)NUM_ELEMS(table);
+    int32_t dense = denseResponseCount(table, count, 11000);
+
+    EXPECT_EQ(0, dense);
+    for (int code : {11000, 11001, 11002, 20017, 20022}) {
+        EXPECT_EQ(linearIndex(table, count, code), responseIndex(table, count, dense, 11000, code))
+                << "code " << code;
+    }
+}
@@ -8,7 +8,6 @@ LOCAL_SRC_FILES:= \
 
 LOCAL_SHARED_LIBRARIES := \
     libutils \
-    libbinder \
     libcutils \
     libhardware_legacy \
     liblog
@@ -30,3 +29,5 @@ LOCAL_MODULE:= libsecril-client
 LOCAL_PRELINK_MODULE := false
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
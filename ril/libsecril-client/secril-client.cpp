@@ -9,7 +9,6 @@
 #define LOG_TAG "RILClient"
 /*#define LOG_NDEBUG 0*/
 
-#include <binder/Parcel.h>
 #include <telephony/ril.h>
 #include <cutils/record_stream.h>
 
@@ -18,8 +17,11 @@
 #include <cutils/sockets.h>
 #include <netinet/in.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <string.h>
 #include <fcntl.h>
+#include <utils/Errors.h>
 #include <utils/Log.h>
 #include <android/log.h>
 #include <pthread.h>
@@ -45,8 +47,8 @@ namespace android {
 #define MULTI_CLIENT_Q_SOCKET_NAME "QMulticlient"
 
 #define MAX_COMMAND_BYTES       (8 * 1024)
-#define REQ_POOL_SIZE           32
-#define TOKEN_POOL_SIZE         32
+#define HANDLER_TABLE_SIZE      64  // open addressing, power of two
+#define PENDING_HASH_SIZE       64  // buckets of the token hash, power of two
 
 // Constants for response types
 #define RESPONSE_SOLICITED      0
@@ -121,8 +123,12 @@ namespace android {
 typedef struct _ReqHistory {
     int         token;  // token used for request
     uint32_t    id;     // request ID
+    struct _ReqHistory *next;   // next in the same hash bucket
 } ReqHistory;
 
+// Handler tables are hashed on id with linear probing. id 0 marks a free
+// slot; an unregistered handler keeps its id with a NULL handler, so probe
+// chains stay intact and the slot is reused if the id registers again.
 typedef struct _ReqRespHandler {
     uint32_t        id;         // request ID
     RilOnComplete   handler;    // handler function
@@ -133,6 +139,36 @@ typedef struct _UnsolHandler {
     RilOnUnsolicited    handler;    // handler function
 } UnsolHandler;
 
+// Cursor over one framed record, read in place the way Parcel lays it out:
+// native-endian int32s and byte arrays padded to 4 bytes.
+struct RxRecord {
+    const uint8_t   *data;
+    size_t          size;
+    size_t          pos;
+
+    RxRecord(const void *buffer, size_t len)
+        : data((const uint8_t *)buffer), size(len), pos(0) {}
+
+    status_t readInt32(int32_t *val) {
+        if (size - pos < sizeof(int32_t))
+            return NOT_ENOUGH_DATA;
+        memcpy(val, data + pos, sizeof(int32_t));
+        pos += sizeof(int32_t);
+        return NO_ERROR;
+    }
+
+    const void *readInplace(size_t len) {
+        size_t padded = (len + 3) & ~(size_t)3;
+        const void *ret;
+
+        if (padded < len || size - pos < padded)
+            return NULL;
+        ret = data + pos;
+        pos += padded;
+        return ret;
+    }
+};
+
 typedef struct _RilClientPrv {
     HRilClient      parent;
     uint8_t         b_connect;  // connected to server?
@@ -140,12 +176,13 @@ typedef struct _RilClientPrv {
     int             pipefd[2];
     fd_set          sock_rfds;  // for read with select()
     RecordStream    *p_rs;
-    uint32_t        token_pool; // each bit in token_pool used for token.
-                                // so, pool size is 32.
+    uint32_t        next_token; // last token handed out, updated atomically
     pthread_t       tid_reader; // socket reader thread id
-    ReqHistory      history[TOKEN_POOL_SIZE];       // request history
-    ReqRespHandler  req_handlers[REQ_POOL_SIZE];    // request response handler list
-    UnsolHandler    unsol_handlers[REQ_POOL_SIZE];  // unsolicited response handler list
+    pthread_mutex_t lock;       // guards history and the handler tables
+    pthread_mutex_t send_lock;  // keeps frames from concurrent senders whole
+    ReqHistory      *history[PENDING_HASH_SIZE];        // outstanding requests by token
+    ReqRespHandler  req_handlers[HANDLER_TABLE_SIZE];   // request response handler table
+    UnsolHandler    unsol_handlers[HANDLER_TABLE_SIZE]; // unsolicited response handler table
     RilOnError      err_cb;         // error callback
     void            *err_cb_data;   // error callback data
     uint8_t b_del_handler;
@@ -157,12 +194,13 @@ typedef struct _RilClientPrv {
 //---------------------------------------------------------------------------
 static void * RxReaderFunc(void *param);
 static int processRxBuffer(RilClientPrv *prv, void *buffer, size_t buflen);
-static uint32_t AllocateToken(uint32_t *token_pool);
-static void FreeToken(uint32_t *token_pool, uint32_t token);
-static uint8_t IsValidToken(uint32_t *token_pool, uint32_t token);
-static int blockingWrite(int fd, const void *buffer, size_t len);
+static uint32_t AllocateToken(uint32_t *next_token);
+static uint8_t IsValidToken(RilClientPrv *prv, int token);
+static int blockingWritev(int fd, struct iovec *iov, int iovcnt);
 static int RecordReqHistory(RilClientPrv *prv, int token, uint32_t id);
 static void ClearReqHistory(RilClientPrv *prv, int token);
+static void ClearAllReqHistory(RilClientPrv *prv);
+static int FindHandlerSlot(const uint32_t *ids, size_t stride, uint32_t id, bool for_insert);
 static RilOnComplete FindReqHandler(RilClientPrv *prv, int token, uint32_t *id);
 static RilOnUnsolicited FindUnsolHandler(RilClientPrv *prv, uint32_t id);
 static int SendOemRequestHookRaw(HRilClient client, int req_id, char *data, size_t len);
@@ -188,49 +226,30 @@ static char ConvertAudioPath(AudioPath path);
 extern "C"
 int RegisterUnsolicitedHandler(HRilClient client, uint32_t id, RilOnUnsolicited handler) {
     RilClientPrv *client_prv;
-    int match_slot = -1;
-    int first_empty_slot = -1;
-    int i;
+    int slot;
+    int ret = RIL_CLIENT_ERR_SUCCESS;
 
-    if (client == NULL || client->prv == NULL)
+    if (client == NULL || client->prv == NULL || id == 0)
         return RIL_CLIENT_ERR_INVAL;
 
     client_prv = (RilClientPrv *)(client->prv);
 
-    for (i = 0; i < REQ_POOL_SIZE; i++) {
-        // Check if  there is matched handler.
-        if (id == client_prv->unsol_handlers[i].id) {
-            match_slot = i;
-        }
-        // Find first empty handler slot.
-        if (first_empty_slot == -1 && client_prv->unsol_handlers[i].id == 0) {
-            first_empty_slot = i;
-        }
-    }
+    pthread_mutex_lock(&client_prv->lock);
 
-    if (handler == NULL) {  // Unregister.
-        if (match_slot >= 0) {
-            memset(&(client_prv->unsol_handlers[match_slot]), 0, sizeof(UnsolHandler));
-            return RIL_CLIENT_ERR_SUCCESS;
-        }
-        else {
-            return RIL_CLIENT_ERR_SUCCESS;
-        }
+    slot = FindHandlerSlot(&client_prv->unsol_handlers[0].id, sizeof(UnsolHandler), id,
+                           handler != NULL);
+    if (slot >= 0) {
+        // Unregistering leaves the id behind as a tombstone.
+        client_prv->unsol_handlers[slot].id = id;
+        client_prv->unsol_handlers[slot].handler = handler;
     }
-    else {// Register.
-        if (match_slot >= 0) {
-            client_prv->unsol_handlers[match_slot].handler = handler;   // Just update.
-        }
-        else if (first_empty_slot >= 0) {
-            client_prv->unsol_handlers[first_empty_slot].id = id;
-            client_prv->unsol_handlers[first_empty_slot].handler = handler;
-        }
-        else {
-            return RIL_CLIENT_ERR_RESOURCE;
-        }
+    else if (handler != NULL) {
+        ret = RIL_CLIENT_ERR_RESOURCE;
     }
 
-    return RIL_CLIENT_ERR_SUCCESS;
+    pthread_mutex_unlock(&client_prv->lock);
+
+    return ret;
 }
 
 
@@ -246,49 +265,30 @@ int RegisterUnsolicitedHandler(HRilClient client, uint32_t id, RilOnUnsolicited
 extern "C"
 int RegisterRequestCompleteHandler(HRilClient client, uint32_t id, RilOnComplete handler) {
     RilClientPrv *client_prv;
-    int match_slot = -1;
-    int first_empty_slot = -1;
-    int i;
+    int slot;
+    int ret = RIL_CLIENT_ERR_SUCCESS;
 
-    if (client == NULL || client->prv == NULL)
+    if (client == NULL || client->prv == NULL || id == 0)
         return RIL_CLIENT_ERR_INVAL;
 
     client_prv = (RilClientPrv *)(client->prv);
 
-    for (i = 0; i < REQ_POOL_SIZE; i++) {
-        // Check if  there is matched handler.
-        if (id == client_prv->req_handlers[i].id) {
-            match_slot = i;
-        }
-        // Find first empty handler slot.
-        if (first_empty_slot == -1 && client_prv->req_handlers[i].id == 0) {
-            first_empty_slot = i;
-        }
-    }
+    pthread_mutex_lock(&client_prv->lock);
 
-    if (handler == NULL) {  // Unregister.
-        if (match_slot >= 0) {
-            memset(&(client_prv->req_handlers[match_slot]), 0, sizeof(ReqRespHandler));
-            return RIL_CLIENT_ERR_SUCCESS;
-        }
-        else {
-            return RIL_CLIENT_ERR_SUCCESS;
-        }
+    slot = FindHandlerSlot(&client_prv->req_handlers[0].id, sizeof(ReqRespHandler), id,
+                           handler != NULL);
+    if (slot >= 0) {
+        // Unregistering leaves the id behind as a tombstone.
+        client_prv->req_handlers[slot].id = id;
+        client_prv->req_handlers[slot].handler = handler;
     }
-    else {  // Register.
-        if (match_slot >= 0) {
-            client_prv->req_handlers[match_slot].handler = handler; // Just update.
-        }
-        else if (first_empty_slot >= 0) {
-            client_prv->req_handlers[first_empty_slot].id = id;
-            client_prv->req_handlers[first_empty_slot].handler = handler;
-        }
-        else {
-            return RIL_CLIENT_ERR_RESOURCE;
-        }
+    else if (handler != NULL) {
+        ret = RIL_CLIENT_ERR_RESOURCE;
     }
 
-    return RIL_CLIENT_ERR_SUCCESS;
+    pthread_mutex_unlock(&client_prv->lock);
+
+    return ret;
 }
 
 
@@ -337,6 +337,8 @@ HRilClient OpenClient_RILD(void) {
     }
 
     memset(client->prv, 0, sizeof(RilClientPrv));
+    pthread_mutex_init(&((RilClientPrv *)(client->prv))->lock, NULL);
+    pthread_mutex_init(&((RilClientPrv *)(client->prv))->send_lock, NULL);
 
     ((RilClientPrv *)(client->prv))->parent = client;
     ((RilClientPrv *)(client->prv))->sock = -1;
@@ -400,7 +402,12 @@ int Connect_RILD(HRilClient client) {
         close(client_prv->pipefd[0]);
         close(client_prv->pipefd[1]);
 
+        ClearAllReqHistory(client_prv);
+        pthread_mutex_destroy(&client_prv->lock);
+        pthread_mutex_destroy(&client_prv->send_lock);
         memset(client_prv, 0, sizeof(RilClientPrv));
+        pthread_mutex_init(&client_prv->lock, NULL);
+        pthread_mutex_init(&client_prv->send_lock, NULL);
         client_prv->sock = -1;
         RLOGE("%s: Can't create Reader thread. %s(%d)", __FUNCTION__, strerror(errno), errno);
         return RIL_CLIENT_ERR_CONNECT;
@@ -464,7 +471,12 @@ int Connect_QRILD(HRilClient client) {
         close(client_prv->pipefd[0]);
         close(client_prv->pipefd[1]);
 
+        ClearAllReqHistory(client_prv);
+        pthread_mutex_destroy(&client_prv->lock);
+        pthread_mutex_destroy(&client_prv->send_lock);
         memset(client_prv, 0, sizeof(RilClientPrv));
+        pthread_mutex_init(&client_prv->lock, NULL);
+        pthread_mutex_init(&client_prv->send_lock, NULL);
         client_prv->sock = -1;
         RLOGE("%s: Can't create Reader thread. %s(%d)", __FUNCTION__, strerror(errno), errno);
         return RIL_CLIENT_ERR_CONNECT;
@@ -528,7 +540,12 @@ int Connect_RILD_Second(HRilClient client)    {
         close(client_prv->pipefd[0]);
         close(client_prv->pipefd[1]);
 
+        ClearAllReqHistory(client_prv);
+        pthread_mutex_destroy(&client_prv->lock);
+        pthread_mutex_destroy(&client_prv->send_lock);
         memset(client_prv, 0, sizeof(RilClientPrv));
+        pthread_mutex_init(&client_prv->lock, NULL);
+        pthread_mutex_init(&client_prv->send_lock, NULL);
         client_prv->sock = -1;
         RLOGE("%s: Can't create Reader thread. %s(%d)", __FUNCTION__, strerror(errno), errno);
         return RIL_CLIENT_ERR_CONNECT;
@@ -577,8 +594,12 @@ int Disconnect_RILD(HRilClient client) {
 
     client_prv = (RilClientPrv *)(client->prv);
 
-    if (client_prv->sock == -1)
+    // Nothing sent on this connection will be answered any more, so drop
+    // its outstanding requests rather than keep them for the next one.
+    if (client_prv->sock == -1) {
+        ClearAllReqHistory(client_prv);
         return RIL_CLIENT_ERR_SUCCESS;
+    }
 
     printf("[*] %s(): sock=%d\n", __FUNCTION__, client_prv->sock);
 
@@ -592,6 +613,8 @@ int Disconnect_RILD(HRilClient client) {
 
     pthread_join(client_prv->tid_reader, NULL);
 
+    ClearAllReqHistory(client_prv);
+
     return RIL_CLIENT_ERR_SUCCESS;
 }
 
@@ -612,6 +635,10 @@ int CloseClient_RILD(HRilClient client) {
 
     Disconnect_RILD(client);
 
+    ClearAllReqHistory((RilClientPrv *)(client->prv));
+    pthread_mutex_destroy(&((RilClientPrv *)(client->prv))->lock);
+    pthread_mutex_destroy(&((RilClientPrv *)(client->prv))->send_lock);
+
     free(client->prv);
     free(client);
 
@@ -1086,10 +1113,11 @@ int InvokeOemRequestHookRaw(HRilClient client, char *data, size_t len) {
 
 
 static int SendOemRequestHookRaw(HRilClient client, int req_id, char *data, size_t len) {
+    static const uint8_t pad[4] = { 0, 0, 0, 0 };
     int token = 0;
     int ret = 0;
-    uint32_t header = 0;
-    android::Parcel p;
+    uint32_t frame[4];
+    struct iovec iov[3];
     RilClientPrv *client_prv;
 
     unsigned int check_req_id = req_id;
@@ -1097,52 +1125,46 @@ static int SendOemRequestHookRaw(HRilClient client, int req_id, char *data, size
     client_prv = (RilClientPrv *)(client->prv);
 
     // Allocate a token.
-    token = AllocateToken(&(client_prv->token_pool));
-    if (token == 0) {
-        RLOGE("%s: No token.", __FUNCTION__);
-        return RIL_CLIENT_ERR_AGAIN;
-    }
+    token = AllocateToken(&(client_prv->next_token));
 
     // Record token for the request sent.
     if (RecordReqHistory(client_prv, token, req_id) != RIL_CLIENT_ERR_SUCCESS) {
-        goto error;
+        return RIL_CLIENT_ERR_AGAIN;
     }
 
-    // Make OEM request data.
-    p.writeInt32(RIL_REQUEST_OEM_HOOK_RAW);
-    p.writeInt32(token);
-    p.writeInt32(len);
-    p.write((void *)data, len);
+    // Make OEM request data, laid out as a Parcel would write it, and send
+    // it together with the size header in one go.
+    frame[1] = RIL_REQUEST_OEM_HOOK_RAW;
+    frame[2] = token;
+    frame[3] = len;
+    frame[0] = htonl(sizeof(frame) - sizeof(frame[0]) + ((len + 3) & ~(size_t)3));
 
-    // DO TX: header(size).
-    header = htonl(p.dataSize());
+    iov[0].iov_base = frame;
+    iov[0].iov_len = sizeof(frame);
+    iov[1].iov_base = data;
+    iov[1].iov_len = len;
+    iov[2].iov_base = (void *)pad;
+    iov[2].iov_len = (4 - (len & 3)) & 3;
 
     RLOGV("%s(): token = %d\n", __FUNCTION__, token);
 
-    ret = blockingWrite(client_prv->sock, (void *)&header, sizeof(header));
-    if (ret < 0) {
-        RLOGE("%s: send request header failed. (%d)", __FUNCTION__, ret);
-        goto error;
-    }
-
-    // Do TX: response data.
-    ret = blockingWrite(client_prv->sock, p.data(), p.dataSize());
+    pthread_mutex_lock(&client_prv->send_lock);
+    ret = blockingWritev(client_prv->sock, iov, 3);
+    pthread_mutex_unlock(&client_prv->send_lock);
     if (ret < 0) {
-        RLOGE("%s: send request data failed. (%d)", __FUNCTION__, ret);
+        RLOGE("%s: send request failed. (%d)", __FUNCTION__, ret);
         goto error;
     }
 
     // check if the handler for specified event is NULL and deregister token
     // to prevent token pool overflow
     if(!FindReqHandler(client_prv, token, &check_req_id)) {
-        FreeToken(&(client_prv->token_pool), token);
         ClearReqHistory(client_prv, token);
     }
 
     return RIL_CLIENT_ERR_SUCCESS;
 
 error:
-    FreeToken(&(client_prv->token_pool), token);
     ClearReqHistory(client_prv, token);
 
     if (ret == -EPIPE || ret == -EBADFD) {
@@ -1252,7 +1274,11 @@ static void * RxReaderFunc(void *param) {
         RLOGV("[*] %s() b_connect=%d\n", __FUNCTION__, client_prv->b_connect);
         if (select(maxfd, &(client_prv->sock_rfds), NULL, NULL, NULL) > 0) {
             if (FD_ISSET(client_prv->sock, &(client_prv->sock_rfds))) {
-                // Read incoming data
+                bool wake_locked = false;
+
+                // Read incoming data. record_stream pulls as much as one
+                // read() returns and hands back every complete record in
+                // it, so a burst is drained under a single wake lock.
                 for (;;) {
                     // loop until EAGAIN/EINTR, end of stream, or other error
                     ret = record_stream_get_next(client_prv->p_rs, &p_record, &recordlen);
@@ -1263,6 +1289,10 @@ static void * RxReaderFunc(void *param) {
                         break;
                     }
                     else if (ret == 0) {    // && p_record != NULL
+                        if (!wake_locked) {
+                            acquire_wake_lock(PARTIAL_WAKE_LOCK, RIL_CLIENT_WAKE_LOCK);
+                            wake_locked = true;
+                        }
                         n = processRxBuffer(client_prv, p_record, recordlen);
                         if (n != RIL_CLIENT_ERR_SUCCESS) {
                             RLOGE("%s: processRXBuffer returns %d", __FUNCTION__, n);
@@ -1273,6 +1303,9 @@ static void * RxReaderFunc(void *param) {
                     }
                 }
 
+                if (wake_locked)
+                    release_wake_lock(RIL_CLIENT_WAKE_LOCK);
+
                 if (ret == 0 || !(errno == EAGAIN || errno == EINTR)) {
                     // fatal error or end-of-stream
                     if (client_prv->sock > 0) {
@@ -1281,8 +1314,10 @@ static void * RxReaderFunc(void *param) {
                         client_prv->b_connect = 0;
                     }
 
-                    if (client_prv->p_rs)
+                    if (client_prv->p_rs) {
                         record_stream_free(client_prv->p_rs);
+                        client_prv->p_rs = NULL;
+                    }
 
                     // EOS
                     if (client_prv->err_cb) {
@@ -1303,6 +1338,11 @@ static void * RxReaderFunc(void *param) {
                     close(client_prv->pipefd[0]);
                     close(client_prv->pipefd[1]);
 
+                    if (client_prv->p_rs) {
+                        record_stream_free(client_prv->p_rs);
+                        client_prv->p_rs = NULL;
+                    }
+
                     client_prv->sock = -1;
                     client_prv->b_connect = 0;
                 }
@@ -1316,8 +1356,10 @@ static void * RxReaderFunc(void *param) {
                 client_prv->b_connect = 0;
             }
 
-            if (client_prv->p_rs)
+            if (client_prv->p_rs) {
                 record_stream_free(client_prv->p_rs);
+                client_prv->p_rs = NULL;
+            }
 
             // EOS
             if (client_prv->err_cb) {
@@ -1331,7 +1373,7 @@ static void * RxReaderFunc(void *param) {
 }
 
 
-static int processUnsolicited(RilClientPrv *prv, Parcel &p) {
+static int processUnsolicited(RilClientPrv *prv, RxRecord &p) {
     int32_t resp_id, len;
     status_t status;
     const void *data = NULL;
@@ -1364,7 +1406,7 @@ static int processUnsolicited(RilClientPrv *prv, Parcel &p) {
 }
 
 
-static int processSolicited(RilClientPrv *prv, Parcel &p) {
+static int processSolicited(RilClientPrv *prv, RxRecord &p) {
     int32_t token, err, len;
     status_t status;
     const void *data = NULL;
@@ -1380,7 +1422,7 @@ static int processSolicited(RilClientPrv *prv, Parcel &p) {
         return RIL_CLIENT_ERR_IO;
     }
 
-    if (IsValidToken(&(prv->token_pool), token) == 0) {
+    if (IsValidToken(prv, token) == 0) {
         RLOGE("%s: Invalid Token", __FUNCTION__);
         return RIL_CLIENT_ERR_INVAL;    // Invalid token.
     }
@@ -1429,22 +1471,18 @@ static int processSolicited(RilClientPrv *prv, Parcel &p) {
     }
 
 error:
-    FreeToken(&(prv->token_pool), token);
     ClearReqHistory(prv, token);
     return ret;
 }
 
 
+// Called from RxReaderFunc() with the client wake lock held.
 static int processRxBuffer(RilClientPrv *prv, void *buffer, size_t buflen) {
-    Parcel p;
+    RxRecord p(buffer, buflen);
     int32_t response_type;
     status_t status;
     int ret = RIL_CLIENT_ERR_SUCCESS;
 
-    acquire_wake_lock(PARTIAL_WAKE_LOCK, RIL_CLIENT_WAKE_LOCK);
-
-    p.setData((uint8_t *)buffer, buflen);
-
     status = p.readInt32(&response_type);
     RLOGV("%s: status %d response_type %d", __FUNCTION__, status, response_type);
 
@@ -1469,141 +1507,194 @@ static int processRxBuffer(RilClientPrv *prv, void *buffer, size_t buflen) {
     }
 
 EXIT:
-    release_wake_lock(RIL_CLIENT_WAKE_LOCK);
     return ret;
 }
 
 
-static uint32_t AllocateToken(uint32_t *token_pool) {
-    int i;
+static uint32_t AllocateToken(uint32_t *next_token) {
+    uint32_t token;
 
-    // Token pool is full.
-    if (*token_pool == 0xFFFFFFFF)
-        return 0;
+    // Tokens only need to be unique among outstanding requests; 0 is invalid.
+    do {
+        token = __atomic_add_fetch(next_token, 1, __ATOMIC_RELAXED) & 0x7FFFFFFF;
+    } while (token == 0);
 
-    for (i = 0; i < 32; i++) {
-        uint32_t new_token = 0x00000001 << i;
+    return token;
+}
 
-        if ((*token_pool & new_token) == 0) {
-            *token_pool |= new_token;
-            return new_token;
-        }
-    }
 
-    return 0;
-}
+static ReqHistory **FindReqHistoryLocked(RilClientPrv *prv, int token) {
+    ReqHistory **pp = &prv->history[token & (PENDING_HASH_SIZE - 1)];
 
+    while (*pp != NULL && (*pp)->token != token)
+        pp = &(*pp)->next;
 
-static void FreeToken(uint32_t *token_pool, uint32_t token) {
-    *token_pool &= ~token;
+    return pp;
 }
 
 
-static uint8_t IsValidToken(uint32_t *token_pool, uint32_t token) {
+static uint8_t IsValidToken(RilClientPrv *prv, int token) {
+    uint8_t valid;
+
     if (token == 0)
         return 0;
 
-    if ((*token_pool & token) == token)
-        return 1;
-    else
-        return 0;
+    pthread_mutex_lock(&prv->lock);
+    valid = *FindReqHistoryLocked(prv, token) != NULL;
+    pthread_mutex_unlock(&prv->lock);
+
+    return valid;
 }
 
 
 static int RecordReqHistory(RilClientPrv *prv, int token, uint32_t id) {
-    int i = 0;
+    ReqHistory *rec;
 
     RLOGV("[*] %s(): token(%d), ID(%d)\n", __FUNCTION__, token, id);
-    for (i = 0; i < TOKEN_POOL_SIZE; i++) {
-        if (prv->history[i].token == 0) {
-            prv->history[i].token = token;
-            prv->history[i].id = id;
-
-            RLOGV("[*] %s(): token(%d), ID(%d)\n", __FUNCTION__, token, id);
 
-            return RIL_CLIENT_ERR_SUCCESS;
-        }
+    rec = (ReqHistory *)malloc(sizeof(ReqHistory));
+    if (rec == NULL) {
+        RLOGE("%s: No free record for token %d", __FUNCTION__, token);
+        return RIL_CLIENT_ERR_RESOURCE;
     }
 
-    RLOGE("%s: No free record for token %d", __FUNCTION__, token);
+    rec->token = token;
+    rec->id = id;
 
-    return RIL_CLIENT_ERR_RESOURCE;
+    pthread_mutex_lock(&prv->lock);
+    rec->next = prv->history[token & (PENDING_HASH_SIZE - 1)];
+    prv->history[token & (PENDING_HASH_SIZE - 1)] = rec;
+    pthread_mutex_unlock(&prv->lock);
+
+    return RIL_CLIENT_ERR_SUCCESS;
 }
 
 static void ClearReqHistory(RilClientPrv *prv, int token) {
-    int i = 0;
+    ReqHistory **pp;
+    ReqHistory *rec = NULL;
 
     RLOGV("[*] %s(): token(%d)\n", __FUNCTION__, token);
-    for (i = 0; i < TOKEN_POOL_SIZE; i++) {
-        if (prv->history[i].token == token) {
-            memset(&(prv->history[i]), 0, sizeof(ReqHistory));
-            break;
-        }
+
+    pthread_mutex_lock(&prv->lock);
+    pp = FindReqHistoryLocked(prv, token);
+    if (*pp != NULL) {
+        rec = *pp;
+        *pp = rec->next;
     }
+    pthread_mutex_unlock(&prv->lock);
+
+    free(rec);
 }
 
 
-static RilOnUnsolicited FindUnsolHandler(RilClientPrv *prv, uint32_t id) {
+static void ClearAllReqHistory(RilClientPrv *prv) {
     int i;
 
-    // Search unsolicited handler table.
-    for (i = 0; i < REQ_POOL_SIZE; i++) {
-        if (prv->unsol_handlers[i].id == id)
-            return prv->unsol_handlers[i].handler;
+    pthread_mutex_lock(&prv->lock);
+    for (i = 0; i < PENDING_HASH_SIZE; i++) {
+        while (prv->history[i] != NULL) {
+            ReqHistory *rec = prv->history[i];
+            prv->history[i] = rec->next;
+            free(rec);
+        }
+    }
+    pthread_mutex_unlock(&prv->lock);
+}
+
+
+/**
+ * Probes a handler table laid out as structs of the given stride that start
+ * with their uint32_t id. Returns the slot holding id, or if for_insert and
+ * the id is absent, the first free slot; -1 if neither exists.
+ */
+static int FindHandlerSlot(const uint32_t *ids, size_t stride, uint32_t id, bool for_insert) {
+    const uint8_t *base = (const uint8_t *)ids;
+    uint32_t start = id & (HANDLER_TABLE_SIZE - 1);
+    uint32_t i;
+
+    for (i = 0; i < HANDLER_TABLE_SIZE; i++) {
+        uint32_t slot = (start + i) & (HANDLER_TABLE_SIZE - 1);
+        uint32_t slot_id = *(const uint32_t *)(base + slot * stride);
+
+        if (slot_id == id)
+            return slot;
+        if (slot_id == 0)
+            return for_insert ? (int)slot : -1;
     }
 
-    return (RilOnUnsolicited)NULL;
+    return -1;
+}
+
+
+static RilOnUnsolicited FindUnsolHandler(RilClientPrv *prv, uint32_t id) {
+    RilOnUnsolicited handler = NULL;
+    int slot;
+
+    pthread_mutex_lock(&prv->lock);
+    slot = FindHandlerSlot(&prv->unsol_handlers[0].id, sizeof(UnsolHandler), id, false);
+    if (slot >= 0)
+        handler = prv->unsol_handlers[slot].handler;
+    pthread_mutex_unlock(&prv->lock);
+
+    return handler;
 }
 
 
 static RilOnComplete FindReqHandler(RilClientPrv *prv, int token, uint32_t *id) {
-    int i = 0;
-    int j = 0;
+    RilOnComplete handler = NULL;
+    ReqHistory *rec;
+    int slot;
 
     RLOGV("[*] %s(): token(%d)\n", __FUNCTION__, token);
 
-    // Search request history.
-    for (i = 0; i < TOKEN_POOL_SIZE; i++) {
-        printf("[*] %s(): history_token(%d)\n", __FUNCTION__, prv->history[i].token);
-        if (prv->history[i].token == token) {
-            // Search request handler with request ID found.
-            for (j = 0; j < REQ_POOL_SIZE; j++) {
-                printf("[*] %s(): token(%d), req_id(%d), history_id(%d)\n", __FUNCTION__, token, prv->history[i].id, prv->history[i].id);
-                if (prv->req_handlers[j].id == prv->history[i].id) {
-              *id = prv->req_handlers[j].id;
-                    return prv->req_handlers[j].handler;
-                }
-            }
+    pthread_mutex_lock(&prv->lock);
+    rec = *FindReqHistoryLocked(prv, token);
+    if (rec != NULL) {
+        slot = FindHandlerSlot(&prv->req_handlers[0].id, sizeof(ReqRespHandler), rec->id, false);
+        if (slot >= 0 && prv->req_handlers[slot].handler != NULL) {
+            *id = rec->id;
+            handler = prv->req_handlers[slot].handler;
         }
     }
+    pthread_mutex_unlock(&prv->lock);
 
-    return NULL;
+    return handler;
 }
 
-static int blockingWrite(int fd, const void *buffer, size_t len) {
-    size_t writeOffset = 0;
-    const uint8_t *toWrite;
+static int blockingWritev(int fd, struct iovec *iov, int iovcnt) {
     ssize_t written = 0;
+    struct pollfd pfd;
 
-    if (buffer == NULL)
-        return -1;
-
-    toWrite = (const uint8_t *)buffer;
-
-    while (writeOffset < len) {
+    while (iovcnt > 0) {
         do
         {
-            written = write(fd, toWrite + writeOffset, len - writeOffset);
+            written = writev(fd, iov, iovcnt);
         } while (written < 0 && errno == EINTR);
 
-        if (written >= 0) {
-            writeOffset += written;
+        if (written < 0 && errno == EAGAIN) {
+            // The socket is non-blocking for the reader; wait for room.
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            if (TEMP_FAILURE_RETRY(poll(&pfd, 1, -1)) >= 0)
+                continue;
         }
-        else {
+
+        if (written < 0) {
             RLOGE ("RIL Response: unexpected error on write errno:%d", errno);
             close(fd);
             return -errno;
         }
+
+        // Skip what went out, resuming a partially written entry.
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
     }
 
     return 0;
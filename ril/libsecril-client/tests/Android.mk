@@ -0,0 +1,35 @@
+# Copyright (C) 2024 The LineageOS Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+# Built from the library sources; the test's own socket_local_client() and
+# wake lock calls take precedence over the ones in the shared libraries.
+LOCAL_MODULE := libsecril-client_test
+LOCAL_MODULE_TAGS := optional
+LOCAL_SRC_FILES := \
+    ../secril-client.cpp \
+    secril_client_test.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/..
+
+LOCAL_SHARED_LIBRARIES := \
+    libutils \
+    libcutils \
+    libhardware_legacy \
+    liblog
+
+include $(BUILD_NATIVE_TEST)
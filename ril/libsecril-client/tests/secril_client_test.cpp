@@ -0,0 +1,559 @@
+/*
+ * Copyright (C) 2024 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <telephony/ril.h>
+
+#include "secril-client.h"
+
+#define RESPONSE_SOLICITED      0
+#define RESPONSE_UNSOLICITED    1
+
+using namespace std::chrono_literals;
+
+/*
+ * Connect_RILD() takes whatever socket_local_client() hands it, so the test
+ * gives it one end of a socketpair and plays rild on the other.
+ */
+static int sClientSocket = -1;
+
+extern "C" int socket_local_client(const char *, int, int)
+{
+    int fd = sClientSocket;
+
+    sClientSocket = -1;
+    if (fd < 0)
+        errno = ECONNREFUSED;
+    return fd;
+}
+
+extern "C" int acquire_wake_lock(int, const char *)
+{
+    return 0;
+}
+
+extern "C" int release_wake_lock(const char *)
+{
+    return 0;
+}
+
+// Handlers take no cookie, so what they see goes through globals
+static std::atomic<int> sCompleted;
+static std::vector<std::atomic<int>> *sSeen;
+static std::mutex sErrorsLock;
+static std::vector<int> sErrors;
+
+static int onComplete(HRilClient, const void *data, size_t len)
+{
+    uint32_t seq;
+
+    if (sSeen != NULL && data != NULL && len >= sizeof(seq)) {
+        memcpy(&seq, data, sizeof(seq));
+        if (seq < sSeen->size())
+            (*sSeen)[seq]++;
+    }
+    sCompleted++;
+    return 0;
+}
+
+// What a handler was given, with NULL data told apart from empty data
+struct Recorded {
+    bool null;
+    size_t len;
+    std::vector<uint8_t> data;
+};
+
+static std::mutex sRecordedLock;
+static std::vector<Recorded> sRecorded;
+
+static int onRecord(HRilClient, const void *data, size_t len)
+{
+    Recorded r;
+
+    r.null = data == NULL;
+    r.len = len;
+    if (data != NULL)
+        r.data.assign((const uint8_t *)data, (const uint8_t *)data + len);
+
+    std::lock_guard<std::mutex> lock(sRecordedLock);
+    sRecorded.push_back(r);
+    return 0;
+}
+
+static size_t recordedCount()
+{
+    std::lock_guard<std::mutex> lock(sRecordedLock);
+    return sRecorded.size();
+}
+
+static int onError(void *, int error)
+{
+    std::lock_guard<std::mutex> lock(sErrorsLock);
+    sErrors.push_back(error);
+    return 0;
+}
+
+static bool readFully(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+
+    while (len > 0) {
+        ssize_t n = TEMP_FAILURE_RETRY(read(fd, p, len));
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    while (len > 0) {
+        ssize_t n = TEMP_FAILURE_RETRY(write(fd, p, len));
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/*
+ * The rild end of the socket: parses every OEM_HOOK_RAW frame the client
+ * sends and, if asked to, echoes its payload back as a solicited response.
+ */
+class FakeRild {
+public:
+    explicit FakeRild(bool reply) : m_reply(reply), m_fd(-1), m_bad(0) {}
+
+    // Also runs when an assertion bails out with the client still connected
+    ~FakeRild()
+    {
+        hangUp();
+    }
+
+    // Returns the client end, to be picked up by the next Connect_RILD()
+    int start()
+    {
+        int fds[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+            return -1;
+        m_fd = fds[1];
+        m_thread = std::thread(&FakeRild::run, this);
+        return fds[0];
+    }
+
+    // Waits for the client to hang up
+    void stop()
+    {
+        if (m_thread.joinable())
+            m_thread.join();
+        if (m_fd >= 0)
+            close(m_fd);
+        m_fd = -1;
+    }
+
+    // Drops the connection from the rild side
+    void hangUp()
+    {
+        if (m_fd >= 0)
+            shutdown(m_fd, SHUT_RDWR);
+        stop();
+    }
+
+    bool reply(int32_t token, const void *data, uint32_t len)
+    {
+        return write({RESPONSE_SOLICITED, token, RIL_CLIENT_ERR_SUCCESS, (int32_t)len}, data, len);
+    }
+
+    bool unsolicited(int32_t id, const void *data, uint32_t len)
+    {
+        return write({RESPONSE_UNSOLICITED, id, (int32_t)len}, data, len);
+    }
+
+    // Sends one record: the given words, then size bytes of data padded to 4
+    bool write(std::initializer_list<int32_t> words, const void *data, size_t size)
+    {
+        std::vector<uint8_t> record((1 + words.size()) * sizeof(int32_t) + ((size + 3) & ~(size_t)3));
+        uint32_t header = htonl(record.size() - sizeof(header));
+
+        memcpy(record.data(), &header, sizeof(header));
+        memcpy(record.data() + sizeof(header), words.begin(), words.size() * sizeof(int32_t));
+        if (size)
+            memcpy(record.data() + (1 + words.size()) * sizeof(int32_t), data, size);
+
+        std::lock_guard<std::mutex> lock(m_writeLock);
+        return writeFully(m_fd, record.data(), record.size());
+    }
+
+    std::vector<int32_t> tokens()
+    {
+        std::lock_guard<std::mutex> lock(m_framesLock);
+        return m_tokens;
+    }
+
+    // Bodies of the frames received, without the size header
+    std::vector<std::vector<uint8_t>> frames()
+    {
+        std::lock_guard<std::mutex> lock(m_framesLock);
+        return m_frames;
+    }
+
+    int bad() const
+    {
+        return m_bad;
+    }
+
+private:
+    void run()
+    {
+        uint32_t size;
+        std::vector<uint8_t> body;
+        int32_t request, token, len;
+
+        while (readFully(m_fd, &size, sizeof(size))) {
+            size = ntohl(size);
+            body.resize(size);
+            if (size < 3 * sizeof(int32_t) || !readFully(m_fd, body.data(), size)) {
+                m_bad++;
+                break;
+            }
+
+            memcpy(&request, &body[0], sizeof(request));
+            memcpy(&token, &body[4], sizeof(token));
+            memcpy(&len, &body[8], sizeof(len));
+            if (request != RIL_REQUEST_OEM_HOOK_RAW || len < 0 ||
+                    size != 3 * sizeof(int32_t) + ((len + 3) & ~3u)) {
+                m_bad++;
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_framesLock);
+                m_tokens.push_back(token);
+                m_frames.push_back(body);
+            }
+            if (m_reply)
+                reply(token, &body[12], len);
+        }
+    }
+
+    bool m_reply;
+    int m_fd;
+    std::atomic<int> m_bad;
+    std::thread m_thread;
+    std::mutex m_writeLock;
+    std::mutex m_framesLock;
+    std::vector<int32_t> m_tokens;
+    std::vector<std::vector<uint8_t>> m_frames;
+};
+
+template <typename Pred>
+static bool waitFor(Pred pred)
+{
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+class SecRilClientTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        sCompleted = 0;
+        sSeen = NULL;
+        sErrors.clear();
+        sRecorded.clear();
+
+        m_client = OpenClient_RILD();
+        ASSERT_TRUE(m_client != NULL);
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+                  RegisterRequestCompleteHandler(m_client, RIL_REQUEST_OEM_HOOK_RAW, onComplete));
+    }
+
+    virtual void TearDown()
+    {
+        CloseClient_RILD(m_client);
+        sSeen = NULL;
+    }
+
+    void connect(FakeRild &rild)
+    {
+        sClientSocket = rild.start();
+        ASSERT_LE(0, sClientSocket);
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, Connect_RILD(m_client));
+        ASSERT_EQ(1, isConnected_RILD(m_client));
+    }
+
+    int send(uint32_t seq, size_t len = sizeof(uint32_t))
+    {
+        std::vector<char> data(len, (char)seq);
+
+        memcpy(data.data(), &seq, sizeof(seq));
+        return InvokeOemRequestHookRaw(m_client, data.data(), data.size());
+    }
+
+    static int errors(int error)
+    {
+        std::lock_guard<std::mutex> lock(sErrorsLock);
+        return std::count(sErrors.begin(), sErrors.end(), error);
+    }
+
+    static std::vector<uint8_t> pattern(size_t len, uint8_t seed)
+    {
+        std::vector<uint8_t> data(len);
+
+        for (size_t i = 0; i < len; i++)
+            data[i] = seed + i * 7;
+        return data;
+    }
+
+    HRilClient m_client;
+};
+
+TEST_F(SecRilClientTest, ConcurrentSendersEachCompleteOnce)
+{
+    const uint32_t kThreads = 8;
+    const uint32_t kRequests = 2000;
+    std::vector<std::atomic<int>> seen(kThreads * kRequests);
+    std::vector<std::thread> senders;
+    FakeRild rild(true);
+
+    sSeen = &seen;
+    connect(rild);
+
+    for (uint32_t t = 0; t < kThreads; t++) {
+        senders.emplace_back([this, t]() {
+            for (uint32_t i = 0; i < kRequests; i++) {
+                // odd payload lengths exercise the padding
+                ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(t * kRequests + i, 4 + i % 5));
+            }
+        });
+    }
+    for (auto &sender : senders)
+        sender.join();
+
+    ASSERT_TRUE(waitFor([&]() { return sCompleted == (int)(kThreads * kRequests); }));
+    EXPECT_EQ(0, rild.bad());
+    for (size_t i = 0; i < seen.size(); i++)
+        ASSERT_EQ(1, seen[i]) << "request " << i;
+
+    // every token was unique among the requests in flight
+    std::vector<int32_t> tokens = rild.tokens();
+    std::sort(tokens.begin(), tokens.end());
+    EXPECT_EQ(tokens.end(), std::adjacent_find(tokens.begin(), tokens.end()));
+
+    EXPECT_EQ(RIL_CLIENT_ERR_SUCCESS, Disconnect_RILD(m_client));
+    rild.stop();
+}
+
+TEST_F(SecRilClientTest, DisconnectDropsOutstandingRequests)
+{
+    FakeRild first(false);
+    FakeRild second(true);
+    std::vector<int32_t> stale;
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, RegisterErrorCallback(m_client, onError, NULL));
+
+    connect(first);
+    for (uint32_t i = 0; i < 16; i++)
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(i));
+    ASSERT_TRUE(waitFor([&]() { return first.tokens().size() == 16; }));
+    stale = first.tokens();
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, Disconnect_RILD(m_client));
+    EXPECT_EQ(0, isConnected_RILD(m_client));
+    first.stop();
+
+    // a late answer to the old connection is no longer matched to a request
+    connect(second);
+    for (int32_t token : stale)
+        ASSERT_TRUE(second.reply(token, NULL, 0));
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(0));
+
+    ASSERT_TRUE(waitFor([&]() { return sCompleted == 1; }));
+    EXPECT_EQ((int)stale.size(), errors(RIL_CLIENT_ERR_INVAL));
+
+    EXPECT_EQ(RIL_CLIENT_ERR_SUCCESS, Disconnect_RILD(m_client));
+    second.stop();
+}
+
+TEST_F(SecRilClientTest, DisconnectAfterHangUpDropsOutstandingRequests)
+{
+    FakeRild first(false);
+    FakeRild second(true);
+    std::vector<int32_t> stale;
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, RegisterErrorCallback(m_client, onError, NULL));
+
+    connect(first);
+    for (uint32_t i = 0; i < 16; i++)
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(i));
+    ASSERT_TRUE(waitFor([&]() { return first.tokens().size() == 16; }));
+    stale = first.tokens();
+
+    // rild goes away first; the reader notices and reports it
+    first.hangUp();
+    ASSERT_TRUE(waitFor([&]() { return errors(RIL_CLIENT_ERR_CONNECT) == 1; }));
+    EXPECT_EQ(RIL_CLIENT_ERR_SUCCESS, Disconnect_RILD(m_client));
+
+    connect(second);
+    for (int32_t token : stale)
+        ASSERT_TRUE(second.reply(token, NULL, 0));
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(0));
+
+    ASSERT_TRUE(waitFor([&]() { return sCompleted == 1; }));
+    EXPECT_EQ((int)stale.size(), errors(RIL_CLIENT_ERR_INVAL));
+
+    EXPECT_EQ(RIL_CLIENT_ERR_SUCCESS, Disconnect_RILD(m_client));
+    second.stop();
+}
+
+TEST_F(SecRilClientTest, FramesMatchParcelLayout)
+{
+    const size_t kLengths = 37;
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<int32_t> tokens;
+    FakeRild rild(false);
+
+    connect(rild);
+    for (size_t len = 0; len < kLengths; len++) {
+        std::vector<uint8_t> data = pattern(len, len);
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+                  InvokeOemRequestHookRaw(m_client, (char *)data.data(), len));
+    }
+    ASSERT_TRUE(waitFor([&]() { return rild.frames().size() == kLengths; }));
+    frames = rild.frames();
+    tokens = rild.tokens();
+
+    // request, token, length and the payload zero padded to 4 bytes, as
+    // Parcel::writeInt32() and Parcel::write() laid it out
+    for (size_t len = 0; len < kLengths; len++) {
+        int32_t words[3] = { RIL_REQUEST_OEM_HOOK_RAW, tokens[len], (int32_t)len };
+        std::vector<uint8_t> expected(sizeof(words) + ((len + 3) & ~(size_t)3));
+        std::vector<uint8_t> data = pattern(len, len);
+
+        memcpy(expected.data(), words, sizeof(words));
+        if (len)
+            memcpy(expected.data() + sizeof(words), data.data(), len);
+        EXPECT_EQ(expected, frames[len]) << "length " << len;
+    }
+    EXPECT_EQ(0, rild.bad());
+}
+
+TEST_F(SecRilClientTest, LargeRequestWaitsForRoom)
+{
+    // far more than the socket buffer, so the write stops part way
+    std::vector<uint8_t> data = pattern(1024 * 1024 + 3, 1);
+    std::vector<std::vector<uint8_t>> frames;
+    FakeRild rild(false);
+
+    connect(rild);
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+              InvokeOemRequestHookRaw(m_client, (char *)data.data(), data.size()));
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(0));
+
+    ASSERT_TRUE(waitFor([&]() { return rild.frames().size() == 2; }));
+    frames = rild.frames();
+    ASSERT_EQ(3 * sizeof(int32_t) + data.size() + 1, frames[0].size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), frames[0].begin() + 3 * sizeof(int32_t)));
+    EXPECT_EQ(0, rild.bad());
+}
+
+TEST_F(SecRilClientTest, ResponsesParsedInPlace)
+{
+    const size_t kLengths = 37;
+    FakeRild rild(true);
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+              RegisterRequestCompleteHandler(m_client, RIL_REQUEST_OEM_HOOK_RAW, onRecord));
+
+    connect(rild);
+    for (size_t len = 0; len < kLengths; len++) {
+        std::vector<uint8_t> data = pattern(len, len);
+        ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+                  InvokeOemRequestHookRaw(m_client, (char *)data.data(), len));
+    }
+    ASSERT_TRUE(waitFor([&]() { return recordedCount() == kLengths; }));
+
+    // the echo comes back in order, without its padding
+    for (size_t len = 0; len < kLengths; len++) {
+        EXPECT_EQ(len, sRecorded[len].len);
+        EXPECT_EQ(len == 0, sRecorded[len].null);
+        EXPECT_EQ(pattern(len, len), sRecorded[len].data) << "length " << len;
+    }
+}
+
+TEST_F(SecRilClientTest, TruncatedResponseGivesNoData)
+{
+    std::vector<uint8_t> data = pattern(8, 0);
+    FakeRild rild(false);
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS,
+              RegisterRequestCompleteHandler(m_client, RIL_REQUEST_OEM_HOOK_RAW, onRecord));
+
+    connect(rild);
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, send(0));
+    ASSERT_TRUE(waitFor([&]() { return rild.tokens().size() == 1; }));
+
+    // claims more data than the record holds
+    ASSERT_TRUE(rild.write({RESPONSE_SOLICITED, rild.tokens()[0], RIL_CLIENT_ERR_SUCCESS, 100},
+                           data.data(), data.size()));
+    ASSERT_TRUE(waitFor([&]() { return recordedCount() == 1; }));
+
+    EXPECT_TRUE(sRecorded[0].null);
+    EXPECT_EQ(100u, sRecorded[0].len);
+}
+
+TEST_F(SecRilClientTest, UnsolicitedParsedInPlace)
+{
+    const int32_t kId = 11000;
+    std::vector<uint8_t> data = pattern(13, 5);
+    FakeRild rild(false);
+
+    ASSERT_EQ(RIL_CLIENT_ERR_SUCCESS, RegisterUnsolicitedHandler(m_client, kId, onRecord));
+
+    connect(rild);
+    ASSERT_TRUE(rild.unsolicited(kId + 1, data.data(), data.size()));
+    ASSERT_TRUE(rild.unsolicited(kId, data.data(), data.size()));
+    ASSERT_TRUE(waitFor([&]() { return recordedCount() == 1; }));
+
+    EXPECT_EQ(data.size(), sRecorded[0].len);
+    EXPECT_EQ(data, sRecorded[0].data);
+}
@@ -11,7 +11,14 @@
 #include "hidl/SehRadioIndication.h"
 #include "hidl/SehRadioResponse.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <thread>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
@@ -64,23 +71,137 @@ std::vector<C> LoadConfiguration(std::string data) {
     return config;
 }
 
-bool died = false;
-void onRILDDeath(void* cookie) {
-    if (died) return;
-    died = true;
+// Backoff between reconnect attempts after the vendor radio died. The delay
+// doubles with every death of a short-lived connection, up to the cap, and
+// each wait is jittered so that slots do not retry in lockstep.
+static constexpr auto kReconnectDelayMin = 500ms;
+static constexpr auto kReconnectDelayMax = 30s;
+// A connection that stayed up this long resets the backoff.
+static constexpr auto kStableConnection = 60s;
+
+// Brings up one SIM slot on its own thread and brings it back up in place
+// whenever the vendor radio service behind it dies.
+class SlotConnection {
+  public:
+    SlotConnection(int slot, const std::string& config)
+        : mName("slot" + std::to_string(slot)), mConfig(config), mRandom(std::random_device()()) {}
+
+    void start() { std::thread(&SlotConnection::run, this).detach(); }
+
+    void onDied() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mDied = true;
+        mCond.notify_all();
+    }
+
+  private:
+    bool connect();
+    bool connectAidl(const std::string& svcName);
+    bool connectHidl();
+    void run();
+
+    const std::string mName;
+    const std::string mConfig;
+    std::mt19937 mRandom;
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    bool mDied = false;
 
-    LOG(ERROR) << "SehRadio died, sleeping for 10s before restarting";
-    std::this_thread::sleep_for(10000ms);
-    exit(1);
+    // Held for as long as the connection lives, which keeps the death link
+    std::shared_ptr<ISehRadioNetwork> mAidlSvc;
+    sp<ISehRadio> mHidlSvc;
+};
+
+static void onAidlDeath(void* cookie) {
+    static_cast<SlotConnection*>(cookie)->onDied();
 }
 
 struct RilHidlDeathRecipient : public hidl_death_recipient {
-    void serviceDied(uint64_t cookie, const wp<IBase>& who) override { onRILDDeath((void*)cookie); }
+    void serviceDied(uint64_t cookie, const wp<IBase>& who) override {
+        reinterpret_cast<SlotConnection*>(cookie)->onDied();
+    }
 };
 
-static const auto gHalDeathRecipient = AIBinder_DeathRecipient_new(onRILDDeath);
+static const auto gHalDeathRecipient = AIBinder_DeathRecipient_new(onAidlDeath);
 static const auto gHidlHalDeathRecipient = sp<RilHidlDeathRecipient>::make();
 
+bool SlotConnection::connectAidl(const std::string& svcName) {
+    auto config = LoadConfiguration<AidlVendorConfig>(mConfig);
+    auto samsungIndication = ndk::SharedRefBase::make<SehRadioNetworkIndication>();
+    auto samsungResponse = ndk::SharedRefBase::make<SehRadioNetworkResponse>();
+    auto svc = ISehRadioNetwork::fromBinder(
+            ndk::SpAIBinder(AServiceManager_waitForService(svcName.c_str())));
+    if (svc == nullptr) return false;
+
+    if (AIBinder_linkToDeath(svc->asBinder().get(), gHalDeathRecipient, this) != STATUS_OK)
+        return false;
+    if (!svc->setResponseFunctions(samsungResponse, samsungIndication).isOk()) return false;
+    if (!svc->setVendorSpecificConfiguration(0x4242, config).isOk()) return false;
+
+    mAidlSvc = svc;
+    return true;
+}
+
+bool SlotConnection::connectHidl() {
+    auto config = LoadConfiguration<SehVendorConfiguration>(mConfig);
+    auto samsungIndication = sp<SehRadioIndication>::make();
+    auto samsungResponse = sp<SehRadioResponse>::make();
+    auto svc = ISehRadio::getService(mName);
+    if (svc == nullptr) return false;
+
+    auto linked = svc->linkToDeath(gHidlHalDeathRecipient, reinterpret_cast<uint64_t>(this));
+    if (!linked.isOk() || !linked) return false;
+    if (!svc->setResponseFunction(samsungResponse, samsungIndication).isOk()) return false;
+    if (!svc->setVendorSpecificConfiguration(0x3232, hidl_vec(config)).isOk()) return false;
+
+    mHidlSvc = svc;
+    return true;
+}
+
+bool SlotConnection::connect() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mDied = false;
+    }
+    mAidlSvc = nullptr;
+    mHidlSvc = nullptr;
+
+    auto aidlSvcName = std::string(ISehRadioNetwork::descriptor) + "/" + mName;
+    if (AServiceManager_isDeclared(aidlSvcName.c_str())) return connectAidl(aidlSvcName);
+    return connectHidl();
+}
+
+void SlotConnection::run() {
+    std::chrono::milliseconds delay = kReconnectDelayMin;
+
+    for (;;) {
+        if (connect()) {
+            LOG(INFO) << "Done (" << mName << ")";
+
+            auto connectedAt = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(mLock);
+                mCond.wait(lock, [this] { return mDied; });
+            }
+            if (std::chrono::steady_clock::now() - connectedAt >= kStableConnection)
+                delay = kReconnectDelayMin;
+
+            LOG(ERROR) << "SehRadio died (" << mName << ")";
+        } else {
+            LOG(ERROR) << "SehRadio bring-up failed (" << mName << ")";
+        }
+
+        using Rep = std::chrono::milliseconds::rep;
+        auto wait = std::chrono::milliseconds(
+                std::uniform_int_distribution<Rep>(delay.count() / 2, delay.count())(mRandom));
+        LOG(INFO) << "Reconnecting " << mName << " in " << wait.count() << "ms";
+        std::this_thread::sleep_for(wait);
+
+        delay = std::min(delay * 2, std::chrono::milliseconds(kReconnectDelayMax));
+    }
+}
+
 int main() {
     ABinderProcess_setThreadPoolMaxThreadCount(0);
     ABinderProcess_startThreadPool();
@@ -91,31 +212,12 @@ int main() {
         content = "FW_READY=1";
     }
 
+    // Slots come up concurrently, each waiting for its own service
     int slotCount = GetIntProperty("ro.vendor.multisim.simslotcount", 1);
+    std::vector<std::unique_ptr<SlotConnection>> slots;
     for (int slot = 1; slot <= slotCount; slot++) {
-        auto slotName = "slot" + std::to_string(slot);
-        auto aidlSvcName = std::string(ISehRadioNetwork::descriptor) + "/" + slotName;
-        if (AServiceManager_isDeclared(aidlSvcName.c_str())) {
-            auto config = LoadConfiguration<AidlVendorConfig>(content);
-            auto samsungIndication = ndk::SharedRefBase::make<SehRadioNetworkIndication>();
-            auto samsungResponse = ndk::SharedRefBase::make<SehRadioNetworkResponse>();
-            auto svc = ISehRadioNetwork::fromBinder(
-                    ndk::SpAIBinder(AServiceManager_waitForService(aidlSvcName.c_str())));
-            svc->setResponseFunctions(samsungResponse, samsungIndication);
-            svc->setVendorSpecificConfiguration(0x4242, config);
-            AIBinder_linkToDeath(svc->asBinder().get(), gHalDeathRecipient, 0);
-            AIBinder_incStrong(svc->asBinder().get());
-        } else {
-            auto config = LoadConfiguration<SehVendorConfiguration>(content);
-            auto samsungIndication = sp<SehRadioIndication>::make();
-            auto samsungResponse = sp<SehRadioResponse>::make();
-            auto svc = ISehRadio::getService(slotName);
-            svc->setResponseFunction(samsungResponse, samsungIndication);
-            svc->setVendorSpecificConfiguration(0x3232, hidl_vec(config));
-            svc->linkToDeath(gHidlHalDeathRecipient, 0);
-            svc->incStrong(gHidlHalDeathRecipient.get());
-        }
-        LOG(INFO) << "Done (slot" << slot << ")";
+        slots.push_back(std::make_unique<SlotConnection>(slot, content));
+        slots.back()->start();
     }
 
     ABinderProcess_joinThreadPool();